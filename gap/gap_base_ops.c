@@ -28,6 +28,8 @@
  */
 
 /* revision history:
+ * 2.8.xx;  2026/10/18    agent: duplicate and density report the used copy strategy (reflink, hardlink, copy)
+ * 2.8.xx;  2026/10/18    agent: renumber, rename, shift and reverse use transactional bulk renaming
  * 2.8.xx;  2017/04/04    hof: added gap_base_rename
  * 1.3.17b; 2003/07/31   hof: message text fixes for translators (# 118392)
  * 1.3.16b; 2003/07/04   hof: added gap_density, confirm dialog for frame deleting operations
@@ -56,6 +58,7 @@
 #include "gap_arr_dialog.h"
 #include "gap_lock.h"
 #include "gap_thumbnail.h"
+#include "gap_bulk_rename.h"
 
 
 extern      int gap_debug; /* ==0  ... dont print debug infos */
@@ -70,6 +73,171 @@ extern      int gap_debug; /* ==0  ... dont print debug infos */
 #define GAP_HELP_ID_REVERSE           "plug-in-gap-reverse"
 
 
+
+/* ------------------------------
+ * p_bulk_rename_check_journal
+ * ------------------------------
+ * check for a journal of an interrupted bulk rename operation
+ * (renumber, rename, shift, reverse) on the frames of ainfo_ptr.
+ * if there is one, complete the interrupted operation (roll forward)
+ * or undo it (roll back). in interactive mode the user decides,
+ * otherwise the operation is rolled forward.
+ *
+ * return TRUE if the frames are in a consistent state (ready for the next operation)
+ */
+static gboolean
+p_bulk_rename_check_journal(GapAnimInfo *ainfo_ptr)
+{
+  gboolean l_roll_forward;
+
+  if(!gap_bulk_rename_journal_exists(ainfo_ptr->basename))
+  {
+    return(TRUE);
+  }
+
+  l_roll_forward = TRUE;
+  if(ainfo_ptr->run_mode == GIMP_RUN_INTERACTIVE)
+  {
+    GapArrButtonArg  l_argv[3];
+    gchar           *l_msg;
+    gint             l_rc;
+
+    l_argv[0].but_txt  = GTK_STOCK_CANCEL;
+    l_argv[0].but_val  = -1;
+    l_argv[1].but_txt  = _("Roll back");
+    l_argv[1].but_val  = 0;
+    l_argv[2].but_txt  = _("Roll forward");
+    l_argv[2].but_val  = 1;
+
+    l_msg = g_strdup_printf(_("A previous operation on the frames %s*%s was interrupted.\n"
+                              "Roll forward to complete it or roll back to undo it.")
+                           , ainfo_ptr->basename
+                           , ainfo_ptr->extension);
+    l_rc = gap_arr_buttons_dialog(_("Interrupted Frame Renaming"), l_msg, 3, l_argv, -1);
+    g_free(l_msg);
+    if(l_rc < 0)
+    {
+      return(FALSE);
+    }
+    l_roll_forward = (l_rc == 1);
+  }
+
+  if(0 != gap_bulk_rename_recover(ainfo_ptr->basename, l_roll_forward))
+  {
+    gap_arr_msg_win(ainfo_ptr->run_mode
+                   , _("Error: could not recover the interrupted frame renaming operation."));
+    return(FALSE);
+  }
+  return(TRUE);
+}  /* end p_bulk_rename_check_journal */
+
+
+/* ------------------------------
+ * p_bulk_rename_add_frame
+ * ------------------------------
+ * add the move of frame from_nr to to_nr.
+ * the destination name keeps the number of digits of the source frame
+ * (same naming rule as gap_lib_rename_frame).
+ */
+static gboolean
+p_bulk_rename_add_frame(GapBulkRename *bren, GapAnimInfo *ainfo_ptr, long from_nr, long to_nr)
+{
+  char     *l_from_fname;
+  char     *l_to_fname;
+  long      l_digits_used;
+  gboolean  l_ok;
+
+  l_from_fname = gap_lib_alloc_fname(ainfo_ptr->basename, from_nr, ainfo_ptr->extension);
+  if(l_from_fname == NULL)
+  {
+    return(FALSE);
+  }
+
+  l_digits_used = gap_lib_count_framenumber_digits(l_from_fname);
+  if (l_digits_used > 0)
+  {
+    l_to_fname = gap_lib_alloc_fname_fixed_digits(ainfo_ptr->basename, to_nr, ainfo_ptr->extension, l_digits_used);
+  }
+  else
+  {
+    l_to_fname = gap_lib_alloc_fname(ainfo_ptr->basename, to_nr, ainfo_ptr->extension);
+  }
+
+  l_ok = gap_bulk_rename_add(bren, l_from_fname, l_to_fname);
+
+  g_free(l_from_fname);
+  g_free(l_to_fname);
+
+  return(l_ok);
+}  /* end p_bulk_rename_add_frame */
+
+
+/* ------------------------------
+ * p_bulk_rename_execute
+ * ------------------------------
+ * execute and free the bulk rename.
+ * return 0 on success, -1 on errors (in that case all frames keep their old names)
+ */
+static gint32
+p_bulk_rename_execute(GapBulkRename *bren, GapAnimInfo *ainfo_ptr)
+{
+  gint32 l_rc;
+
+  bren->do_progress = (ainfo_ptr->run_mode == GIMP_RUN_INTERACTIVE);
+  l_rc = gap_bulk_rename_execute(bren);
+  if(gap_debug)
+  {
+    printf("p_bulk_rename_execute: rc:%d moves:%d renames:%d cycles:%d\n"
+      , (int)l_rc
+      , (int)bren->moves->len
+      , (int)bren->rename_count
+      , (int)bren->cycle_count
+      );
+  }
+  gap_bulk_rename_free(bren);
+
+  if(l_rc != 0)
+  {
+    gap_arr_msg_win(ainfo_ptr->run_mode, _("Error: could not rename frames"));
+    return(-1);
+  }
+  return(0);
+}  /* end p_bulk_rename_execute */
+
+
+/* ------------------------------
+ * p_report_copy_strategies
+ * ------------------------------
+ * report how many frames were duplicated via reflink, hardlink
+ * or plain copy (see gap_lib_file_copy_fast).
+ */
+static void
+p_report_copy_strategies(GapAnimInfo *ainfo_ptr, const char *operation, gint32 *copy_counts)
+{
+  gchar *l_msg;
+
+  if((copy_counts[GAP_LIB_COPY_PLAIN]
+    + copy_counts[GAP_LIB_COPY_REFLINK]
+    + copy_counts[GAP_LIB_COPY_HARDLINK]) == 0)
+  {
+    return;
+  }
+
+  l_msg = g_strdup_printf(_("%s: frames created by reflink: %d, hardlink: %d, copy: %d")
+                         , operation
+                         , (int)copy_counts[GAP_LIB_COPY_REFLINK]
+                         , (int)copy_counts[GAP_LIB_COPY_HARDLINK]
+                         , (int)copy_counts[GAP_LIB_COPY_PLAIN]
+                         );
+  printf("%s\n", l_msg);
+  if(ainfo_ptr->run_mode == GIMP_RUN_INTERACTIVE)
+  {
+    gimp_progress_set_text(l_msg);
+  }
+  g_free(l_msg);
+}  /* end p_report_copy_strategies */
+
+
 /* ------------------------
  * p_density_shrink
  * ------------------------
@@ -209,6 +377,7 @@ p_density_grow(GapAnimInfo *ainfo_ptr
    gint32  copied_frames;
    gdouble target_range_fsize;
    gdouble    l_percentage, l_percentage_step;
+   gint32     l_copy_counts[GAP_LIB_COPY_STRATEGY_COUNT] = { 0, 0, 0 };
 
    if(ainfo_ptr->run_mode == GIMP_RUN_INTERACTIVE)
    {
@@ -278,7 +447,13 @@ p_density_grow(GapAnimInfo *ainfo_ptr
         l_dup_name = gap_lib_alloc_fname(ainfo_ptr->basename, l_hi, ainfo_ptr->extension);
         if((l_dup_name != NULL) && (l_alias_name != NULL))
         {
-           gap_lib_image_file_copy(l_alias_name, l_dup_name);
+           GapLibCopyStrategy l_strategy;
+
+           gap_lib_image_file_copy_fast(l_alias_name, l_dup_name, &l_strategy);
+           if(l_strategy != GAP_LIB_COPY_FAILED)
+           {
+             l_copy_counts[l_strategy]++;
+           }
            g_free(l_dup_name);
            g_free(l_alias_name);
         }
@@ -308,6 +483,8 @@ p_density_grow(GapAnimInfo *ainfo_ptr
      }
    }
 
+   p_report_copy_strategies(ainfo_ptr, _("Density"), l_copy_counts);
+
    /* recalculate last and total frames */
    ainfo_ptr->frame_cnt += copied_frames;
    ainfo_ptr->last_frame_nr += copied_frames;
@@ -522,6 +699,8 @@ p_del(GapAnimInfo *ainfo_ptr, long cnt)
  *
  * all following frames are renamed (renumbered up by cnt)
  * current frame is duplicated (cnt) times
+ * (the duplicates are created as reflink or hardlink if possible,
+ *  see gap_lib_file_copy_fast)
  *
  * return image_id (of the new loaded frame) on success
  *        or -1 on errors
@@ -538,6 +717,7 @@ p_dup(GapAnimInfo *ainfo_ptr, long cnt, long range_from, long range_to)
    char  *l_curr_name;
    gdouble    l_percentage, l_percentage_step;
    gboolean   l_lo_frame_found;
+   gint32     l_copy_counts[GAP_LIB_COPY_STRATEGY_COUNT] = { 0, 0, 0 };
 
    if(gap_debug) fprintf(stderr, "DEBUG  p_dup fr:%d to:%d cnt:%d extension:%s: basename:%s frame_cnt:%d\n",
                          (int)range_from, (int)range_to, (int)cnt, ainfo_ptr->extension, ainfo_ptr->basename, (int)ainfo_ptr->frame_cnt);
@@ -649,7 +829,13 @@ p_dup(GapAnimInfo *ainfo_ptr, long cnt, long range_from, long range_to)
       {
          if (g_file_test(l_curr_name, G_FILE_TEST_EXISTS))
          {
-           gap_lib_image_file_copy(l_curr_name, l_dup_name);
+           GapLibCopyStrategy l_strategy;
+
+           gap_lib_image_file_copy_fast(l_curr_name, l_dup_name, &l_strategy);
+           if(l_strategy != GAP_LIB_COPY_FAILED)
+           {
+             l_copy_counts[l_strategy]++;
+           }
          }
          g_free(l_dup_name);
          g_free(l_curr_name);
@@ -668,6 +854,8 @@ p_dup(GapAnimInfo *ainfo_ptr, long cnt, long range_from, long range_to)
       l_hi--;
    }
 
+   p_report_copy_strategies(ainfo_ptr, _("Duplicate"), l_copy_counts);
+
    /* restore current position */
    ainfo_ptr->frame_cnt += l_cnt2;
    ainfo_ptr->last_frame_nr = ainfo_ptr->first_frame_nr + ainfo_ptr->frame_cnt -1;
@@ -754,6 +942,9 @@ p_exchg(GapAnimInfo *ainfo_ptr, long dest)
  *  example:  cnt == 1 :  range before 3, 4, 5, 6, 7
  *                        range after  4, 5, 6, 7, 3
  *
+ * the frames are moved with one transactional bulk rename
+ * (a shift is one cycle, that is renamed with only one temporary name)
+ *
  * return image_id (of the new loaded frame) on success
  *        or -1 on errors
  * ============================================================================
@@ -762,13 +953,12 @@ static gint32
 p_shift(GapAnimInfo *ainfo_ptr, long cnt, long range_from, long range_to)
 {
    long  l_lo, l_hi, l_curr, l_dst;
-   long  l_upper;
+   long  l_size;
    long  l_shift;
    gchar *l_curr_name;
    gchar *tmp_errtxt;
    gboolean l_frame_found;
-
-   gdouble    l_percentage, l_percentage_step;
+   GapBulkRename *bren;
 
    if(gap_debug) fprintf(stderr, "DEBUG  p_shift fr:%d to:%d cnt:%d\n",
                          (int)range_from, (int)range_to, (int)cnt);
@@ -806,37 +996,32 @@ p_shift(GapAnimInfo *ainfo_ptr, long cnt, long range_from, long range_to)
    }
    g_free(l_curr_name);
 
-   l_percentage = 0.0;
    if(ainfo_ptr->run_mode == GIMP_RUN_INTERACTIVE)
    {
      gimp_progress_init( _("Renumber frame sequence..."));
    }
 
-   /* rename (renumber) all frames 
-    * (using higher numbers than last available frame number)
+   /* collect the moves of all frames in the range (the range is rotated
+    * by l_shift frame numbers) and execute them as one bulk rename.
     */
-
-   l_upper = ainfo_ptr->last_frame_nr +100;
-   l_percentage_step = 0.5 / ((1.0 + l_lo) - l_hi);
+   l_size = (l_hi - l_lo) + 1;
+   bren = gap_bulk_rename_new(ainfo_ptr->basename);
    l_curr = l_lo;
+   l_frame_found = gap_lib_framefile_with_framenr_exists(ainfo_ptr, l_curr);
    while (l_curr <= l_hi)
    {
-     l_frame_found = gap_lib_framefile_with_framenr_exists(ainfo_ptr, l_curr);
      if (l_frame_found)
      {
-       if(0 != gap_lib_rename_frame(ainfo_ptr, l_curr, l_curr + l_upper))
+       l_dst = l_lo + ((((l_curr - l_lo) + l_shift) % l_size) + l_size) % l_size;
+       if (!p_bulk_rename_add_frame(bren, ainfo_ptr, l_curr, l_dst))
        {
-         tmp_errtxt = g_strdup_printf(_("Error: could not rename frame %ld to %ld"), l_lo, l_hi);
+         tmp_errtxt = g_strdup_printf(_("Error: could not rename frame %ld to %ld"), l_curr, l_dst);
          gap_arr_msg_win(ainfo_ptr->run_mode, tmp_errtxt);
          g_free(tmp_errtxt);
+         gap_bulk_rename_free(bren);
          return -1;
        }
      }
-     if(ainfo_ptr->run_mode == GIMP_RUN_INTERACTIVE)
-     {
-       l_percentage += l_percentage_step;
-       gimp_progress_update (l_percentage);
-     }
      /* advance l_curr to the next available frame number 
       * (normally to l_curr += 1; sometimes to higher number when frames are missing) 
       */
@@ -844,35 +1029,9 @@ p_shift(GapAnimInfo *ainfo_ptr, long cnt, long range_from, long range_to)
                            , ainfo_ptr->basename, ainfo_ptr->extension, &l_frame_found);
    }
 
-   /* rename (renumber) all frames (using desired destination numbers)
-    */
-   l_dst = l_lo + l_shift;
-   if (l_dst > l_hi) { l_dst -= (l_lo -1); }
-   if (l_dst < l_lo) { l_dst += ((l_hi - l_lo) +1); }
-   for(l_curr = l_upper + l_lo; l_curr <= l_upper + l_hi; l_curr++)
+   if (0 != p_bulk_rename_execute(bren, ainfo_ptr))
    {
-     if (l_dst > l_hi) 
-     {
-       l_dst = l_lo; 
-     }
-     l_frame_found = gap_lib_framefile_with_framenr_exists(ainfo_ptr, l_curr);
-     if (l_frame_found)
-     {
-       if(0 != gap_lib_rename_frame(ainfo_ptr, l_curr, l_dst))
-       {
-         tmp_errtxt = g_strdup_printf(_("Error: could not rename frame %ld to %ld"), l_lo, l_hi);
-         gap_arr_msg_win(ainfo_ptr->run_mode, tmp_errtxt);
-         g_free(tmp_errtxt);
-         return -1;
-       }
-     }
-     if(ainfo_ptr->run_mode == GIMP_RUN_INTERACTIVE)
-     {
-       l_percentage += l_percentage_step;
-       gimp_progress_update (l_percentage);
-     }
-
-     l_dst ++;
+     return -1;
    }
 
 
@@ -900,6 +1059,8 @@ p_shift(GapAnimInfo *ainfo_ptr, long cnt, long range_from, long range_to)
  *   range before A(3), B(4), C(7), D(21), E(22), F(51)
  *   range after  F(3), E(4), D(7), C(21), B(22), A(51)
  *
+ * the frames are moved with one transactional bulk rename.
+ *
  * return image_id (of the new loaded frame) on success
  *        or -1 on errors
  * ============================================================================
@@ -907,13 +1068,13 @@ p_shift(GapAnimInfo *ainfo_ptr, long cnt, long range_from, long range_to)
 static gint32
 p_reverse(GapAnimInfo *ainfo_ptr, long range_from, long range_to)
 {
-   long  l_tmp_nr;
    long  l_lo, l_hi, l_curr;
    long  l_swap;
+   long  l_idx, l_count;
+   long *l_frame_nrs;
    gchar *tmp_errtxt;
-   gdouble    l_percentage;
-
-   l_tmp_nr = ainfo_ptr->last_frame_nr + 4;  /* use a free frame_nr for temp name */
+   gboolean l_cur_frame_found;
+   GapBulkRename *bren;
 
    if(gap_debug) fprintf(stderr, "DEBUG  p_reverse fr:%d to:%d\n",
                          (int)range_from, (int)range_to);
@@ -945,86 +1106,53 @@ p_reverse(GapAnimInfo *ainfo_ptr, long range_from, long range_to)
         return -1;
    }
 
-   l_percentage = 0.0;
    if(ainfo_ptr->run_mode == GIMP_RUN_INTERACTIVE)
    {
      gimp_progress_init( _("Renumber frame sequence..."));
    }
 
-
-   /* swap lo with high for each of the (first half of the) frames
-    * to reverse the frame sequence.
+   /* collect the numbers of all available frames in the range
+    * and move the frame at position l_idx to the number at the mirrored position
+    * (all moves are executed as one bulk rename)
     */
+   l_frame_nrs = g_new(long, (l_hi - l_lo) + 1);
+   l_count = 0;
    l_curr = l_lo;
-   l_swap = l_hi - (l_curr - l_lo);
-   while(1)
+   l_cur_frame_found = gap_lib_framefile_with_framenr_exists(ainfo_ptr, l_curr);
+   while(l_curr <= l_hi)
    {
-     gboolean l_cur_frame_found;
-     gboolean l_swap_frame_found;
-     
-     l_cur_frame_found = gap_lib_framefile_with_framenr_exists(ainfo_ptr, l_curr);
-     if(l_cur_frame_found != TRUE)
-     {
-       /* advance l_curr to the next available frame number 
-        * (normally to l_curr += 1; 
-        * sometimes to higher number when frames are missing) 
-        */
-       l_curr = gap_lib_get_next_available_frame_number(l_curr, 1
-                           , ainfo_ptr->basename, ainfo_ptr->extension, &l_cur_frame_found);
-     }
-     l_swap_frame_found = gap_lib_framefile_with_framenr_exists(ainfo_ptr, l_swap);
-     if(l_swap_frame_found != TRUE)
+     if(l_cur_frame_found)
      {
-       /* advance l_swap to the previous available frame number 
-        * (normally to l_swap -= 1; 
-        * sometimes to lower number when frames are missing) 
-        */
-       l_swap = gap_lib_get_next_available_frame_number(l_swap, -1
-                           , ainfo_ptr->basename, ainfo_ptr->extension, &l_swap_frame_found);
-     }
-     
-     if ((l_cur_frame_found != TRUE) 
-     ||  (l_swap_frame_found != TRUE)
-     ||  (l_swap <= l_curr))
-     {
-        /* stop when no more frames found for swapping 
-         * or all framenames in the range are already swapped.
-         */
-        break;  
+       l_frame_nrs[l_count] = l_curr;
+       l_count++;
      }
+     /* advance l_curr to the next available frame number 
+      * (normally to l_curr += 1; 
+      * sometimes to higher number when frames are missing) 
+      */
+     l_curr = gap_lib_get_next_available_frame_number(l_curr, 1
+                           , ainfo_ptr->basename, ainfo_ptr->extension, &l_cur_frame_found);
+   }
 
-     /* rename hi (l_swap) to temp */
-     if(0 != gap_lib_rename_frame(ainfo_ptr, l_swap, l_tmp_nr))
-     {
-       tmp_errtxt = g_strdup_printf(_("Error: could not rename frame %ld to %ld"), l_swap, l_tmp_nr);
-       gap_arr_msg_win(ainfo_ptr->run_mode, tmp_errtxt);
-       g_free(tmp_errtxt);
-       return -1;
-     }
-     /* rename lo to hi */
-     if(0 != gap_lib_rename_frame(ainfo_ptr, l_curr, l_swap))
-     {
-       tmp_errtxt = g_strdup_printf(_("Error: could not rename frame %ld to %ld"), ainfo_ptr->curr_frame_nr, l_swap);
-       gap_arr_msg_win(ainfo_ptr->run_mode, tmp_errtxt);
-       g_free(tmp_errtxt);
-       return -1;
-     }
-     /* rename temp to lo */
-     if(0 != gap_lib_rename_frame(ainfo_ptr, l_tmp_nr, l_curr))
+   bren = gap_bulk_rename_new(ainfo_ptr->basename);
+   for(l_idx = 0; l_idx < l_count; l_idx++)
+   {
+     l_swap = l_frame_nrs[(l_count - 1) - l_idx];
+     if(!p_bulk_rename_add_frame(bren, ainfo_ptr, l_frame_nrs[l_idx], l_swap))
      {
-       tmp_errtxt = g_strdup_printf(_("Error: could not rename frame %ld to %ld"), l_tmp_nr, ainfo_ptr->curr_frame_nr);
+       tmp_errtxt = g_strdup_printf(_("Error: could not rename frame %ld to %ld"), l_frame_nrs[l_idx], l_swap);
        gap_arr_msg_win(ainfo_ptr->run_mode, tmp_errtxt);
        g_free(tmp_errtxt);
+       gap_bulk_rename_free(bren);
+       g_free(l_frame_nrs);
        return -1;
      }
-     if (ainfo_ptr->run_mode == GIMP_RUN_INTERACTIVE)
-     {
-       l_percentage = (double)((l_curr - l_lo + 1) / ((l_hi - l_lo + 1) / 2.0 ));
-       if (l_percentage > 1.0) l_percentage = 1.0;
-       gimp_progress_update (l_percentage);
-     }
-     l_curr++;
-     l_swap--;
+   }
+   g_free(l_frame_nrs);
+
+   if (0 != p_bulk_rename_execute(bren, ainfo_ptr))
+   {
+     return -1;
    }
 
    /* load from the "new" current frame */
@@ -1907,7 +2035,8 @@ gap_base_shift(GimpRunMode run_mode, gint32 image_id, int nr,
   ainfo_ptr = gap_lib_alloc_ainfo(image_id, run_mode);
   if(ainfo_ptr != NULL)
   {
-    if (0 == gap_lib_dir_ainfo(ainfo_ptr))
+    if ((p_bulk_rename_check_journal(ainfo_ptr))
+    &&  (0 == gap_lib_dir_ainfo(ainfo_ptr)))
     {
       if(run_mode == GIMP_RUN_INTERACTIVE)
       {
@@ -1963,7 +2092,8 @@ gap_base_reverse(GimpRunMode run_mode, gint32 image_id,
   ainfo_ptr = gap_lib_alloc_ainfo(image_id, run_mode);
   if(ainfo_ptr != NULL)
   {
-    if (0 == gap_lib_dir_ainfo(ainfo_ptr))
+    if ((p_bulk_rename_check_journal(ainfo_ptr))
+    &&  (0 == gap_lib_dir_ainfo(ainfo_ptr)))
     {
       if(run_mode == GIMP_RUN_INTERACTIVE)
       {
@@ -2117,113 +2247,84 @@ gap_lib_rename_frame_digits(GapAnimInfo *ainfo_ptr, long from_nr, long to_nr, lo
  *     frame_14.xcf                frame_0010.xcf
  *     frame_16.xcf                frame_0011.xcf
  *
- * the 2nd example is processed in 2 loops, where the 1.st loop
- * steps down through all frames and makes continous numbers  0017, 0016, 0015, 0014.
- * the 2nd (up stepping) pass makes the final numbers.
- *
- *  example3:  digits == 4, start_frame_nr == 8
- *
- *     Old filenames               New Filenames
- *   -----------------------------------------------
- *     frame_2.xcf                 frame_0008.xcf
- *     frame_3.xcf                 frame_0009.xcf
- *     frame_4.xcf                 frame_0010.xcf
- *     frame_5.xcf                 frame_0011.xcf
- *
- * the 3nd example does not need a 2nd pass, because the 1.st downstepping loop
- * can make the requested numbers.
+ * all moves are collected first and executed as one transactional
+ * bulk rename (see gap_bulk_rename.c), where each frame is renamed only once
+ * (frames on a cycle of the renumbering permutation need one extra temporary rename).
  */
 static gint32
 p_renumber_frames(GapAnimInfo *ainfo_ptr, long start_frame_nr, long digits)
 {
-  long l_from;
-  long l_to;
-  long l_has_digits;
-  gboolean two_pass;
+  GapBulkRename *bren;
+  long  l_from;
+  long  l_to;
+  long  l_cnt;
+  long  l_has_digits;
+  long  l_new_curr_frame_nr;
+  char *l_new_curr_name;
 
 
   if(ainfo_ptr->run_mode == GIMP_RUN_INTERACTIVE)
   {
     gimp_progress_init(_("Renumber Frames"));
   }
-  two_pass = FALSE;
-  if(start_frame_nr > ainfo_ptr->first_frame_nr)
-  {
-    long l_cnt;
 
-    l_from = ainfo_ptr->last_frame_nr;
-    l_to = ainfo_ptr->last_frame_nr + (start_frame_nr - ainfo_ptr->first_frame_nr);
+  bren = gap_bulk_rename_new(ainfo_ptr->basename);
+  l_new_curr_frame_nr = -1;
+  l_new_curr_name = NULL;
 
-    l_cnt=0;
-    while (l_cnt < ainfo_ptr->frame_cnt)
+  l_from = ainfo_ptr->first_frame_nr;
+  l_to = start_frame_nr;
+  l_cnt = 0;
+  while ((l_cnt < ainfo_ptr->frame_cnt) && (l_from <= ainfo_ptr->last_frame_nr))
+  {
+    if (gap_debug) printf("p_renumber_frames: l_from:%d l_to:%d\n", (int)l_from, (int)l_to);
+
+    if( gap_lib_exists_frame_nr(ainfo_ptr, l_from, &l_has_digits) )
     {
+      char     *l_from_fname;
+      char     *l_to_fname;
+      gboolean  l_ok;
 
-      if (gap_debug) printf("p_renumber_frames: DOWNSTEP l_cnt:%d l_from:%d l_to:%d\n", (int)l_cnt, (int)l_to, (int)l_from);
-      if( gap_lib_exists_frame_nr(ainfo_ptr, l_from, &l_has_digits) )
-      {
-        if((l_from != l_to)
-        || (l_has_digits != digits))
-        {
-          if (0 != gap_lib_rename_frame_digits(ainfo_ptr, l_from, l_to, l_has_digits, digits))
-          {
-            return -1;
-          }
-        }
-        l_to--;
-        l_cnt++;
-      }
-      /* advance l_from to the previous available frame number 
-       * (normally to l_from -= 1; sometimes to lower number when frames are missing) 
-       */
-      l_from = gap_lib_get_next_available_frame_number(l_from, -1
-               , ainfo_ptr->basename, ainfo_ptr->extension, NULL);
+      l_from_fname = gap_lib_alloc_fname_fixed_digits(ainfo_ptr->basename, l_from, ainfo_ptr->extension, l_has_digits);
+      l_to_fname = gap_lib_alloc_fname_fixed_digits(ainfo_ptr->basename, l_to, ainfo_ptr->extension, digits);
+      l_ok = gap_bulk_rename_add(bren, l_from_fname, l_to_fname);
 
-      if(ainfo_ptr->run_mode == GIMP_RUN_INTERACTIVE)
+      if (l_from == ainfo_ptr->curr_frame_nr)
       {
-        gimp_progress_update( (gdouble)(l_cnt)
-                            / (gdouble)(ainfo_ptr->frame_cnt) );
+        l_new_curr_frame_nr = l_to;
+        l_new_curr_name = g_strdup(l_to_fname);
       }
-    }
-    if(start_frame_nr !=  (l_to +1))
-    {
-      two_pass = TRUE;
-      if(ainfo_ptr->run_mode == GIMP_RUN_INTERACTIVE)
+      g_free(l_from_fname);
+      g_free(l_to_fname);
+
+      if (!l_ok)
       {
-        gimp_progress_init(_("Renumber Frames 2nd Pass"));
+        gap_bulk_rename_free(bren);
+        g_free(l_new_curr_name);
+        return -1;
       }
+      l_to++;
+      l_cnt++;
     }
+    /* advance l_from to the next available frame number 
+     * (normally to l_from += 1; sometimes to higher number when frames are missing) 
+     */
+    l_from = gap_lib_get_next_available_frame_number(l_from, 1
+               , ainfo_ptr->basename, ainfo_ptr->extension, NULL);
   }
 
-  if((start_frame_nr <= ainfo_ptr->first_frame_nr)
-  || (two_pass))
+  if (0 != p_bulk_rename_execute(bren, ainfo_ptr))
   {
-    l_from = ainfo_ptr->first_frame_nr;
-    l_to = start_frame_nr;
-    while (l_to < start_frame_nr + ainfo_ptr->frame_cnt)
-    {
-
-      if (gap_debug) printf("p_renumber_frames: UPSTEP l_from:%d l_to:%d\n", (int)l_to, (int)l_from);
-
-      if( gap_lib_exists_frame_nr(ainfo_ptr, l_from, &l_has_digits) )
-      {
-        if((l_from != l_to)
-        || (l_has_digits != digits))
-        {
-          if(0 != gap_lib_rename_frame_digits(ainfo_ptr, l_from, l_to, l_has_digits, digits))
-          {
-            return -1;
-          }
-        }
-        l_to++;
-      }
-      l_from++;
+    g_free(l_new_curr_name);
+    return -1;
+  }
 
-      if(ainfo_ptr->run_mode == GIMP_RUN_INTERACTIVE)
-      {
-        gimp_progress_update( (gdouble)(l_from - ainfo_ptr->first_frame_nr)
-                            / (gdouble)(1+ (ainfo_ptr->last_frame_nr - ainfo_ptr->first_frame_nr)) );
-      }
-    }
+  /* keep track of the new current frame number and filename */
+  if (l_new_curr_name != NULL)
+  {
+    ainfo_ptr->curr_frame_nr = l_new_curr_frame_nr;
+    gimp_image_set_filename(ainfo_ptr->image_id, l_new_curr_name);
+    g_free(l_new_curr_name);
   }
 
   return 0; /* OK */
@@ -2249,7 +2350,8 @@ gap_base_renumber(GimpRunMode run_mode, gint32 image_id,
   ainfo_ptr = gap_lib_alloc_ainfo(image_id, run_mode);
   if(ainfo_ptr != NULL)
   {
-    if (0 == gap_lib_dir_ainfo(ainfo_ptr))
+    if ((p_bulk_rename_check_journal(ainfo_ptr))
+    &&  (0 == gap_lib_dir_ainfo(ainfo_ptr)))
     {
       if(run_mode == GIMP_RUN_INTERACTIVE)
       {
@@ -2340,12 +2442,16 @@ p_getbasenameWithoutDirpartPtr(char *basenamePtr)
  *     frame_000004.xcf            newname_000004.xcf
  *     frame_000005.xcf            newname_000005.xcf
  *
+ * the renames are executed as one transactional bulk rename
+ * (see gap_bulk_rename.c) after all new names were checked.
  */
 static gint32
 p_rename_frames(GapAnimInfo *ainfo_ptr, char *newBasenamePtr, gboolean doRename)
 {
   long l_fnr;
   gint l_errcount;
+  GapBulkRename *bren;
+  char *l_new_curr_name;
 
 
   if(ainfo_ptr->run_mode == GIMP_RUN_INTERACTIVE)
@@ -2360,6 +2466,9 @@ p_rename_frames(GapAnimInfo *ainfo_ptr, char *newBasenamePtr, gboolean doRename)
     }
   }
 
+  bren = gap_bulk_rename_new(ainfo_ptr->basename);
+  bren->do_progress = FALSE;
+  l_new_curr_name = NULL;
   l_errcount = 0;
   l_fnr = ainfo_ptr->first_frame_nr;
   while (l_fnr <= ainfo_ptr->last_frame_nr)
@@ -2414,20 +2523,15 @@ p_rename_frames(GapAnimInfo *ainfo_ptr, char *newBasenamePtr, gboolean doRename)
       {
         if (doRename == TRUE)
         {
-           gint l_rc;
-           
-           l_rc = g_rename(l_curr_name, l_new_name);
-	   gap_thumb_file_rename_thumbnail(l_curr_name, l_new_name);
-	   
+           if (!gap_bulk_rename_add(bren, l_curr_name, l_new_name))
+           {
+             l_errcount++;
+           }
            if (l_fnr == ainfo_ptr->curr_frame_nr)
            {
-             gimp_image_set_filename(ainfo_ptr->image_id, l_new_name);
+             g_free(l_new_curr_name);
+             l_new_curr_name = g_strdup(l_new_name);
            }
-	   
-	   if (l_rc != 0)
-	   {
-	     l_errcount++;
-	   }
         }
       }
       g_free(l_new_name);
@@ -2448,6 +2552,23 @@ p_rename_frames(GapAnimInfo *ainfo_ptr, char *newBasenamePtr, gboolean doRename)
     }
   }
   
+  if ((doRename == TRUE) && (l_errcount == 0))
+  {
+    if (0 == gap_bulk_rename_execute(bren))
+    {
+      if (l_new_curr_name != NULL)
+      {
+        gimp_image_set_filename(ainfo_ptr->image_id, l_new_curr_name);
+      }
+    }
+    else
+    {
+      l_errcount++;
+    }
+  }
+  gap_bulk_rename_free(bren);
+  g_free(l_new_curr_name);
+
   if (l_errcount > 0)
   {
     return (-1);
@@ -2529,7 +2650,8 @@ gap_base_rename(GimpRunMode run_mode, gint32 image_id,
   ainfo_ptr = gap_lib_alloc_ainfo(image_id, run_mode);
   if(ainfo_ptr != NULL)
   {
-    if (0 == gap_lib_dir_ainfo(ainfo_ptr))
+    if ((p_bulk_rename_check_journal(ainfo_ptr))
+    &&  (0 == gap_lib_dir_ainfo(ainfo_ptr)))
     {
       if(run_mode != GIMP_RUN_NONINTERACTIVE)
       {
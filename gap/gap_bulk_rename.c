@@ -0,0 +1,773 @@
+/*  gap_bulk_rename.c
+ *
+ *  GAP ... Gimp Animation Plugins
+ *
+ *  This module provides transactional bulk renaming of frame files.
+ *  All moves of one operation (renumber, rename, shift, reverse)
+ *  are collected as one permutation and executed with the minimum
+ *  number of renames. A journal file records the planned and completed
+ *  renames, so an interrupted operation can be rolled forward or back.
+ *
+ *  Journal file format (<basename>renjournal.gap):
+ *
+ *    # GIMP / GAP bulk rename journal
+ *    STEP<TAB>from_name<TAB>to_name      (one line per planned rename)
+ *    BEGIN                               (the step list is complete)
+ *    DONE<TAB>idx                        (step idx was renamed from -> to)
+ *    UNDO<TAB>idx                        (step idx was renamed back to -> from)
+ */
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026/10/18  agent: created
+ */
+
+#include "config.h"
+
+/* SYSTEM (UNIX) includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <glib/gstdio.h>
+
+/* GIMP includes */
+#include "libgimp/gimp.h"
+
+/* GAP includes */
+#include "gap_bulk_rename.h"
+#include "gap_thumbnail.h"
+
+extern int gap_debug;
+
+#define GAP_BREN_JOURNAL_HEADER   "# GIMP / GAP bulk rename journal"
+#define GAP_BREN_KEY_STEP         "STEP"
+#define GAP_BREN_KEY_BEGIN        "BEGIN"
+#define GAP_BREN_KEY_DONE         "DONE"
+#define GAP_BREN_KEY_UNDO         "UNDO"
+#define GAP_BREN_TMP_SUFFIX       ".gap_bren_tmp"
+#define GAP_BREN_PROGRESS_STEPS   64
+
+
+static void     p_free_move(gpointer data);
+static void     p_free_step(gpointer data);
+static void     p_add_step(GPtrArray *steps, const char *from_name, const char *to_name);
+static gchar   *p_alloc_tmp_name(GapBulkRename *bren, const char *name);
+static gboolean p_plan(GapBulkRename *bren);
+static FILE    *p_write_journal(GapBulkRename *bren);
+static void     p_journal_record(FILE *fp, const char *key, gint idx);
+static void     p_sync_journal(FILE *fp);
+static gint     p_rename_step(const char *from_name, const char *to_name);
+
+
+/* --------------------------------
+ * gap_bulk_rename_alloc_journal_name
+ * --------------------------------
+ * the caller should g_free the returned name after use
+ */
+char *
+gap_bulk_rename_alloc_journal_name(const char *basename)
+{
+  if(basename == NULL)
+  {
+    return(NULL);
+  }
+  return(g_strdup_printf("%srenjournal.gap", basename));
+}  /* end gap_bulk_rename_alloc_journal_name */
+
+
+/* --------------------------------
+ * gap_bulk_rename_journal_exists
+ * --------------------------------
+ * return TRUE if there is a journal of an interrupted bulk rename
+ * for the frames with the specified basename.
+ */
+gboolean
+gap_bulk_rename_journal_exists(const char *basename)
+{
+  char     *l_journal_name;
+  gboolean  l_exists;
+
+  l_journal_name = gap_bulk_rename_alloc_journal_name(basename);
+  if(l_journal_name == NULL)
+  {
+    return(FALSE);
+  }
+  l_exists = g_file_test(l_journal_name, G_FILE_TEST_EXISTS);
+  g_free(l_journal_name);
+
+  return(l_exists);
+}  /* end gap_bulk_rename_journal_exists */
+
+
+/* --------------------------------
+ * gap_bulk_rename_new
+ * --------------------------------
+ */
+GapBulkRename *
+gap_bulk_rename_new(const char *basename)
+{
+  GapBulkRename *bren;
+
+  bren = g_new0(GapBulkRename, 1);
+  bren->journal_name = gap_bulk_rename_alloc_journal_name(basename);
+  bren->moves = g_ptr_array_new();
+  bren->src_hash = g_hash_table_new(g_str_hash, g_str_equal);
+  bren->dst_hash = g_hash_table_new(g_str_hash, g_str_equal);
+  bren->steps = g_ptr_array_new();
+  bren->do_progress = FALSE;
+
+  return(bren);
+}  /* end gap_bulk_rename_new */
+
+
+/* --------------------------------
+ * gap_bulk_rename_add
+ * --------------------------------
+ * add one move from_name -> to_name.
+ * moves where from_name equals to_name are ignored.
+ * return FALSE if the move conflicts with an already added move
+ * (same source or same destination), because the moves
+ * would no longer describe a permutation.
+ */
+gboolean
+gap_bulk_rename_add(GapBulkRename *bren, const char *from_name, const char *to_name)
+{
+  GapBulkRenameMove *move;
+
+  if((bren == NULL) || (from_name == NULL) || (to_name == NULL))
+  {
+    return(FALSE);
+  }
+  if(strcmp(from_name, to_name) == 0)
+  {
+    return(TRUE);
+  }
+  if((g_hash_table_lookup(bren->src_hash, from_name) != NULL)
+  || (g_hash_table_lookup(bren->dst_hash, to_name) != NULL))
+  {
+    printf("gap_bulk_rename_add: conflicting move %s -> %s\n", from_name, to_name);
+    return(FALSE);
+  }
+
+  move = g_new0(GapBulkRenameMove, 1);
+  move->from_name = g_strdup(from_name);
+  move->to_name = g_strdup(to_name);
+  move->planned = FALSE;
+
+  g_ptr_array_add(bren->moves, move);
+  g_hash_table_insert(bren->src_hash, move->from_name, move);
+  g_hash_table_insert(bren->dst_hash, move->to_name, move);
+
+  return(TRUE);
+}  /* end gap_bulk_rename_add */
+
+
+/* --------------------------------
+ * p_free_move
+ * --------------------------------
+ */
+static void
+p_free_move(gpointer data)
+{
+  GapBulkRenameMove *move;
+
+  move = (GapBulkRenameMove *)data;
+  if(move != NULL)
+  {
+    g_free(move->from_name);
+    g_free(move->to_name);
+    g_free(move);
+  }
+}  /* end p_free_move */
+
+
+/* --------------------------------
+ * p_free_step
+ * --------------------------------
+ */
+static void
+p_free_step(gpointer data)
+{
+  GapBulkRenameStep *step;
+
+  step = (GapBulkRenameStep *)data;
+  if(step != NULL)
+  {
+    g_free(step->from_name);
+    g_free(step->to_name);
+    g_free(step);
+  }
+}  /* end p_free_step */
+
+
+/* --------------------------------
+ * gap_bulk_rename_free
+ * --------------------------------
+ */
+void
+gap_bulk_rename_free(GapBulkRename *bren)
+{
+  if(bren == NULL)
+  {
+    return;
+  }
+  g_hash_table_destroy(bren->src_hash);
+  g_hash_table_destroy(bren->dst_hash);
+  g_ptr_array_foreach(bren->moves, (GFunc)p_free_move, NULL);
+  g_ptr_array_free(bren->moves, TRUE);
+  g_ptr_array_foreach(bren->steps, (GFunc)p_free_step, NULL);
+  g_ptr_array_free(bren->steps, TRUE);
+  g_free(bren->journal_name);
+  g_free(bren);
+}  /* end gap_bulk_rename_free */
+
+
+/* --------------------------------
+ * p_add_step
+ * --------------------------------
+ */
+static void
+p_add_step(GPtrArray *steps, const char *from_name, const char *to_name)
+{
+  GapBulkRenameStep *step;
+
+  step = g_new(GapBulkRenameStep, 1);
+  step->from_name = g_strdup(from_name);
+  step->to_name = g_strdup(to_name);
+  g_ptr_array_add(steps, step);
+}  /* end p_add_step */
+
+
+/* --------------------------------
+ * p_alloc_tmp_name
+ * --------------------------------
+ * temporary names are built in the same directory as the
+ * frame itself, so that the renames stay atomic.
+ */
+static gchar *
+p_alloc_tmp_name(GapBulkRename *bren, const char *name)
+{
+  gchar *l_tmp_name;
+  gint   l_ii;
+
+  l_tmp_name = g_strdup_printf("%s%s", name, GAP_BREN_TMP_SUFFIX);
+  for(l_ii = 1; ; l_ii++)
+  {
+    if((!g_file_test(l_tmp_name, G_FILE_TEST_EXISTS))
+    && (g_hash_table_lookup(bren->dst_hash, l_tmp_name) == NULL))
+    {
+      break;
+    }
+    g_free(l_tmp_name);
+    l_tmp_name = g_strdup_printf("%s%s%d", name, GAP_BREN_TMP_SUFFIX, l_ii);
+  }
+  return(l_tmp_name);
+}  /* end p_alloc_tmp_name */
+
+
+/* --------------------------------
+ * p_plan
+ * --------------------------------
+ * decompose the permutation of all moves into chains and cycles
+ * and build the list of renames in execution order.
+ *
+ * chain   a -> b -> c -> d   (d is a free name)
+ *         renames: c->d, b->c, a->b
+ * cycle   a -> b -> c -> a
+ *         renames: a->tmp, c->a, b->c, tmp->b
+ *
+ * return FALSE if a source file is missing or a move would overwrite
+ * a file that is not part of the permutation.
+ */
+static gboolean
+p_plan(GapBulkRename *bren)
+{
+  GPtrArray *l_seq;
+  guint      l_idx;
+  gboolean   l_ok;
+
+  l_ok = TRUE;
+  l_seq = g_ptr_array_new();
+  bren->chain_count = 0;
+  bren->cycle_count = 0;
+
+  for(l_idx = 0; l_idx < bren->moves->len; l_idx++)
+  {
+    GapBulkRenameMove *move;
+    GapBulkRenameMove *cur;
+    GapBulkRenameMove *pred;
+    gboolean           l_is_cycle;
+    gint               l_ii;
+
+    move = g_ptr_array_index(bren->moves, l_idx);
+    if(move->planned)
+    {
+      continue;
+    }
+
+    /* walk back to the start of the chain (or around the cycle) */
+    l_is_cycle = FALSE;
+    cur = move;
+    while(TRUE)
+    {
+      pred = g_hash_table_lookup(bren->dst_hash, cur->from_name);
+      if(pred == NULL)
+      {
+        break;
+      }
+      if(pred == move)
+      {
+        l_is_cycle = TRUE;
+        break;
+      }
+      cur = pred;
+    }
+    if(l_is_cycle)
+    {
+      cur = move;
+    }
+
+    /* collect the sequence in forward direction */
+    g_ptr_array_set_size(l_seq, 0);
+    while(cur != NULL)
+    {
+      if(!g_file_test(cur->from_name, G_FILE_TEST_EXISTS))
+      {
+        printf("gap_bulk_rename: source file %s not found\n", cur->from_name);
+        l_ok = FALSE;
+      }
+      cur->planned = TRUE;
+      g_ptr_array_add(l_seq, cur);
+      cur = g_hash_table_lookup(bren->src_hash, cur->to_name);
+      if((l_is_cycle) && (cur == move))
+      {
+        break;
+      }
+    }
+
+    if(l_is_cycle)
+    {
+      GapBulkRenameMove *first;
+      gchar             *l_tmp_name;
+
+      bren->cycle_count++;
+      first = g_ptr_array_index(l_seq, 0);
+      l_tmp_name = p_alloc_tmp_name(bren, first->from_name);
+
+      p_add_step(bren->steps, first->from_name, l_tmp_name);
+      for(l_ii = l_seq->len -1; l_ii > 0; l_ii--)
+      {
+        cur = g_ptr_array_index(l_seq, l_ii);
+        p_add_step(bren->steps, cur->from_name, cur->to_name);
+      }
+      p_add_step(bren->steps, l_tmp_name, first->to_name);
+      g_free(l_tmp_name);
+    }
+    else
+    {
+      GapBulkRenameMove *last;
+
+      bren->chain_count++;
+      last = g_ptr_array_index(l_seq, l_seq->len -1);
+      if(g_file_test(last->to_name, G_FILE_TEST_EXISTS))
+      {
+        printf("gap_bulk_rename: destination file %s already exists\n", last->to_name);
+        l_ok = FALSE;
+      }
+      for(l_ii = l_seq->len -1; l_ii >= 0; l_ii--)
+      {
+        cur = g_ptr_array_index(l_seq, l_ii);
+        p_add_step(bren->steps, cur->from_name, cur->to_name);
+      }
+    }
+  }
+
+  g_ptr_array_free(l_seq, TRUE);
+  bren->rename_count = bren->steps->len;
+
+  if(gap_debug)
+  {
+    printf("gap_bulk_rename p_plan: moves:%d chains:%d cycles:%d renames:%d ok:%d\n"
+      , (int)bren->moves->len
+      , (int)bren->chain_count
+      , (int)bren->cycle_count
+      , (int)bren->rename_count
+      , (int)l_ok
+      );
+  }
+  return(l_ok);
+}  /* end p_plan */
+
+
+/* --------------------------------
+ * p_sync_journal
+ * --------------------------------
+ */
+static void
+p_sync_journal(FILE *fp)
+{
+  fflush(fp);
+#ifndef G_OS_WIN32
+  fsync(fileno(fp));
+#endif
+}  /* end p_sync_journal */
+
+
+/* --------------------------------
+ * p_journal_record
+ * --------------------------------
+ */
+static void
+p_journal_record(FILE *fp, const char *key, gint idx)
+{
+  if(fp != NULL)
+  {
+    fprintf(fp, "%s\t%d\n", key, (int)idx);
+    fflush(fp);
+  }
+}  /* end p_journal_record */
+
+
+/* --------------------------------
+ * p_write_journal
+ * --------------------------------
+ * write all planned steps to the journal file
+ * and return the journal filehandle (opened for appending records)
+ * or NULL if the journal could not be written.
+ */
+static FILE *
+p_write_journal(GapBulkRename *bren)
+{
+  FILE  *fp;
+  guint  l_idx;
+
+  if(bren->journal_name == NULL)
+  {
+    return(NULL);
+  }
+  fp = g_fopen(bren->journal_name, "w");
+  if(fp == NULL)
+  {
+    return(NULL);
+  }
+
+  fprintf(fp, "%s\n", GAP_BREN_JOURNAL_HEADER);
+  for(l_idx = 0; l_idx < bren->steps->len; l_idx++)
+  {
+    GapBulkRenameStep *step;
+
+    step = g_ptr_array_index(bren->steps, l_idx);
+    fprintf(fp, "%s\t%s\t%s\n", GAP_BREN_KEY_STEP, step->from_name, step->to_name);
+  }
+  fprintf(fp, "%s\n", GAP_BREN_KEY_BEGIN);
+  p_sync_journal(fp);
+
+  return(fp);
+}  /* end p_write_journal */
+
+
+/* --------------------------------
+ * p_rename_step
+ * --------------------------------
+ */
+static gint
+p_rename_step(const char *from_name, const char *to_name)
+{
+  gint l_rc;
+
+  if(gap_debug)
+  {
+    printf("DEBUG gap_bulk_rename: %s ..to.. %s\n", from_name, to_name);
+  }
+  l_rc = g_rename(from_name, to_name);
+  if(l_rc == 0)
+  {
+    gap_thumb_file_rename_thumbnail((char *)from_name, (char *)to_name);
+  }
+  return(l_rc);
+}  /* end p_rename_step */
+
+
+/* --------------------------------
+ * gap_bulk_rename_execute
+ * --------------------------------
+ * perform all collected moves.
+ * if one of the renames fails, all renames done so far are undone.
+ * the journal file is removed when the operation is complete
+ * (committed or rolled back).
+ *
+ * return 0 if all moves were done, -1 on errors.
+ */
+gint32
+gap_bulk_rename_execute(GapBulkRename *bren)
+{
+  FILE  *fp;
+  guint  l_idx;
+  gint   l_done;
+
+  if(bren == NULL)
+  {
+    return(-1);
+  }
+  if(bren->moves->len == 0)
+  {
+    return(0);
+  }
+  if(!p_plan(bren))
+  {
+    return(-1);
+  }
+
+  fp = p_write_journal(bren);
+  if(fp == NULL)
+  {
+    printf("gap_bulk_rename: could not write journal file %s\n"
+          , bren->journal_name == NULL ? "(null)" : bren->journal_name);
+    return(-1);
+  }
+
+  l_done = 0;
+  for(l_idx = 0; l_idx < bren->steps->len; l_idx++)
+  {
+    GapBulkRenameStep *step;
+
+    step = g_ptr_array_index(bren->steps, l_idx);
+    if(p_rename_step(step->from_name, step->to_name) != 0)
+    {
+      printf("gap_bulk_rename: could not rename %s to %s\n", step->from_name, step->to_name);
+      break;
+    }
+    p_journal_record(fp, GAP_BREN_KEY_DONE, l_idx);
+    l_done++;
+
+    if((bren->do_progress) && ((l_idx % GAP_BREN_PROGRESS_STEPS) == 0))
+    {
+      gimp_progress_update((gdouble)l_idx / (gdouble)bren->steps->len);
+    }
+  }
+
+  if(l_done < (gint)bren->steps->len)
+  {
+    gint l_ii;
+
+    /* rollback all steps done so far (in reverse order) */
+    for(l_ii = l_done -1; l_ii >= 0; l_ii--)
+    {
+      GapBulkRenameStep *step;
+
+      step = g_ptr_array_index(bren->steps, l_ii);
+      if(p_rename_step(step->to_name, step->from_name) != 0)
+      {
+        /* keep the journal for later recovery */
+        printf("gap_bulk_rename: rollback failed at %s, journal %s kept\n"
+              , step->to_name, bren->journal_name);
+        fclose(fp);
+        return(-1);
+      }
+      p_journal_record(fp, GAP_BREN_KEY_UNDO, l_ii);
+    }
+    fclose(fp);
+    g_remove(bren->journal_name);
+    return(-1);
+  }
+
+  fclose(fp);
+  g_remove(bren->journal_name);
+
+  if(bren->do_progress)
+  {
+    gimp_progress_update(1.0);
+  }
+
+  return(0);
+}  /* end gap_bulk_rename_execute */
+
+
+/* --------------------------------
+ * gap_bulk_rename_recover
+ * --------------------------------
+ * complete (roll_forward == TRUE) or undo (roll_forward == FALSE)
+ * an interrupted bulk rename operation, as recorded in the journal file
+ * for the frames with the specified basename.
+ * The journal is removed after successful recovery.
+ *
+ * return 0 if OK (or no journal present), -1 on errors.
+ */
+gint32
+gap_bulk_rename_recover(const char *basename, gboolean roll_forward)
+{
+  char      *l_journal_name;
+  gchar     *l_content;
+  gchar    **l_lines;
+  GPtrArray *l_steps;
+  FILE      *fp;
+  gboolean   l_begin;
+  gint       l_done;
+  gint       l_recorded;
+  gint       l_ii;
+  gint32     l_rc;
+
+  l_journal_name = gap_bulk_rename_alloc_journal_name(basename);
+  if(l_journal_name == NULL)
+  {
+    return(-1);
+  }
+  if(!g_file_get_contents(l_journal_name, &l_content, NULL, NULL))
+  {
+    g_free(l_journal_name);
+    return(0);
+  }
+
+  l_steps = g_ptr_array_new();
+  l_begin = FALSE;
+  l_done = 0;
+  l_lines = g_strsplit(l_content, "\n", -1);
+  for(l_ii = 0; l_lines[l_ii] != NULL; l_ii++)
+  {
+    gchar **l_fields;
+
+    l_fields = g_strsplit(l_lines[l_ii], "\t", 3);
+    if((l_fields[0] != NULL) && (l_fields[1] != NULL))
+    {
+      if((strcmp(l_fields[0], GAP_BREN_KEY_STEP) == 0) && (l_fields[2] != NULL))
+      {
+        p_add_step(l_steps, l_fields[1], l_fields[2]);
+      }
+      else if(strcmp(l_fields[0], GAP_BREN_KEY_DONE) == 0)
+      {
+        l_done = atoi(l_fields[1]) + 1;
+      }
+      else if(strcmp(l_fields[0], GAP_BREN_KEY_UNDO) == 0)
+      {
+        l_done = atoi(l_fields[1]);
+      }
+    }
+    else if((l_fields[0] != NULL) && (strcmp(l_fields[0], GAP_BREN_KEY_BEGIN) == 0))
+    {
+      l_begin = TRUE;
+    }
+    g_strfreev(l_fields);
+  }
+  g_strfreev(l_lines);
+  g_free(l_content);
+
+  l_rc = 0;
+  if(!l_begin)
+  {
+    /* the journal was not complete, no rename was done yet */
+    l_done = 0;
+    g_ptr_array_foreach(l_steps, (GFunc)p_free_step, NULL);
+    g_ptr_array_set_size(l_steps, 0);
+  }
+  l_done = CLAMP(l_done, 0, (gint)l_steps->len);
+
+  /* a rename may have been done without its record (crash between
+   * the rename and the journal write). a step that is not done yet
+   * always has its source file present; a step that is done (and not
+   * undone) always has its destination file present.
+   */
+  l_recorded = l_done;
+  if(l_done < (gint)l_steps->len)
+  {
+    GapBulkRenameStep *step;
+
+    step = g_ptr_array_index(l_steps, l_done);
+    if((!g_file_test(step->from_name, G_FILE_TEST_EXISTS))
+    && (g_file_test(step->to_name, G_FILE_TEST_EXISTS)))
+    {
+      l_done++;
+    }
+  }
+  if((l_done == l_recorded) && (l_done > 0))
+  {
+    GapBulkRenameStep *step;
+
+    step = g_ptr_array_index(l_steps, l_done -1);
+    if((!g_file_test(step->to_name, G_FILE_TEST_EXISTS))
+    && (g_file_test(step->from_name, G_FILE_TEST_EXISTS)))
+    {
+      l_done--;
+    }
+  }
+
+  if(gap_debug)
+  {
+    printf("gap_bulk_rename_recover: %s steps:%d done:%d roll_forward:%d\n"
+      , l_journal_name
+      , (int)l_steps->len
+      , (int)l_done
+      , (int)roll_forward
+      );
+  }
+
+  fp = g_fopen(l_journal_name, "a");
+  if(roll_forward)
+  {
+    for(l_ii = l_done; l_ii < (gint)l_steps->len; l_ii++)
+    {
+      GapBulkRenameStep *step;
+
+      step = g_ptr_array_index(l_steps, l_ii);
+      if(p_rename_step(step->from_name, step->to_name) != 0)
+      {
+        l_rc = -1;
+        break;
+      }
+      p_journal_record(fp, GAP_BREN_KEY_DONE, l_ii);
+    }
+  }
+  else
+  {
+    for(l_ii = l_done -1; l_ii >= 0; l_ii--)
+    {
+      GapBulkRenameStep *step;
+
+      step = g_ptr_array_index(l_steps, l_ii);
+      if(p_rename_step(step->to_name, step->from_name) != 0)
+      {
+        l_rc = -1;
+        break;
+      }
+      p_journal_record(fp, GAP_BREN_KEY_UNDO, l_ii);
+    }
+  }
+  if(fp != NULL)
+  {
+    fclose(fp);
+  }
+
+  if(l_rc == 0)
+  {
+    g_remove(l_journal_name);
+  }
+  else
+  {
+    printf("gap_bulk_rename_recover: recovery failed, journal %s kept\n", l_journal_name);
+  }
+
+  g_ptr_array_foreach(l_steps, (GFunc)p_free_step, NULL);
+  g_ptr_array_free(l_steps, TRUE);
+  g_free(l_journal_name);
+
+  return(l_rc);
+}  /* end gap_bulk_rename_recover */
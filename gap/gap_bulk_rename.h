@@ -0,0 +1,82 @@
+/*  gap_bulk_rename.h
+ *
+ *  GAP ... Gimp Animation Plugins
+ *
+ *  This module provides transactional bulk renaming of frame files.
+ *  (used for renumber, rename, shift and reverse of frame sequences)
+ */
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026/10/18  agent: created
+ */
+
+#ifndef _GAP_BULK_RENAME_H
+#define _GAP_BULK_RENAME_H
+
+#include "libgimp/gimp.h"
+
+/* a GapBulkRename collects all (from_name, to_name) moves of one operation.
+ * gap_bulk_rename_execute treats the moves as one permutation,
+ * decomposes it into chains and cycles and performs the minimum number
+ * of renames (chain of n moves: n renames, cycle of n moves: n+1 renames).
+ *
+ * all planned renames are written to a journal file (<basename>renjournal.gap)
+ * before the first rename is done, and each completed rename is recorded.
+ * an operation that was interrupted (crash, kill) can be completed
+ * or undone later via gap_bulk_rename_recover.
+ */
+
+typedef struct GapBulkRenameMove {
+  gchar     *from_name;
+  gchar     *to_name;
+  gboolean   planned;
+} GapBulkRenameMove;
+
+typedef struct GapBulkRenameStep {
+  gchar     *from_name;
+  gchar     *to_name;
+} GapBulkRenameStep;
+
+typedef struct GapBulkRename {
+  gchar      *journal_name;
+  GPtrArray  *moves;         /* of GapBulkRenameMove */
+  GHashTable *src_hash;      /* key: from_name, value: GapBulkRenameMove  (not owned) */
+  GHashTable *dst_hash;      /* key: to_name,   value: GapBulkRenameMove  (not owned) */
+  GPtrArray  *steps;         /* of GapBulkRenameStep (planned renames in execution order) */
+  gboolean    do_progress;   /* TRUE: report progress via gimp_progress_update */
+
+  /* statistics (valid after planning) */
+  gint32      chain_count;
+  gint32      cycle_count;
+  gint32      rename_count;
+} GapBulkRename;
+
+
+char          *gap_bulk_rename_alloc_journal_name(const char *basename);
+gboolean       gap_bulk_rename_journal_exists(const char *basename);
+
+GapBulkRename *gap_bulk_rename_new(const char *basename);
+gboolean       gap_bulk_rename_add(GapBulkRename *bren, const char *from_name, const char *to_name);
+gint32         gap_bulk_rename_execute(GapBulkRename *bren);
+void           gap_bulk_rename_free(GapBulkRename *bren);
+
+gint32         gap_bulk_rename_recover(const char *basename, gboolean roll_forward);
+
+#endif
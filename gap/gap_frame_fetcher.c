@@ -52,6 +52,8 @@
 /*
  * 2008.08.20  hof  - created (moved image cache stuff from gap_story_render_processing modules to this  new module)
  *                  - new feature:  caching of videohandles.
+ * 2026.10.18  agent  - new feature: parallel preload of png images via GdkPixbuf
+ *                      (gap_frame_fetch_preload_image)
  *
  */
 
@@ -74,6 +76,7 @@
 
 
 #include <glib/gstdio.h>
+#include <string.h>
 
 
 
@@ -161,6 +164,16 @@ typedef struct GapFFetchGvahandCache
 } GapFFetchGvahandCache;
 
 
+/* -------- types for the parallel image preload  ------- */
+
+typedef struct GapFFetchPreloadElem  /* nickname: pre */
+{
+   gchar     *filename;
+   GdkPixbuf *pixbuf;     /* decoded image, NULL if the worker could not decode the file */
+   gboolean   done;       /* TRUE when the worker thread has finished (protected by preloadMutex) */
+} GapFFetchPreloadElem;
+
+
 
 extern int gap_debug;  /* 1 == print debug infos , 0 dont print debug infos */
 
@@ -173,6 +186,14 @@ static GapFFetchGvahandCache *global_gvcache = NULL;
 
 static GapFFetchResourceUserElem *global_rsource_users = NULL;
 
+/* the preload table and its worker threads are used by the main thread only,
+ * the workers access their own GapFFetchPreloadElem (done flag under preloadMutex)
+ */
+static GThreadPool *preloadThreadPool = NULL;
+static GHashTable  *preloadTable = NULL;      /* filename -> GapFFetchPreloadElem */
+static GMutex      *preloadMutex = NULL;
+static GCond       *preloadDoneCond = NULL;
+
 
 /*************************************************************
  *         FRAME FETCHER procedures                          *
@@ -204,6 +225,13 @@ static t_GVA_Handle*  p_ffetch_get_open_gvahand(const char* filename, gint32 sel
 
 static void           p_add_image_to_list_of_duplicated_images(gint32 image_id, gint32 ffetch_user_id);
 
+static gboolean       p_is_plain_rgb_png(const char *filename);
+static void           p_preload_worker_thread(GapFFetchPreloadElem *pre, gpointer data);
+static void           p_preload_wait_done(GapFFetchPreloadElem *pre);
+static void           p_preload_free_elem(GapFFetchPreloadElem *pre);
+static gint32         p_create_image_from_pixbuf(const char *filename, GdkPixbuf *pixbuf);
+static gint32         p_load_image(const char *filename);
+
 static gint32 p_get_ffetch_max_img_cache_elements();
 static gint32 p_get_ffetch_max_gvc_cache_elements();
 static gint32 p_get_ffetch_gva_frames_to_keep_cached();
@@ -465,6 +493,260 @@ p_find_cache_image(const char* filename, gint32 ffetch_user_id
 
 
 
+/* ----------------------------------------------------
+ * p_is_plain_rgb_png
+ * ----------------------------------------------------
+ * check the header chunks of a png file.
+ * returns TRUE for 8 or 16 bit RGB and RGBA png files without layer offsets.
+ * For those files decoding via GdkPixbuf delivers the same pixels
+ * as the gimp png loader (both use libpng with 16 bit stripped and tRNS expanded).
+ * Indexed and grayscale png files are loaded as INDEXED or GRAY images by gimp
+ * and are further processed in that mode, therefore they are not preloaded.
+ */
+static gboolean
+p_is_plain_rgb_png(const char *filename)
+{
+  static const guchar pngSignature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+  FILE     *fp;
+  guchar    buf[25];
+  gboolean  isPlainRgb;
+  gint      ii;
+
+  fp = g_fopen(filename, "rb");
+  if(fp == NULL)
+  {
+    return (FALSE);
+  }
+
+  isPlainRgb = FALSE;
+
+  /* signature (8 bytes), IHDR length and type (8 bytes) and IHDR data (13 bytes) */
+  if((fread(buf, 1, 8, fp) == 8)
+  && (memcmp(buf, pngSignature, 8) == 0)
+  && (fread(buf, 1, 21, fp) == 21)
+  && (memcmp(&buf[4], "IHDR", 4) == 0))
+  {
+    guchar bitDepth;
+    guchar colorType;
+
+    bitDepth  = buf[16];
+    colorType = buf[17];
+    if(((bitDepth == 8) || (bitDepth == 16))
+    && ((colorType == 2) || (colorType == 6)))  /* RGB or RGBA */
+    {
+      /* skip IHDR crc and check the chunks up to the 1st IDAT chunk */
+      fseek(fp, 4, SEEK_CUR);
+      for(ii = 0; ii < 1000; ii++)
+      {
+        guint32 chunkLength;
+
+        if(fread(buf, 1, 8, fp) != 8)
+        {
+          break;
+        }
+        if(memcmp(&buf[4], "IDAT", 4) == 0)
+        {
+          isPlainRgb = TRUE;
+          break;
+        }
+        if(memcmp(&buf[4], "oFFs", 4) == 0)
+        {
+          /* the gimp loader sets layer offsets */
+          break;
+        }
+        chunkLength = ((guint32)buf[0] << 24) | ((guint32)buf[1] << 16)
+                    | ((guint32)buf[2] << 8)  |  (guint32)buf[3];
+        if(fseek(fp, (long)chunkLength + 4, SEEK_CUR) != 0)
+        {
+          break;
+        }
+      }
+    }
+  }
+
+  fclose(fp);
+  return (isPlainRgb);
+
+}  /* end p_is_plain_rgb_png */
+
+
+/* ----------------------------------------------------
+ * p_preload_worker_thread
+ * ----------------------------------------------------
+ * decode the image file of the preload element via GdkPixbuf.
+ * Note: this runs as thread and must not call the gimp PDB.
+ */
+static void
+p_preload_worker_thread(GapFFetchPreloadElem *pre, gpointer data)
+{
+  GdkPixbuf *pixbuf;
+
+  pixbuf = NULL;
+  if(p_is_plain_rgb_png(pre->filename))
+  {
+    pixbuf = gdk_pixbuf_new_from_file(pre->filename, NULL);
+    if(pixbuf != NULL)
+    {
+      if((gdk_pixbuf_get_bits_per_sample(pixbuf) != 8)
+      || (gdk_pixbuf_get_colorspace(pixbuf) != GDK_COLORSPACE_RGB))
+      {
+        g_object_unref(pixbuf);
+        pixbuf = NULL;
+      }
+    }
+  }
+
+  g_mutex_lock(preloadMutex);
+  pre->pixbuf = pixbuf;
+  pre->done = TRUE;
+  g_cond_broadcast(preloadDoneCond);
+  g_mutex_unlock(preloadMutex);
+
+}  /* end p_preload_worker_thread */
+
+
+/* ----------------------------------------------------
+ * p_preload_wait_done
+ * ----------------------------------------------------
+ */
+static void
+p_preload_wait_done(GapFFetchPreloadElem *pre)
+{
+  g_mutex_lock(preloadMutex);
+  while(pre->done != TRUE)
+  {
+    g_cond_wait(preloadDoneCond, preloadMutex);
+  }
+  g_mutex_unlock(preloadMutex);
+
+}  /* end p_preload_wait_done */
+
+
+/* ----------------------------------------------------
+ * p_preload_free_elem
+ * ----------------------------------------------------
+ * free a preload element (the worker must have finished)
+ */
+static void
+p_preload_free_elem(GapFFetchPreloadElem *pre)
+{
+  if(pre->pixbuf != NULL)
+  {
+    g_object_unref(pre->pixbuf);
+  }
+  g_free(pre->filename);
+  g_free(pre);
+
+}  /* end p_preload_free_elem */
+
+
+/* ----------------------------------------------------
+ * p_create_image_from_pixbuf
+ * ----------------------------------------------------
+ * create a gimp image with one layer (named Background like the gimp png loader does)
+ * from the decoded pixbuf.
+ */
+static gint32
+p_create_image_from_pixbuf(const char *filename, GdkPixbuf *pixbuf)
+{
+  GimpDrawable *drawable;
+  GimpPixelRgn  dstPR;
+  gint32        image_id;
+  gint32        layer_id;
+  gint32        width;
+  gint32        height;
+  gint32        bpp;
+  gint32        rowstride;
+  guchar       *pixels;
+
+  width = gdk_pixbuf_get_width(pixbuf);
+  height = gdk_pixbuf_get_height(pixbuf);
+  bpp = gdk_pixbuf_get_n_channels(pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+  pixels = gdk_pixbuf_get_pixels(pixbuf);
+
+  image_id = gimp_image_new(width, height, GIMP_RGB);
+  if(image_id < 0)
+  {
+    return (-1);
+  }
+  layer_id = gimp_layer_new(image_id, "Background"
+                           , width, height
+                           , (bpp == 4) ? GIMP_RGBA_IMAGE : GIMP_RGB_IMAGE
+                           , 100.0
+                           , GIMP_NORMAL_MODE
+                           );
+  gimp_image_insert_layer(image_id, layer_id, 0, 0);
+
+  drawable = gimp_drawable_get(layer_id);
+  gimp_pixel_rgn_init(&dstPR, drawable, 0, 0, width, height, TRUE, FALSE);
+  if(rowstride == width * bpp)
+  {
+    gimp_pixel_rgn_set_rect(&dstPR, pixels, 0, 0, width, height);
+  }
+  else
+  {
+    gint32 row;
+
+    for(row = 0; row < height; row++)
+    {
+      gimp_pixel_rgn_set_row(&dstPR, pixels + (row * rowstride), 0, row, width);
+    }
+  }
+  gimp_drawable_flush(drawable);
+  gimp_drawable_detach(drawable);
+
+  gimp_image_set_filename(image_id, filename);
+
+  return (image_id);
+
+}  /* end p_create_image_from_pixbuf */
+
+
+/* ----------------------------------------------------
+ * p_load_image
+ * ----------------------------------------------------
+ * load the image from the preload table when it was
+ * preloaded via gap_frame_fetch_preload_image
+ * (waits until the worker thread has decoded the image)
+ * or from file via gimp loader plug-in.
+ */
+static gint32
+p_load_image(const char *filename)
+{
+  GapFFetchPreloadElem *pre;
+  gint32                l_image_id;
+
+  l_image_id = -1;
+  if(preloadTable != NULL)
+  {
+    pre = g_hash_table_lookup(preloadTable, filename);
+    if(pre != NULL)
+    {
+      g_hash_table_remove(preloadTable, filename);
+      p_preload_wait_done(pre);
+      if(pre->pixbuf != NULL)
+      {
+        l_image_id = p_create_image_from_pixbuf(filename, pre->pixbuf);
+        if(gap_debug)
+        {
+          printf("FrameFetcher: took preloaded image:%s (image_id:%d)\n"
+            , filename, (int)l_image_id);
+        }
+      }
+      p_preload_free_elem(pre);
+    }
+  }
+
+  if(l_image_id < 0)
+  {
+    l_image_id = gap_lib_load_image((char *)filename);
+  }
+  return (l_image_id);
+
+}  /* end p_load_image */
+
+
 /* ----------------------------------------------------
  * p_load_image_and_add_to_cache
  * ----------------------------------------------------
@@ -494,7 +776,7 @@ p_load_image_and_add_to_cache(const char* filename, gint32 ffetch_user_id
   }
 
   l_filename = g_strdup(filename);
-  l_image_id = gap_lib_load_image(l_filename);
+  l_image_id = p_load_image(l_filename);
   if(gap_debug)
   {
     printf("FrameFetcher: loaded image from disk:%s (image_id:%d) pid:%d\n"
@@ -1423,6 +1705,132 @@ gap_frame_fetch_dup_video(gint32 ffetch_user_id
 }  /* end gap_frame_fetch_dup_video */
 
 
+/* -------------------------------------------------
+ * gap_frame_fetch_preload_image
+ * -------------------------------------------------
+ * start decoding of the specified image file in a parallel worker thread.
+ * A following fetch of this image (that is not already cached)
+ * takes the decoded pixels instead of loading the file again.
+ * This is done only for RGB png files, where GdkPixbuf delivers the same pixels
+ * as the gimp loader (other files are loaded via gimp at fetch time as usual).
+ * The caller must have initialized the thread system (gap_base_thread_init)
+ * and shall call gap_frame_fetch_preload_drop when the preloaded images
+ * are no longer expected to be fetched.
+ */
+void
+gap_frame_fetch_preload_image(gint32 ffetch_user_id, const char *filename)
+{
+  GapFFetchPreloadElem *pre;
+  GapImageChacheInfo    gapImageChacheInfo;
+  gint32                originalWidth;
+  gint32                originalHeight;
+  gint                  l_len;
+
+  if(filename == NULL)
+  {
+    return;
+  }
+  l_len = strlen(filename);
+  if((l_len < 4)
+  || (g_ascii_strcasecmp(&filename[l_len - 4], ".png") != 0))
+  {
+    return;
+  }
+  if(preloadTable != NULL)
+  {
+    if(g_hash_table_lookup(preloadTable, filename) != NULL)
+    {
+      return;
+    }
+  }
+
+  /* no preload for images that are already cached in any variant */
+  if((p_find_cache_image(filename, ffetch_user_id
+                        , GAP_IMAGE_CACHE_TYPE_ORIGINAL_SIZE
+                        , &gapImageChacheInfo
+                        , &originalWidth, &originalHeight) >= 0)
+  || (p_find_cache_image(filename, ffetch_user_id
+                        , GAP_IMAGE_CACHE_TYPE_PRESCALE_ENABLED
+                        , &gapImageChacheInfo
+                        , &originalWidth, &originalHeight) >= 0))
+  {
+    return;
+  }
+  if(!g_file_test(filename, G_FILE_TEST_EXISTS))
+  {
+    return;
+  }
+
+  if(preloadThreadPool == NULL)
+  {
+    GError *error = NULL;
+
+    preloadMutex = g_mutex_new();
+    preloadDoneCond = g_cond_new();
+    preloadTable = g_hash_table_new(g_str_hash, g_str_equal);
+    preloadThreadPool = g_thread_pool_new((GFunc)p_preload_worker_thread
+                                         ,NULL        /* user data */
+                                         ,MAX(1, gap_base_get_numProcessors())  /* max_threads */
+                                         ,FALSE       /* exclusive */
+                                         ,&error      /* GError **error */
+                                         );
+    if (preloadThreadPool == NULL)
+    {
+      printf("** ERROR could not create preloadThreadPool\n");
+      return;
+    }
+  }
+
+  pre = g_new0(GapFFetchPreloadElem, 1);
+  pre->filename = g_strdup(filename);
+  pre->pixbuf = NULL;
+  pre->done = FALSE;
+  g_hash_table_insert(preloadTable, pre->filename, pre);
+  g_thread_pool_push(preloadThreadPool, pre, NULL);
+
+  if(gap_debug)
+  {
+    printf("gap_frame_fetch_preload_image: %s\n", filename);
+  }
+
+}  /* end gap_frame_fetch_preload_image */
+
+
+/* -------------------------------------------------
+ * p_preload_drop_elem
+ * -------------------------------------------------
+ */
+static gboolean
+p_preload_drop_elem(gpointer key, gpointer value, gpointer user_data)
+{
+  GapFFetchPreloadElem *pre;
+
+  pre = (GapFFetchPreloadElem *)value;
+  p_preload_wait_done(pre);
+  p_preload_free_elem(pre);
+
+  return (TRUE);  /* remove from the table */
+
+}  /* end p_preload_drop_elem */
+
+
+/* -------------------------------------------------
+ * gap_frame_fetch_preload_drop
+ * -------------------------------------------------
+ * drop all preloaded images that were not fetched
+ * (waits for worker threads that are still decoding)
+ */
+void
+gap_frame_fetch_preload_drop(void)
+{
+  if(preloadTable != NULL)
+  {
+    g_hash_table_foreach_remove(preloadTable, p_preload_drop_elem, NULL);
+  }
+
+}  /* end gap_frame_fetch_preload_drop */
+
+
 /* -------------------------------------------------
  * gap_frame_fetch_drop_resources
  * -------------------------------------------------
@@ -1432,6 +1840,7 @@ gap_frame_fetch_dup_video(gint32 ffetch_user_id
 void
 gap_frame_fetch_drop_resources()
 {
+  gap_frame_fetch_preload_drop();
   gap_frame_fetch_delete_list_of_duplicated_images(-1);
 
   p_drop_image_cache();
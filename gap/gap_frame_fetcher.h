@@ -187,6 +187,25 @@ void
 gap_frame_fetch_remove_parasite(gint32 image_id);
 
 
+/* -------------------------------------------------
+ * gap_frame_fetch_preload_image
+ * -------------------------------------------------
+ * start decoding of the specified (RGB png) image file in a parallel
+ * worker thread. a following fetch takes the decoded image
+ * instead of loading the file.
+ */
+void
+gap_frame_fetch_preload_image(gint32 ffetch_user_id, const char *filename);
+
+/* -------------------------------------------------
+ * gap_frame_fetch_preload_drop
+ * -------------------------------------------------
+ * drop all preloaded images that were not fetched.
+ */
+void
+gap_frame_fetch_preload_drop(void);
+
+
 /* ----------------------------------------------------
  * gap_frame_fetch_dump_resources
  * ----------------------------------------------------
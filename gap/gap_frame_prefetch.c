@@ -0,0 +1,349 @@
+/*  gap_frame_prefetch.c
+ *
+ *  GAP ... Gimp Animation Plugins
+ *
+ *  This module provides bounded read-ahead of frame files
+ *  in a worker thread. Range operations that handle many frames
+ *  (convert, flatten, scale, resize, crop) spend a big part of their
+ *  time waiting for the disk while loading the next frame.
+ *  The worker reads the files of the next frames (up to a configurable
+ *  number of frames ahead) so that the following gimp load operation
+ *  is served from the filesystem cache.
+ *
+ *  Note that the libgimp PDB interface is not thread save,
+ *  therefore the worker thread does not make any gimp calls.
+ */
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026/10/18  agent: created
+ */
+
+#include "config.h"
+
+/* SYSTEM (UNIX) includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+/* GIMP includes */
+#include "libgimp/gimp.h"
+
+/* GAP includes */
+#include "gap_frame_prefetch.h"
+#include "gap_lib.h"
+#include "gap_base.h"
+
+extern int gap_debug;
+
+#define PREFETCH_READ_BUFFER_SIZE  (256 * 1024)
+
+typedef struct GapFramePrefetchRequest {
+  gchar   *filename;
+  long     frame_nr;
+} GapFramePrefetchRequest;
+
+/* the stop request for the worker thread
+ * (GAsyncQueue does not accept NULL pointers)
+ */
+static GapFramePrefetchRequest  stopRequest = { NULL, 0 };
+
+
+static void      p_free_request(GapFramePrefetchRequest *req);
+static void      p_read_file(GapFramePrefetch *pref, const char *filename, guchar *buffer);
+static gpointer  p_prefetch_worker_thread(GapFramePrefetch *pref);
+
+
+/* ---------------------------------
+ * p_free_request
+ * ---------------------------------
+ */
+static void
+p_free_request(GapFramePrefetchRequest *req)
+{
+  if((req != NULL) && (req != &stopRequest))
+  {
+    g_free(req->filename);
+    g_free(req);
+  }
+}  /* end p_free_request */
+
+
+/* ---------------------------------
+ * p_read_file
+ * ---------------------------------
+ * read the whole file (the data is dropped, the only purpose
+ * is to get the file into the filesystem cache).
+ * missing files are silently ignored.
+ */
+static void
+p_read_file(GapFramePrefetch *pref, const char *filename, guchar *buffer)
+{
+  FILE   *fp;
+  size_t  l_len;
+  gint64  l_bytes;
+
+  fp = g_fopen(filename, "rb");
+  if(fp == NULL)
+  {
+    return;
+  }
+
+  l_bytes = 0;
+  while(g_atomic_int_get(&pref->cancel) == 0)
+  {
+    l_len = fread(buffer, 1, PREFETCH_READ_BUFFER_SIZE, fp);
+    if(l_len == 0)
+    {
+      break;
+    }
+    l_bytes += l_len;
+  }
+  fclose(fp);
+
+  pref->bytes_read += l_bytes;
+  g_atomic_int_inc(&pref->files_read);
+
+}  /* end p_read_file */
+
+
+/* ---------------------------------
+ * p_prefetch_worker_thread
+ * ---------------------------------
+ * process prefetch requests until the stop request is received.
+ */
+static gpointer
+p_prefetch_worker_thread(GapFramePrefetch *pref)
+{
+  guchar *buffer;
+
+  buffer = g_malloc(PREFETCH_READ_BUFFER_SIZE);
+  while(TRUE)
+  {
+    GapFramePrefetchRequest *req;
+
+    req = (GapFramePrefetchRequest *)g_async_queue_pop(pref->queue);
+    if(req == &stopRequest)
+    {
+      break;
+    }
+    if((g_atomic_int_get(&pref->cancel) == 0)
+    && (((req->frame_nr - g_atomic_int_get(&pref->cur_frame_nr)) * pref->step) > 0))
+    {
+      /* read only frames that the caller has not loaded yet */
+      p_read_file(pref, req->filename, buffer);
+      if(gap_debug)
+      {
+        printf("p_prefetch_worker_thread: prefetched frame:%d %s\n"
+          , (int)req->frame_nr
+          , req->filename
+          );
+      }
+    }
+    p_free_request(req);
+  }
+  g_free(buffer);
+
+  return (NULL);
+}  /* end p_prefetch_worker_thread */
+
+
+/* ---------------------------------
+ * gap_frame_prefetch_get_gimprc_count
+ * ---------------------------------
+ * get the configured number of frames to prefetch
+ * (gimprc parameter video-frame-prefetch-count, 0 turns prefetch off)
+ */
+gint32
+gap_frame_prefetch_get_gimprc_count(void)
+{
+  return (gap_base_get_gimprc_int_value(GAP_GIMPRC_VIDEO_FRAME_PREFETCH_COUNT
+                                       , GAP_FRAME_PREFETCH_DEFAULT_COUNT
+                                       , 0
+                                       , GAP_FRAME_PREFETCH_MAX_COUNT
+                                       ));
+}  /* end gap_frame_prefetch_get_gimprc_count */
+
+
+/* ---------------------------------
+ * gap_frame_prefetch_new
+ * ---------------------------------
+ * create a prefetch worker for the frames begin_frame_nr upto end_frame_nr
+ * (descending order if begin_frame_nr > end_frame_nr).
+ * The frame begin_frame_nr itself is not prefetched, because
+ * the caller is expected to load it immediately.
+ *
+ * returns NULL if max_in_flight < 1 or in case thread support is not available.
+ * (all other gap_frame_prefetch procedures accept NULL and do nothing
+ * in that case, so the caller simply runs sequential)
+ */
+GapFramePrefetch *
+gap_frame_prefetch_new(const char *basename, const char *extension
+                      , long begin_frame_nr, long end_frame_nr
+                      , gint32 max_in_flight)
+{
+  GapFramePrefetch *pref;
+  GError           *error = NULL;
+
+  if((max_in_flight < 1) || (basename == NULL) || (begin_frame_nr == end_frame_nr))
+  {
+    return (NULL);
+  }
+  if(!gap_base_thread_init())
+  {
+    return (NULL);
+  }
+
+  pref = g_new0(GapFramePrefetch, 1);
+  pref->basename = g_strdup(basename);
+  pref->extension = g_strdup(extension);
+  pref->step = (begin_frame_nr > end_frame_nr) ? -1 : 1;
+  pref->limit_frame_nr = end_frame_nr;
+  pref->next_frame_nr = begin_frame_nr + pref->step;
+  pref->max_in_flight = MIN(max_in_flight, GAP_FRAME_PREFETCH_MAX_COUNT);
+  pref->queue = g_async_queue_new();
+
+  pref->thread = g_thread_create((GThreadFunc)p_prefetch_worker_thread
+                                , pref      /* data */
+                                , TRUE      /* joinable */
+                                , &error
+                                );
+  if(pref->thread == NULL)
+  {
+    printf("gap_frame_prefetch_new: could not create prefetch thread %s\n"
+          , (error != NULL) ? error->message : ""
+          );
+    if(error != NULL)
+    {
+      g_error_free(error);
+    }
+    g_async_queue_unref(pref->queue);
+    g_free(pref->basename);
+    g_free(pref->extension);
+    g_free(pref);
+    return (NULL);
+  }
+
+  if(gap_debug)
+  {
+    printf("gap_frame_prefetch_new: from:%d to:%d max_in_flight:%d\n"
+      , (int)begin_frame_nr
+      , (int)end_frame_nr
+      , (int)pref->max_in_flight
+      );
+  }
+
+  gap_frame_prefetch_advance(pref, begin_frame_nr);
+
+  return (pref);
+}  /* end gap_frame_prefetch_new */
+
+
+/* ---------------------------------
+ * gap_frame_prefetch_advance
+ * ---------------------------------
+ * the caller is now handling cur_frame_nr.
+ * Request prefetch of all frames within the window
+ * (cur_frame_nr, cur_frame_nr + max_in_flight] that were not requested yet.
+ * gaps in the frame sequence (missing files) are handled by the worker
+ * that simply skips files that do not exist.
+ */
+void
+gap_frame_prefetch_advance(GapFramePrefetch *pref, long cur_frame_nr)
+{
+  if(pref == NULL)
+  {
+    return;
+  }
+
+  g_atomic_int_set(&pref->cur_frame_nr, cur_frame_nr);
+
+  /* frames at or behind the current frame are no longer worth to be requested */
+  if(((pref->next_frame_nr - cur_frame_nr) * pref->step) <= 0)
+  {
+    pref->next_frame_nr = cur_frame_nr + pref->step;
+  }
+
+  while((((pref->next_frame_nr - cur_frame_nr) * pref->step) <= pref->max_in_flight)
+  &&    (((pref->limit_frame_nr - pref->next_frame_nr) * pref->step) >= 0))
+  {
+    GapFramePrefetchRequest *req;
+
+    req = g_new(GapFramePrefetchRequest, 1);
+    req->frame_nr = pref->next_frame_nr;
+    req->filename = gap_lib_alloc_fname(pref->basename
+                                       , pref->next_frame_nr
+                                       , pref->extension
+                                       );
+    if(req->filename != NULL)
+    {
+      g_async_queue_push(pref->queue, req);
+    }
+    else
+    {
+      g_free(req);
+    }
+    pref->next_frame_nr += pref->step;
+  }
+
+}  /* end gap_frame_prefetch_advance */
+
+
+/* ---------------------------------
+ * gap_frame_prefetch_free
+ * ---------------------------------
+ * stop the worker thread (pending requests are dropped),
+ * wait until it has finished and free all resources.
+ */
+void
+gap_frame_prefetch_free(GapFramePrefetch *pref)
+{
+  GapFramePrefetchRequest *req;
+
+  if(pref == NULL)
+  {
+    return;
+  }
+
+  g_atomic_int_set(&pref->cancel, 1);
+  g_async_queue_push(pref->queue, &stopRequest);
+  g_thread_join(pref->thread);
+
+  /* drop requests that were not processed (none expected after the stop request) */
+  while((req = (GapFramePrefetchRequest *)g_async_queue_try_pop(pref->queue)) != NULL)
+  {
+    p_free_request(req);
+  }
+  g_async_queue_unref(pref->queue);
+
+  if(gap_debug)
+  {
+    printf("gap_frame_prefetch_free: files_read:%d bytes_read:%.0f\n"
+      , (int)g_atomic_int_get(&pref->files_read)
+      , (double)pref->bytes_read
+      );
+  }
+
+  g_free(pref->basename);
+  g_free(pref->extension);
+  g_free(pref);
+
+}  /* end gap_frame_prefetch_free */
@@ -0,0 +1,77 @@
+/*  gap_frame_prefetch.h
+ *
+ *  GAP ... Gimp Animation Plugins
+ *
+ *  This module provides bounded read-ahead of frame files
+ *  in a worker thread (used to overlap disk I/O with frame processing
+ *  in range operations that load, process and save many frames).
+ */
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026/10/18  agent: created
+ */
+
+#ifndef _GAP_FRAME_PREFETCH_H
+#define _GAP_FRAME_PREFETCH_H
+
+#include "libgimp/gimp.h"
+
+#define GAP_GIMPRC_VIDEO_FRAME_PREFETCH_COUNT   "video-frame-prefetch-count"
+#define GAP_FRAME_PREFETCH_DEFAULT_COUNT        4
+#define GAP_FRAME_PREFETCH_MAX_COUNT            64
+
+/* a GapFramePrefetch reads the files of upcoming frames in a worker thread
+ * while the main thread (the only one that talks to the gimp core via PDB)
+ * loads, processes and saves the current frame.
+ * The prefetch only warms the filesystem cache, all PDB calls,
+ * the frame order and the error handling remain in the calling thread.
+ *
+ * The caller advances the prefetch window via gap_frame_prefetch_advance
+ * once per handled frame. At most max_in_flight frames ahead of the
+ * current frame are requested at any time.
+ */
+typedef struct GapFramePrefetch {
+  gchar        *basename;
+  gchar        *extension;
+  long          step;              /* +1 ascending, -1 descending */
+  long          limit_frame_nr;    /* last frame number to prefetch (inclusive) */
+  long          next_frame_nr;     /* next frame number to request */
+  gint32        max_in_flight;
+
+  GAsyncQueue  *queue;             /* of gchar* filenames, NULL is the stop request */
+  GThread      *thread;
+  volatile gint cancel;            /* set to 1 to make the worker drop pending requests */
+  volatile gint cur_frame_nr;      /* frame currently handled by the caller */
+
+  /* statistics (updated by the worker thread) */
+  volatile gint files_read;
+  gint64        bytes_read;
+} GapFramePrefetch;
+
+
+gint32             gap_frame_prefetch_get_gimprc_count(void);
+
+GapFramePrefetch  *gap_frame_prefetch_new(const char *basename, const char *extension
+                      , long begin_frame_nr, long end_frame_nr
+                      , gint32 max_in_flight);
+void               gap_frame_prefetch_advance(GapFramePrefetch *pref, long cur_frame_nr);
+void               gap_frame_prefetch_free(GapFramePrefetch *pref);
+
+#endif
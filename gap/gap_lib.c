@@ -26,6 +26,12 @@
  */
 
 /* revision history:
+ * 2.8.xx   2026/10/18   agent: automatic onionskin creation keeps reference frames
+ *                              in the persistent gap_onion_cache and prefetches the
+ *                              reference frames for the next step in navigation direction
+ * 2.8.xx   2026/10/18   agent: added gap_lib_file_copy_fast (tries reflink and optional hardlink before
+ *                              copying file contents), gap_lib_save_named_frame breaks hardlinks
+ *                              before writing (copy on write)
  * 2.1.0a   2005/03/10   hof: added active_layer_tracking feature
  * 2.1.0a   2004/12/04   hof: added gap_lib (base)_shorten_filename
  * 2.1.0a   2004/04/18   hof: added gap_lib (base)_fprintf_gdouble
@@ -96,9 +102,14 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <fcntl.h>
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/fs.h>           /* for FICLONE */
+#endif
 
 #include <glib/gstdio.h>
 
@@ -131,6 +142,7 @@
 #include "gap_lock.h"
 #include "gap_navi_activtable.h"
 #include "gap_onion_base.h"
+#include "gap_onion_cache.h"
 #include "gap_pdb_calls.h"
 #include "gap_thumbnail.h"
 #include "gap_vin.h"
@@ -795,6 +807,267 @@ gap_lib_image_file_copy(char *fname, char *fname_copy)
    return(l_rc);
 }
 
+/* ============================================================================
+ * gap_lib_image_file_copy_fast
+ *    (copy the imagefile and its thumbnail,
+ *     using the fastest available copy strategy, see gap_lib_file_copy_fast)
+ * ============================================================================
+ */
+int
+gap_lib_image_file_copy_fast(char *fname, char *fname_copy, GapLibCopyStrategy *strategy_used)
+{
+   int            l_rc;
+
+   l_rc = gap_lib_file_copy_fast(fname, fname_copy, strategy_used);
+   gap_thumb_file_copy_thumbnail(fname, fname_copy);
+   return(l_rc);
+}
+
+/* ------------------------------------
+ * gap_lib_copy_strategy_name
+ * ------------------------------------
+ */
+const char *
+gap_lib_copy_strategy_name(GapLibCopyStrategy strategy)
+{
+  switch(strategy)
+  {
+    case GAP_LIB_COPY_REFLINK:   return("reflink");
+    case GAP_LIB_COPY_HARDLINK:  return("hardlink");
+    case GAP_LIB_COPY_PLAIN:     return("copy");
+    default:                     break;
+  }
+  return("failed");
+}  /* end gap_lib_copy_strategy_name */
+
+/* ------------------------------------
+ * p_get_copy_strategy_gimprc
+ * ------------------------------------
+ * the gimprc option video-frame-copy-strategy selects the allowed strategies
+ *   "auto"     try reflink, then plain copy (default)
+ *   "reflink"  same as "auto"
+ *   "hardlink" try reflink, then hardlink, then plain copy
+ *              (explicit opt-in, hardlinked frames share their contents
+ *              until they are saved via gap_lib_save_named_frame)
+ *   "copy"     always copy the file contents
+ */
+static void
+p_get_copy_strategy_gimprc(gboolean *allow_reflink, gboolean *allow_hardlink)
+{
+  static gint l_allow_reflink = -1;
+  static gint l_allow_hardlink = -1;
+  char *value_string;
+
+  if(l_allow_reflink < 0)
+  {
+    l_allow_reflink = TRUE;
+    l_allow_hardlink = FALSE;
+    value_string = gimp_gimprc_query("video-frame-copy-strategy");
+    if(value_string)
+    {
+      if(gap_debug) printf("video-frame-copy-strategy: %s\n", value_string);
+
+      if((*value_string == 'h') || (*value_string == 'H'))
+      {
+        l_allow_hardlink = TRUE;
+      }
+      else if((*value_string == 'c') || (*value_string == 'C'))
+      {
+        l_allow_reflink = FALSE;
+        l_allow_hardlink = FALSE;
+      }
+      g_free(value_string);
+    }
+  }
+
+  *allow_reflink = l_allow_reflink;
+  *allow_hardlink = l_allow_hardlink;
+}  /* end p_get_copy_strategy_gimprc */
+
+/* ------------------------------------
+ * p_file_reflink
+ * ------------------------------------
+ * create fname_copy as reflink (shared extents with copy on write semantic
+ * handled by the filesystem, e.g. btrfs, xfs).
+ * returns TRUE on success.
+ */
+static gboolean
+p_file_reflink(char *fname, char *fname_copy)
+{
+#ifdef FICLONE
+  static gboolean l_reflink_supported = TRUE;
+  int             l_fd_src;
+  int             l_fd_dst;
+  gboolean        l_ok;
+
+  if(!l_reflink_supported)
+  {
+    return(FALSE);
+  }
+
+  l_ok = FALSE;
+  l_fd_src = g_open(fname, O_RDONLY, 0);
+  if(l_fd_src < 0)
+  {
+    return(FALSE);
+  }
+  l_fd_dst = g_open(fname_copy, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if(l_fd_dst >= 0)
+  {
+    if(ioctl(l_fd_dst, FICLONE, l_fd_src) == 0)
+    {
+      l_ok = TRUE;
+    }
+    else if((errno == EOPNOTSUPP) || (errno == ENOTTY) || (errno == EINVAL))
+    {
+      /* the filesystem does not support reflinks, dont try again in this session */
+      l_reflink_supported = FALSE;
+    }
+    close(l_fd_dst);
+    if(!l_ok)
+    {
+      g_remove(fname_copy);
+    }
+  }
+  close(l_fd_src);
+
+  return(l_ok);
+#else
+  return(FALSE);
+#endif
+}  /* end p_file_reflink */
+
+/* ------------------------------------
+ * p_file_hardlink
+ * ------------------------------------
+ * create fname_copy as hardlink to fname.
+ * note that a hardlinked frame shares its contents with the original
+ * until it is saved again via gap_lib_save_named_frame
+ * (that always writes a new file and breaks the link).
+ */
+static gboolean
+p_file_hardlink(char *fname, char *fname_copy)
+{
+#ifndef G_OS_WIN32
+  if(link(fname, fname_copy) == 0)
+  {
+    return(TRUE);
+  }
+#endif
+  return(FALSE);
+}  /* end p_file_hardlink */
+
+/* ============================================================================
+ * gap_lib_file_copy_fast
+ * ============================================================================
+ * create fname_copy with the same content as fname,
+ * using the fastest strategy that is allowed (gimprc video-frame-copy-strategy)
+ * and supported by the filesystem:
+ *   1.) reflink (FICLONE)   no data is copied, copy on write by the filesystem
+ *   2.) hardlink            no data is copied, copy on write by gap_lib_save_named_frame
+ *                           (only if video-frame-copy-strategy is "hardlink")
+ *   3.) plain copy of the file contents.
+ * the used strategy is reported in strategy_used (if not NULL)
+ */
+int
+gap_lib_file_copy_fast(char *fname, char *fname_copy, GapLibCopyStrategy *strategy_used)
+{
+  GapLibCopyStrategy l_strategy;
+  gboolean           l_allow_reflink;
+  gboolean           l_allow_hardlink;
+  int                l_rc;
+
+  p_get_copy_strategy_gimprc(&l_allow_reflink, &l_allow_hardlink);
+  l_strategy = GAP_LIB_COPY_FAILED;
+  l_rc = -1;
+
+  if(strategy_used != NULL)
+  {
+    *strategy_used = GAP_LIB_COPY_FAILED;
+  }
+  if(strcmp(fname, fname_copy) == 0)
+  {
+    return(-1);
+  }
+
+  /* an already existing copy is replaced (never write through an existing link) */
+  if(g_file_test(fname_copy, G_FILE_TEST_EXISTS))
+  {
+    g_remove(fname_copy);
+  }
+
+  if((l_allow_reflink)
+  && (p_file_reflink(fname, fname_copy)))
+  {
+    l_strategy = GAP_LIB_COPY_REFLINK;
+    l_rc = 0;
+  }
+  else if((l_allow_hardlink)
+  && (p_file_hardlink(fname, fname_copy)))
+  {
+    l_strategy = GAP_LIB_COPY_HARDLINK;
+    l_rc = 0;
+  }
+  else
+  {
+    l_rc = gap_lib_file_copy(fname, fname_copy);
+    if(l_rc == 0)
+    {
+      l_strategy = GAP_LIB_COPY_PLAIN;
+    }
+  }
+
+  if(gap_debug)
+  {
+    printf("gap_lib_file_copy_fast src:%s dst:%s strategy:%s\n"
+      , fname
+      , fname_copy
+      , gap_lib_copy_strategy_name(l_strategy)
+      );
+  }
+
+  if(strategy_used != NULL)
+  {
+    *strategy_used = l_strategy;
+  }
+  return(l_rc);
+}  /* end gap_lib_file_copy_fast */
+
+/* ------------------------------------
+ * p_break_hardlink
+ * ------------------------------------
+ * if fname is one of several hardlinks to the same file,
+ * replace it by a private copy (so that writing to fname
+ * does not change the contents of the other linked frames)
+ */
+static void
+p_break_hardlink(const char *fname)
+{
+  GStatBuf  l_stat_buf;
+  char     *l_cow_name;
+
+  if (0 != g_stat(fname, &l_stat_buf))
+  {
+    return;
+  }
+  if (l_stat_buf.st_nlink <= 1)
+  {
+    return;
+  }
+
+  if(gap_debug) printf("p_break_hardlink: %s has %d links\n", fname, (int)l_stat_buf.st_nlink);
+
+  l_cow_name = g_strdup_printf("%s.gcow", fname);
+  if(0 == gap_lib_file_copy((char *)fname, l_cow_name))
+  {
+    if(0 != g_rename(l_cow_name, fname))
+    {
+      g_remove(l_cow_name);
+    }
+  }
+  g_free(l_cow_name);
+}  /* end p_break_hardlink */
+
 /* ============================================================================
  * gap_lib_file_copy
  * ============================================================================
@@ -836,6 +1109,11 @@ gap_lib_file_copy(char *fname, char *fname_copy)
   fread(l_buffer, 1, (size_t)l_len, l_fp);
   fclose(l_fp);
 
+  /* remove an existing fname_copy before writing, because it may be
+   * a hardlink that shares its contents with other frames
+   */
+  g_remove(fname_copy);
+
   l_fp = g_fopen(fname_copy, "wb");                 /* open write */
   if(l_fp == NULL)
   {
@@ -2862,6 +3140,8 @@ gap_lib_save_named_image(gint32 image_id, const char *sav_name, GimpRunMode run_
  *  on success rename it to desired framename.
  *  (this is done, to avoid corrupted frames on disk in case of
  *   crash in one of the save procedures)
+ *  Note that this also breaks hardlinks to frames that were
+ *  duplicated via gap_lib_file_copy_fast (copy on write).
  * ============================================================================
  */
 int
@@ -3037,7 +3317,10 @@ gap_lib_save_named_frame(gint32 image_id, char *sav_name)
   }
   else
   {
-    /* ZIP tmpname ==> sav_name */
+    /* ZIP tmpname ==> sav_name
+     * (gzip writes into the existing file, therefore break hardlinks first)
+     */
+    p_break_hardlink(sav_name);
     if(NULL != p_gzip(l_tmpname, sav_name, "zip"))
     {
        /* OK zip created compressed file named sav_name
@@ -3435,21 +3718,71 @@ gap_lib_replace_image(GapAnimInfo *ainfo_ptr)
   {
     if(do_onionskin_crate)
     {
-       /* create onionskinlayers without keeping the handled images cached
-        * (passing NULL pointers for the chaching structures and functions)
-        */
-       gap_onion_base_onionskin_apply(NULL         /* dummy pointer gpp */
-             , image_id               /* apply on the newly loaded image_id */
-             , vin_ptr
-             , ainfo_ptr->frame_nr        /* the new current frame_nr */
-             , ainfo_ptr->first_frame_nr
-             , ainfo_ptr->last_frame_nr
-             , ainfo_ptr->basename
-             , ainfo_ptr->extension
-             , NULL                    /* fptr_add_img_to_cache */
-             , NULL                    /* fptr_find_frame_in_img_cache */
-             , FALSE                   /* use_cache */
-             );
+       if(gap_onion_cache_get_gimprc_bytesize() > 0)
+       {
+         GapOnionCache *onion_cache;
+         gint32         prefetch_frame_nr;
+
+         /* create onionskinlayers using the persistent onion cache,
+          * that keeps the reference frames of the previous navigation steps
+          * (as images without display in the gimp core)
+          */
+         onion_cache = gap_onion_cache_open(ainfo_ptr->basename
+                                           , ainfo_ptr->extension
+                                           , vin_ptr
+                                           , TRUE   /* persistent */
+                                           );
+         gap_onion_base_onionskin_apply(onion_cache
+               , image_id               /* apply on the newly loaded image_id */
+               , vin_ptr
+               , ainfo_ptr->frame_nr        /* the new current frame_nr */
+               , ainfo_ptr->first_frame_nr
+               , ainfo_ptr->last_frame_nr
+               , ainfo_ptr->basename
+               , ainfo_ptr->extension
+               , gap_onion_cache_add_image
+               , gap_onion_cache_find_frame
+               , TRUE                    /* use_cache */
+               );
+
+         /* load the reference frames for the next step in navigation direction */
+         prefetch_frame_nr = gap_onion_cache_get_prefetch_frame_nr(onion_cache, ainfo_ptr->frame_nr);
+         if(prefetch_frame_nr >= 0)
+         {
+           gap_onion_base_onionskin_prefetch(onion_cache
+               , vin_ptr
+               , prefetch_frame_nr
+               , ainfo_ptr->first_frame_nr
+               , ainfo_ptr->last_frame_nr
+               , ainfo_ptr->basename
+               , ainfo_ptr->extension
+               , gap_onion_cache_add_image
+               , gap_onion_cache_find_frame
+               );
+         }
+         gap_onion_cache_close(onion_cache);
+       }
+       else
+       {
+         /* delete images that a persistent cache of previous calls still holds */
+         gap_onion_cache_drop_persistent();
+
+         /* create onionskinlayers without keeping the handled images cached
+          * (passing NULL pointers for the chaching structures and functions)
+          */
+         gap_onion_base_onionskin_apply(NULL         /* dummy pointer gpp */
+               , image_id               /* apply on the newly loaded image_id */
+               , vin_ptr
+               , ainfo_ptr->frame_nr        /* the new current frame_nr */
+               , ainfo_ptr->first_frame_nr
+               , ainfo_ptr->last_frame_nr
+               , ainfo_ptr->basename
+               , ainfo_ptr->extension
+               , NULL                    /* fptr_add_img_to_cache */
+               , NULL                    /* fptr_find_frame_in_img_cache */
+               , FALSE                   /* use_cache */
+               );
+       }
     }
 
     p_do_active_layer_tracking(image_id
@@ -25,6 +25,7 @@
  */
 
 /* revision history:
+ * 2.8.xx   2026/10/18   agent: added gap_lib_file_copy_fast, gap_lib_image_file_copy_fast
  * 2.1.0a   2004/04/18   hof: added gap_lib_fprintf_gdouble
  * 1.3.26a  2004/02/29   hof: ainfo.type changed from long to GapLibAinfoType
  * 1.3.26a  2004/02/01   hof: added: gap_lib_alloc_ainfo_from_name
@@ -54,6 +55,18 @@
 #include "gap_lib_common_defs.h"
 
 
+/* strategies used by gap_lib_file_copy_fast */
+typedef enum
+{
+   GAP_LIB_COPY_FAILED      = -1
+  ,GAP_LIB_COPY_PLAIN       = 0
+  ,GAP_LIB_COPY_REFLINK     = 1
+  ,GAP_LIB_COPY_HARDLINK    = 2
+} GapLibCopyStrategy;
+
+#define GAP_LIB_COPY_STRATEGY_COUNT 3
+
+
 /* procedures used in other gap*.c files */
 
 gint32      gap_lib_layer_tracking(gint32 image_id
@@ -70,6 +83,8 @@ gint32      gap_lib_layer_tracking(gint32 image_id
 int          gap_lib_file_exists(const char *fname);
 char*        gap_lib_searchpath_for_exefile(const char *exefile, const char *path);
 int          gap_lib_file_copy(char *fname, char *fname_copy);
+int          gap_lib_file_copy_fast(char *fname, char *fname_copy, GapLibCopyStrategy *strategy_used);
+const char*  gap_lib_copy_strategy_name(GapLibCopyStrategy strategy);
 void         gap_lib_free_ainfo(GapAnimInfo **ainfo);
 char*        gap_lib_alloc_basename(const char *imagename, long *number);
 char*        gap_lib_alloc_extension(const char *imagename);
@@ -90,10 +105,12 @@ char*  gap_lib_alloc_fname_fixed_digits(char *basename, long nr, char *extension
 char*  gap_lib_alloc_fname(char *basename, long nr, char *extension);
 char*  gap_lib_alloc_fname6(char *basename, long nr, char *extension, long default_digits);
 gboolean gap_lib_exists_frame_nr(GapAnimInfo *ainfo_ptr, long nr, long *l_has_digits);
+long   gap_lib_count_framenumber_digits(const char *imagename);
 
 long  gap_lib_get_frame_nr(gint32 image_id);
 long  gap_lib_get_frame_nr_from_name(char *fname);
 int   gap_lib_image_file_copy(char *fname, char *fname_copy);
+int   gap_lib_image_file_copy_fast(char *fname, char *fname_copy, GapLibCopyStrategy *strategy_used);
 
 gchar *gap_lib_get_video_paste_name(void);
 gint32 gap_vid_edit_clear(void);
@@ -26,6 +26,8 @@
  */
 
 /* revision history:
+ * gimp    2.8.xx;  2026/10/18  agent: thumbnail update creates the thumbnails in the background
+ *                                     (gap_thumb_service) and renders them as they complete
  * gimp    2.1.0a;  2005/03/12  hof: added radio buttons for active layer tracking
  * gimp    2.1.0a;  2004/11/04  hof: replaced deprecated option_menu by gimp_image_combo_box_new
  * gimp    2.1.0a;  2004/06/26  hof: #144649 use NULL for the default cursor as active_cursor
@@ -125,6 +127,7 @@
 #include "gap_pview_da.h"
 #include "gap_arr_dialog.h"
 #include "gap_thumbnail.h"
+#include "gap_thumb_service.h"
 #include "gap_image.h"
 
 
@@ -133,6 +136,7 @@
 
 #define NAVI_CHECK_SIZE 4
 #define MAX_DYN_ROWS 400
+#define NAVI_THUMB_POLL_INTERVAL 100   /* millisecs */
 
 #define KEY_NAVI_DIALOG_TO_FRONT     "plug_in_gap_navigator_to_front"
 
@@ -315,6 +319,9 @@ typedef struct NaviDialog
   GtkWidget     *acl_trace_off_toggle;
   GtkWidget     *acl_trace_by_name_toggle;
   GtkWidget     *acl_trace_by_pos_toggle;
+
+  GapThumbService *thumb_service;     /* background thumbnail creation (NULL if not active) */
+  int              thumb_timer;       /* polling for completed thumbnails (-1 if not active) */
 } NaviDialog;
 
 
@@ -339,6 +346,11 @@ static void navi_ops_menu_set_sensitive(void);
 static void navi_ops_buttons_set_sensitive(void);
 
 static void navi_pviews_reset(void);
+static gint32   navi_thumb_priority(gint32 frame_nr);
+static gboolean navi_thumb_update_background(gboolean update_all);
+static void     navi_thumb_refresh_frame(gint32 frame_nr);
+static gint     navi_thumb_poll(gpointer data);
+static void     navi_render_preview (FrameWidget *fw);
 static void navi_dialog_thumb_update_callback(GtkWidget *w, gpointer   data);
 static void navi_dialog_thumb_updateall_callback(GtkWidget *w, gpointer   data);
 static void navi_dialog_vcr_play_callback(GtkWidget *w, gpointer   data);
@@ -1752,6 +1764,12 @@ navi_thumb_update(gboolean update_all)
     return;
   }
 
+  if(navi_thumb_update_background(update_all))
+  {
+    /* thumbnails are created in the background and rendered as they complete */
+    return;
+  }
+
   navi_set_waiting_cursor();
 
   l_any_upd_flag = FALSE;
@@ -1830,6 +1848,187 @@ navi_thumb_update(gboolean update_all)
 
 
 
+/* ---------------------------------
+ * navi_thumb_priority
+ * ---------------------------------
+ * priority for background thumbnail creation of frame_nr:
+ * frames that are visible in the dyn table first,
+ * all other frames ordered by their distance to the visible area.
+ */
+static gint32
+navi_thumb_priority(gint32 frame_nr)
+{
+  gint32 l_timezoom;
+  gint32 l_last_visible_frame_nr;
+
+  l_timezoom = 1;
+  if(naviD->vin_ptr)
+  {
+    l_timezoom = MAX(1, naviD->vin_ptr->timezoom);
+  }
+  l_last_visible_frame_nr = naviD->dyn_topframenr + ((naviD->dyn_rows - 1) * l_timezoom);
+
+  if((frame_nr >= naviD->dyn_topframenr)
+  && (frame_nr <= l_last_visible_frame_nr)
+  && (((frame_nr - naviD->dyn_topframenr) % l_timezoom) == 0))
+  {
+    return (GAP_THUMB_SERVICE_PRIORITY_VISIBLE);
+  }
+  if(frame_nr < naviD->dyn_topframenr)
+  {
+    return (1 + naviD->dyn_topframenr - frame_nr);
+  }
+  return (1 + frame_nr - l_last_visible_frame_nr);
+}  /* end navi_thumb_priority */
+
+
+/* ---------------------------------
+ * navi_thumb_update_background
+ * ---------------------------------
+ * request thumbnail update of all frames from the background thumbnail service.
+ * returns FALSE if background processing is not available
+ * (turned off via gimprc or no thread support)
+ */
+static gboolean
+navi_thumb_update_background(gboolean update_all)
+{
+  gint32 l_num_threads;
+  gint32 l_thumb_size;
+  gint32 l_frame_nr;
+
+  l_num_threads = gap_thumb_service_get_gimprc_threads();
+  if(l_num_threads < 1)
+  {
+    return (FALSE);
+  }
+  l_thumb_size = gap_thumb_get_thumbnail_size();
+
+  if(naviD->thumb_service)
+  {
+    if((strcmp(naviD->thumb_service->basename, naviD->ainfo_ptr->basename) != 0)
+    || (strcmp(naviD->thumb_service->extension, naviD->ainfo_ptr->extension) != 0)
+    || (naviD->thumb_service->thumb_size != l_thumb_size))
+    {
+      gap_thumb_service_free(naviD->thumb_service);
+      naviD->thumb_service = NULL;
+    }
+    else
+    {
+      /* restart (drop requests of the previous update) */
+      gap_thumb_service_cancel(naviD->thumb_service);
+    }
+  }
+
+  if(naviD->thumb_service == NULL)
+  {
+    naviD->thumb_service = gap_thumb_service_new(naviD->ainfo_ptr->basename
+                                                , naviD->ainfo_ptr->extension
+                                                , l_thumb_size
+                                                , l_num_threads
+                                                );
+    if(naviD->thumb_service == NULL)
+    {
+      return (FALSE);
+    }
+  }
+
+  for(l_frame_nr = naviD->ainfo_ptr->first_frame_nr;
+      l_frame_nr <= naviD->ainfo_ptr->last_frame_nr;
+      l_frame_nr++)
+  {
+    gap_thumb_service_request(naviD->thumb_service
+                             , l_frame_nr
+                             , navi_thumb_priority(l_frame_nr)
+                             , update_all
+                             );
+  }
+
+  if(naviD->thumb_timer < 0)
+  {
+    naviD->thumb_timer = g_timeout_add(NAVI_THUMB_POLL_INTERVAL,
+                                       (GtkFunction)navi_thumb_poll, NULL);
+  }
+  return (TRUE);
+}  /* end navi_thumb_update_background */
+
+
+/* ---------------------------------
+ * navi_thumb_refresh_frame
+ * ---------------------------------
+ * render the (new) thumbnail of frame_nr if it is visible in the dyn table
+ */
+static void
+navi_thumb_refresh_frame(gint32 frame_nr)
+{
+  gint l_row;
+
+  for(l_row = 0; l_row < naviD->dyn_rows; l_row++)
+  {
+    FrameWidget *fw;
+
+    fw = &naviD->frame_widget_tab[l_row];
+    if(fw->frame_nr == frame_nr)
+    {
+      /* reset the timestamp to force reading the thumbnail file */
+      fw->frame_timestamp = 0;
+      navi_render_preview(fw);
+    }
+  }
+}  /* end navi_thumb_refresh_frame */
+
+
+/* ---------------------------------
+ * navi_thumb_poll
+ * ---------------------------------
+ * timer callback while the background thumbnail update is active.
+ * renders all thumbnails that were completed by the worker threads
+ * and creates (at most) one thumbnail of a frame that only gimp can read.
+ * the timer stops itself when all requests are processed.
+ */
+static gint
+navi_thumb_poll(gpointer data)
+{
+  gint32                 l_frame_nr;
+  GapThumbServiceStatus  l_status;
+
+  if(naviD == NULL)
+  {
+    return (FALSE);
+  }
+  if(naviD->thumb_service == NULL)
+  {
+    naviD->thumb_timer = -1;
+    return (FALSE);
+  }
+
+  while(gap_thumb_service_pop_result(naviD->thumb_service, &l_frame_nr, &l_status))
+  {
+    if(l_status == GAP_THUMB_SERVICE_STATUS_DONE)
+    {
+      navi_thumb_refresh_frame(l_frame_nr);
+    }
+  }
+
+  suspend_gimage_notify++;
+  if(gap_thumb_service_process_gimp_request(naviD->thumb_service, &l_frame_nr, &l_status))
+  {
+    if(l_status == GAP_THUMB_SERVICE_STATUS_DONE)
+    {
+      navi_thumb_refresh_frame(l_frame_nr);
+    }
+  }
+  suspend_gimage_notify--;
+
+  if(!gap_thumb_service_is_busy(naviD->thumb_service))
+  {
+    if(gap_debug) printf("navi_thumb_poll: background thumbnail update finished\n");
+    naviD->thumb_timer = -1;
+    return (FALSE);
+  }
+  return (TRUE);
+}  /* end navi_thumb_poll */
+
+
 static void
 navi_dialog_thumb_update_callback(GtkWidget *w, gpointer   data)
 {
@@ -2517,6 +2716,12 @@ navi_render_preview (FrameWidget *fw)
 
      l_can_use_cached_thumbnail = FALSE;
      l_referenced_frame_exists = FALSE;
+     /* visible frames are processed first while a background thumbnail update is running */
+     gap_thumb_service_raise_priority(naviD->thumb_service
+                                     , fw->frame_nr
+                                     , GAP_THUMB_SERVICE_PRIORITY_VISIBLE
+                                     );
+
      l_frame_filename = gap_lib_alloc_fname(naviD->ainfo_ptr->basename, fw->frame_nr, naviD->ainfo_ptr->extension);
      if(l_frame_filename)
      {
@@ -4101,6 +4306,8 @@ navi_dialog_create (GtkWidget* shell, gint32 image_id)
   naviD->acl_trace_off_toggle = NULL;
   naviD->acl_trace_by_name_toggle = NULL;
   naviD->acl_trace_by_pos_toggle = NULL;
+  naviD->thumb_service = NULL;
+  naviD->thumb_timer = -1;
   naviD->dyn_adj = NULL;         /* disable procedure navi_dyn_adj_set_limits before this widget is created  */
   naviD->sel_range_list = NULL;  /* startup without selection */
   naviD->prev_selected_framnr = -1;
@@ -4463,6 +4670,13 @@ int  gap_navigator(gint32 image_id)
       g_source_remove(naviD->timer);
       naviD->timer = -1;
     }
+  if (naviD->thumb_timer >= 0)
+    {
+      g_source_remove(naviD->thumb_timer);
+      naviD->thumb_timer = -1;
+    }
+  gap_thumb_service_free(naviD->thumb_service);
+  naviD->thumb_service = NULL;
 
   navi_pviews_reset();
 
@@ -24,6 +24,7 @@
  */
 
 /* revision history:
+ * version 2.8.xx;   2026/10/18   agent: added gap_onion_base_onionskin_prefetch
  * version 2.1.0a;   2004/06/03   hof: added onionskin ref_mode
  * version 1.3.16c;  2003.07.08   hof: created (as extract of the gap_onion_worker.c module)
  */
@@ -223,6 +224,152 @@ gap_onion_base_onionskin_delete(gint32 image_id)
 }       /* end gap_onion_base_onionskin_delete */
 
 
+/* ---------------------------------
+ * p_calculate_ref_frame_nr
+ * ---------------------------------
+ * calculate the frame number of the reference frame for the
+ * onion layer number l_onr (1 upto num_olayers).
+ * sign_ptr holds the direction state for the bidirectional ref_modes
+ * (must be initialized with -1 by the caller before the first onion layer).
+ * returns FALSE if there is no reference frame for l_onr and all further
+ * onion layers (reference out of range without cycle or multiple fold back cycle)
+ */
+static gboolean
+p_calculate_ref_frame_nr(GapVinVideoInfo *vin_ptr
+             , gint32  l_onr
+             , gint32 *sign_ptr
+             , long   ainfo_curr_frame_nr
+             , long   ainfo_first_frame_nr
+             , long   ainfo_last_frame_nr
+             , gint32 *frame_nr_ptr)
+{
+  gint32        l_nr;
+  gint32        l_frame_nr;
+
+  if(vin_ptr->asc_opacity)
+  {
+     /* process far neigbours first to give them the highest configured opacity value */
+     l_nr = (1+ vin_ptr->num_olayers) - l_onr;
+  }
+  else
+  {
+     /* process near neigbours first to give them the highest configured opacity value */
+     l_nr = l_onr;
+  }
+
+  /* find out reference frame number */
+  switch(vin_ptr->ref_mode)
+  {
+    case GAP_ONION_REFMODE_BIDRIECTIONAL_SINGLE:
+      *sign_ptr *= -1; /* toggle sign between -1 and +1 */
+      break;
+    case GAP_ONION_REFMODE_BIDRIECTIONAL_DOUBLE:
+      *sign_ptr *= -1; /* toggle sign between -1 and +1 */
+      l_nr = 1 + ((l_nr -1) / 2);
+      break;
+    case GAP_ONION_REFMODE_NORMAL:
+      *sign_ptr = 1;  /* normal mode: always force sign of +1 */
+    default:
+      break;
+  }
+
+  l_frame_nr = ainfo_curr_frame_nr + (*sign_ptr * (vin_ptr->ref_delta * l_nr));
+
+
+  if(!vin_ptr->ref_cycle)
+  {
+    if((l_frame_nr < ainfo_first_frame_nr)
+    || (l_frame_nr > ainfo_last_frame_nr))
+    {
+       return (FALSE);  /* fold back cycle turned off */
+    }
+  }
+  if (l_frame_nr < ainfo_first_frame_nr)
+  {
+    l_frame_nr = ainfo_last_frame_nr +1 - (ainfo_first_frame_nr - l_frame_nr);
+    if (l_frame_nr < ainfo_first_frame_nr)
+    {
+      return (FALSE);  /* stop on multiple fold back cycle */
+    }
+  }
+  if (l_frame_nr > ainfo_last_frame_nr)
+  {
+    l_frame_nr = ainfo_first_frame_nr -1 + (l_frame_nr - ainfo_last_frame_nr);
+    if (l_frame_nr > ainfo_last_frame_nr)
+    {
+       return (FALSE);  /* stop on multiple fold back cycle */
+    }
+  }
+
+  *frame_nr_ptr = l_frame_nr;
+  return (TRUE);
+}       /* end p_calculate_ref_frame_nr */
+
+
+/* ---------------------------------
+ * p_merge_ref_frame
+ * ---------------------------------
+ * merge the relevant layers of the reference frame image tmp_image_id.
+ * set some layers invisible
+ * a) ignored bottomlayer(s)
+ * b) select_mode dependent: layers where layername does not match select-string
+ * c) all onion layers
+ * and merge the remaining visible layers (clip at image size)
+ * returns the layer_id of the merged layer.
+ */
+static gint32
+p_merge_ref_frame(GapVinVideoInfo *vin_ptr, gint32 tmp_image_id)
+{
+  gint32      l_ign;
+  gint32      l_idx;
+  gint32      l_layer_id;
+  gint32      l_is_onion;
+  gint32     *l_layers_list;
+  gint        l_nlayers;
+  char       *l_layername;
+
+  l_layers_list = gimp_image_get_layers(tmp_image_id, &l_nlayers);
+  for(l_ign=0, l_idx=l_nlayers -1; l_idx >= 0;l_idx--)
+  {
+    l_layer_id = l_layers_list[l_idx];
+    l_layername = gimp_item_get_name(l_layer_id);
+
+
+    l_is_onion = gap_onion_base_check_is_onion_layer(l_layer_id);
+
+    if((l_ign <  vin_ptr->ignore_botlayers)
+    || (FALSE == gap_match_layer( l_idx
+                              , l_layername
+                              , &vin_ptr->select_string[0]
+                              , vin_ptr->select_mode
+                              , vin_ptr->select_case
+                              , vin_ptr->select_invert
+                              , l_nlayers
+                              , l_layer_id)
+       )
+    || (l_is_onion))
+    {
+      gimp_item_set_visible(l_layer_id, FALSE);
+    }
+
+    g_free (l_layername);
+
+    if(!l_is_onion)
+    {
+      /* exclude other onion layers from counting ignored layers
+       */
+      l_ign++;
+    }
+  }
+  if(l_layers_list != NULL)  { g_free (l_layers_list); }
+
+  /* merge visible layers (clip at image size) */
+  l_layer_id = gap_image_merge_visible_layers(tmp_image_id, GIMP_CLIP_TO_IMAGE);
+
+  return (l_layer_id);
+}       /* end p_merge_ref_frame */
+
+
 /* ============================================================================
  * gap_onion_base_onionskin_apply
  *    create or replace onion layer(s) in the current image.
@@ -267,15 +414,11 @@ gap_onion_base_onionskin_apply(gpointer gpp
              , GapOnionBaseFptrFindFrameInImageCache fptr_find_frame_in_img_cache
              , gboolean use_cache)
 {
-  gint32        l_nr;
   gint32        l_sign;
 
   gint32        l_onr;
-  gint32        l_ign;
-  gint32        l_idx;
   gint32        l_frame_nr;
   gint32        l_tmp_image_id;
-  gint32        l_is_onion;
   gint32        l_layerstack;
   char         *l_new_filename;
   char         *l_name;
@@ -285,7 +428,6 @@ gap_onion_base_onionskin_apply(gpointer gpp
   gint32     *l_layers_list;
   gint        l_nlayers;
   gdouble     l_opacity;
-  char       *l_layername;
   gint32      l_active_layer;
 
 
@@ -352,60 +494,13 @@ gap_onion_base_onionskin_apply(gpointer gpp
   for(l_onr=1; l_onr <= vin_ptr->num_olayers; l_onr++)
   {
     /* find out reference frame number */
-
-    if(vin_ptr->asc_opacity)
-    {
-       /* process far neigbours first to give them the highest configured opacity value */
-       l_nr = (1+ vin_ptr->num_olayers) - l_onr;
-    }
-    else
-    {
-       /* process near neigbours first to give them the highest configured opacity value */
-       l_nr = l_onr;
-    }
-
-    /* find out reference frame number */
-    switch(vin_ptr->ref_mode)
-    {
-      case GAP_ONION_REFMODE_BIDRIECTIONAL_SINGLE:
-        l_sign *= -1; /* toggle sign between -1 and +1 */
-        break;
-      case GAP_ONION_REFMODE_BIDRIECTIONAL_DOUBLE:
-        l_sign *= -1; /* toggle sign between -1 and +1 */
-        l_nr = 1 + ((l_nr -1) / 2);
-        break;
-      case GAP_ONION_REFMODE_NORMAL:
-        l_sign = 1;  /* normal mode: always force sign of +1 */
-      default:
-        break;
-    }
-
-    l_frame_nr = ainfo_curr_frame_nr + (l_sign * (vin_ptr->ref_delta * l_nr));
-
-
-    if(!vin_ptr->ref_cycle)
-    {
-      if((l_frame_nr < ainfo_first_frame_nr)
-      || (l_frame_nr > ainfo_last_frame_nr))
-      {
-         break;  /* fold back cycle turned off */
-      }
-    }
-    if (l_frame_nr < ainfo_first_frame_nr)
-    {
-      l_frame_nr = ainfo_last_frame_nr +1 - (ainfo_first_frame_nr - l_frame_nr);
-      if (l_frame_nr < ainfo_first_frame_nr)
-      {
-        break;  /* stop on multiple fold back cycle */
-      }
-    }
-    if (l_frame_nr > ainfo_last_frame_nr)
+    if(!p_calculate_ref_frame_nr(vin_ptr, l_onr, &l_sign
+                               , ainfo_curr_frame_nr
+                               , ainfo_first_frame_nr
+                               , ainfo_last_frame_nr
+                               , &l_frame_nr))
     {
-      l_frame_nr = ainfo_first_frame_nr -1 + (l_frame_nr - ainfo_last_frame_nr);
-      if (l_frame_nr > ainfo_last_frame_nr)
-      {
-         break;  /* stop on multiple fold back cycle */
-      }
+      break;
     }
 
     l_tmp_image_id = -1;
@@ -474,47 +569,7 @@ gap_onion_base_onionskin_apply(gpointer gpp
        */
       if(gap_debug) printf("gap_onion_base_onionskin_apply: layer is NOT available in the CACHE\n");
 
-      /* set some layers invisible
-       * a) ignored bottomlayer(s)
-       * b) select_mode dependent: layers where layername does not match select-string
-       * c) all onion layers
-       */
-      l_layers_list = gimp_image_get_layers(l_tmp_image_id, &l_nlayers);
-      for(l_ign=0, l_idx=l_nlayers -1; l_idx >= 0;l_idx--)
-      {
-        l_layer_id = l_layers_list[l_idx];
-        l_layername = gimp_item_get_name(l_layer_id);
-
-
-        l_is_onion = gap_onion_base_check_is_onion_layer(l_layer_id);
-
-        if((l_ign <  vin_ptr->ignore_botlayers)
-        || (FALSE == gap_match_layer( l_idx
-                                  , l_layername
-                                  , &vin_ptr->select_string[0]
-                                  , vin_ptr->select_mode
-                                  , vin_ptr->select_case
-                                  , vin_ptr->select_invert
-                                  , l_nlayers
-                                  , l_layer_id)
-           )
-        || (l_is_onion))
-        {
-          gimp_item_set_visible(l_layer_id, FALSE);
-        }
-
-        g_free (l_layername);
-
-        if(!l_is_onion)
-        {
-          /* exclude other onion layers from counting ignored layers
-           */
-          l_ign++;
-        }
-      }
-
-      /* merge visible layers (clip at image size) */
-      l_layer_id = gap_image_merge_visible_layers(l_tmp_image_id, GIMP_CLIP_TO_IMAGE);
+      l_layer_id = p_merge_ref_frame(vin_ptr, l_tmp_image_id);
     }
     else
     {
@@ -673,6 +728,100 @@ gap_onion_base_onionskin_apply(gpointer gpp
 }       /* end gap_onion_base_onionskin_apply */
 
 
+/* ============================================================================
+ * gap_onion_base_onionskin_prefetch
+ *    load (and merge) the reference frames that are required for
+ *    onion layers of the frame prefetch_frame_nr into the image cache
+ *    (typically the frame that is expected as current frame
+ *    at the next navigation step).
+ *    reference frames that are already cached are not loaded again.
+ *
+ * returns the number of frames that were loaded into the cache.
+ * ============================================================================
+ */
+gint
+gap_onion_base_onionskin_prefetch(gpointer gpp
+             , GapVinVideoInfo *vin_ptr
+             , long   prefetch_frame_nr
+             , long   ainfo_first_frame_nr
+             , long   ainfo_last_frame_nr
+             , char  *ainfo_basename
+             , char  *ainfo_extension
+             , GapOnionBaseFptrAddImageToCache        fptr_add_img_to_cache
+             , GapOnionBaseFptrFindFrameInImageCache fptr_find_frame_in_img_cache
+             )
+{
+  gint32        l_sign;
+  gint32        l_onr;
+  gint32        l_frame_nr;
+  gint32        l_tmp_image_id;
+  gint32        l_layer_id;
+  gint          l_loaded;
+  char         *l_new_filename;
+
+  l_loaded = 0;
+  if((fptr_add_img_to_cache == NULL)
+  || (fptr_find_frame_in_img_cache == NULL)
+  || (prefetch_frame_nr < ainfo_first_frame_nr)
+  || (prefetch_frame_nr > ainfo_last_frame_nr))
+  {
+    return (l_loaded);
+  }
+
+  l_sign = -1;
+  for(l_onr=1; l_onr <= vin_ptr->num_olayers; l_onr++)
+  {
+    if(!p_calculate_ref_frame_nr(vin_ptr, l_onr, &l_sign
+                               , prefetch_frame_nr
+                               , ainfo_first_frame_nr
+                               , ainfo_last_frame_nr
+                               , &l_frame_nr))
+    {
+      break;
+    }
+
+    (*fptr_find_frame_in_img_cache)(gpp, l_frame_nr, &l_tmp_image_id, &l_layer_id);
+    if((l_tmp_image_id >= 0) && (l_layer_id >= 0))
+    {
+      continue;
+    }
+
+    if(l_tmp_image_id < 0)
+    {
+      l_new_filename = gap_lib_alloc_fname(ainfo_basename,
+                                          l_frame_nr,
+                                          ainfo_extension);
+      if(!g_file_test(l_new_filename, G_FILE_TEST_EXISTS))
+      {
+        g_free(l_new_filename);
+        continue;
+      }
+      l_tmp_image_id = gap_lib_load_image(l_new_filename);
+      g_free(l_new_filename);
+      if(l_tmp_image_id < 0)
+      {
+        break;
+      }
+      gimp_image_undo_disable(l_tmp_image_id); /*  NO Undo */
+      l_loaded++;
+    }
+
+    l_layer_id = p_merge_ref_frame(vin_ptr, l_tmp_image_id);
+    (*fptr_add_img_to_cache)(gpp, l_frame_nr, l_tmp_image_id, l_layer_id);
+  }
+
+  if(gap_debug)
+  {
+    printf("gap_onion_base_onionskin_prefetch: prefetch_frame_nr:%d loaded:%d\n"
+          , (int)prefetch_frame_nr
+          , (int)l_loaded
+          );
+  }
+
+  return (l_loaded);
+}       /* end gap_onion_base_onionskin_prefetch */
+
+
 /* ----------------------------------
  * gap_onion_image_has_oinonlayers
  * ----------------------------------
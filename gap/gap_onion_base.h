@@ -25,6 +25,7 @@
  */
 
 /* revision history:
+ * version 2.8.xx;  2026.10.18   agent: added gap_onion_base_onionskin_prefetch
  * version 1.3.16c; 2003.07.09   hof: created (as extract of the gap_onion_worker.c module)
  * version 1.2.2a;  2001.12.10   hof: created
  */
@@ -110,6 +111,16 @@ gint    gap_onion_base_onionskin_apply(gpointer gpp
              , GapOnionBaseFptrFindFrameInImageCache fptr_find_frame_in_img_cache
              , gboolean use_cache
              );
+gint    gap_onion_base_onionskin_prefetch(gpointer gpp
+             , GapVinVideoInfo *vin_ptr
+             , long   prefetch_frame_nr
+             , long   ainfo_first_frame_nr
+             , long   ainfo_last_frame_nr
+             , char  *ainfo_basename
+             , char  *ainfo_extension
+             , GapOnionBaseFptrAddImageToCache        fptr_add_img_to_cache
+             , GapOnionBaseFptrFindFrameInImageCache fptr_find_frame_in_img_cache
+             );
 
 gboolean gap_onion_image_has_oinonlayers(gint32 image_id, gboolean only_visible);
 gint32   gap_onion_base_image_duplicate(gint32 image_id);
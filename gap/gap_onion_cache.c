@@ -0,0 +1,631 @@
+/* gap_onion_cache.c   procedures
+ *
+ * GAP ... Gimp Animation Plugins
+ *
+ * This Module contains the image cache for onionskin reference frames.
+ *
+ * The cache holds the reference frames as temporary images (without display)
+ * that were loaded (and optionally merged) for onionskin layer creation.
+ * Entries are keyed by frame number and the modification time (nanoseconds)
+ * and size of the frame file, the cache size is limited by the estimated memory usage
+ * (gimprc parameter video-onionskin-cache) and the least recently used
+ * entries are deleted first when the limit is exceeded.
+ */
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026.10.19   agent: frames are stamped with nanosecond mtime and size,
+ *                                    the persistent cache is opt-in
+ * version 2.8.xx;  2026.10.18   agent: created (replaces the fixed size image cache of gap_onion_worker.c)
+ */
+
+#include "config.h"
+
+/* SYTEM (UNIX) includes */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <glib/gstdio.h>
+
+#include <libgimp/gimp.h>
+
+#include <gap_file_util.h>
+
+#include <gap_lib.h>
+#include <gap_image.h>
+#include <gap_onion_cache.h>
+
+extern int gap_debug;
+
+/* key for the index of the persistent cache (gimp_set_data) */
+#define GAP_ONION_CACHE_DATA_KEY   "plug_in_gap_onion_cache"
+
+
+static guint     p_calculate_cfg_checksum(GapVinVideoInfo *vin_ptr);
+static void      p_get_frame_stamp(GapOnionCache *cache, gint32 framenr
+                    , gint64 *mtime_nsec, gint64 *filesize);
+static gint64    p_estimate_bytesize(gint32 image_id);
+static void      p_remove_entry(GapOnionCache *cache, gint32 idx, gboolean delete_image);
+static void      p_evict_lru_entries(GapOnionCache *cache, gint32 framenr_to_keep);
+
+
+/* ---------------------------------
+ * p_calculate_cfg_checksum
+ * ---------------------------------
+ * checksum of the onionskin settings that affect the merged layer
+ * of a cached reference frame.
+ */
+static guint
+p_calculate_cfg_checksum(GapVinVideoInfo *vin_ptr)
+{
+  gchar *l_cfg_string;
+  guint  l_checksum;
+
+  if(vin_ptr == NULL)
+  {
+    return (0);
+  }
+  l_cfg_string = g_strdup_printf("%d %d %d %d %s"
+                          , (int)vin_ptr->ignore_botlayers
+                          , (int)vin_ptr->select_mode
+                          , (int)vin_ptr->select_case
+                          , (int)vin_ptr->select_invert
+                          , vin_ptr->select_string
+                          );
+  l_checksum = g_str_hash(l_cfg_string);
+  g_free(l_cfg_string);
+
+  return (l_checksum);
+}  /* end p_calculate_cfg_checksum */
+
+
+/* ---------------------------------
+ * p_get_frame_stamp
+ * ---------------------------------
+ * deliver the modification time (nanoseconds) and size of the frame file
+ * (0 if the file does not exist). Navigation saves and reloads frames
+ * within the same second, a seconds based mtime would not detect that.
+ */
+static void
+p_get_frame_stamp(GapOnionCache *cache, gint32 framenr
+                 , gint64 *mtime_nsec, gint64 *filesize)
+{
+  char        *l_filename;
+
+  *mtime_nsec = 0;
+  *filesize = 0;
+  l_filename = gap_lib_alloc_fname(cache->basename, framenr, cache->extension);
+  if(l_filename != NULL)
+  {
+    gap_file_get_stamp(l_filename, mtime_nsec, filesize);
+    g_free(l_filename);
+  }
+}  /* end p_get_frame_stamp */
+
+
+/* ---------------------------------
+ * p_estimate_bytesize
+ * ---------------------------------
+ * estimate the memory used by the pixel data of all layers of the image.
+ */
+static gint64
+p_estimate_bytesize(gint32 image_id)
+{
+  gint32  *l_layers_list;
+  gint     l_nlayers;
+  gint     l_idx;
+  gint64   l_bytesize;
+
+  l_bytesize = 0;
+  l_layers_list = gimp_image_get_layers(image_id, &l_nlayers);
+  if(l_layers_list != NULL)
+  {
+    for(l_idx = 0; l_idx < l_nlayers; l_idx++)
+    {
+      l_bytesize += (gint64)gimp_drawable_width(l_layers_list[l_idx])
+                  * (gint64)gimp_drawable_height(l_layers_list[l_idx])
+                  * (gint64)gimp_drawable_bpp(l_layers_list[l_idx]);
+    }
+    g_free(l_layers_list);
+  }
+  return (l_bytesize);
+}  /* end p_estimate_bytesize */
+
+
+/* ---------------------------------
+ * p_remove_entry
+ * ---------------------------------
+ * remove the entry at index idx (and delete its image if requested).
+ * the last entry is moved into the free slot.
+ */
+static void
+p_remove_entry(GapOnionCache *cache, gint32 idx, gboolean delete_image)
+{
+  if((idx < 0) || (idx >= cache->count))
+  {
+    return;
+  }
+
+  if(gap_debug)
+  {
+    printf("gap_onion_cache: remove framenr:%d image_id:%d delete_image:%d\n"
+          , (int)cache->entry[idx].framenr
+          , (int)cache->entry[idx].image_id
+          , (int)delete_image
+          );
+  }
+
+  if((delete_image) && (gimp_image_is_valid(cache->entry[idx].image_id)))
+  {
+    gap_image_delete_immediate(cache->entry[idx].image_id);
+  }
+  cache->used_bytesize -= cache->entry[idx].bytesize;
+  cache->count--;
+  if(idx < cache->count)
+  {
+    cache->entry[idx] = cache->entry[cache->count];
+  }
+}  /* end p_remove_entry */
+
+
+/* ---------------------------------
+ * p_evict_lru_entries
+ * ---------------------------------
+ * delete least recently used entries until the memory limit is met.
+ * the entry for framenr_to_keep (the one that was just added) is never removed.
+ */
+static void
+p_evict_lru_entries(GapOnionCache *cache, gint32 framenr_to_keep)
+{
+  while(cache->used_bytesize > cache->max_bytesize)
+  {
+    gint32 l_idx;
+    gint32 l_lru_idx;
+
+    l_lru_idx = -1;
+    for(l_idx = 0; l_idx < cache->count; l_idx++)
+    {
+      if(cache->entry[l_idx].framenr == framenr_to_keep)
+      {
+        continue;
+      }
+      if((l_lru_idx < 0)
+      || (cache->entry[l_idx].lru_stamp < cache->entry[l_lru_idx].lru_stamp))
+      {
+        l_lru_idx = l_idx;
+      }
+    }
+    if(l_lru_idx < 0)
+    {
+      break;
+    }
+    p_remove_entry(cache, l_lru_idx, TRUE);
+  }
+}  /* end p_evict_lru_entries */
+
+
+/* ------------------------------------
+ * gap_onion_cache_get_gimprc_bytesize
+ * ------------------------------------
+ * get the max memory size for cached onionskin reference frames
+ * from the gimprc parameter video-onionskin-cache
+ * (in kilobytes (K) or megabytes (M), 0 turns the cache off,
+ * the cache is off if the parameter is not set)
+ */
+gint64
+gap_onion_cache_get_gimprc_bytesize(void)
+{
+  gint64 bytesize;
+  gchar *value_string;
+
+  value_string = gimp_gimprc_query(GAP_GIMPRC_ONIONSKIN_CACHE);
+  if(value_string)
+  {
+    char *ptr;
+
+    bytesize = atol(value_string);
+    for(ptr=value_string; *ptr != '\0'; ptr++)
+    {
+      if ((*ptr == 'M') || (*ptr == 'm'))
+      {
+        bytesize *= (1024 * 1024);
+        break;
+      }
+      if ((*ptr == 'K') || (*ptr == 'k'))
+      {
+        bytesize *= 1024;
+        break;
+      }
+    }
+    if (bytesize < 0)
+    {
+      bytesize = 0;
+    }
+    g_free(value_string);
+  }
+  else
+  {
+    bytesize = 0;
+  }
+
+  return (bytesize);
+}  /* end gap_onion_cache_get_gimprc_bytesize */
+
+
+/* ---------------------------------
+ * gap_onion_cache_open
+ * ---------------------------------
+ * create a cache for the frames of the animation basename/extension.
+ * a persistent cache restores the index of the previous call
+ * (the cached images remain in the gimp core between plug-in calls).
+ * cached images are dropped if the animation or the merge relevant
+ * onionskin settings have changed since then.
+ */
+GapOnionCache *
+gap_onion_cache_open(const char *basename, const char *extension
+                   , GapVinVideoInfo *vin_ptr, gboolean persistent)
+{
+  GapOnionCache *cache;
+  guint          l_cfg_checksum;
+  gint32         l_idx;
+
+  cache = g_new0(GapOnionCache, 1);
+  l_cfg_checksum = p_calculate_cfg_checksum(vin_ptr);
+
+  if(persistent)
+  {
+    if(gimp_get_data_size(GAP_ONION_CACHE_DATA_KEY) == sizeof(GapOnionCache))
+    {
+      gimp_get_data(GAP_ONION_CACHE_DATA_KEY, cache);
+
+      /* drop entries where the image was deleted in the meantime */
+      for(l_idx = cache->count -1; l_idx >= 0; l_idx--)
+      {
+        if(!gimp_image_is_valid(cache->entry[l_idx].image_id))
+        {
+          p_remove_entry(cache, l_idx, FALSE);
+        }
+        else if((cache->entry[l_idx].layer_id >= 0)
+             && (!gimp_item_is_valid(cache->entry[l_idx].layer_id)))
+        {
+          cache->entry[l_idx].layer_id = -1;
+        }
+      }
+
+      if((strcmp(cache->basename, basename) != 0)
+      || (strcmp(cache->extension, extension) != 0)
+      || (cache->cfg_checksum != l_cfg_checksum))
+      {
+        gap_onion_cache_flush(cache);
+        cache->last_curr_frame_nr = -1;
+        cache->last_delta = 0;
+      }
+    }
+    else
+    {
+      cache->last_curr_frame_nr = -1;
+    }
+  }
+  else
+  {
+    cache->last_curr_frame_nr = -1;
+  }
+
+  g_snprintf(cache->basename, sizeof(cache->basename), "%s", basename);
+  g_snprintf(cache->extension, sizeof(cache->extension), "%s", extension);
+  cache->cfg_checksum = l_cfg_checksum;
+  cache->persistent = persistent;
+  cache->hits = 0;
+  cache->misses = 0;
+  cache->max_bytesize = gap_onion_cache_get_gimprc_bytesize();
+  if(!persistent)
+  {
+    /* processing a range of frames always uses the cache */
+    if(cache->max_bytesize <= 0)
+    {
+      cache->max_bytesize = GAP_ONION_CACHE_DEFAULT_MAX_BYTESIZE;
+    }
+  }
+  p_evict_lru_entries(cache, -1);
+
+  if(gap_debug)
+  {
+    printf("gap_onion_cache_open: persistent:%d count:%d used_bytesize:%.0f max_bytesize:%.0f\n"
+          , (int)persistent
+          , (int)cache->count
+          , (double)cache->used_bytesize
+          , (double)cache->max_bytesize
+          );
+  }
+
+  return (cache);
+}  /* end gap_onion_cache_open */
+
+
+/* ---------------------------------
+ * gap_onion_cache_close
+ * ---------------------------------
+ * a persistent cache stores its index for the next call
+ * (the cached images are kept), other caches delete all cached images.
+ */
+void
+gap_onion_cache_close(GapOnionCache *cache)
+{
+  if(cache == NULL)
+  {
+    return;
+  }
+
+  if(gap_debug)
+  {
+    printf("gap_onion_cache_close: persistent:%d count:%d hits:%d misses:%d used_bytesize:%.0f\n"
+          , (int)cache->persistent
+          , (int)cache->count
+          , (int)cache->hits
+          , (int)cache->misses
+          , (double)cache->used_bytesize
+          );
+  }
+
+  if((cache->persistent) && (cache->max_bytesize > 0))
+  {
+    gimp_set_data(GAP_ONION_CACHE_DATA_KEY, cache, sizeof(GapOnionCache));
+  }
+  else
+  {
+    gap_onion_cache_flush(cache);
+    if(cache->persistent)
+    {
+      gimp_set_data(GAP_ONION_CACHE_DATA_KEY, cache, sizeof(GapOnionCache));
+    }
+  }
+  g_free(cache);
+
+}  /* end gap_onion_cache_close */
+
+
+/* ---------------------------------
+ * gap_onion_cache_drop_persistent
+ * ---------------------------------
+ * delete the images of the persistent cache index of a previous call
+ * and store an empty index. (used when the cache is turned off,
+ * otherwise those hidden images would stay in the gimp core)
+ */
+void
+gap_onion_cache_drop_persistent(void)
+{
+  GapOnionCache *cache;
+
+  if(gimp_get_data_size(GAP_ONION_CACHE_DATA_KEY) != sizeof(GapOnionCache))
+  {
+    return;
+  }
+
+  cache = g_new0(GapOnionCache, 1);
+  gimp_get_data(GAP_ONION_CACHE_DATA_KEY, cache);
+  if(cache->count > 0)
+  {
+    if(gap_debug)
+    {
+      printf("gap_onion_cache_drop_persistent: count:%d\n", (int)cache->count);
+    }
+    gap_onion_cache_flush(cache);
+    gimp_set_data(GAP_ONION_CACHE_DATA_KEY, cache, sizeof(GapOnionCache));
+  }
+  g_free(cache);
+
+}  /* end gap_onion_cache_drop_persistent */
+
+
+/* ---------------------------------
+ * gap_onion_cache_flush
+ * ---------------------------------
+ * delete all cached images and set the cache empty.
+ */
+void
+gap_onion_cache_flush(GapOnionCache *cache)
+{
+  if(cache == NULL)
+  {
+    return;
+  }
+  while(cache->count > 0)
+  {
+    p_remove_entry(cache, cache->count -1, TRUE);
+  }
+  cache->used_bytesize = 0;
+}  /* end gap_onion_cache_flush */
+
+
+/* ---------------------------------
+ * gap_onion_cache_find_frame
+ * ---------------------------------
+ * deliver image_id and layer_id (the merged layer or -1)
+ * of the cached frame framenr.
+ * returns the index of the cache entry or -1 if the frame is not cached
+ * (or the frame file was changed since it was cached).
+ */
+gint32
+gap_onion_cache_find_frame(void *cache_void
+                   , gint32 framenr, gint32 *image_id, gint32 *layer_id)
+{
+  GapOnionCache *cache;
+  gint32         l_idx;
+
+  *image_id = -1;
+  *layer_id = -1;
+
+  cache = (GapOnionCache *)cache_void;
+  if(cache == NULL)
+  {
+    return (-1);
+  }
+
+  for(l_idx = 0; l_idx < cache->count; l_idx++)
+  {
+    if(framenr == cache->entry[l_idx].framenr)
+    {
+      gint64 l_mtime_nsec;
+      gint64 l_filesize;
+
+      p_get_frame_stamp(cache, framenr, &l_mtime_nsec, &l_filesize);
+      if((cache->entry[l_idx].mtime_nsec != l_mtime_nsec)
+      || (cache->entry[l_idx].filesize != l_filesize)
+      || (!gimp_image_is_valid(cache->entry[l_idx].image_id)))
+      {
+        /* the frame file was changed (or removed) since it was cached */
+        p_remove_entry(cache, l_idx, TRUE);
+        break;
+      }
+      cache->lru_clock++;
+      cache->entry[l_idx].lru_stamp = cache->lru_clock;
+      cache->hits++;
+      *image_id = cache->entry[l_idx].image_id;
+      *layer_id = cache->entry[l_idx].layer_id;
+      return (l_idx);
+    }
+  }
+
+  cache->misses++;
+  return (-1);
+}  /* end gap_onion_cache_find_frame */
+
+
+/* ---------------------------------
+ * gap_onion_cache_add_image
+ * ---------------------------------
+ * add image_id and layer_id (-1 if the image was loaded but not merged)
+ * for framenr to the cache, or update the existing entry.
+ * Do not add the current (displayed) image to the cache !!
+ */
+void
+gap_onion_cache_add_image(void *cache_void
+                   , gint32 framenr, gint32 image_id, gint32 layer_id)
+{
+  GapOnionCache *cache;
+  gint32         l_idx;
+
+  cache = (GapOnionCache *)cache_void;
+  if(cache == NULL)
+  {
+    return;
+  }
+
+  if(gap_debug)
+  {
+     printf("gap_onion_cache_add_image: count:%d framenr:%d image_id:%d layer_id:%d\n"
+           , (int)cache->count
+           , (int)framenr
+           , (int)image_id
+           , (int)layer_id
+           );
+  }
+
+  for(l_idx = 0; l_idx < cache->count; l_idx++)
+  {
+    if(framenr == cache->entry[l_idx].framenr)
+    {
+      if(cache->entry[l_idx].image_id == image_id)
+      {
+        if((cache->entry[l_idx].layer_id < 0) && (layer_id >= 0))
+        {
+          /* update the cache with the id of the merged layer */
+          cache->entry[l_idx].layer_id = layer_id;
+          cache->used_bytesize -= cache->entry[l_idx].bytesize;
+          cache->entry[l_idx].bytesize = p_estimate_bytesize(image_id);
+          cache->used_bytesize += cache->entry[l_idx].bytesize;
+        }
+        cache->lru_clock++;
+        cache->entry[l_idx].lru_stamp = cache->lru_clock;
+        p_evict_lru_entries(cache, framenr);
+        return;
+      }
+
+      /* the frame was cached with another image, replace it */
+      p_remove_entry(cache, l_idx, TRUE);
+      break;
+    }
+  }
+
+  if(cache->count >= GAP_ONION_CACHE_MAX_ENTRIES)
+  {
+    gint64 l_max_bytesize;
+
+    /* all slots in use, force eviction of the least recently used entry */
+    l_max_bytesize = cache->max_bytesize;
+    cache->max_bytesize = cache->used_bytesize - 1;
+    p_evict_lru_entries(cache, framenr);
+    cache->max_bytesize = l_max_bytesize;
+  }
+
+  l_idx = cache->count;
+  cache->count++;
+  cache->lru_clock++;
+  cache->entry[l_idx].framenr = framenr;
+  cache->entry[l_idx].image_id = image_id;
+  cache->entry[l_idx].layer_id = layer_id;
+  p_get_frame_stamp(cache, framenr
+                   , &cache->entry[l_idx].mtime_nsec
+                   , &cache->entry[l_idx].filesize);
+  cache->entry[l_idx].bytesize = p_estimate_bytesize(image_id);
+  cache->entry[l_idx].lru_stamp = cache->lru_clock;
+  cache->used_bytesize += cache->entry[l_idx].bytesize;
+
+  p_evict_lru_entries(cache, framenr);
+
+}  /* end gap_onion_cache_add_image */
+
+
+/* ---------------------------------------
+ * gap_onion_cache_get_prefetch_frame_nr
+ * ---------------------------------------
+ * record the navigation step to curr_frame_nr and return the frame number
+ * that is expected as current frame at the next step
+ * (or -1 if the navigation direction is not predictable).
+ * single steps and repeated steps with the same distance are predicted.
+ */
+gint32
+gap_onion_cache_get_prefetch_frame_nr(GapOnionCache *cache, gint32 curr_frame_nr)
+{
+  gint32 l_delta;
+  gint32 l_prefetch_frame_nr;
+
+  if(cache == NULL)
+  {
+    return (-1);
+  }
+
+  l_prefetch_frame_nr = -1;
+  if(cache->last_curr_frame_nr >= 0)
+  {
+    l_delta = curr_frame_nr - cache->last_curr_frame_nr;
+    if((l_delta == 1) || (l_delta == -1)
+    || ((l_delta != 0) && (l_delta == cache->last_delta)))
+    {
+      l_prefetch_frame_nr = curr_frame_nr + l_delta;
+    }
+    cache->last_delta = l_delta;
+  }
+  cache->last_curr_frame_nr = curr_frame_nr;
+
+  return (l_prefetch_frame_nr);
+}  /* end gap_onion_cache_get_prefetch_frame_nr */
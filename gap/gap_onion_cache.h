@@ -0,0 +1,103 @@
+/* gap_onion_cache.h
+ *
+ * GAP ... Gimp Animation Plugins
+ *
+ * This Module contains the image cache for onionskin reference frames
+ */
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026.10.19   agent: nanosecond mtime and size stamp, gap_onion_cache_drop_persistent
+ * version 2.8.xx;  2026.10.18   agent: created
+ */
+
+#ifndef _GAP_ONION_CACHE_H
+#define _GAP_ONION_CACHE_H
+
+#include "config.h"
+
+#include <libgimp/gimp.h>
+
+#include <gap_vin.h>
+
+#define GAP_ONION_CACHE_MAX_ENTRIES           64
+#define GAP_ONION_CACHE_DEFAULT_MAX_BYTESIZE  (64 * 1024 * 1024)
+#define GAP_GIMPRC_ONIONSKIN_CACHE            "video-onionskin-cache"
+
+/* the onion cache keeps loaded (and merged) reference frames as
+ * temporary images (without display) in the gimp core.
+ * Entries are keyed by frame number, the modification time (nanoseconds)
+ * and the size of the frame file (an entry becomes invalid when the frame file changes)
+ * and are evicted in least recently used order when the estimated
+ * memory usage exceeds the configured limit.
+ *
+ * A persistent cache keeps its index via gimp_set_data when closed,
+ * and restores it at the next open (in the next plug-in call
+ * of the same gimp session), so that stepping from frame to frame
+ * reuses the reference frames that were loaded in the previous steps.
+ * The persistent cache is opt-in (gimprc parameter video-onionskin-cache),
+ * gap_onion_cache_drop_persistent deletes the kept images when it is turned off.
+ */
+typedef struct GapOnionCacheEntry {
+   gint32       framenr;
+   gint32       image_id;
+   gint32       layer_id;      /* the merged layer or -1 (loaded but not merged yet) */
+   gint64       mtime_nsec;    /* modification time (nanoseconds) of the frame file at load time */
+   gint64       filesize;      /* size of the frame file at load time */
+   gint64       bytesize;      /* estimated memory usage of the image */
+   guint32      lru_stamp;
+} GapOnionCacheEntry;
+
+typedef struct GapOnionCache {
+   char         basename[1024];
+   char         extension[50];
+   guint        cfg_checksum;       /* checksum of the merge relevant onion settings */
+   gint64       max_bytesize;
+   gint64       used_bytesize;
+   guint32      lru_clock;
+   gint32       last_curr_frame_nr; /* current frame at the previous apply (navigation direction) */
+   gint32       last_delta;
+   gboolean     persistent;
+   gint32       hits;
+   gint32       misses;
+   gint32       count;
+   GapOnionCacheEntry entry[GAP_ONION_CACHE_MAX_ENTRIES];
+} GapOnionCache;
+
+
+gint64          gap_onion_cache_get_gimprc_bytesize(void);
+
+GapOnionCache * gap_onion_cache_open(const char *basename, const char *extension
+                   , GapVinVideoInfo *vin_ptr, gboolean persistent);
+void            gap_onion_cache_close(GapOnionCache *cache);
+void            gap_onion_cache_flush(GapOnionCache *cache);
+void            gap_onion_cache_drop_persistent(void);
+
+/* the following procedures match the GapOnionBaseFptrFindFrameInImageCache
+ * and GapOnionBaseFptrAddImageToCache function types
+ * (the cache is passed as gpp_void)
+ */
+gint32          gap_onion_cache_find_frame(void *cache_void
+                   , gint32 framenr, gint32 *image_id, gint32 *layer_id);
+void            gap_onion_cache_add_image(void *cache_void
+                   , gint32 framenr, gint32 image_id, gint32 layer_id);
+
+gint32          gap_onion_cache_get_prefetch_frame_nr(GapOnionCache *cache, gint32 curr_frame_nr);
+
+#endif
@@ -286,7 +286,7 @@ run(const gchar *name
   gap_onion_worker_get_data_onion_cfg(gpp);  /* get current params (if there are any) */
 
   gpp->vin.onionskin_auto_enable = TRUE;
-  gpp->cache.count = 0;    /* start with empty image cache */
+  gpp->cache = NULL;       /* image cache is opened at range processing */
   gpp->image_ID    = param[1].data.d_image;
 
   gpp->range_from            = gpp->ainfo.curr_frame_nr;
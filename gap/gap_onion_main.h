@@ -64,6 +64,7 @@
 #include <gap_layer_copy.h>
 
 #include <gap_onion_base.h>
+#include <gap_onion_cache.h>
 #include <gap_vin.h>
 
 
@@ -78,10 +79,6 @@
 #define GAP_ONION_RUN_APPLY   2
 #define GAP_ONION_RUN_DELETE  3
 
-/* how many frames are kept in cache for range processing */
-#define GAP_ONION_CACHE_SIZE  12
-
-
 /* note: plugin mames starting with plug_in_gap_
  * cannot be used as filter in other gap functions (Video->Frames Modify)
  * that is the reason why MAKE and DEL names do not contain "gap"
@@ -97,21 +94,12 @@ typedef struct GapOnionMainAinfo {
    gdouble      framerate;
 } GapOnionMainAinfo;
 
-typedef struct GapOnionMainImageCache {
-   gint32       count;
-   gint32       framenr[GAP_ONION_CACHE_SIZE];
-   gint32       image_id[GAP_ONION_CACHE_SIZE];
-   gint32       layer_id[GAP_ONION_CACHE_SIZE];
-} GapOnionMainImageCache;
-
-
-
 typedef struct {
   GapVinVideoInfo  vin;
   gint    run;
 
   GapOnionMainAinfo     ainfo;
-  GapOnionMainImageCache cache;
+  GapOnionCache        *cache;   /* image cache for range processing (NULL if not open) */
   gint32  range_from;
   gint32  range_to;
   gint32  image_ID;        /* -1 if there is no valid current image */
@@ -24,6 +24,8 @@
  */
 
 /* revision history:
+ * version 2.8.xx;  2026.10.18   agent: use gap_onion_cache (LRU limited by memory size)
+ *                                     instead of the fixed size image cache
  * version 1.3.16c; 2003.07.09   hof: splitted off gap_onion_base.c (for automatic apply)
  * version 1.3.16b; 2003.07.06   hof: bugfixes, added parameter asc_opacity
  * version 1.3.14a; 2003.05.24   hof: integration into gimp-gap-1.3.14
@@ -37,139 +39,42 @@ extern int gap_debug;
 
 /* ============================================================================
  * p_find_frame_in_img_cache
- *    return delete image (with workaround to ensure that most of the
+ *    deliver image_id and layer_id of framenr from the image cache.
  *    return -1 if nothing was found.
  * ============================================================================
  */
-gint32
+static gint32
 p_find_frame_in_img_cache(void *gpp_void
                          , gint32 framenr, gint32 *image_id, gint32 *layer_id)
 {
   GapOnionMainGlobalParams *gpp;
-  gint32 l_idx;
-  *image_id = -1;
-  *layer_id = -1;
 
   gpp = (GapOnionMainGlobalParams *)gpp_void;
-
-  for(l_idx = 0; l_idx < MIN(gpp->cache.count, GAP_ONION_CACHE_SIZE); l_idx++)
-  {
-    if(framenr == gpp->cache.framenr[l_idx])
-    {
-      *image_id = gpp->cache.image_id[l_idx];
-      *layer_id = gpp->cache.layer_id[l_idx];
-      return (l_idx);
-    }
-  }
-  return (-1);
+  return (gap_onion_cache_find_frame(gpp->cache, framenr, image_id, layer_id));
 }       /* end p_find_frame_in_img_cache */
 
 /* ============================================================================
  * p_add_img_to_cache
  *    add image_id and layer_id to the image cache.
- *    the image cache is a list of temporary images (without display)
- *    and contains frames that were processed in the previous steps
+ *    the image cache holds temporary images (without display)
+ *    of frames that were processed in the previous steps
  *    of the onionskin layer processing.
  *    - a layer_id of -1 is used, if the image was loaded, but not
  *      merged.
- *    - If the framenr is already in the cache
- *      ??
- *    - If the cache is full, the oldest image_id is deleted
- *      and removed from the cache
  *    - Do not add the current image to the cache !!
  * ============================================================================
  */
-void
+static void
 p_add_img_to_cache (void *gpp_void, gint32 framenr, gint32 image_id, gint32 layer_id)
 {
   GapOnionMainGlobalParams *gpp;
-  gint32 l_idx;
 
   gpp = (GapOnionMainGlobalParams *)gpp_void;
-
-  if(gap_debug)
-  {
-     printf("p_add_img_to_cache: cache.count: %d)\n", (int)gpp->cache.count);
-     printf("PARAMS framenr: %d image_id: %d layer_id: %d\n"
-           , (int)framenr
-           , (int)image_id
-           , (int)layer_id
-           );
-  }
-  for(l_idx = 0; l_idx < MIN(gpp->cache.count, GAP_ONION_CACHE_SIZE); l_idx++)
-  {
-    if(framenr == gpp->cache.framenr[l_idx])
-    {
-      /* an image with this framenr is already in the cache */
-      if(gap_debug) printf("p_add_img_to_cache: framenr already in cache at index: %d)\n", (int)l_idx);
-
-      if( gpp->cache.layer_id[l_idx] >= 0)
-      {
-        /* the cached image has aready merged layers */
-        return;
-      }
-      if(layer_id >= 0)
-      {
-         /* update the chache with the id of the merged layer */
-         gpp->cache.image_id[l_idx] = image_id;
-         gpp->cache.layer_id[l_idx] = layer_id;
-      }
-      return;
-    }
-  }
-  if(l_idx < GAP_ONION_CACHE_SIZE)
-  {
-    gpp->cache.count++;
-  }
-  else
-  {
-    if(gap_debug)
-    {
-      printf("p_add_img_to_cache: FULL CACHE delete oldest entry\n");
-    }
-    /* cache is full, so delete 1.st (oldest) entry */
-    gap_image_delete_immediate(gpp->cache.image_id[0]);
-
-    /* shift all entries down one index step */
-    for(l_idx = 0; l_idx <  GAP_ONION_CACHE_SIZE -1; l_idx++)
-    {
-      gpp->cache.framenr[l_idx] = gpp->cache.framenr[l_idx +1];
-      gpp->cache.image_id[l_idx] = gpp->cache.image_id[l_idx +1];
-      gpp->cache.layer_id[l_idx] = gpp->cache.layer_id[l_idx +1];
-    }
-    /* l_idx = GAP_ONION_CACHE_SIZE -1; */
-  }
-
-  if(gap_debug)
-  {
-    printf("p_add_img_to_cache: new entry ADDED at IMAGECACHE index: %d\n", (int)l_idx);
-  }
-  gpp->cache.framenr[l_idx] = framenr;
-  gpp->cache.image_id[l_idx] = image_id;
-  gpp->cache.layer_id[l_idx] = layer_id;
+  gap_onion_cache_add_image(gpp->cache, framenr, image_id, layer_id);
 }       /* end p_add_img_to_cache */
 
 
 
-/* ============================================================================
- * p_delete_img_cache
- *    delete all images in the cache, and set the cache empty.
- * ============================================================================
- */
-static void
-p_delete_img_cache (GapOnionMainGlobalParams *gpp)
-{
-  gint32 l_idx;
-
-  if(gap_debug) printf("gap_image_delete_immediate: cache.count: %d)\n", (int)gpp->cache.count);
-  for(l_idx = 0; l_idx < MIN(gpp->cache.count, GAP_ONION_CACHE_SIZE); l_idx++)
-  {
-    gap_image_delete_immediate(gpp->cache.image_id[l_idx]);
-  }
-  gpp->cache.count = 0;
-}       /* end p_delete_img_cache */
-
-
 /* ============================================================================
  * gap_onion_worker_plug_in_gap_get_animinfo
  *      get informations about the animation
@@ -381,6 +286,11 @@ gap_onion_worker_onion_range(GapOnionMainGlobalParams *gpp)
     return -1;
   }
 
+  gpp->cache = gap_onion_cache_open(gpp->ainfo.basename, gpp->ainfo.extension
+                                   , &gpp->vin
+                                   , FALSE    /* not persistent */
+                                   );
+
   l_curr_frame_nr = gpp->ainfo.curr_frame_nr;
   l_frame_nr = l_begin;
   while(1)
@@ -410,7 +320,8 @@ gap_onion_worker_onion_range(GapOnionMainGlobalParams *gpp)
         if(gpp->image_ID < 0)
         {
           g_free(l_new_filename);
-          return -1;
+          l_rc = -1;
+          break;
         }
       }
       else
@@ -419,8 +330,6 @@ gap_onion_worker_onion_range(GapOnionMainGlobalParams *gpp)
         l_new_filename = NULL;
         goto continue_with_next_frame;
       }
-      /* add image to cache */
-      p_add_img_to_cache(gpp, l_frame_nr, gpp->image_ID, -1);
     }
 
     if(gpp->run == GAP_ONION_RUN_APPLY)
@@ -440,7 +349,19 @@ gap_onion_worker_onion_range(GapOnionMainGlobalParams *gpp)
     if(l_rc < 0)
     {
        g_free(l_new_filename);
-       return -1;
+       if (l_curr_frame_nr != l_frame_nr)
+       {
+         gap_image_delete_immediate(gpp->image_ID);
+       }
+       break;
+    }
+
+    if (l_curr_frame_nr != l_frame_nr)
+    {
+      /* add image to cache (after save, because the cache entry
+       * is keyed by the modification time of the frame file)
+       */
+      p_add_img_to_cache(gpp, l_frame_nr, gpp->image_ID, -1);
     }
 
 continue_with_next_frame:
@@ -474,7 +395,12 @@ continue_with_next_frame:
   }
 
   /* clean up the cache (delete all cached temp images) */
-  p_delete_img_cache(gpp);
+  gap_onion_cache_close(gpp->cache);
+  gpp->cache = NULL;
 
+  if(l_rc < 0)
+  {
+    return -1;
+  }
   return 0; /* OK */
 }       /* end gap_onion_worker_onion_range */
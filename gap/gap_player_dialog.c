@@ -28,6 +28,8 @@
  */
 
 /* Revision history
+ *  (2026/10/18)  v2.8.xx    agent: - playback timing statistics
+ *  (2026/10/18)  v2.8.xx    agent: - read-ahead of the next frames into the player cache
  *  (2007/11/01)  v2.3.0     hof: - gimprc changed to "show-tooltips" with gimp-2.4
  *  (2004/11/12)  v2.1.0     hof: - added help button
  *  (2004/03/17)  v1.3.27a   hof: - go_timer does check if video api is busy and retries
@@ -384,6 +386,18 @@ static guchar * p_fetch_videoframe_via_cache(GapPlayerMainGlobalParams *gpp
 static void     p_frame_chache_processing(GapPlayerMainGlobalParams *gpp
                    , const gchar *ckey);
 static void     p_update_cache_status (GapPlayerMainGlobalParams *gpp);
+static gint32   p_calculate_next_framenr(GapPlayerMainGlobalParams *gpp
+                   , gint32    current_framenr
+                   , gboolean *play_backward
+                   , gint32   *pingpong_count
+                   , gboolean *range_end_reached
+                   );
+static gchar *  p_readahead_new_ckey(GapPlayerMainGlobalParams *gpp, gint32 framenr);
+static void     p_readahead_insert_results(GapPlayerMainGlobalParams *gpp);
+static void     p_update_stats_status(GapPlayerMainGlobalParams *gpp);
+static void     p_readahead_update(GapPlayerMainGlobalParams *gpp);
+static void     p_readahead_cancel(GapPlayerMainGlobalParams *gpp);
+static void     p_readahead_free(GapPlayerMainGlobalParams *gpp);
 
 static void     p_audio_startup_server(GapPlayerMainGlobalParams *gpp);
 static gint32       p_get_audio_relevant_FrameNr(GapPlayerMainGlobalParams *gpp, gint32 framenr);
@@ -2361,8 +2375,10 @@ p_stop_playback(GapPlayerMainGlobalParams *gpp)
   gpp->request_cancel_video_api = TRUE;
   gpp->play_is_active = FALSE;
   gpp->pingpong_count = 0;
+  p_readahead_cancel(gpp);
 
   gtk_label_set_text ( GTK_LABEL(gpp->status_label), _("Ready"));
+  p_update_stats_status(gpp);
 
   p_check_tooltips();
   p_audio_stop(gpp);
@@ -3206,6 +3222,7 @@ p_init_video_playback_cache(GapPlayerMainGlobalParams *gpp)
 {
   gpp->max_player_cache = gap_player_cache_get_gimprc_bytesize();
   gap_player_cache_set_max_bytesize(gpp->max_player_cache);
+  gpp->readahead_frames = gap_player_readahead_get_gimprc_frames();
 }  /* end p_init_video_playback_cache */
 
 /* -----------------------------
@@ -3312,9 +3329,11 @@ p_fetch_frame_via_cache(GapPlayerMainGlobalParams *gpp
   cdata = NULL;
   th_data = NULL;
 
-  if (gpp->mtrace_mode == GAP_PLAYER_MTRACE_OFF)
+  if ((gpp->mtrace_mode == GAP_PLAYER_MTRACE_OFF)
+  && (ckey != NULL))
   {
     cdata = gap_player_cache_lookup(ckey);
+    gap_player_stats_record_cache_lookup(&gpp->stats, (cdata != NULL));
   }
   if(cdata != NULL)
   {
@@ -3518,6 +3537,290 @@ p_frame_chache_processing(GapPlayerMainGlobalParams *gpp
 }  /* end p_frame_chache_processing */
 
 
+/* ------------------------------
+ * p_readahead_new_ckey
+ * ------------------------------
+ * build the player cache key for the specified frame
+ * (same key as used by p_display_frame)
+ */
+static gchar *
+p_readahead_new_ckey(GapPlayerMainGlobalParams *gpp, gint32 framenr)
+{
+  gchar *ckey;
+  gchar *l_filename;
+
+  if(gpp->ainfo_ptr->ainfo_type == GAP_AINFO_MOVIE)
+  {
+    return (gap_player_cache_new_movie_key(gpp->ainfo_ptr->old_filename
+                         , framenr
+                         , gpp->ainfo_ptr->seltrack
+                         , gpp->ainfo_ptr->delace
+                         ));
+  }
+
+  l_filename = gap_lib_alloc_fname(gpp->ainfo_ptr->basename, framenr, gpp->ainfo_ptr->extension);
+  ckey = gap_player_cache_new_image_key(l_filename);
+  g_free(l_filename);
+
+  return (ckey);
+}  /* end p_readahead_new_ckey */
+
+
+/* ------------------------------
+ * p_readahead_insert_results
+ * ------------------------------
+ * move the frames that were completed by the read-ahead worker
+ * into the player cache.
+ */
+static void
+p_readahead_insert_results(GapPlayerMainGlobalParams *gpp)
+{
+  gint32  l_framenr;
+  guchar *l_th_data;
+  gint32  l_th_width;
+  gint32  l_th_height;
+  gint32  l_th_bpp;
+
+  while(gap_player_readahead_pop_result(gpp->readahead
+                                       , &l_framenr
+                                       , &l_th_data
+                                       , &l_th_width
+                                       , &l_th_height
+                                       , &l_th_bpp
+                                       ))
+  {
+    GapPlayerCacheData *cdata;
+    gchar              *ckey;
+
+    ckey = p_readahead_new_ckey(gpp, l_framenr);
+    if(gap_player_cache_lookup(ckey) != NULL)
+    {
+      /* the frame was displayed (and cached) while the worker was fetching it */
+      g_free(l_th_data);
+      g_free(ckey);
+      continue;
+    }
+
+    /* the read-ahead buffers are not flipped (the flip is applied at rendering) */
+    cdata = gap_player_cache_new_data(l_th_data
+             , l_th_width * l_th_height * l_th_bpp
+             , l_th_width
+             , l_th_height
+             , l_th_bpp
+             , gpp->cache_compression
+             , GAP_STB_FLIP_NONE
+             );
+    if(cdata != NULL)
+    {
+      gap_player_cache_insert(ckey, cdata);
+    }
+    else
+    {
+      g_free(l_th_data);
+    }
+    g_free(ckey);
+  }
+
+}  /* end p_readahead_insert_results */
+
+
+/* ------------------------------
+ * p_readahead_update
+ * ------------------------------
+ * called after each playback timer cycle.
+ * collects the frames that were completed by the read-ahead worker
+ * and requests the next frames in playback order that are not yet cached.
+ * The number of requested frames is limited by the gimprc setting
+ * video_player_readahead_frames and to a quarter of the player cache size.
+ *
+ * The worker is canceled when the displayed frame is not one
+ * of the previously predicted frames (the user did seek or changed
+ * the playback direction).
+ *
+ * Note: storyboard playback and MTRACE mode are not supported
+ * (storyboard frames are composed via gimp, which is not possible
+ * in a thread).
+ */
+static void
+p_readahead_update(GapPlayerMainGlobalParams *gpp)
+{
+  GapPlayerReadaheadSourceType l_source_type;
+  const char *l_basename;
+  gint32      l_request_tab[GAP_PLAYER_READAHEAD_MAX_FRAMES];
+  gint32      l_request_count;
+  gint32      l_max_frames;
+  gint32      l_frame_size;
+  gint32      l_framenr;
+  gint32      l_pingpong_count;
+  gboolean    l_play_backward;
+  gboolean    l_range_end_reached;
+  gboolean    l_seek_detected;
+  gint32      ii;
+
+  if(!gpp->play_is_active)
+  {
+    p_readahead_cancel(gpp);
+    return;
+  }
+  if((gpp->readahead_frames <= 0)
+  || (gpp->max_player_cache <= 0)
+  || (gpp->stb_ptr != NULL)
+  || (gpp->mtrace_mode != GAP_PLAYER_MTRACE_OFF)
+  || (gpp->ainfo_ptr == NULL)
+  || (gpp->pv_ptr == NULL))
+  {
+    p_readahead_free(gpp);
+    return;
+  }
+
+  if(gpp->ainfo_ptr->ainfo_type == GAP_AINFO_MOVIE)
+  {
+    l_source_type = GAP_PLAYER_READAHEAD_MOVIE;
+    l_basename = gpp->ainfo_ptr->old_filename;
+  }
+  else
+  {
+    if(gpp->ainfo_ptr->frame_cnt <= 0)
+    {
+      p_readahead_free(gpp);
+      return;
+    }
+    l_source_type = GAP_PLAYER_READAHEAD_FRAMES;
+    l_basename = gpp->ainfo_ptr->basename;
+  }
+
+  if(!gap_player_readahead_matches(gpp->readahead
+          , l_source_type
+          , l_basename
+          , gpp->ainfo_ptr->extension
+          , gpp->ainfo_ptr->seltrack
+          , gpp->ainfo_ptr->delace
+          , gpp->pv_ptr->pv_width
+          , gpp->pv_ptr->pv_height
+          , gpp->use_thumbnails
+          ))
+  {
+    p_readahead_free(gpp);
+    gpp->readahead = gap_player_readahead_new(l_source_type
+          , l_basename
+          , gpp->ainfo_ptr->extension
+          , gpp->ainfo_ptr->seltrack
+          , gpp->ainfo_ptr->delace
+          , gpp->preferred_decoder
+          , gpp->pv_ptr->pv_width
+          , gpp->pv_ptr->pv_height
+          , gpp->use_thumbnails
+          , gpp->readahead_frames
+          );
+    if(gpp->readahead == NULL)
+    {
+      /* read-ahead is not available (no thread support or videofile could not be opened),
+       * turn it off for this player session
+       */
+      gpp->readahead_frames = 0;
+      return;
+    }
+  }
+
+  /* check for seek or change of playback direction */
+  l_seek_detected = (gpp->readahead_plan_count > 0);
+  for(ii = 0; ii < gpp->readahead_plan_count; ii++)
+  {
+    if(gpp->readahead_plan_tab[ii] == gpp->play_current_framenr)
+    {
+      l_seek_detected = FALSE;
+      break;
+    }
+  }
+  if(l_seek_detected)
+  {
+    gap_player_readahead_cancel(gpp->readahead);
+  }
+
+  p_readahead_insert_results(gpp);
+
+  /* limit the read-ahead to a quarter of the player cache size */
+  l_frame_size = MAX(1, gpp->pv_ptr->pv_width * gpp->pv_ptr->pv_height * 4);
+  l_max_frames = MIN(gpp->readahead_frames, (gpp->max_player_cache / 4) / l_frame_size);
+  l_max_frames = MIN(l_max_frames, GAP_PLAYER_READAHEAD_MAX_FRAMES);
+
+  /* predict the next frames (on copies of the playback state) */
+  l_framenr = gpp->play_current_framenr;
+  l_play_backward = gpp->play_backward;
+  l_pingpong_count = gpp->pingpong_count;
+  l_request_count = 0;
+  gpp->readahead_plan_count = 0;
+  for(ii = 0; ii < l_max_frames; ii++)
+  {
+    gchar *ckey;
+
+    l_framenr = p_calculate_next_framenr(gpp
+                   , l_framenr
+                   , &l_play_backward
+                   , &l_pingpong_count
+                   , &l_range_end_reached
+                   );
+    if(l_framenr < 0)
+    {
+      break;
+    }
+    gpp->readahead_plan_tab[gpp->readahead_plan_count] = l_framenr;
+    gpp->readahead_plan_count++;
+
+    if((l_source_type == GAP_PLAYER_READAHEAD_FRAMES)
+    && (gpp->imagename == NULL)
+    && (l_framenr == gpp->ainfo_ptr->curr_frame_nr))
+    {
+      /* the active image is rendered from the gimp image (that may have unsaved changes) */
+      continue;
+    }
+
+    ckey = p_readahead_new_ckey(gpp, l_framenr);
+    if(gap_player_cache_lookup(ckey) == NULL)
+    {
+      l_request_tab[l_request_count] = l_framenr;
+      l_request_count++;
+    }
+    g_free(ckey);
+  }
+
+  gap_player_readahead_set_requests(gpp->readahead, l_request_tab, l_request_count);
+  p_update_cache_status(gpp);
+
+}  /* end p_readahead_update */
+
+
+/* ------------------------------
+ * p_readahead_cancel
+ * ------------------------------
+ */
+static void
+p_readahead_cancel(GapPlayerMainGlobalParams *gpp)
+{
+  gpp->readahead_plan_count = 0;
+  if(gpp->readahead != NULL)
+  {
+    gap_player_readahead_cancel(gpp->readahead);
+  }
+}  /* end p_readahead_cancel */
+
+
+/* ------------------------------
+ * p_readahead_free
+ * ------------------------------
+ */
+static void
+p_readahead_free(GapPlayerMainGlobalParams *gpp)
+{
+  gpp->readahead_plan_count = 0;
+  if(gpp->readahead != NULL)
+  {
+    gap_player_readahead_free(gpp->readahead);
+    gpp->readahead = NULL;
+  }
+}  /* end p_readahead_free */
+
+
 
 
 /* --------------------------------
@@ -3901,11 +4204,13 @@ p_render_display_free_pixbuf(GapPlayerMainGlobalParams *gpp
     /* copy pixbuf as layer into the mtrace_image (only of mtrace_mode not OFF) */
     p_mtrace_pixbuf(gpp, pixbuf);
 
+    gap_player_stats_start_render(&gpp->stats);
     gap_pview_render_f_from_pixbuf (gpp->pv_ptr
                                    , pixbuf
                                    , flip_request
                                    , flip_status
                                    );
+    gap_player_stats_stop_render(&gpp->stats);
     g_object_unref(pixbuf);
 }  /* end p_render_display_free_pixbuf */
 
@@ -3937,6 +4242,7 @@ p_render_display_free_thdata(GapPlayerMainGlobalParams *gpp
                , th_bpp
                );
 
+  gap_player_stats_start_render(&gpp->stats);
   th_data_was_grabbed = gap_pview_render_f_from_buf (gpp->pv_ptr
                , th_data
                , th_width
@@ -3946,6 +4252,7 @@ p_render_display_free_thdata(GapPlayerMainGlobalParams *gpp
                , flip_request
                , flip_status
                );
+  gap_player_stats_stop_render(&gpp->stats);
   if(th_data_was_grabbed)
   {
     /* the gap_pview_render_f_from_buf procedure can grab the th_data
@@ -3993,11 +4300,13 @@ p_render_display_free_image_id(GapPlayerMainGlobalParams *gpp
   /* copy image as layer into the mtrace_image (only if mtrace_mode not OFF) */
   p_mtrace_image(gpp, image_id);
 
+  gap_player_stats_start_render(&gpp->stats);
   gap_pview_render_f_from_image (gpp->pv_ptr
                                , image_id
                                , flip_request
                                , flip_status
                                );
+  gap_player_stats_stop_render(&gpp->stats);
   gimp_image_delete(image_id);
 
 }  /* end p_render_display_free_image_id */
@@ -4134,6 +4443,7 @@ p_display_frame(GapPlayerMainGlobalParams *gpp, gint32 framenr)
   }
 
   GAP_TIMM_START_FUNCTION(funcId);
+  gap_player_stats_start_frame(&gpp->stats);
 
   ckey = NULL;
   l_th_data = NULL;
@@ -4529,14 +4839,27 @@ p_get_available_frame_number(GapPlayerMainGlobalParams *gpp, gint32  framenr, gi
 
 
 /* ------------------------------
- * p_get_next_framenr_in_sequence /2
+ * p_calculate_next_framenr
  * ------------------------------
+ * calculate the frame number that follows current_framenr in playback order
+ * according to the play_loop, play_pingpong and play_selection_only settings.
+ * the playback direction and pingpong counter are passed as IN/OUT parameters
+ * (this allows the read-ahead to predict the next frames on copies
+ * without changing the playback state).
+ * range_end_reached is set to TRUE when the first or last frame was passed.
+ * returns -1 when playback shall STOP.
  */
-gint32
-p_get_next_framenr_in_sequence2(GapPlayerMainGlobalParams *gpp)
+static gint32
+p_calculate_next_framenr(GapPlayerMainGlobalParams *gpp
+   , gint32    current_framenr
+   , gboolean *play_backward
+   , gint32   *pingpong_count
+   , gboolean *range_end_reached
+   )
 {
   gint32 l_first;
   gint32 l_last;
+  gint32 l_framenr;
   gint   l_stepsize;
   
   l_first = gpp->ainfo_ptr->first_frame_nr;
@@ -4547,85 +4870,87 @@ p_get_next_framenr_in_sequence2(GapPlayerMainGlobalParams *gpp)
     l_last  = gpp->end_frame;
   }
 
+  l_framenr = current_framenr;
+  *range_end_reached = FALSE;
 
-  if(gpp->play_backward)
+  if(*play_backward)
   {
-    if(gpp->play_current_framenr <= l_first)
+    if(l_framenr <= l_first)
     {
-      p_audio_resync(gpp);
+      *range_end_reached = TRUE;
       if(gpp->play_loop)
       {
         if(gpp->play_pingpong)
         {
-          gpp->play_current_framenr = l_first + 1;
-          gpp->play_backward = FALSE;
-          gpp->pingpong_count++;
+          l_framenr = l_first + 1;
+          *play_backward = FALSE;
+          (*pingpong_count)++;
         }
         else
         {
-          gpp->play_current_framenr = l_last;
+          l_framenr = l_last;
         }
       }
       else
       {
-        if((gpp->play_pingpong) && (gpp->pingpong_count <= 0))
+        if((gpp->play_pingpong) && (*pingpong_count <= 0))
         {
-          gpp->play_current_framenr = l_first + 1;
-          gpp->play_backward = FALSE;
-          gpp->pingpong_count++;
+          l_framenr = l_first + 1;
+          *play_backward = FALSE;
+          (*pingpong_count)++;
         }
         else
         {
-          gpp->pingpong_count = 0;
+          *pingpong_count = 0;
           return -1;  /* STOP if first frame reached */
         }
       }
     }
     else
     {
-      gpp->play_current_framenr--;
+      l_framenr--;
     }
   }
   else
   {
-    if(gpp->play_current_framenr >= l_last)
+    if(l_framenr >= l_last)
     {
-      p_audio_resync(gpp);
+      *range_end_reached = TRUE;
       if(gpp->play_loop)
       {
         if(gpp->play_pingpong)
         {
-          gpp->play_current_framenr = l_last - 1;
-          gpp->play_backward = TRUE;
-          gpp->pingpong_count++;
+          l_framenr = l_last - 1;
+          *play_backward = TRUE;
+          (*pingpong_count)++;
         }
         else
         {
-          gpp->play_current_framenr = l_first;
+          l_framenr = l_first;
         }
       }
       else
       {
-        if((gpp->play_pingpong) && (gpp->pingpong_count <= 0))
+        if((gpp->play_pingpong) && (*pingpong_count <= 0))
         {
-          gpp->play_current_framenr = l_last - 1;
-          gpp->play_backward = TRUE;
-          gpp->pingpong_count++;
+          l_framenr = l_last - 1;
+          *play_backward = TRUE;
+          (*pingpong_count)++;
         }
         else
         {
-          gpp->pingpong_count = 0;
+          *pingpong_count = 0;
           return -1;  /* STOP if last frame reached */
         }
       }
     }
     else
     {
-      gpp->play_current_framenr++;
+      l_framenr++;
     }
   }
 
-  if (gpp->play_backward)
+  if (*play_backward)
   {
     l_stepsize = -1;
   }
@@ -4634,12 +4959,38 @@ p_get_next_framenr_in_sequence2(GapPlayerMainGlobalParams *gpp)
     l_stepsize = 1;
   }
 
-  gpp->play_current_framenr =
-     p_get_available_frame_number(gpp, gpp->play_current_framenr, l_stepsize);
+  l_framenr = p_get_available_frame_number(gpp, l_framenr, l_stepsize);
 
+  return (CLAMP(l_framenr, l_first, l_last));
+}  /* end p_calculate_next_framenr */
+
+
+/* ------------------------------
+ * p_get_next_framenr_in_sequence /2
+ * ------------------------------
+ */
+gint32
+p_get_next_framenr_in_sequence2(GapPlayerMainGlobalParams *gpp)
+{
+  gint32   l_framenr;
+  gboolean l_range_end_reached;
 
+  l_framenr = p_calculate_next_framenr(gpp
+                 , gpp->play_current_framenr
+                 , &gpp->play_backward
+                 , &gpp->pingpong_count
+                 , &l_range_end_reached
+                 );
+  if(l_range_end_reached)
+  {
+    p_audio_resync(gpp);
+  }
+  if(l_framenr < 0)
+  {
+    return -1;
+  }
 
-  gpp->play_current_framenr = CLAMP(gpp->play_current_framenr, l_first, l_last);
+  gpp->play_current_framenr = l_framenr;
   return (gpp->play_current_framenr);
 }  /* end p_get_next_framenr_in_sequence2 */
 
@@ -4863,6 +5214,7 @@ on_timer_playback(GapPlayerMainGlobalParams *gpp)
               * until we are in time again
               */
              l_frame_dropped = TRUE;
+             gap_player_stats_record_dropped(&gpp->stats);
              /* printf("DROP (SKIP) frame\n"); */
              gtk_label_set_text ( GTK_LABEL(gpp->status_label), _("Skip"));
            }
@@ -4889,6 +5241,11 @@ on_timer_playback(GapPlayerMainGlobalParams *gpp)
            }
 
            l_delay = gpp->delay_secs - gpp->rest_secs;
+           if(!l_frame_dropped)
+           {
+             /* the displayed frame missed its deadline */
+             gap_player_stats_record_late(&gpp->stats);
+           }
 
            /* no time left at this point, try to display (or drop) next frame immediate */
            if(!l_frame_dropped)
@@ -4899,6 +5256,15 @@ on_timer_playback(GapPlayerMainGlobalParams *gpp)
          }
        }    /* end for */
 
+       /* fill the player cache with the next frames while the current frame is displayed */
+       p_readahead_update(gpp);
+
+       /* refresh the statistics display about once per second */
+       if(((gint32)gpp->framecnt % MAX(1, (gint32)gpp->speed)) == 0)
+       {
+         p_update_stats_status(gpp);
+       }
+
        /* keep track of absolute delay (since start or speed change) just for display purposes */
        gpp->delay_secs = l_delay;
 
@@ -4974,6 +5340,7 @@ on_timer_go_job(GapPlayerMainGlobalParams *gpp)
       else
       {
         /*if(gap_debug) printf("on_timer_go_job: DISPLAY RENDER %06d\n", (int)gpp->go_job_framenr); */
+        p_readahead_cancel(gpp);
         p_display_frame(gpp, gpp->go_job_framenr);
       }
     }
@@ -6311,6 +6678,7 @@ on_shell_window_destroy                (GtkObject       *object,
   if(gpp)
   {
     p_stop_playback(gpp);
+    p_readahead_free(gpp);
   }
 
   gpp->shell_window = NULL;
@@ -7318,7 +7686,17 @@ p_update_cache_status (GapPlayerMainGlobalParams *gpp)
   bytes_used = gap_player_cache_get_current_bytes_used();
   max_bytes = gap_player_cache_get_max_bytesize();
 
-  g_snprintf(status_txt, sizeof(status_txt), "%d", (int)elem_counter);
+  if(gpp->readahead != NULL)
+  {
+    g_snprintf(status_txt, sizeof(status_txt), _("%d  (read-ahead: %d)")
+              , (int)elem_counter
+              , (int)gap_player_readahead_get_depth(gpp->readahead)
+              );
+  }
+  else
+  {
+    g_snprintf(status_txt, sizeof(status_txt), "%d", (int)elem_counter);
+  }
   gtk_label_set_text ( GTK_LABEL(gpp->label_current_cache_values)
                      , status_txt);
 
@@ -7437,6 +7815,146 @@ on_cache_clear_button_clicked (GtkButton       *button,
 }  /* end on_cache_clear_button_clicked */
 
 
+/* -----------------------------------------
+ * p_update_stats_status
+ * -----------------------------------------
+ */
+static void
+p_update_stats_status(GapPlayerMainGlobalParams *gpp)
+{
+  gchar *summary;
+
+  if(gpp->label_playback_stats == NULL)
+  {
+    return;
+  }
+  summary = gap_player_stats_get_summary(&gpp->stats);
+  gtk_label_set_text(GTK_LABEL(gpp->label_playback_stats), summary);
+  g_free(summary);
+}  /* end p_update_stats_status */
+
+
+/* -----------------------------------------
+ * on_stats_reset_button_clicked
+ * -----------------------------------------
+ */
+static void
+on_stats_reset_button_clicked (GtkButton       *button,
+                               GapPlayerMainGlobalParams *gpp)
+{
+  if(gpp == NULL)
+  {
+    return;
+  }
+  gap_player_stats_reset(&gpp->stats);
+  p_update_stats_status(gpp);
+}  /* end on_stats_reset_button_clicked */
+
+
+/* -----------------------------------------
+ * on_stats_filesel_close_cb
+ * -----------------------------------------
+ */
+static void
+on_stats_filesel_close_cb(GtkWidget *widget, GapPlayerMainGlobalParams *gpp)
+{
+  if(gpp == NULL)
+  {
+    return;
+  }
+  if(gpp->stats_filesel == NULL)
+  {
+    return;  /* filesel is already closed */
+  }
+
+  gtk_widget_destroy(GTK_WIDGET(gpp->stats_filesel));
+  gpp->stats_filesel = NULL;
+}  /* end on_stats_filesel_close_cb */
+
+
+/* -----------------------------------------
+ * on_stats_filesel_ok_cb
+ * -----------------------------------------
+ */
+static void
+on_stats_filesel_ok_cb(GtkWidget *widget, GapPlayerMainGlobalParams *gpp)
+{
+  const gchar *filename;
+
+  if(gpp == NULL)
+  {
+    return;
+  }
+  if(gpp->stats_filesel == NULL)
+  {
+    return;  /* filesel is already closed */
+  }
+
+  filename = gtk_file_selection_get_filename (GTK_FILE_SELECTION (gpp->stats_filesel));
+  if(filename)
+  {
+    if(*filename != '\0')
+    {
+      if(!gap_player_stats_save_report(&gpp->stats, filename))
+      {
+        gint l_errno;
+
+        l_errno = errno;
+        g_message (_("Failed to write playback statistics\n"
+                     "filename: '%s':\n%s")
+                  , filename
+                  , g_strerror (l_errno)
+                  );
+      }
+    }
+  }
+
+  on_stats_filesel_close_cb(widget, gpp);
+}  /* end on_stats_filesel_ok_cb */
+
+
+/* -----------------------------------------
+ * on_stats_save_button_clicked
+ * -----------------------------------------
+ */
+static void
+on_stats_save_button_clicked (GtkButton       *button,
+                               GapPlayerMainGlobalParams *gpp)
+{
+  if(gpp == NULL)
+  {
+    return;
+  }
+  if(gpp->stats_filesel)
+  {
+    gtk_window_present(GTK_WINDOW(gpp->stats_filesel));
+    return;  /* filesection dialog is already open */
+  }
+
+  gpp->stats_filesel = gtk_file_selection_new (_("Save Playback Statistics"));
+
+  gtk_window_set_position (GTK_WINDOW (gpp->stats_filesel), GTK_WIN_POS_MOUSE);
+
+  gtk_file_selection_set_filename (GTK_FILE_SELECTION (gpp->stats_filesel),
+                                   "gap_player_stats.txt");
+  gtk_widget_show (gpp->stats_filesel);
+
+  g_signal_connect (G_OBJECT (gpp->stats_filesel), "destroy",
+                    G_CALLBACK (on_stats_filesel_close_cb),
+                    gpp);
+
+  g_signal_connect (G_OBJECT (GTK_FILE_SELECTION (gpp->stats_filesel)->ok_button),
+                   "clicked",
+                    G_CALLBACK (on_stats_filesel_ok_cb),
+                    gpp);
+  g_signal_connect (G_OBJECT (GTK_FILE_SELECTION (gpp->stats_filesel)->cancel_button),
+                   "clicked",
+                    G_CALLBACK (on_stats_filesel_close_cb),
+                    gpp);
+
+}  /* end on_stats_save_button_clicked */
+
+
 /* -----------------------------------------
  * p_gimprc_save_option
  * -----------------------------------------
@@ -7624,6 +8142,51 @@ p_new_configframe(GapPlayerMainGlobalParams *gpp)
                         gpp);
 
 
+  row++;
+
+  /* Playback Statistics */
+  label = gtk_label_new(_("Statistics:"));
+  gtk_misc_set_alignment(GTK_MISC(label), 0.0, 0.0);
+  gtk_table_attach(GTK_TABLE(table1), label, 0, 1, row, row + 1, GTK_FILL, GTK_FILL, 0, 0);
+  gtk_widget_show(label);
+
+  /* summary of the playback statistics (updated while playing) */
+  label = gtk_label_new(" ");
+  gpp->label_playback_stats = label;
+  gtk_misc_set_alignment(GTK_MISC(label), 0.0, 0.5);
+  gtk_table_attach(GTK_TABLE(table1), label, 1, 3, row, row + 1, GTK_FILL, GTK_FILL, 4, 0);
+  gtk_widget_show(label);
+  p_update_stats_status(gpp);
+
+  row++;
+
+  {
+    GtkWidget *hbox;
+
+    hbox = gtk_hbox_new (FALSE, 4);
+    gtk_widget_show (hbox);
+    gtk_table_attach(GTK_TABLE(table1), hbox, 1, 3, row, row + 1, GTK_FILL, GTK_FILL, 4, 0);
+
+    /* reset statistics button */
+    button = gtk_button_new_from_stock (GIMP_STOCK_RESET);
+    gtk_widget_show (button);
+    gimp_help_set_help_data(button, _("Reset the playback statistics"),NULL);
+    gtk_box_pack_start (GTK_BOX (hbox), button, FALSE, FALSE, 0);
+    g_signal_connect (G_OBJECT (button), "pressed",
+                        G_CALLBACK (on_stats_reset_button_clicked),
+                        gpp);
+
+    /* save statistics report button */
+    button = gtk_button_new_from_stock (GTK_STOCK_SAVE_AS);
+    gtk_widget_show (button);
+    gimp_help_set_help_data(button, _("Save the playback statistics "
+                                      "(including the frame fetch time histogram) to a text file"),NULL);
+    gtk_box_pack_start (GTK_BOX (hbox), button, FALSE, FALSE, 0);
+    g_signal_connect (G_OBJECT (button), "pressed",
+                        G_CALLBACK (on_stats_save_button_clicked),
+                        gpp);
+  }
+
   row++;
 
   /* Layout Options label */
@@ -9047,6 +9610,9 @@ gap_player_dlg_create(GapPlayerMainGlobalParams *gpp)
   p_init_tile_cache(gpp);
   p_init_video_playback_cache(gpp);
   p_init_layout_options(gpp);
+  gap_player_stats_reset(&gpp->stats);
+  gpp->label_playback_stats = NULL;
+  gpp->stats_filesel = NULL;
 
   gpp->mtrace_image_id = -1;
   gpp->mtrace_mode = GAP_PLAYER_MTRACE_OFF;
@@ -9237,6 +9803,7 @@ void
 gap_player_dlg_cleanup(GapPlayerMainGlobalParams *gpp)
 {
     p_audio_shut_server(gpp);
+    p_readahead_free(gpp);
 
     if(gpp->gtimer)
     {
@@ -22,6 +22,8 @@
  */
 
 /* revision history:
+ * version 2.8.xx;  2026/10/18  agent: playback timing statistics
+ * version 2.8.xx;  2026/10/18  agent: read-ahead of frames into the player cache
  * version 1.3.26d; 2004/01/28  hof: mtrace_mode
  * version 1.3.20d; 2003/10/06  hof: new gpp struct members for resize behaviour
  * version 1.3.19a; 2003/09/07  hof: audiosupport (based on wavplay, for UNIX only),
@@ -39,6 +41,8 @@
 #include "gap_pview_da.h"
 #include "gap_story_file.h"
 #include "gap_player_cache.h"
+#include "gap_player_readahead.h"
+#include "gap_player_stats.h"
 #include "gap_story_render_types.h"
 #include "gap_drawable_vref_parasite.h"
 
@@ -265,6 +269,17 @@ typedef struct GapPlayerMainGlobalParams {
 
   gboolean     enableAutoSkipMissingFrames;
   GtkWidget   *autoSkipMissingFrames_checkbutton;
+
+  /* read-ahead of the next frames into the player cache */
+  GapPlayerReadahead  *readahead;
+  gint32               readahead_frames;   /* max frames to read ahead, 0 turns read-ahead OFF */
+  gint32               readahead_plan_tab[GAP_PLAYER_READAHEAD_MAX_FRAMES];  /* predicted next frames */
+  gint32               readahead_plan_count;
+
+  /* playback timing statistics */
+  GapPlayerStats       stats;
+  GtkWidget           *label_playback_stats;
+  GtkWidget           *stats_filesel;
   
 } GapPlayerMainGlobalParams;
 
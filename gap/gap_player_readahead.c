@@ -0,0 +1,670 @@
+/*  gap_player_readahead.c
+ *
+ *  GAP ... Gimp Animation Plugins
+ *
+ *  This module handles the read-ahead of frames for the GAP video player.
+ *
+ *  The player fetches and renders a frame when the playback timer
+ *  asks for it, and the rendered frame is added to the player cache.
+ *  When fetching a single frame (decoding a videoframe or loading a frame
+ *  image) takes longer than the frame period, playback has to drop frames
+ *  until the frames were played once and are available in the cache.
+ *
+ *  The read-ahead worker thread fetches the next frames in playback order
+ *  (as requested by the player) while the current frame is displayed.
+ *  The player moves the completed frames into the player cache,
+ *  therefore the following playback timer calls are served from the cache.
+ *
+ *  The worker reads image frames via GdkPixbuf and videoframes via its own
+ *  videohandle, gimp calls and the player cache stay on the main thread.
+ */
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx; 2026/10/18  agent: created
+ */
+
+#include "config.h"
+
+/* SYSTEM (UNIX) includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* GIMP includes */
+#include <gtk/gtk.h>
+#include "libgimp/gimp.h"
+#include "libgimpthumb/gimpthumb.h"
+
+/* GAP includes */
+#include "gap_player_readahead.h"
+#include "gap_lib.h"
+#include "gap_base.h"
+#include "gap_thumbnail.h"
+
+extern int gap_debug;
+
+typedef struct GapPlayerReadaheadResult {
+  gint32   framenr;
+  gint32   generation;
+  guchar  *th_data;
+  gint32   th_width;
+  gint32   th_height;
+  gint32   th_bpp;
+} GapPlayerReadaheadResult;
+
+
+static void      p_free_result(GapPlayerReadaheadResult *result);
+static guchar *  p_fetch_image_frame(GapPlayerReadahead *ra, gint32 framenr
+                                    , gint32 *th_width, gint32 *th_height, gint32 *th_bpp);
+static guchar *  p_fetch_movie_frame(GapPlayerReadahead *ra, gint32 framenr
+                                    , gint32 *th_width, gint32 *th_height, gint32 *th_bpp);
+static gpointer  p_readahead_worker_thread(GapPlayerReadahead *ra);
+
+
+/* ---------------------------------
+ * p_free_result
+ * ---------------------------------
+ */
+static void
+p_free_result(GapPlayerReadaheadResult *result)
+{
+  if(result != NULL)
+  {
+    g_free(result->th_data);
+    g_free(result);
+  }
+}  /* end p_free_result */
+
+
+/* ---------------------------------
+ * p_fetch_image_frame
+ * ---------------------------------
+ * load frame image scaled to preview size via GdkPixbuf.
+ * returns NULL for missing frames, for formats that are not supported
+ * by the GdkPixbuf loaders and for frames that the player will display
+ * from a thumbnail file.
+ */
+static guchar *
+p_fetch_image_frame(GapPlayerReadahead *ra, gint32 framenr
+                   , gint32 *th_width, gint32 *th_height, gint32 *th_bpp)
+{
+  GdkPixbuf *pixbuf;
+  gchar     *l_filename;
+  guchar    *th_data;
+
+  th_data = NULL;
+  l_filename = gap_lib_alloc_fname(ra->basename, framenr, ra->extension);
+  if(l_filename == NULL)
+  {
+    return (NULL);
+  }
+
+  if(ra->skip_thumbnailed)
+  {
+    if((gap_thumb_file_has_valid_thumbnail(l_filename, GIMP_THUMB_SIZE_NORMAL))
+    || (gap_thumb_file_has_valid_thumbnail(l_filename, GIMP_THUMB_SIZE_LARGE)))
+    {
+      g_free(l_filename);
+      return (NULL);
+    }
+  }
+
+  pixbuf = gdk_pixbuf_new_from_file_at_scale(l_filename
+                                            , ra->width
+                                            , ra->height
+                                            , FALSE      /* preserve_aspect_ratio */
+                                            , NULL
+                                            );
+  if(pixbuf != NULL)
+  {
+    gint    l_width;
+    gint    l_height;
+    gint    l_bpp;
+    gint    l_rowstride;
+    gint    l_row;
+    guchar *l_pixels;
+
+    l_width = gdk_pixbuf_get_width(pixbuf);
+    l_height = gdk_pixbuf_get_height(pixbuf);
+    l_bpp = gdk_pixbuf_get_n_channels(pixbuf);
+    l_rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+    l_pixels = gdk_pixbuf_get_pixels(pixbuf);
+
+    if((l_bpp == 3) || (l_bpp == 4))
+    {
+      /* copy without the rowstride padding */
+      th_data = g_try_malloc(l_width * l_height * l_bpp);
+      if(th_data != NULL)
+      {
+        for(l_row = 0; l_row < l_height; l_row++)
+        {
+          memcpy(&th_data[l_row * l_width * l_bpp]
+                , &l_pixels[l_row * l_rowstride]
+                , l_width * l_bpp
+                );
+        }
+        *th_width = l_width;
+        *th_height = l_height;
+        *th_bpp = l_bpp;
+      }
+    }
+    g_object_unref(pixbuf);
+  }
+
+  g_free(l_filename);
+  return (th_data);
+
+}  /* end p_fetch_image_frame */
+
+
+/* ---------------------------------
+ * p_fetch_movie_frame
+ * ---------------------------------
+ * fetch videoframe scaled to preview size
+ * via the private videohandle of the worker thread.
+ */
+static guchar *
+p_fetch_movie_frame(GapPlayerReadahead *ra, gint32 framenr
+                   , gint32 *th_width, gint32 *th_height, gint32 *th_bpp)
+{
+  guchar *th_data;
+
+  th_data = NULL;
+#ifdef GAP_ENABLE_VIDEOAPI_SUPPORT
+  if(ra->gvahand != NULL)
+  {
+    gint32   l_deinterlace;
+    gdouble  l_threshold;
+    gboolean l_isBackwards;
+
+    /* split delace value: integer part is deinterlace mode, rest is threshold */
+    l_deinterlace = ra->delace;
+    l_threshold = ra->delace - (gdouble)l_deinterlace;
+    l_isBackwards = (framenr < ra->last_fetched_framenr);
+
+    *th_bpp = 3;
+    *th_width = MIN(ra->width, ra->gvahand->width);
+    *th_height = MIN(ra->height, ra->gvahand->height);
+    th_data = GVA_fetch_frame_to_buffer(ra->gvahand
+                , TRUE          /* do_scale */
+                , l_isBackwards
+                , framenr
+                , l_deinterlace
+                , l_threshold
+                , th_bpp
+                , th_width
+                , th_height
+                );
+  }
+#endif
+  return (th_data);
+
+}  /* end p_fetch_movie_frame */
+
+
+/* ---------------------------------
+ * p_readahead_worker_thread
+ * ---------------------------------
+ * process the requested frames in order until the stop request.
+ */
+static gpointer
+p_readahead_worker_thread(GapPlayerReadahead *ra)
+{
+  g_mutex_lock(ra->mutex);
+  while(!ra->stop)
+  {
+    gint32                    l_framenr;
+    gint32                    l_generation;
+    GapPlayerReadaheadResult *result;
+
+    if(ra->request_idx >= ra->request_count)
+    {
+      g_cond_wait(ra->cond, ra->mutex);
+      continue;
+    }
+
+    l_framenr = ra->request_tab[ra->request_idx];
+    ra->request_idx++;
+    l_generation = ra->generation;
+    ra->busy_framenr = l_framenr;
+    g_mutex_unlock(ra->mutex);
+
+    result = g_new0(GapPlayerReadaheadResult, 1);
+    result->framenr = l_framenr;
+    result->generation = l_generation;
+    if(ra->source_type == GAP_PLAYER_READAHEAD_MOVIE)
+    {
+      result->th_data = p_fetch_movie_frame(ra, l_framenr
+                                           , &result->th_width
+                                           , &result->th_height
+                                           , &result->th_bpp);
+    }
+    else
+    {
+      result->th_data = p_fetch_image_frame(ra, l_framenr
+                                           , &result->th_width
+                                           , &result->th_height
+                                           , &result->th_bpp);
+    }
+    ra->last_fetched_framenr = l_framenr;
+
+    g_mutex_lock(ra->mutex);
+    ra->busy_framenr = -1;
+    if((result->th_data != NULL)
+    && (result->generation == ra->generation))
+    {
+      g_atomic_int_inc(&ra->ready_count);
+      g_async_queue_push(ra->results, result);
+    }
+    else
+    {
+      p_free_result(result);
+    }
+  }
+  g_mutex_unlock(ra->mutex);
+
+  return (NULL);
+}  /* end p_readahead_worker_thread */
+
+
+/* ---------------------------------
+ * gap_player_readahead_get_gimprc_frames
+ * ---------------------------------
+ * get the configured max number of frames to read ahead
+ * (gimprc parameter video_player_readahead_frames, 0 turns read-ahead off)
+ */
+gint32
+gap_player_readahead_get_gimprc_frames(void)
+{
+  return (gap_base_get_gimprc_int_value(GAP_GIMPRC_VIDEO_PLAYER_READAHEAD_FRAMES
+                                       , GAP_PLAYER_READAHEAD_DEFAULT_FRAMES
+                                       , 0
+                                       , GAP_PLAYER_READAHEAD_MAX_FRAMES
+                                       ));
+}  /* end gap_player_readahead_get_gimprc_frames */
+
+
+/* ---------------------------------
+ * gap_player_readahead_new
+ * ---------------------------------
+ * create a read-ahead worker for the specified frame source
+ * that delivers frames at the size width x height.
+ * For GAP_PLAYER_READAHEAD_MOVIE sources a private videohandle
+ * is opened (from the calling main thread).
+ *
+ * returns NULL if max_requests < 1, if the videofile could not be opened
+ * or in case thread support is not available.
+ */
+GapPlayerReadahead *
+gap_player_readahead_new(GapPlayerReadaheadSourceType source_type
+                         , const char *basename
+                         , const char *extension
+                         , gint32      seltrack
+                         , gdouble     delace
+                         , const char *preferred_decoder
+                         , gint32      width
+                         , gint32      height
+                         , gboolean    skip_thumbnailed
+                         , gint32      max_requests
+                         )
+{
+  GapPlayerReadahead *ra;
+  GError             *error = NULL;
+
+  if((max_requests < 1) || (basename == NULL) || (width < 1) || (height < 1))
+  {
+    return (NULL);
+  }
+  if(!gap_base_thread_init())
+  {
+    return (NULL);
+  }
+
+  ra = g_new0(GapPlayerReadahead, 1);
+  ra->source_type = source_type;
+  ra->basename = g_strdup(basename);
+  ra->extension = g_strdup(extension);
+  ra->seltrack = seltrack;
+  ra->delace = delace;
+  ra->width = width;
+  ra->height = height;
+  ra->skip_thumbnailed = skip_thumbnailed;
+  ra->gvahand = NULL;
+  ra->max_requests = MIN(max_requests, GAP_PLAYER_READAHEAD_MAX_FRAMES);
+  ra->request_tab = g_new0(gint32, ra->max_requests);
+  ra->request_count = 0;
+  ra->request_idx = 0;
+  ra->generation = 0;
+  ra->busy_framenr = -1;
+  ra->stop = FALSE;
+  ra->ready_count = 0;
+  ra->last_fetched_framenr = -1;
+
+  if(source_type == GAP_PLAYER_READAHEAD_MOVIE)
+  {
+#ifdef GAP_ENABLE_VIDEOAPI_SUPPORT
+    ra->gvahand = GVA_open_read_pref(basename
+                                    , seltrack
+                                    , 1      /* aud_track */
+                                    , preferred_decoder
+                                    , FALSE  /* use MMX if available (disable_mmx == FALSE) */
+                                    );
+    if(ra->gvahand != NULL)
+    {
+      /* WARNING: the handle is used in a thread, dont use gimp progress */
+      ra->gvahand->do_gimp_progress = FALSE;
+    }
+#endif
+    if(ra->gvahand == NULL)
+    {
+      g_free(ra->request_tab);
+      g_free(ra->basename);
+      g_free(ra->extension);
+      g_free(ra);
+      return (NULL);
+    }
+  }
+  else
+  {
+    /* libgimpthumb must be initialized before the worker uses it */
+    gap_thumb_init();
+  }
+
+  ra->mutex = g_mutex_new();
+  ra->cond = g_cond_new();
+  ra->results = g_async_queue_new();
+
+  ra->thread = g_thread_create((GThreadFunc)p_readahead_worker_thread
+                              , ra        /* data */
+                              , TRUE      /* joinable */
+                              , &error
+                              );
+  if(ra->thread == NULL)
+  {
+    printf("gap_player_readahead_new: could not create read-ahead thread %s\n"
+          , (error != NULL) ? error->message : ""
+          );
+    if(error != NULL)
+    {
+      g_error_free(error);
+    }
+    ra->thread = NULL;
+    gap_player_readahead_free(ra);
+    return (NULL);
+  }
+
+  if(gap_debug)
+  {
+    printf("gap_player_readahead_new: %s source_type:%d size:%dx%d max_requests:%d\n"
+      , ra->basename
+      , (int)ra->source_type
+      , (int)ra->width
+      , (int)ra->height
+      , (int)ra->max_requests
+      );
+  }
+
+  return (ra);
+}  /* end gap_player_readahead_new */
+
+
+/* ---------------------------------
+ * gap_player_readahead_matches
+ * ---------------------------------
+ * check if the read-ahead worker was created for the specified frame source
+ * (the player creates a new worker when the source changes).
+ */
+gboolean
+gap_player_readahead_matches(GapPlayerReadahead *ra
+                         , GapPlayerReadaheadSourceType source_type
+                         , const char *basename
+                         , const char *extension
+                         , gint32      seltrack
+                         , gdouble     delace
+                         , gint32      width
+                         , gint32      height
+                         , gboolean    skip_thumbnailed
+                         )
+{
+  if((ra == NULL) || (basename == NULL))
+  {
+    return (FALSE);
+  }
+  if((ra->source_type != source_type)
+  || (ra->width != width)
+  || (ra->height != height)
+  || (strcmp(ra->basename, basename) != 0))
+  {
+    return (FALSE);
+  }
+  if(source_type == GAP_PLAYER_READAHEAD_MOVIE)
+  {
+    return ((ra->seltrack == seltrack) && (ra->delace == delace));
+  }
+  if((ra->extension == NULL) || (extension == NULL))
+  {
+    return (ra->extension == extension);
+  }
+  return ((strcmp(ra->extension, extension) == 0)
+       && (ra->skip_thumbnailed == skip_thumbnailed));
+
+}  /* end gap_player_readahead_matches */
+
+
+/* ---------------------------------
+ * gap_player_readahead_set_requests
+ * ---------------------------------
+ * replace the list of requested frames by framenr_tab
+ * (the next frames in playback order that are not yet cached).
+ * requests that exceed max_requests are ignored.
+ * A frame that is currently fetched by the worker is not requested again.
+ */
+void
+gap_player_readahead_set_requests(GapPlayerReadahead *ra
+                         , const gint32 *framenr_tab
+                         , gint32        count
+                         )
+{
+  gint32 ii;
+
+  if(ra == NULL)
+  {
+    return;
+  }
+
+  g_mutex_lock(ra->mutex);
+  ra->request_count = 0;
+  ra->request_idx = 0;
+  for(ii = 0; ii < count; ii++)
+  {
+    if(ra->request_count >= ra->max_requests)
+    {
+      break;
+    }
+    if(framenr_tab[ii] != ra->busy_framenr)
+    {
+      ra->request_tab[ra->request_count] = framenr_tab[ii];
+      ra->request_count++;
+    }
+  }
+  if(ra->request_count > 0)
+  {
+    g_cond_signal(ra->cond);
+  }
+  g_mutex_unlock(ra->mutex);
+
+}  /* end gap_player_readahead_set_requests */
+
+
+/* ---------------------------------
+ * gap_player_readahead_pop_result
+ * ---------------------------------
+ * fetch the next completed frame without waiting.
+ * returns TRUE if a frame was available,
+ * the caller is responsible to g_free the returned th_data.
+ */
+gboolean
+gap_player_readahead_pop_result(GapPlayerReadahead *ra
+                         , gint32  *framenr
+                         , guchar **th_data
+                         , gint32  *th_width
+                         , gint32  *th_height
+                         , gint32  *th_bpp
+                         )
+{
+  GapPlayerReadaheadResult *result;
+  gint32                    l_generation;
+
+  if(ra == NULL)
+  {
+    return (FALSE);
+  }
+
+  g_mutex_lock(ra->mutex);
+  l_generation = ra->generation;
+  g_mutex_unlock(ra->mutex);
+
+  while((result = (GapPlayerReadaheadResult *)g_async_queue_try_pop(ra->results)) != NULL)
+  {
+    g_atomic_int_add(&ra->ready_count, -1);
+    if(result->generation != l_generation)
+    {
+      /* frame was fetched before the last cancel (seek, direction change) */
+      p_free_result(result);
+      continue;
+    }
+
+    *framenr = result->framenr;
+    *th_data = result->th_data;
+    *th_width = result->th_width;
+    *th_height = result->th_height;
+    *th_bpp = result->th_bpp;
+    result->th_data = NULL;
+    p_free_result(result);
+    return (TRUE);
+  }
+
+  return (FALSE);
+}  /* end gap_player_readahead_pop_result */
+
+
+/* ---------------------------------
+ * gap_player_readahead_get_depth
+ * ---------------------------------
+ * returns the number of frames that are completed or in work
+ * and not yet taken by the player.
+ */
+gint32
+gap_player_readahead_get_depth(GapPlayerReadahead *ra)
+{
+  gint32 l_depth;
+
+  if(ra == NULL)
+  {
+    return (0);
+  }
+
+  g_mutex_lock(ra->mutex);
+  l_depth = ra->request_count - ra->request_idx;
+  if(ra->busy_framenr >= 0)
+  {
+    l_depth++;
+  }
+  g_mutex_unlock(ra->mutex);
+
+  return (l_depth + g_atomic_int_get(&ra->ready_count));
+}  /* end gap_player_readahead_get_depth */
+
+
+/* ---------------------------------
+ * gap_player_readahead_cancel
+ * ---------------------------------
+ * drop all requests and completed frames.
+ * A frame that is currently fetched by the worker is dropped
+ * when the fetch is finished.
+ */
+void
+gap_player_readahead_cancel(GapPlayerReadahead *ra)
+{
+  GapPlayerReadaheadResult *result;
+
+  if(ra == NULL)
+  {
+    return;
+  }
+
+  g_mutex_lock(ra->mutex);
+  ra->generation++;
+  ra->request_count = 0;
+  ra->request_idx = 0;
+  g_mutex_unlock(ra->mutex);
+
+  while((result = (GapPlayerReadaheadResult *)g_async_queue_try_pop(ra->results)) != NULL)
+  {
+    g_atomic_int_add(&ra->ready_count, -1);
+    p_free_result(result);
+  }
+
+}  /* end gap_player_readahead_cancel */
+
+
+/* ---------------------------------
+ * gap_player_readahead_free
+ * ---------------------------------
+ * stop the worker thread, wait until it has finished
+ * and free all resources (including the private videohandle).
+ */
+void
+gap_player_readahead_free(GapPlayerReadahead *ra)
+{
+  if(ra == NULL)
+  {
+    return;
+  }
+
+  if(ra->thread != NULL)
+  {
+    g_mutex_lock(ra->mutex);
+    ra->stop = TRUE;
+    g_cond_signal(ra->cond);
+    g_mutex_unlock(ra->mutex);
+    g_thread_join(ra->thread);
+    ra->thread = NULL;
+  }
+
+  gap_player_readahead_cancel(ra);
+
+#ifdef GAP_ENABLE_VIDEOAPI_SUPPORT
+  if(ra->gvahand != NULL)
+  {
+    GVA_close(ra->gvahand);
+    ra->gvahand = NULL;
+  }
+#endif
+
+  g_async_queue_unref(ra->results);
+  g_cond_free(ra->cond);
+  g_mutex_free(ra->mutex);
+  g_free(ra->request_tab);
+  g_free(ra->basename);
+  g_free(ra->extension);
+  g_free(ra);
+
+}  /* end gap_player_readahead_free */
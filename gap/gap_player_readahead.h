@@ -0,0 +1,131 @@
+/*  gap_player_readahead.h
+ *
+ *  GAP ... Gimp Animation Plugins
+ *
+ *  This module handles the read-ahead of frames for the GAP video player.
+ */
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx; 2026/10/18  agent: created
+ */
+
+#ifndef _GAP_PLAYER_READAHEAD_H
+#define _GAP_PLAYER_READAHEAD_H
+
+#include "libgimp/gimp.h"
+
+#ifdef GAP_ENABLE_VIDEOAPI_SUPPORT
+#include "gap_vid_api.h"
+#else
+#ifndef GAP_STUBTYPE_GVA_HANDLE
+typedef gpointer t_GVA_Handle;
+#define GAP_STUBTYPE_GVA_HANDLE
+#endif
+#endif
+
+#define GAP_GIMPRC_VIDEO_PLAYER_READAHEAD_FRAMES   "video_player_readahead_frames"
+#define GAP_PLAYER_READAHEAD_DEFAULT_FRAMES        8
+#define GAP_PLAYER_READAHEAD_MAX_FRAMES            100
+
+typedef enum {
+    GAP_PLAYER_READAHEAD_FRAMES      /* frame image files basename<nr>extension */
+   ,GAP_PLAYER_READAHEAD_MOVIE       /* frames of one videofile */
+  } GapPlayerReadaheadSourceType;
+
+/* a GapPlayerReadahead runs one worker thread that fetches the frames
+ * of a list of requested frame numbers (the next frames in playback order)
+ * at preview size into RGB(A) buffers.
+ * The player moves the completed buffers into the player cache
+ * on the main thread (the player cache is not thread save).
+ *
+ * The worker does not make any gimp PDB calls.
+ * image frames are read via the GdkPixbuf loaders (formats that only gimp
+ * can read, such as xcf are skipped), videoframes are read
+ * via a private videohandle of the worker.
+ */
+typedef struct GapPlayerReadahead {
+  GapPlayerReadaheadSourceType  source_type;
+  gchar        *basename;            /* FRAMES: basename, MOVIE: name of the videofile */
+  gchar        *extension;           /* FRAMES: extension, MOVIE: NULL */
+  gint32        seltrack;            /* MOVIE: selected videotrack */
+  gdouble       delace;              /* MOVIE: deinterlace mode and threshold */
+  gint32        width;               /* preview size */
+  gint32        height;
+  gboolean      skip_thumbnailed;    /* FRAMES: skip frames that are displayed from thumbnails */
+  t_GVA_Handle *gvahand;             /* MOVIE: videohandle used by the worker thread only */
+
+  GThread      *thread;
+  GMutex       *mutex;
+  GCond        *cond;
+
+  /* members protected by mutex */
+  gint32       *request_tab;         /* requested frame numbers in playback order */
+  gint32        request_count;
+  gint32        request_idx;         /* index of the next request to be processed by the worker */
+  gint32        max_requests;
+  gint32        generation;          /* incremented on cancel, results of older generations are dropped */
+  gint32        busy_framenr;        /* frame currently fetched by the worker, -1 when idle */
+  gboolean      stop;
+
+  GAsyncQueue  *results;             /* of GapPlayerReadaheadResult */
+  volatile gint ready_count;         /* completed frames that were not yet taken by the player */
+  gint32        last_fetched_framenr;
+} GapPlayerReadahead;
+
+
+gint32               gap_player_readahead_get_gimprc_frames(void);
+
+GapPlayerReadahead * gap_player_readahead_new(GapPlayerReadaheadSourceType source_type
+                         , const char *basename
+                         , const char *extension
+                         , gint32      seltrack
+                         , gdouble     delace
+                         , const char *preferred_decoder
+                         , gint32      width
+                         , gint32      height
+                         , gboolean    skip_thumbnailed
+                         , gint32      max_requests
+                         );
+gboolean             gap_player_readahead_matches(GapPlayerReadahead *ra
+                         , GapPlayerReadaheadSourceType source_type
+                         , const char *basename
+                         , const char *extension
+                         , gint32      seltrack
+                         , gdouble     delace
+                         , gint32      width
+                         , gint32      height
+                         , gboolean    skip_thumbnailed
+                         );
+void                 gap_player_readahead_set_requests(GapPlayerReadahead *ra
+                         , const gint32 *framenr_tab
+                         , gint32        count
+                         );
+gboolean             gap_player_readahead_pop_result(GapPlayerReadahead *ra
+                         , gint32  *framenr
+                         , guchar **th_data
+                         , gint32  *th_width
+                         , gint32  *th_height
+                         , gint32  *th_bpp
+                         );
+gint32               gap_player_readahead_get_depth(GapPlayerReadahead *ra);
+void                 gap_player_readahead_cancel(GapPlayerReadahead *ra);
+void                 gap_player_readahead_free(GapPlayerReadahead *ra);
+
+#endif
@@ -0,0 +1,365 @@
+/*  gap_player_stats.c
+ *
+ *  GAP ... Gimp Animation Plugins
+ *
+ *  This module records playback timing statistics of the GAP video player:
+ *  frames displayed, dropped and late, the player cache hit ratio,
+ *  a histogram of the frame fetch latency and the time spent
+ *  for rendering the frames into the pview widget.
+ *  The numbers are shown in the player preferences and can be saved
+ *  as text report to tune cache size and video decoder settings.
+ */
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026/10/18  agent: created
+ */
+
+#include "config.h"
+
+/* SYSTEM (UNIX) includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <glib/gstdio.h>
+
+/* GIMP includes */
+#include "libgimp/gimp.h"
+
+/* GAP includes */
+#include "gap_player_stats.h"
+#include "gap-intl.h"
+
+extern int gap_debug;
+
+/* upper limits (in millisecs) of the fetch latency histogram slots */
+static const gint32 histogram_limits_msecs[GAP_PLAYER_STATS_HISTOGRAM_SLOTS -1] =
+  { 1, 2, 5, 10, 20, 40, 80, 160, 320 };
+
+
+static guint64   p_elapsed_usecs(GTimeVal *startTimePtr);
+static void      p_record_duration(GapPlayerStatsDuration *duration, guint64 usecs);
+static gdouble   p_avg_msecs(GapPlayerStatsDuration *duration);
+
+
+/* ---------------------------------
+ * p_elapsed_usecs
+ * ---------------------------------
+ */
+static guint64
+p_elapsed_usecs(GTimeVal *startTimePtr)
+{
+  GTimeVal  now;
+  gint64    usecs;
+
+  g_get_current_time(&now);
+  usecs = ((gint64)now.tv_sec - (gint64)startTimePtr->tv_sec) * G_USEC_PER_SEC
+        + ((gint64)now.tv_usec - (gint64)startTimePtr->tv_usec);
+
+  return ((guint64)MAX(usecs, 0));
+}  /* end p_elapsed_usecs */
+
+
+/* ---------------------------------
+ * p_record_duration
+ * ---------------------------------
+ */
+static void
+p_record_duration(GapPlayerStatsDuration *duration, guint64 usecs)
+{
+  if((duration->count == 0) || (usecs < duration->min_usecs))
+  {
+    duration->min_usecs = usecs;
+  }
+  if(usecs > duration->max_usecs)
+  {
+    duration->max_usecs = usecs;
+  }
+  duration->sum_usecs += usecs;
+  duration->count++;
+}  /* end p_record_duration */
+
+
+/* ---------------------------------
+ * p_avg_msecs
+ * ---------------------------------
+ */
+static gdouble
+p_avg_msecs(GapPlayerStatsDuration *duration)
+{
+  if(duration->count == 0)
+  {
+    return (0.0);
+  }
+  return (((gdouble)duration->sum_usecs / (gdouble)duration->count) / 1000.0);
+}  /* end p_avg_msecs */
+
+
+/* ---------------------------------
+ * gap_player_stats_reset
+ * ---------------------------------
+ * clear all recorded values and start a new statistics session.
+ */
+void
+gap_player_stats_reset(GapPlayerStats *stats)
+{
+  if(stats == NULL)
+  {
+    return;
+  }
+  memset(stats, 0, sizeof(GapPlayerStats));
+  g_get_current_time(&stats->session_start);
+}  /* end gap_player_stats_reset */
+
+
+/* ---------------------------------
+ * gap_player_stats_start_frame
+ * ---------------------------------
+ * start the fetch time measuring of the next displayed frame.
+ */
+void
+gap_player_stats_start_frame(GapPlayerStats *stats)
+{
+  g_get_current_time(&stats->frame_start);
+  stats->frame_active = TRUE;
+  stats->render_active = FALSE;
+}  /* end gap_player_stats_start_frame */
+
+
+/* ---------------------------------
+ * gap_player_stats_start_render
+ * ---------------------------------
+ * record the fetch time of the current frame
+ * and start the render time measuring.
+ * (renderings that are not part of a displayed frame,
+ * e.g. repaint at resize, are not recorded)
+ */
+void
+gap_player_stats_start_render(GapPlayerStats *stats)
+{
+  guint64 l_usecs;
+  gint    ii;
+
+  if(!stats->frame_active)
+  {
+    return;
+  }
+
+  l_usecs = p_elapsed_usecs(&stats->frame_start);
+  p_record_duration(&stats->fetch, l_usecs);
+
+  for(ii = 0; ii < GAP_PLAYER_STATS_HISTOGRAM_SLOTS -1; ii++)
+  {
+    if(l_usecs < (guint64)histogram_limits_msecs[ii] * 1000)
+    {
+      break;
+    }
+  }
+  stats->fetch_histogram[ii]++;
+
+  g_get_current_time(&stats->render_start);
+  stats->frame_active = FALSE;
+  stats->render_active = TRUE;
+}  /* end gap_player_stats_start_render */
+
+
+/* ---------------------------------
+ * gap_player_stats_stop_render
+ * ---------------------------------
+ */
+void
+gap_player_stats_stop_render(GapPlayerStats *stats)
+{
+  if(!stats->render_active)
+  {
+    return;
+  }
+  p_record_duration(&stats->render, p_elapsed_usecs(&stats->render_start));
+  stats->render_active = FALSE;
+  stats->frames_displayed++;
+}  /* end gap_player_stats_stop_render */
+
+
+/* ---------------------------------
+ * gap_player_stats_record_cache_lookup
+ * ---------------------------------
+ */
+void
+gap_player_stats_record_cache_lookup(GapPlayerStats *stats, gboolean hit)
+{
+  stats->cache_lookups++;
+  if(hit)
+  {
+    stats->cache_hits++;
+  }
+}  /* end gap_player_stats_record_cache_lookup */
+
+
+/* ---------------------------------
+ * gap_player_stats_record_dropped
+ * ---------------------------------
+ */
+void
+gap_player_stats_record_dropped(GapPlayerStats *stats)
+{
+  stats->frames_dropped++;
+}  /* end gap_player_stats_record_dropped */
+
+
+/* ---------------------------------
+ * gap_player_stats_record_late
+ * ---------------------------------
+ */
+void
+gap_player_stats_record_late(GapPlayerStats *stats)
+{
+  stats->frames_late++;
+}  /* end gap_player_stats_record_late */
+
+
+/* ---------------------------------
+ * gap_player_stats_get_summary
+ * ---------------------------------
+ * returns a short (2 lines) summary for display in the player dialog.
+ * the caller is responsible to g_free the returned string.
+ */
+gchar *
+gap_player_stats_get_summary(GapPlayerStats *stats)
+{
+  gdouble l_hit_ratio;
+
+  l_hit_ratio = 0.0;
+  if(stats->cache_lookups > 0)
+  {
+    l_hit_ratio = (100.0 * (gdouble)stats->cache_hits) / (gdouble)stats->cache_lookups;
+  }
+
+  return (g_strdup_printf(_("%d frames, %d dropped, %d late, cache hits: %.0f%%\n"
+                            "fetch: %.1f ms (max %.1f)  render: %.1f ms (max %.1f)")
+                 , (int)stats->frames_displayed
+                 , (int)stats->frames_dropped
+                 , (int)stats->frames_late
+                 , (float)l_hit_ratio
+                 , (float)p_avg_msecs(&stats->fetch)
+                 , (float)stats->fetch.max_usecs / 1000.0
+                 , (float)p_avg_msecs(&stats->render)
+                 , (float)stats->render.max_usecs / 1000.0
+                 ));
+}  /* end gap_player_stats_get_summary */
+
+
+/* ---------------------------------
+ * gap_player_stats_get_report
+ * ---------------------------------
+ * returns the full statistics report including the fetch latency histogram.
+ * the caller is responsible to g_free the returned string.
+ */
+gchar *
+gap_player_stats_get_report(GapPlayerStats *stats)
+{
+  GString *report;
+  gdouble  l_session_secs;
+  gint     ii;
+
+  report = g_string_new("# GIMP-GAP player playback statistics\n");
+
+  l_session_secs = (gdouble)p_elapsed_usecs(&stats->session_start) / (gdouble)G_USEC_PER_SEC;
+  g_string_append_printf(report, "session_seconds       %.3f\n", (float)l_session_secs);
+  g_string_append_printf(report, "frames_displayed      %d\n", (int)stats->frames_displayed);
+  g_string_append_printf(report, "frames_dropped        %d\n", (int)stats->frames_dropped);
+  g_string_append_printf(report, "frames_late           %d\n", (int)stats->frames_late);
+  g_string_append_printf(report, "cache_lookups         %d\n", (int)stats->cache_lookups);
+  g_string_append_printf(report, "cache_hits            %d\n", (int)stats->cache_hits);
+  if(stats->cache_lookups > 0)
+  {
+    g_string_append_printf(report, "cache_hit_ratio       %.3f\n"
+                          , (float)stats->cache_hits / (float)stats->cache_lookups);
+  }
+
+  g_string_append_printf(report, "fetch_msecs           count:%d avg:%.3f min:%.3f max:%.3f\n"
+                        , (int)stats->fetch.count
+                        , (float)p_avg_msecs(&stats->fetch)
+                        , (float)stats->fetch.min_usecs / 1000.0
+                        , (float)stats->fetch.max_usecs / 1000.0
+                        );
+  g_string_append_printf(report, "render_msecs          count:%d avg:%.3f min:%.3f max:%.3f\n"
+                        , (int)stats->render.count
+                        , (float)p_avg_msecs(&stats->render)
+                        , (float)stats->render.min_usecs / 1000.0
+                        , (float)stats->render.max_usecs / 1000.0
+                        );
+
+  g_string_append(report, "# fetch latency histogram (msecs: number of frames)\n");
+  for(ii = 0; ii < GAP_PLAYER_STATS_HISTOGRAM_SLOTS; ii++)
+  {
+    gchar *l_key;
+
+    if(ii < GAP_PLAYER_STATS_HISTOGRAM_SLOTS -1)
+    {
+      l_key = g_strdup_printf("fetch_lt_%d_msecs", (int)histogram_limits_msecs[ii]);
+    }
+    else
+    {
+      l_key = g_strdup_printf("fetch_ge_%d_msecs", (int)histogram_limits_msecs[ii -1]);
+    }
+    g_string_append_printf(report, "%-21s %u\n", l_key, (guint)stats->fetch_histogram[ii]);
+    g_free(l_key);
+  }
+
+  return (g_string_free(report, FALSE));
+}  /* end gap_player_stats_get_report */
+
+
+/* ---------------------------------
+ * gap_player_stats_save_report
+ * ---------------------------------
+ * write the statistics report to the specified file.
+ * returns FALSE on errors (errno is set in this case)
+ */
+gboolean
+gap_player_stats_save_report(GapPlayerStats *stats, const char *filename)
+{
+  FILE     *fp;
+  gchar    *report;
+  gboolean  ok;
+
+  fp = g_fopen(filename, "w");
+  if(fp == NULL)
+  {
+    return (FALSE);
+  }
+
+  report = gap_player_stats_get_report(stats);
+  ok = (fputs(report, fp) >= 0);
+  g_free(report);
+
+  if(fclose(fp) != 0)
+  {
+    ok = FALSE;
+  }
+
+  if(gap_debug)
+  {
+    printf("gap_player_stats_save_report: %s ok:%d\n", filename, (int)ok);
+  }
+
+  return (ok);
+}  /* end gap_player_stats_save_report */
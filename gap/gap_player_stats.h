@@ -0,0 +1,92 @@
+/*  gap_player_stats.h
+ *
+ *  GAP ... Gimp Animation Plugins
+ *
+ *  This module records playback timing statistics of the GAP video player.
+ */
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026/10/18  agent: created
+ */
+
+#ifndef _GAP_PLAYER_STATS_H
+#define _GAP_PLAYER_STATS_H
+
+#include "libgimp/gimp.h"
+
+/* number of slots in the fetch latency histogram.
+ * slot upper limits are 1, 2, 5, 10, 20, 40, 80, 160, 320 millisecs,
+ * the last slot counts all fetches that took longer.
+ */
+#define GAP_PLAYER_STATS_HISTOGRAM_SLOTS   10
+
+typedef struct GapPlayerStatsDuration {
+  guint32   count;
+  guint64   sum_usecs;
+  guint64   min_usecs;
+  guint64   max_usecs;
+} GapPlayerStatsDuration;
+
+/* GapPlayerStats collects the timing of all frames that are displayed
+ * via p_display_frame since the player was opened (or the last reset).
+ * fetch time is measured from start of the frame until the frame
+ * is passed to the pview render procedure,
+ * render time is the time spent in gap_pview_render_f_from_buf
+ * (or the pixbuf/image variants).
+ *
+ * all gap_player_stats procedures must be called from the main thread.
+ */
+typedef struct GapPlayerStats {
+  GTimeVal                session_start;
+
+  gint32                  frames_displayed;
+  gint32                  frames_dropped;   /* frames skipped to keep exact timing */
+  gint32                  frames_late;      /* frames displayed after their deadline */
+
+  gint32                  cache_lookups;
+  gint32                  cache_hits;
+
+  GapPlayerStatsDuration  fetch;
+  GapPlayerStatsDuration  render;
+  guint32                 fetch_histogram[GAP_PLAYER_STATS_HISTOGRAM_SLOTS];
+
+  /* current frame */
+  gboolean                frame_active;
+  gboolean                render_active;
+  GTimeVal                frame_start;
+  GTimeVal                render_start;
+} GapPlayerStats;
+
+
+void      gap_player_stats_reset(GapPlayerStats *stats);
+
+void      gap_player_stats_start_frame(GapPlayerStats *stats);
+void      gap_player_stats_start_render(GapPlayerStats *stats);
+void      gap_player_stats_stop_render(GapPlayerStats *stats);
+
+void      gap_player_stats_record_cache_lookup(GapPlayerStats *stats, gboolean hit);
+void      gap_player_stats_record_dropped(GapPlayerStats *stats);
+void      gap_player_stats_record_late(GapPlayerStats *stats);
+
+gchar *   gap_player_stats_get_summary(GapPlayerStats *stats);
+gchar *   gap_player_stats_get_report(GapPlayerStats *stats);
+gboolean  gap_player_stats_save_report(GapPlayerStats *stats, const char *filename);
+
+#endif
@@ -32,6 +32,8 @@
  */
 
 /* revision history
+ * 2.8.xx;  2026/10/18   agent: p_frames_convert, p_anim_sizechange: read ahead the next frames
+ *                              in a worker thread (gimprc video-frame-prefetch-count)
  * 2.1.0a;  2004/11/12   hof: added help buttons
  * 2.1.0a;  2004/04/26   hof: frames_to_multilayer: do not force save of current image
  *                            and use gimp_image_duplicate for the current frame
@@ -103,6 +105,7 @@
 #include "gap_image.h"
 #include "gap_range_ops.h"
 #include "gap_vin.h"
+#include "gap_frame_prefetch.h"
 
 
 extern      int gap_debug; /* ==0  ... dont print debug infos */
@@ -1376,6 +1379,7 @@ p_frames_convert(GapAnimInfo *ainfo_ptr,
   char   *l_sav_name;
   gint32  l_rc;
   gint    l_overwrite_mode;
+  GapFramePrefetch *l_prefetch;
   static  GapArrButtonArg  l_argv[3];
 
 
@@ -1420,9 +1424,17 @@ p_frames_convert(GapAnimInfo *ainfo_ptr,
   }
 
 
+  /* read ahead the next frames while the current frame is processed */
+  l_prefetch = gap_frame_prefetch_new(ainfo_ptr->basename, ainfo_ptr->extension
+                                     , l_begin, l_end
+                                     , gap_frame_prefetch_get_gimprc_count()
+                                     );
+
   l_cur_frame_nr = l_begin;
   while(l_rc >= 0)
   {
+    gap_frame_prefetch_advance(l_prefetch, l_cur_frame_nr);
+
     /* build the frame name */
     if(ainfo_ptr->new_filename != NULL)
     {
@@ -1446,7 +1458,8 @@ p_frames_convert(GapAnimInfo *ainfo_ptr,
     l_tmp_image_id = gap_lib_load_image(ainfo_ptr->new_filename);
     if(l_tmp_image_id < 0)
     {
-       return -1;
+       l_rc = -1;
+       break;
     }
 
     l_img_already_flat = FALSE; /* an image without any layer is considered as not flattend */
@@ -1622,6 +1635,8 @@ check_end_or_advance_to_next_frame:
                       , l_step, ainfo_ptr->basename, ainfo_ptr->extension, NULL);
   }
 
+  gap_frame_prefetch_free(l_prefetch);
+
   return l_rc;
 
 }       /* end p_frames_convert */
@@ -1691,6 +1706,7 @@ p_anim_sizechange(GapAnimInfo *ainfo_ptr,
   gdouble    l_percentage, l_percentage_step;
   int         l_rc;
   gboolean    l_frame_found;
+  GapFramePrefetch *l_prefetch;
 
   l_rc = 0;
   l_percentage = 0.0;
@@ -1719,11 +1735,19 @@ p_anim_sizechange(GapAnimInfo *ainfo_ptr,
   l_percentage_step = 1.0 / ((1.0 + l_end) - l_begin);
 
 
+  /* read ahead the next frames while the current frame is processed */
+  l_prefetch = gap_frame_prefetch_new(ainfo_ptr->basename, ainfo_ptr->extension
+                                     , l_begin, l_end
+                                     , gap_frame_prefetch_get_gimprc_count()
+                                     );
+
   l_cur_frame_nr = l_begin;
 
   l_frame_found = TRUE;
   while(l_frame_found == TRUE)
   {
+    gap_frame_prefetch_advance(l_prefetch, l_cur_frame_nr);
+
     /* build the frame name */
     if(ainfo_ptr->new_filename != NULL) g_free(ainfo_ptr->new_filename);
     ainfo_ptr->new_filename = gap_lib_alloc_fname(ainfo_ptr->basename,
@@ -1731,7 +1755,8 @@ p_anim_sizechange(GapAnimInfo *ainfo_ptr,
                                         ainfo_ptr->extension);
     if(ainfo_ptr->new_filename == NULL)
     {
-       return -1;
+       l_rc = -1;
+       break;
     }
 
     if (g_file_test(ainfo_ptr->new_filename, G_FILE_TEST_EXISTS))
@@ -1740,7 +1765,8 @@ p_anim_sizechange(GapAnimInfo *ainfo_ptr,
       l_tmp_image_id = gap_lib_load_image(ainfo_ptr->new_filename);
       if(l_tmp_image_id < 0)
       {
-         return -1;
+         l_rc = -1;
+         break;
       }
 
       l_rc = p_image_sizechange(l_tmp_image_id, asiz_mode,
@@ -1783,6 +1809,8 @@ p_anim_sizechange(GapAnimInfo *ainfo_ptr,
 
   }   /* end while loop over all frames*/
 
+  gap_frame_prefetch_free(l_prefetch);
+
   return l_rc;
 }       /* end  p_anim_sizechange */
 
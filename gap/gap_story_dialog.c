@@ -940,6 +940,8 @@ p_render_all_frame_widgets (GapStbTabWidgets *tabw)
 
   if(l_stb)
   {
+    /* elements may have changed, force rebuild of the frame index at next lookup */
+    gap_story_invalidate_frame_index(l_stb);
     l_act_elems = gap_story_count_active_elements(l_stb, tabw->vtrack);
   }
 
@@ -6734,6 +6736,7 @@ p_tabw_update_frame_label_and_rowpage_limits (GapStbTabWidgets *tabw, GapStbMain
   {
     gint32 l_act_elems = 0;
 
+    gap_story_invalidate_frame_index(stb_dst);
     l_act_elems = gap_story_count_active_elements(stb_dst, tabw->vtrack );
     l_max_rowpage = p_get_max_rowpage(l_act_elems, tabw->cols, tabw->rows);
   }
@@ -24,6 +24,7 @@
  */
 
 /* revision history:
+ * version 2.8.xx;  2026/10/18  agent: locate frame numbers via binary search in a per track frame index
  * version 2.3.0;   2006/06/14  hof: added storyboard support for layer_masks,
  *                                   overlapping frames (are converted to shadow tracks at processing)
  *                                   and image flipping
@@ -682,6 +683,7 @@ gap_story_new_story_board(const char *filename)
 
     stb->stb_parttype  = 0;
     stb->stb_unique_id  = global_stb_id++;
+    stb->bulk_append = FALSE;
 
     stb->mask_section = gap_story_create_or_find_section_by_name(stb, GAP_STB_MASK_SECTION_NAME);
     stb->active_section = gap_story_create_or_find_section_by_name(stb, NULL);
@@ -839,6 +841,8 @@ gap_story_new_section()
 
    new_section->section_id = global_stb_elem_id++;
    new_section->version = 0;
+   new_section->frame_index = NULL;
+   new_section->append_hint = NULL;
 
    new_section->next = NULL;
 
@@ -1401,6 +1405,12 @@ gap_story_free_stb_section(GapStorySection *stb_section)
 {
   if (stb_section)
   {
+    gap_story_section_invalidate_frame_index(stb_section);
+    if (stb_section->append_hint)
+    {
+      g_free(stb_section->append_hint);
+      stb_section->append_hint = NULL;
+    }
     if (stb_section->stb_elem)
     {
       p_free_stb_elem_list(stb_section->stb_elem);
@@ -1536,6 +1546,55 @@ gap_story_free_storyboard(GapStoryBoard **stb_ptr)
 
 
 
+/* ----------------------------------------------------
+ * p_story_update_append_hint
+ * ----------------------------------------------------
+ * update the append_hint for the specified element (or list of elements)
+ * that was linked to the end of the section's element list.
+ */
+static void
+p_story_update_append_hint(GapStoryAppendHint *append_hint, GapStoryElem *stb_elem)
+{
+  GapStoryElem *stb_tail;
+
+  for(stb_tail = stb_elem; stb_tail != NULL; stb_tail = (GapStoryElem *)stb_tail->next)
+  {
+    append_hint->tail = stb_tail;
+    if(stb_tail->record_type == GAP_STBREC_VID_COMMENT)
+    {
+      continue;
+    }
+    append_hint->non_comment = stb_tail;
+    if((stb_tail->track >= 0) && (stb_tail->track < GAP_STB_MAX_VID_TRACKS))
+    {
+      append_hint->track_non_comment[stb_tail->track] = stb_tail;
+      if(stb_tail->record_type == GAP_STBREC_ATT_TRANSITION)
+      {
+        append_hint->track_transition[stb_tail->track] = stb_tail;
+      }
+    }
+  }
+}  /* end p_story_update_append_hint */
+
+
+/* ----------------------------------------------------
+ * p_story_get_append_hint
+ * ----------------------------------------------------
+ * return the append_hint of the section (bulk_append mode only).
+ * the hint is created at first use with one walk through the element list.
+ */
+static GapStoryAppendHint *
+p_story_get_append_hint(GapStorySection *section)
+{
+  if(section->append_hint == NULL)
+  {
+    section->append_hint = g_new0(GapStoryAppendHint, 1);
+    p_story_update_append_hint(section->append_hint, section->stb_elem);
+  }
+  return (section->append_hint);
+}  /* end p_story_get_append_hint */
+
+
 /* ----------------------------------------------------
  * gap_story_list_append_elem
  * ----------------------------------------------------
@@ -1610,14 +1669,33 @@ gap_story_list_append_elem_at_section(GapStoryBoard *stb, GapStoryElem *stb_elem
        /* link stb_elem (that can be a single ement or list) to the end of elem list
         * in the specified active section
         */
-       stb_listend = active_section->stb_elem;
-       while(stb_listend->next != NULL)
+       if(stb->bulk_append)
        {
-          if(stb_listend->record_type != GAP_STBREC_VID_COMMENT)
-          {
-            stb_non_comment = stb_listend;
-          }
-          stb_listend = (GapStoryElem *)stb_listend->next;
+         GapStoryAppendHint *append_hint;
+
+         /* in bulk_append mode the section knows its tail,
+          * (non_comment may be the tail itself, but is only relevant
+          * when the tail is a comment)
+          */
+         append_hint = p_story_get_append_hint(active_section);
+         stb_listend = append_hint->tail;
+         stb_non_comment = append_hint->non_comment;
+       }
+       else
+       {
+         stb_listend = active_section->stb_elem;
+         while(stb_listend->next != NULL)
+         {
+            if(stb_listend->record_type != GAP_STBREC_VID_COMMENT)
+            {
+              stb_non_comment = stb_listend;
+            }
+            stb_listend = (GapStoryElem *)stb_listend->next;
+         }
+         if(stb_listend->record_type != GAP_STBREC_VID_COMMENT)
+         {
+           stb_non_comment = stb_listend;
+         }
        }
        if((stb_listend->record_type == GAP_STBREC_VID_COMMENT)
        && (stb_elem->record_type != GAP_STBREC_VID_COMMENT))
@@ -1665,10 +1743,52 @@ gap_story_list_append_elem_at_section(GapStoryBoard *stb, GapStoryElem *stb_elem
          stb_listend->next = (GapStoryElem *)stb_elem;
        }
      }
+
+     if(stb->bulk_append)
+     {
+       p_story_update_append_hint(p_story_get_append_hint(active_section), stb_elem);
+     }
   }
 }  /* end gap_story_list_append_elem */
 
 
+/* ----------------------------------------------------
+ * p_story_bulk_append_begin
+ * ----------------------------------------------------
+ * switch the specified (new) storyboard to bulk_append mode,
+ * where appending elements and looking up the last element of a track
+ * does not walk the element lists.
+ * This mode must only be used while no other code
+ * modifies the element lists of the storyboard.
+ */
+static void
+p_story_bulk_append_begin(GapStoryBoard *stb)
+{
+  stb->bulk_append = TRUE;
+}  /* end p_story_bulk_append_begin */
+
+
+/* ----------------------------------------------------
+ * p_story_bulk_append_end
+ * ----------------------------------------------------
+ */
+static void
+p_story_bulk_append_end(GapStoryBoard *stb)
+{
+  GapStorySection *section;
+
+  stb->bulk_append = FALSE;
+  for(section = stb->stb_section; section != NULL; section = section->next)
+  {
+    if(section->append_hint)
+    {
+      g_free(section->append_hint);
+      section->append_hint = NULL;
+    }
+  }
+}  /* end p_story_bulk_append_end */
+
+
 /* ----------------------------------------------------
  * p_get_last_non_comment_elem
  * ----------------------------------------------------
@@ -1679,6 +1799,13 @@ p_get_last_non_comment_elem(GapStoryBoard *stb, gint32 in_track, GapStorySection
   GapStoryElem *stb_elem_non_comment;
   GapStoryElem *stb_elem;
 
+  if((stb->bulk_append)
+  && (in_track >= 0)
+  && (in_track < GAP_STB_MAX_VID_TRACKS))
+  {
+    return (p_story_get_append_hint(active_section)->track_non_comment[in_track]);
+  }
+
   stb_elem_non_comment = NULL;
   for(stb_elem = active_section->stb_elem; stb_elem != NULL; stb_elem = (GapStoryElem *)stb_elem->next)
   {
@@ -1710,6 +1837,22 @@ gap_story_set_fit_size_attributes(GapStoryBoard *stb
 {
   GapStoryElem      *stb_elem;
 
+  if((stb->bulk_append)
+  && (story_id < 0)
+  && (in_track >= 0)
+  && (in_track < GAP_STB_MAX_VID_TRACKS))
+  {
+    /* without story_id the attributes of the last transition in the track are used */
+    stb_elem = p_story_get_append_hint(active_section)->track_transition[in_track];
+    if(stb_elem)
+    {
+      target_stb_elem->att_keep_proportions = stb_elem->att_keep_proportions;
+      target_stb_elem->att_fit_width = stb_elem->att_fit_width;
+      target_stb_elem->att_fit_height = stb_elem->att_fit_height;
+    }
+    return;
+  }
+
   for(stb_elem = active_section->stb_elem; stb_elem != NULL;  stb_elem = stb_elem->next)
   {
     if(stb_elem->track != in_track)
@@ -3052,6 +3195,7 @@ p_story_parse_line(GapStoryBoard *stb, char *longline
   char *l_record_key;
   char *l_parname;
   char *l_wordval[GAP_MAX_STB_PARAMS_PER_LINE];
+  char  l_empty_value[1];
   gint ii;
   GapStoryElem *stb_elem;
 
@@ -3065,14 +3209,17 @@ p_story_parse_line(GapStoryBoard *stb, char *longline
   stb->curr_nr = longlinenr;
 
 
-  /* clear array of values */
+  /* clear array of values
+   * (unused values share the l_empty_value buffer,
+   * fetched values are owned by l_wordval without further copies)
+   */
+  l_empty_value[0] = '\0';
   for(ii=0; ii < GAP_MAX_STB_PARAMS_PER_LINE; ii++)
   {
-    l_wordval[ii] = g_strdup("\0");
+    l_wordval[ii] = &l_empty_value[0];
   }
 
   /* get the record key (1.st space separated word) */
-  g_free(l_wordval[0]);
   l_wordval[0]    = p_fetch_string(&l_scan_ptr, &l_parname);
   l_record_key = l_wordval[0];
   if(l_parname)
@@ -3153,8 +3300,8 @@ p_story_parse_line(GapStoryBoard *stb, char *longline
           }
           else
           {
-            g_free(l_wordval[l_key_idx]);
-            l_wordval[l_key_idx] = g_strdup(l_value);
+            l_wordval[l_key_idx] = l_value;
+            l_value = NULL;
           }
         }
         else
@@ -3165,8 +3312,8 @@ p_story_parse_line(GapStoryBoard *stb, char *longline
           }
           else
           {
-            g_free(l_wordval[ii]);
-            l_wordval[ii] = g_strdup(l_value);
+            l_wordval[ii] = l_value;
+            l_value = NULL;
           }
         }
       }
@@ -4508,7 +4655,10 @@ p_story_parse_line(GapStoryBoard *stb, char *longline
 cleanup:
   for(ii=0; ii < GAP_MAX_STB_PARAMS_PER_LINE; ii++)
   {
-    g_free(l_wordval[ii]);
+    if(l_wordval[ii] != &l_empty_value[0])
+    {
+      g_free(l_wordval[ii]);
+    }
     l_wordval[ii] = NULL;
   }
 
@@ -4558,20 +4708,38 @@ p_stb_is_empty_in_all_sections(GapStoryBoard *stb)
 GapStoryBoard *
 gap_story_parse(const gchar *filename)
 {
-  GapValTextFileLines *txf_ptr_root;
-  GapValTextFileLines *txf_ptr;
   GapStoryBoard *stb;
+  gchar *filecontent;
+  gchar *filecontent_end;
+  gsize  filesize;
+  gchar *line_ptr;
   gchar *longline;
   gchar *multi_lines;
   gint32 longlinenr;
   gint32 line_nr;
+  static gint32 funcId = -1;
+
+  GAP_TIMM_GET_FUNCTION_ID(funcId, "gap_story_parse");
 
   stb = gap_story_new_story_board(filename);
   if(stb == NULL)
   {
     return (NULL);
   }
-  txf_ptr_root = gap_val_load_textfile(filename);
+
+  GAP_TIMM_START_FUNCTION(funcId);
+
+  /* load the whole file into one buffer,
+   * the lines are split up in place (without copying each line)
+   */
+  filecontent = NULL;
+  filesize = 0;
+  if(!g_file_get_contents(filename, &filecontent, &filesize, NULL))
+  {
+    filecontent = NULL;
+    filesize = 0;
+  }
+  filecontent_end = filecontent + filesize;
 
   /* when loading from file assume the old behaviour
    * where highest video track is on top.
@@ -4579,60 +4747,79 @@ gap_story_parse(const gchar *filename)
    */
   stb->master_vtrack1_is_toplayer = FALSE;
 
+  /* the new storyboard is not visible to other code while parsing */
+  p_story_bulk_append_begin(stb);
 
   longline = NULL;
   multi_lines = NULL;
   longlinenr = 0;
   line_nr = 0;
-  for(txf_ptr = txf_ptr_root; txf_ptr != NULL; txf_ptr = (GapValTextFileLines *) txf_ptr->next)
+  line_ptr = filecontent;
+  while((line_ptr != NULL) && (line_ptr < filecontent_end))
   {
+    gchar *l_line;
+    gchar *l_nl_ptr;
     gint l_len;
 
+    l_line = line_ptr;
+    l_nl_ptr = memchr(line_ptr, '\n', filecontent_end - line_ptr);
+    if(l_nl_ptr != NULL)
+    {
+      *l_nl_ptr = '\0';
+      line_ptr = l_nl_ptr + 1;
+    }
+    else
+    {
+      /* last line without newline (g_file_get_contents terminates the buffer) */
+      line_ptr = filecontent_end;
+    }
+
+    /* line_nr counts physical lines, and is used for error reporting */
     line_nr++;
     if(gap_debug)
     {
       printf("line_nr: %d\n", (int)line_nr);
     }
 
-    gap_file_chop_trailingspace_and_nl(&txf_ptr->line[0]);
-    l_len = strlen(txf_ptr->line);
+    gap_file_chop_trailingspace_and_nl(l_line);
+    l_len = strlen(l_line);
 
     if(gap_debug)
     {
-      printf("line:%s:\n", txf_ptr->line);
-    }
-
-    /* concatenate long lines */
-    if(multi_lines == NULL)
-    {
-      multi_lines = g_strdup(txf_ptr->line);
-    }
-    else
-    {
-      gchar *l_ml;
-
-      l_ml = g_strdup_printf("%s\n%s", multi_lines, txf_ptr->line);
-      g_free(multi_lines);
-      multi_lines = l_ml;
+      printf("line:%s:\n", l_line);
     }
 
     /* handle long lines with backslash at line end
      * concatenate those lines with blank inbetween for
      * the following syntax check.
+     * (multi_lines keeps the original lines for comments)
      */
-    if (txf_ptr->line[l_len-1] == '\\')
+    if ((l_len > 0) && (l_line[l_len-1] == '\\'))
     {
+      if(multi_lines == NULL)
+      {
+        multi_lines = g_strdup(l_line);
+      }
+      else
+      {
+        gchar *l_ml;
+
+        l_ml = g_strdup_printf("%s\n%s", multi_lines, l_line);
+        g_free(multi_lines);
+        multi_lines = l_ml;
+      }
+
       if(longline == NULL)
       {
-        longline = g_strdup(txf_ptr->line);
+        longline = g_strdup(l_line);
       }
       else
       {
-        char *l_line;
+        char *l_concat_line;
 
-        l_line = g_strdup_printf("%s %s", longline, txf_ptr->line);
+        l_concat_line = g_strdup_printf("%s %s", longline, l_line);
         g_free(longline);
-        longline = l_line;
+        longline = l_concat_line;
       }
       if(longlinenr == 0)
       {
@@ -4643,17 +4830,23 @@ gap_story_parse(const gchar *filename)
     {
       if(longline == NULL)
       {
-        p_story_parse_line(stb, txf_ptr->line, line_nr, multi_lines);
+        /* the typical case: single line record is parsed in place */
+        p_story_parse_line(stb, l_line, line_nr, l_line);
       }
       else
       {
-        char *l_line;
+        char *l_concat_line;
+        gchar *l_ml;
+
+        l_ml = g_strdup_printf("%s\n%s", multi_lines, l_line);
+        g_free(multi_lines);
+        multi_lines = l_ml;
 
-        l_line = g_strdup_printf("%s %s", longline, txf_ptr->line);
+        l_concat_line = g_strdup_printf("%s %s", longline, l_line);
         g_free(longline);
         longline = NULL;
-        p_story_parse_line(stb, l_line, longlinenr, multi_lines);
-        g_free(l_line);
+        p_story_parse_line(stb, l_concat_line, longlinenr, multi_lines);
+        g_free(l_concat_line);
       }
       longlinenr = 0;
       if(multi_lines)
@@ -4666,16 +4859,18 @@ gap_story_parse(const gchar *filename)
   if(longline)
   {
     p_story_parse_line(stb, longline, longlinenr, multi_lines);
+    g_free(longline);
     if(multi_lines)
     {
         g_free(multi_lines);
     }
   }
 
-  if(txf_ptr_root)
-  {
-    gap_val_free_textfile_lines(txf_ptr_root);
-  }
+  /* currline pointed into the freed buffer */
+  stb->currline = "\0";
+  g_free(filecontent);
+
+  p_story_bulk_append_end(stb);
 
 
   /* calculate nframes
@@ -4730,6 +4925,8 @@ gap_story_parse(const gchar *filename)
   if(gap_debug) printf("gap_story_parse: RET ptr:%ld\n", (long)stb);
 
   stb->unsaved_changes = FALSE;
+
+  GAP_TIMM_STOP_FUNCTION(funcId);
   return(stb);
 }  /* end gap_story_parse */
 
@@ -6326,6 +6523,211 @@ p_story_local_wanted_framenr(GapStoryLocateRet *ret_elem, GapStoryElem *stb_elem
 
 
 
+/* ---------------------------------
+ * gap_story_section_invalidate_frame_index
+ * ---------------------------------
+ * free the frame index of the specified section.
+ * the index is rebuilt at the next frame number lookup.
+ * editing code that changes elements (nframes, track, att_overlap)
+ * or the element list of a section without incrementing the section version
+ * must call this procedure.
+ */
+void
+gap_story_section_invalidate_frame_index(GapStorySection *section)
+{
+  GapStoryFrameIndex *frame_index;
+  gint                ii;
+
+  if (section == NULL)
+  {
+    return;
+  }
+  frame_index = section->frame_index;
+  if (frame_index == NULL)
+  {
+    return;
+  }
+
+  for(ii=0; ii < GAP_STB_MAX_VID_TRACKS; ii++)
+  {
+    g_free(frame_index->tab[ii]);
+  }
+  g_free(frame_index);
+  section->frame_index = NULL;
+
+}  /* end gap_story_section_invalidate_frame_index */
+
+
+/* ---------------------------------
+ * gap_story_invalidate_frame_index
+ * ---------------------------------
+ * free the frame index of all sections of the specified storyboard.
+ */
+void
+gap_story_invalidate_frame_index(GapStoryBoard *stb)
+{
+  GapStorySection *section;
+
+  if (stb == NULL)
+  {
+    return;
+  }
+  for(section = stb->stb_section; section != NULL; section = section->next)
+  {
+    gap_story_section_invalidate_frame_index(section);
+  }
+}  /* end gap_story_invalidate_frame_index */
+
+
+/* ---------------------------------
+ * p_get_frame_index
+ * ---------------------------------
+ * return the frame index of the section,
+ * (re)build the index in case it is not available or outdated.
+ * returns NULL if in_track can not be handled via the index.
+ *
+ * the index holds for each element of a track
+ *  frames_before:  sum of nframes of all previous elements
+ *  overlap_sum:    sum of att_overlap of all transitions upto and including the element
+ *  expanded_end:   frames_before + nframes
+ *  end_max:        maximum of (frames_before + nframes - overlap_sum)
+ *                  of all elements upto and including the element
+ * expanded_end and end_max are ascending, therefore the first element
+ * that contains a frame number can be found via binary search.
+ */
+static GapStoryFrameIndex *
+p_get_frame_index(GapStorySection *section, gint32 in_track)
+{
+  GapStoryFrameIndex *frame_index;
+  GapStoryElem       *stb_elem;
+  gint32              l_frames_before[GAP_STB_MAX_VID_TRACKS];
+  gint32              l_overlap_sum[GAP_STB_MAX_VID_TRACKS];
+  gint32              l_end_max[GAP_STB_MAX_VID_TRACKS];
+  gint                ii;
+
+  if ((in_track < 0) || (in_track >= GAP_STB_MAX_VID_TRACKS))
+  {
+    return (NULL);
+  }
+
+  frame_index = section->frame_index;
+  if (frame_index != NULL)
+  {
+    if ((frame_index->version == section->version)
+    &&  (frame_index->stb_elem == section->stb_elem))
+    {
+      return (frame_index);
+    }
+    gap_story_section_invalidate_frame_index(section);
+  }
+
+  frame_index = g_new0(GapStoryFrameIndex, 1);
+  frame_index->version = section->version;
+  frame_index->stb_elem = section->stb_elem;
+
+  /* 1.st pass count elements per track */
+  for(stb_elem = section->stb_elem; stb_elem != NULL;  stb_elem = stb_elem->next)
+  {
+    if ((stb_elem->track >= 0) && (stb_elem->track < GAP_STB_MAX_VID_TRACKS))
+    {
+      frame_index->count[stb_elem->track]++;
+    }
+  }
+
+  for(ii=0; ii < GAP_STB_MAX_VID_TRACKS; ii++)
+  {
+    if (frame_index->count[ii] > 0)
+    {
+      frame_index->tab[ii] = g_new(GapStoryFrameIndexEntry, frame_index->count[ii]);
+    }
+    frame_index->count[ii] = 0;
+    l_frames_before[ii] = 0;
+    l_overlap_sum[ii] = 0;
+    l_end_max[ii] = G_MININT32;
+  }
+
+  /* 2.nd pass calculate the running sums */
+  for(stb_elem = section->stb_elem; stb_elem != NULL;  stb_elem = stb_elem->next)
+  {
+    GapStoryFrameIndexEntry *entry;
+    gint32                   l_track;
+
+    l_track = stb_elem->track;
+    if ((l_track < 0) || (l_track >= GAP_STB_MAX_VID_TRACKS))
+    {
+      continue;
+    }
+
+    if (stb_elem->record_type == GAP_STBREC_ATT_TRANSITION)
+    {
+      l_overlap_sum[l_track] += stb_elem->att_overlap;
+    }
+
+    entry = &frame_index->tab[l_track][frame_index->count[l_track]];
+    entry->stb_elem = stb_elem;
+    entry->frames_before = l_frames_before[l_track];
+    entry->overlap_sum = l_overlap_sum[l_track];
+    entry->expanded_end = l_frames_before[l_track] + stb_elem->nframes;
+    l_end_max[l_track] = MAX(l_end_max[l_track], entry->expanded_end - entry->overlap_sum);
+    entry->end_max = l_end_max[l_track];
+
+    l_frames_before[l_track] = entry->expanded_end;
+    frame_index->count[l_track]++;
+  }
+
+  section->frame_index = frame_index;
+  return (frame_index);
+
+}  /* end p_get_frame_index */
+
+
+/* ---------------------------------
+ * p_frame_index_search
+ * ---------------------------------
+ * binary search for the first element in the specified track
+ * that contains in_framenr (in_framenr >= 1)
+ * expanded: TRUE  search in expanded frame numbers (ignoring overlaps)
+ *           FALSE search in frame numbers where overlapping frames are skipped.
+ * returns NULL if in_framenr is beyond the end of the track.
+ */
+static GapStoryFrameIndexEntry *
+p_frame_index_search(GapStoryFrameIndex *frame_index, gint32 in_track
+  , gint32 in_framenr, gboolean expanded)
+{
+  GapStoryFrameIndexEntry *tab;
+  gint32                   l_lo;
+  gint32                   l_hi;
+
+  tab = frame_index->tab[in_track];
+  l_lo = 0;
+  l_hi = frame_index->count[in_track];
+
+  while (l_lo < l_hi)
+  {
+    gint32 l_mid;
+    gint32 l_end;
+
+    l_mid = l_lo + ((l_hi - l_lo) / 2);
+    l_end = (expanded) ? tab[l_mid].expanded_end : tab[l_mid].end_max;
+    if (l_end < in_framenr)
+    {
+      l_lo = l_mid + 1;
+    }
+    else
+    {
+      l_hi = l_mid;
+    }
+  }
+
+  if (l_lo >= frame_index->count[in_track])
+  {
+    return (NULL);
+  }
+  return (&tab[l_lo]);
+
+}  /* end p_frame_index_search */
+
+
 /* ---------------------------------
  * gap_story_locate_expanded_framenr
  * ---------------------------------
@@ -6353,6 +6755,7 @@ gap_story_locate_expanded_framenr(GapStorySection  *section, gint32 in_framenr,
 {
   GapStoryLocateRet *ret_elem;
   GapStoryElem      *stb_elem;
+  GapStoryFrameIndex *frame_index;
   gint32             l_framenr;
 
   ret_elem = g_new(GapStoryLocateRet, 1);
@@ -6371,6 +6774,20 @@ gap_story_locate_expanded_framenr(GapStorySection  *section, gint32 in_framenr,
     return(ret_elem);
   }
 
+  frame_index = p_get_frame_index(section, in_track);
+  if (frame_index != NULL)
+  {
+    GapStoryFrameIndexEntry *entry;
+
+    entry = p_frame_index_search(frame_index, in_track, in_framenr, TRUE);
+    if (entry != NULL)
+    {
+      p_story_local_wanted_framenr(ret_elem, entry->stb_elem
+                                  , in_framenr - entry->frames_before);
+    }
+    return(ret_elem);
+  }
+
   for(stb_elem = section->stb_elem; stb_elem != NULL;  stb_elem = stb_elem->next)
   {
     if(stb_elem->track != in_track)
@@ -6406,6 +6823,7 @@ p_story_locate_framenr(GapStorySection   *section, gint32 in_framenr, gint32 in_
 {
   GapStoryLocateRet *ret_elem;
   GapStoryElem      *stb_elem;
+  GapStoryFrameIndex *frame_index;
   gint32             l_framenr;
 
   ret_elem = g_new(GapStoryLocateRet, 1);
@@ -6423,6 +6841,20 @@ p_story_locate_framenr(GapStorySection   *section, gint32 in_framenr, gint32 in_
     return(ret_elem);
   }
 
+  frame_index = p_get_frame_index(section, in_track);
+  if (frame_index != NULL)
+  {
+    GapStoryFrameIndexEntry *entry;
+
+    entry = p_frame_index_search(frame_index, in_track, in_framenr, FALSE);
+    if (entry != NULL)
+    {
+      p_story_local_wanted_framenr(ret_elem, entry->stb_elem
+                                  , in_framenr + entry->overlap_sum - entry->frames_before);
+    }
+    return(ret_elem);
+  }
+
   for(stb_elem = section->stb_elem; stb_elem != NULL;  stb_elem = stb_elem->next)
   {
     if(stb_elem->track != in_track)
@@ -7427,6 +7859,7 @@ p_story_board_duplicate(GapStoryBoard *stb_ptr, GapStoryDuplicateMode dup_mode
   {
     return (NULL);
   }
+  p_story_bulk_append_begin(stb_dup);
   stb_dup->master_type = stb_ptr->master_type;
   stb_dup->master_width = stb_ptr->master_width;
   stb_dup->master_height = stb_ptr->master_height;
@@ -7657,6 +8090,7 @@ p_story_board_duplicate(GapStoryBoard *stb_ptr, GapStoryDuplicateMode dup_mode
   {
     p_story_board_duplicate_refered_mask_definitions(stb_dup, stb_ptr);
   }
+  p_story_bulk_append_end(stb_dup);
 
   if(gap_debug)
   {
@@ -24,6 +24,8 @@
  */
 
 /* revision history:
+ * version 2.8.xx;  2026/10/18  agent: append hints for fast bulk append while parsing
+ * version 2.8.xx;  2026/10/18  agent: frame index for gap_story_locate_framenr
  * version 2.3.0;   2006/04/14  new features: overlap, flip, mask definitions
  * version 1.3.25b; 2004/01/23  hof: created
  */
@@ -212,6 +214,41 @@
     struct GapStoryElem  *next;
   } GapStoryElem;
 
+  /* one entry per element of a track in the frame index of a section.
+   * (all values refer to the elements of the same track in list order)
+   */
+  typedef struct GapStoryFrameIndexEntry
+  {
+     GapStoryElem    *stb_elem;
+     gint32          frames_before;   /* sum of nframes of all previous elements */
+     gint32          overlap_sum;     /* sum of att_overlap of transitions upto and including this element */
+     gint32          expanded_end;    /* last expanded frame number of this element */
+     gint32          end_max;         /* max last frame number (respecting overlaps) upto this element */
+  } GapStoryFrameIndexEntry;
+
+  /* the frame index of a section is built on demand and allows
+   * gap_story_locate_framenr and gap_story_locate_expanded_framenr to find
+   * the element of a frame number via binary search.
+   * it is valid as long as version and stb_elem root match the section.
+   */
+  typedef struct GapStoryFrameIndex
+  {
+     gint32                   version;
+     GapStoryElem            *stb_elem;
+     gint32                   count[GAP_STB_MAX_VID_TRACKS];
+     GapStoryFrameIndexEntry *tab[GAP_STB_MAX_VID_TRACKS];
+  } GapStoryFrameIndex;
+
+  /* the list tail and the last elements per video track of a section.
+   * maintained only while the storyboard is in bulk_append mode
+   */
+  typedef struct GapStoryAppendHint {
+     GapStoryElem *tail;
+     GapStoryElem *non_comment;                               /* last non comment element */
+     GapStoryElem *track_non_comment[GAP_STB_MAX_VID_TRACKS];  /* last non comment element per track */
+     GapStoryElem *track_transition[GAP_STB_MAX_VID_TRACKS];   /* last transition element per track */
+  } GapStoryAppendHint;
+
   typedef struct GapStorySection
   {
      GapStoryElem    *stb_elem;
@@ -221,6 +258,9 @@
      gint32          section_id;  /* unique ID, NOT persistent */
      gint32          version;     /* numer of changes while editing, NOT persistent */
 
+     GapStoryFrameIndex *frame_index;  /* NULL or cached index for frame number lookup, NOT persistent */
+     GapStoryAppendHint *append_hint;  /* NULL or list tail hints in bulk_append mode, NOT persistent */
+
      void            *next;
   } GapStorySection;
 
@@ -300,6 +340,12 @@
 
      gchar         *master_insert_alpha_format;
      gchar         *master_insert_area_format;
+
+     /* TRUE while the parser (or duplicate) appends elements to a new storyboard
+      * that is not visible to other code. In this mode appending uses
+      * the append_hint of the section instead of walking the element list.
+      */
+     gboolean       bulk_append;
  }  GapStoryBoard;
 
 
@@ -349,6 +395,8 @@ GapStoryLocateRet * gap_story_locate_framenr(GapStoryBoard *stb
 GapStoryLocateRet * gap_story_locate_expanded_framenr(GapStorySection  *section
                          , gint32 in_framenr
                          , gint32 in_track);
+void                gap_story_section_invalidate_frame_index(GapStorySection *section);
+void                gap_story_invalidate_frame_index(GapStoryBoard *stb);
 
 void                gap_story_lists_merge(GapStoryBoard *stb_dst
                          , GapStoryBoard *stb_src
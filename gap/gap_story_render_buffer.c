@@ -0,0 +1,538 @@
+/* gap_story_render_buffer.c
+ *
+ *  GAP storyboard rendering processor.
+ *
+ *  This module is the buffer based compositing engine.
+ *  It composes transformed tracks (scale, move, rotate, flip, opacity
+ *  and layermasks) on top of an opaque RGB888 composite frame buffer
+ *  in memory, without creating gimp images and layers.
+ *  The result is flat by construction (the composite frame starts as opaque
+ *  background, each track is painted in normal mode on top of it).
+ *
+ *  The transformation is done per composite frame pixel by inverse mapping
+ *  to the source pixels (bilinear interpolation), therefore clipping at the
+ *  frame borders needs no extra work and no scaled copy of the source
+ *  is created. The rows of the composite frame can be processed in parallel
+ *  worker threads.
+ *
+ *  Note: this module does not call the gimp PDB.
+ */
+
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026/10/18  agent: created
+ */
+
+#include <config.h>
+
+/* SYTEM (UNIX) includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* GIMP includes */
+#include "libgimp/gimp.h"
+
+/* GAP includes */
+#include "gap_lib_common_defs.h"
+#include "gap_story_render_buffer.h"
+
+/* rows per worker job (smaller frames are composed without threads) */
+#define GAP_STB_BUFFER_MIN_ROWS_PER_JOB 16
+
+
+typedef struct GapStbBufferCompositeContext  /* nick: bctx */
+{
+  guchar                    *rgb888;
+  gint32                     width;
+  gint32                     height;
+  GapStoryRenderBufferLayer *blay;
+
+  gdouble   center_x;       /* center of the scaled track in the composite frame */
+  gdouble   center_y;
+  gdouble   cos_rot;
+  gdouble   sin_rot;
+  gboolean  is_rotated;
+  gdouble   src_scale_x;    /* source pixels per scaled track pixel */
+  gdouble   src_scale_y;
+
+  gint32    pending_jobs;   /* protected by bufferMutex */
+} GapStbBufferCompositeContext;
+
+typedef struct GapStbBufferJob
+{
+  GapStbBufferCompositeContext *bctx;
+  gint32  row_from;
+  gint32  row_to;          /* exclusive */
+  gint32  col_from;
+  gint32  col_to;          /* exclusive */
+} GapStbBufferJob;
+
+
+extern int gap_debug;  /* 1 == print debug infos , 0 dont print debug infos */
+
+static GThreadPool *bufferThreadPool = NULL;
+static GMutex      *bufferMutex = NULL;
+static GCond       *bufferJobsDoneCond = NULL;
+
+
+static void      p_sample_source(GapStoryRenderPixelBuffer *src
+                      , gdouble sx, gdouble sy, gdouble *rgba);
+static void      p_composite_rows(GapStbBufferJob *job);
+static void      p_buffer_worker_thread(GapStbBufferJob *job, gpointer data);
+static GThreadPool * p_get_buffer_thread_pool(gint32 numThreads);
+
+
+/* ----------------------------------------------------
+ * gap_story_render_buffer_new
+ * ----------------------------------------------------
+ */
+GapStoryRenderPixelBuffer *
+gap_story_render_buffer_new(gint32 width, gint32 height, gint32 bpp)
+{
+  GapStoryRenderPixelBuffer *pbuf;
+
+  pbuf = g_new(GapStoryRenderPixelBuffer, 1);
+  pbuf->width = width;
+  pbuf->height = height;
+  pbuf->bpp = bpp;
+  pbuf->rowstride = width * bpp;
+  pbuf->data = g_malloc(pbuf->rowstride * height);
+
+  return (pbuf);
+}  /* end gap_story_render_buffer_new */
+
+
+/* ----------------------------------------------------
+ * gap_story_render_buffer_free
+ * ----------------------------------------------------
+ */
+void
+gap_story_render_buffer_free(GapStoryRenderPixelBuffer *pbuf)
+{
+  if(pbuf != NULL)
+  {
+    g_free(pbuf->data);
+    g_free(pbuf);
+  }
+}  /* end gap_story_render_buffer_free */
+
+
+/* ----------------------------------------------------
+ * gap_story_render_buffer_fill_rgb888
+ * ----------------------------------------------------
+ * fill the composite frame with the (opaque) background color
+ */
+void
+gap_story_render_buffer_fill_rgb888(guchar *rgb888
+                 , gint32 width
+                 , gint32 height
+                 , guchar red
+                 , guchar green
+                 , guchar blue
+                 )
+{
+  gint32  ii;
+  gint32  count;
+  guchar *ptr;
+
+  count = width * height;
+  if((red == green) && (red == blue))
+  {
+    memset(rgb888, red, count * 3);
+    return;
+  }
+  ptr = rgb888;
+  for(ii = 0; ii < count; ii++)
+  {
+    *(ptr++) = red;
+    *(ptr++) = green;
+    *(ptr++) = blue;
+  }
+}  /* end gap_story_render_buffer_fill_rgb888 */
+
+
+/* ----------------------------------------------------
+ * p_sample_source
+ * ----------------------------------------------------
+ * bilinear interpolated sample of the source at position sx/sy
+ * (pixel centers are at .5 positions, positions outside are clamped
+ * to the border pixels). The result rgba values are in range 0.0 to 255.0
+ * colors of transparent pixels do not bleed into the result
+ * (interpolation is done with alpha weighted colors)
+ */
+static void
+p_sample_source(GapStoryRenderPixelBuffer *src, gdouble sx, gdouble sy, gdouble *rgba)
+{
+  gdouble  fx;
+  gdouble  fy;
+  gdouble  tx;
+  gdouble  ty;
+  gint32   x0;
+  gint32   y0;
+  gint32   x1;
+  gint32   y1;
+  guchar  *p00;
+  guchar  *p01;
+  guchar  *p10;
+  guchar  *p11;
+  gdouble  w00;
+  gdouble  w01;
+  gdouble  w10;
+  gdouble  w11;
+  gint     cc;
+
+  fx = CLAMP(sx - 0.5, 0.0, (gdouble)(src->width - 1));
+  fy = CLAMP(sy - 0.5, 0.0, (gdouble)(src->height - 1));
+  x0 = (gint32)fx;
+  y0 = (gint32)fy;
+  x1 = MIN(x0 + 1, src->width - 1);
+  y1 = MIN(y0 + 1, src->height - 1);
+  tx = fx - x0;
+  ty = fy - y0;
+
+  p00 = src->data + (y0 * src->rowstride) + (x0 * src->bpp);
+  p01 = src->data + (y0 * src->rowstride) + (x1 * src->bpp);
+  p10 = src->data + (y1 * src->rowstride) + (x0 * src->bpp);
+  p11 = src->data + (y1 * src->rowstride) + (x1 * src->bpp);
+
+  w00 = (1.0 - tx) * (1.0 - ty);
+  w01 = tx * (1.0 - ty);
+  w10 = (1.0 - tx) * ty;
+  w11 = tx * ty;
+
+  if(src->bpp < 4)
+  {
+    for(cc = 0; cc < 3; cc++)
+    {
+      rgba[cc] = (w00 * p00[cc]) + (w01 * p01[cc]) + (w10 * p10[cc]) + (w11 * p11[cc]);
+    }
+    rgba[3] = 255.0;
+    return;
+  }
+
+  /* alpha weighted interpolation */
+  w00 *= p00[3];
+  w01 *= p01[3];
+  w10 *= p10[3];
+  w11 *= p11[3];
+  rgba[3] = w00 + w01 + w10 + w11;
+  if(rgba[3] <= 0.0)
+  {
+    rgba[0] = rgba[1] = rgba[2] = 0.0;
+    rgba[3] = 0.0;
+    return;
+  }
+  for(cc = 0; cc < 3; cc++)
+  {
+    rgba[cc] = ((w00 * p00[cc]) + (w01 * p01[cc]) + (w10 * p10[cc]) + (w11 * p11[cc])) / rgba[3];
+  }
+
+}  /* end p_sample_source */
+
+
+/* ----------------------------------------------------
+ * p_composite_rows
+ * ----------------------------------------------------
+ * compose the track (bctx->blay) into the specified rows
+ * of the composite frame.
+ */
+static void
+p_composite_rows(GapStbBufferJob *job)
+{
+  GapStbBufferCompositeContext *bctx;
+  GapStoryRenderBufferLayer    *blay;
+  gdouble  half_width;
+  gdouble  half_height;
+  gint32   px;
+  gint32   py;
+
+  bctx = job->bctx;
+  blay = bctx->blay;
+  half_width = blay->width / 2.0;
+  half_height = blay->height / 2.0;
+
+  for(py = job->row_from; py < job->row_to; py++)
+  {
+    guchar  *dst;
+    gdouble  dy;
+
+    dy = (py + 0.5) - bctx->center_y;
+    dst = bctx->rgb888 + (((py * bctx->width) + job->col_from) * 3);
+
+    for(px = job->col_from; px < job->col_to; px++, dst += 3)
+    {
+      gdouble dx;
+      gdouble rx;
+      gdouble ry;
+      gdouble alpha;
+      gdouble rgba[4];
+
+      dx = (px + 0.5) - bctx->center_x;
+      if(bctx->is_rotated)
+      {
+        /* inverse rotation (clockwise rotation in the y-down frame) */
+        rx = ( dx * bctx->cos_rot) + (dy * bctx->sin_rot) + half_width;
+        ry = (-dx * bctx->sin_rot) + (dy * bctx->cos_rot) + half_height;
+      }
+      else
+      {
+        rx = dx + half_width;
+        ry = dy + half_height;
+      }
+
+      if((rx < 0.0) || (ry < 0.0) || (rx >= blay->width) || (ry >= blay->height))
+      {
+        continue;  /* outside of the track */
+      }
+
+      alpha = blay->opacity;
+      if(blay->clip_mask != NULL)
+      {
+        alpha *= blay->clip_mask[((gint32)ry * blay->width) + (gint32)rx] / 255.0;
+      }
+      if(blay->master_mask != NULL)
+      {
+        alpha *= blay->master_mask[(py * bctx->width) + px] / 255.0;
+      }
+      if(alpha <= 0.0)
+      {
+        continue;
+      }
+
+      if(blay->src == NULL)
+      {
+        rgba[0] = blay->color[0];
+        rgba[1] = blay->color[1];
+        rgba[2] = blay->color[2];
+        rgba[3] = blay->color[3];
+      }
+      else
+      {
+        /* flip is applied to the source (before scaling and masking) */
+        if((blay->flip_request == GAP_STB_FLIP_HOR) || (blay->flip_request == GAP_STB_FLIP_BOTH))
+        {
+          rx = blay->width - rx;
+        }
+        if((blay->flip_request == GAP_STB_FLIP_VER) || (blay->flip_request == GAP_STB_FLIP_BOTH))
+        {
+          ry = blay->height - ry;
+        }
+        p_sample_source(blay->src
+                       , rx * bctx->src_scale_x
+                       , ry * bctx->src_scale_y
+                       , rgba
+                       );
+      }
+
+      alpha *= rgba[3] / 255.0;
+      if(alpha >= 1.0)
+      {
+        dst[0] = (guchar)(rgba[0] + 0.5);
+        dst[1] = (guchar)(rgba[1] + 0.5);
+        dst[2] = (guchar)(rgba[2] + 0.5);
+      }
+      else if(alpha > 0.0)
+      {
+        dst[0] = (guchar)((rgba[0] * alpha) + (dst[0] * (1.0 - alpha)) + 0.5);
+        dst[1] = (guchar)((rgba[1] * alpha) + (dst[1] * (1.0 - alpha)) + 0.5);
+        dst[2] = (guchar)((rgba[2] * alpha) + (dst[2] * (1.0 - alpha)) + 0.5);
+      }
+    }
+  }
+
+}  /* end p_composite_rows */
+
+
+/* ----------------------------------------------------
+ * p_buffer_worker_thread
+ * ----------------------------------------------------
+ */
+static void
+p_buffer_worker_thread(GapStbBufferJob *job, gpointer data)
+{
+  p_composite_rows(job);
+
+  g_mutex_lock(bufferMutex);
+  job->bctx->pending_jobs--;
+  if(job->bctx->pending_jobs <= 0)
+  {
+    g_cond_broadcast(bufferJobsDoneCond);
+  }
+  g_mutex_unlock(bufferMutex);
+
+}  /* end p_buffer_worker_thread */
+
+
+/* ----------------------------------------------------
+ * p_get_buffer_thread_pool
+ * ----------------------------------------------------
+ */
+static GThreadPool *
+p_get_buffer_thread_pool(gint32 numThreads)
+{
+  if(bufferThreadPool == NULL)
+  {
+    GError *error = NULL;
+
+    bufferMutex = g_mutex_new();
+    bufferJobsDoneCond = g_cond_new();
+    bufferThreadPool = g_thread_pool_new((GFunc)p_buffer_worker_thread
+                                         ,NULL        /* user data */
+                                         ,numThreads  /* max_threads */
+                                         ,FALSE       /* exclusive */
+                                         ,&error      /* GError **error */
+                                         );
+    if(bufferThreadPool == NULL)
+    {
+      printf("** ERROR could not create bufferThreadPool\n");
+    }
+  }
+  return (bufferThreadPool);
+
+}  /* end p_get_buffer_thread_pool */
+
+
+/* ----------------------------------------------------
+ * gap_story_render_buffer_composite_layer
+ * ----------------------------------------------------
+ * compose the transformed track blay on top of the composite frame rgb888
+ * (width x height, opaque RGB 3 bytes per pixel)
+ *
+ * numThreads > 1 splits the rows of the visible area into jobs for
+ * parallel worker threads (the caller must have initialized the thread system).
+ */
+void
+gap_story_render_buffer_composite_layer(guchar *rgb888
+                 , gint32 width
+                 , gint32 height
+                 , GapStoryRenderBufferLayer *blay
+                 , gint32 numThreads
+                 )
+{
+  GapStbBufferCompositeContext  bufferCompositeContext;
+  GapStbBufferCompositeContext *bctx;
+  gdouble  half_extent_x;
+  gdouble  half_extent_y;
+  gint32   col_from;
+  gint32   col_to;
+  gint32   row_from;
+  gint32   row_to;
+  gint32   rows;
+
+  if((blay->width <= 0) || (blay->height <= 0) || (blay->opacity <= 0.0))
+  {
+    return;
+  }
+  if(blay->src != NULL)
+  {
+    if((blay->src->width <= 0) || (blay->src->height <= 0))
+    {
+      return;
+    }
+  }
+
+  bctx = &bufferCompositeContext;
+  bctx->rgb888 = rgb888;
+  bctx->width = width;
+  bctx->height = height;
+  bctx->blay = blay;
+  bctx->center_x = blay->x_offs + (blay->width / 2.0);
+  bctx->center_y = blay->y_offs + (blay->height / 2.0);
+  bctx->is_rotated = FALSE;
+  bctx->cos_rot = 1.0;
+  bctx->sin_rot = 0.0;
+  bctx->src_scale_x = 1.0;
+  bctx->src_scale_y = 1.0;
+  bctx->pending_jobs = 0;
+  if(blay->src != NULL)
+  {
+    bctx->src_scale_x = (gdouble)blay->src->width / (gdouble)blay->width;
+    bctx->src_scale_y = (gdouble)blay->src->height / (gdouble)blay->height;
+  }
+
+  half_extent_x = blay->width / 2.0;
+  half_extent_y = blay->height / 2.0;
+  if((blay->rotate > 0.05) || (blay->rotate < -0.05))
+  {
+    gdouble l_rad;
+
+    l_rad = (blay->rotate * G_PI) / 180.0;
+    bctx->is_rotated = TRUE;
+    bctx->cos_rot = cos(l_rad);
+    bctx->sin_rot = sin(l_rad);
+    half_extent_x = ((fabs(blay->width * bctx->cos_rot)) + (fabs(blay->height * bctx->sin_rot))) / 2.0;
+    half_extent_y = ((fabs(blay->width * bctx->sin_rot)) + (fabs(blay->height * bctx->cos_rot))) / 2.0;
+  }
+
+  /* visible area (bounding box of the transformed track clipped to the frame) */
+  col_from = MAX(0, (gint32)floor(bctx->center_x - half_extent_x));
+  col_to   = MIN(width, (gint32)ceil(bctx->center_x + half_extent_x));
+  row_from = MAX(0, (gint32)floor(bctx->center_y - half_extent_y));
+  row_to   = MIN(height, (gint32)ceil(bctx->center_y + half_extent_y));
+  rows = row_to - row_from;
+  if((col_to <= col_from) || (rows <= 0))
+  {
+    return;
+  }
+
+  if((numThreads > 1)
+  && (rows >= 2 * GAP_STB_BUFFER_MIN_ROWS_PER_JOB)
+  && (p_get_buffer_thread_pool(numThreads) != NULL))
+  {
+    GapStbBufferJob *jobs;
+    gint32 numJobs;
+    gint32 ii;
+
+    numJobs = MIN(numThreads, rows / GAP_STB_BUFFER_MIN_ROWS_PER_JOB);
+    jobs = g_new(GapStbBufferJob, numJobs);
+    bctx->pending_jobs = numJobs;
+    for(ii = 0; ii < numJobs; ii++)
+    {
+      jobs[ii].bctx = bctx;
+      jobs[ii].col_from = col_from;
+      jobs[ii].col_to = col_to;
+      jobs[ii].row_from = row_from + ((rows * ii) / numJobs);
+      jobs[ii].row_to = row_from + ((rows * (ii + 1)) / numJobs);
+      g_thread_pool_push(bufferThreadPool, &jobs[ii], NULL);
+    }
+
+    g_mutex_lock(bufferMutex);
+    while(bctx->pending_jobs > 0)
+    {
+      g_cond_wait(bufferJobsDoneCond, bufferMutex);
+    }
+    g_mutex_unlock(bufferMutex);
+    g_free(jobs);
+  }
+  else
+  {
+    GapStbBufferJob job;
+
+    job.bctx = bctx;
+    job.col_from = col_from;
+    job.col_to = col_to;
+    job.row_from = row_from;
+    job.row_to = row_to;
+    p_composite_rows(&job);
+  }
+
+}  /* end gap_story_render_buffer_composite_layer */
@@ -0,0 +1,87 @@
+/* gap_story_render_buffer.h
+ *
+ *  GAP storyboard rendering processor.
+ *  buffer based compositing engine (compositing of transformed tracks
+ *  in memory buffers without gimp layers)
+ *
+ */
+
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026/10/18  agent: created
+ */
+
+#ifndef GAP_STORY_RENDER_BUFFER_H
+#define GAP_STORY_RENDER_BUFFER_H
+
+#include "libgimp/gimp.h"
+
+#define GAP_GIMPRC_VIDEO_STORYBOARD_BUFFER_COMPOSITING  "video-storyboard-buffer-compositing"
+
+/* source pixels of one track (RGB or RGBA, 8 bit per channel, not premultiplied)
+ * or gray mask pixels (bpp 1, layermask cache)
+ */
+typedef struct GapStoryRenderPixelBuffer  /* nick: pbuf */
+{
+  guchar  *data;
+  gint32   width;
+  gint32   height;
+  gint32   bpp;           /* 3 for RGB, 4 for RGBA, 1 for gray masks */
+  gint32   rowstride;
+} GapStoryRenderPixelBuffer;
+
+/* one track to be composed on top of the composite frame */
+typedef struct GapStoryRenderBufferLayer  /* nick: blay */
+{
+  GapStoryRenderPixelBuffer *src;  /* NULL for unicolor clips (use color) */
+  guchar   color[4];               /* RGBA color for unicolor clips */
+
+  gint32   width;                  /* scaled size of the track (before rotation) */
+  gint32   height;
+  gint32   x_offs;                 /* position of the scaled (unrotated) track in the composite frame */
+  gint32   y_offs;
+  gdouble  rotate;                 /* rotation in degree around the center of the scaled track */
+  gdouble  opacity;                /* 0.0 upto 1.0 */
+  gint32   flip_request;           /* 0 none, 1 flip horizontal, 2 flip vertical, 3 flip both */
+
+  guchar  *clip_mask;              /* optional 8 bit mask at width x height (anchored to the clip) */
+  guchar  *master_mask;            /* optional 8 bit mask at composite frame size (anchored to master) */
+} GapStoryRenderBufferLayer;
+
+
+GapStoryRenderPixelBuffer * gap_story_render_buffer_new(gint32 width, gint32 height, gint32 bpp);
+void                        gap_story_render_buffer_free(GapStoryRenderPixelBuffer *pbuf);
+
+void    gap_story_render_buffer_fill_rgb888(guchar *rgb888
+                 , gint32 width
+                 , gint32 height
+                 , guchar red
+                 , guchar green
+                 , guchar blue
+                 );
+
+void    gap_story_render_buffer_composite_layer(guchar *rgb888
+                 , gint32 width
+                 , gint32 height
+                 , GapStoryRenderBufferLayer *blay
+                 , gint32 numThreads
+                 );
+
+#endif
@@ -0,0 +1,979 @@
+/* gap_story_render_compiled.c
+ *
+ *  GAP storyboard rendering processor.
+ *
+ *  This module handles the compiled storyboard cache.
+ *  The render representation of a storyboard file (the frame range lists
+ *  of all sections, master settings and the refered mask definitions)
+ *  is saved as binary file next to the storyboard.
+ *  Reopening an unchanged storyboard for rendering loads this file
+ *  and skips parsing and analyzing the storyboard.
+ *
+ *  The compiled file is valid as long as the storyboard content checksum (MD5)
+ *  matches and all refered files (images, videos, the frame files of frame
+ *  sequences, filtermacros, colormasks and movepath xml files) have the same
+ *  modification time (nanoseconds) and size (or are still missing)
+ *  as they had at compile time.
+ *  The binary format is written in native byte order and struct layout,
+ *  it is a local cache and not intended for exchange between machines.
+ */
+
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026/10/19  agent: opt-in, nanosecond stamps, frame files of frame sequences
+ * version 2.8.xx;  2026/10/18  agent: created
+ */
+
+#include <config.h>
+
+/* SYTEM (UNIX) includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+
+/* GIMP includes */
+#include "libgimp/gimp.h"
+
+/* GAP includes */
+#include "gap_libgapbase.h"
+#include "gap_lib.h"
+#include "gap_story_file.h"
+#include "gap_story_render_compiled.h"
+#include "gap_fmac_name.h"
+
+
+#define GAP_STB_COMPILED_MAGIC    "GAP-STB-COMPILED\n"
+#define GAP_STB_COMPILED_VERSION  2
+#define GAP_STB_CHECKSUM_LENGTH   33    /* MD5 as hex string incl. terminating 0 */
+
+/* header of the compiled file (followed by the variable length parts) */
+typedef struct GapStbCompiledHeader
+{
+  gchar    magic[20];
+  gint32   version;
+  gint32   sizeof_frn_elem;     /* struct layout check */
+  gint32   sizeof_header;
+  gchar    content_checksum[40];  /* MD5 of the storyboard file content (hex string) */
+  gint64   content_size;
+  gboolean audio_complete;      /* TRUE: compiled with audio (aud_list was built) */
+  gboolean has_audio;           /* TRUE: storyboard has audio elements */
+  gint32   frame_count;         /* frames of the MAIN section */
+  gint32   count_refs;
+  gint32   count_sections;
+  gint32   count_maskdefs;
+
+  /* master settings */
+  gdouble  master_framerate;
+  gint32   master_width;
+  gint32   master_height;
+  gint32   master_samplerate;
+  gdouble  master_volume;
+  gboolean master_insert_alpha_format_has_videobasename;
+  gboolean master_insert_alpha_format_has_framenumber;
+  gboolean master_insert_area_format_has_videobasename;
+  gboolean master_insert_area_format_has_framenumber;
+} GapStbCompiledHeader;
+
+/* mask definition (the relevant attributes of the GapStoryElem) */
+typedef struct GapStbCompiledMaskdef
+{
+  gint32   record_type;
+  gint32   track;
+  gint32   from_frame;
+  gint32   to_frame;
+  gint32   seltrack;
+  gint32   exact_seek;
+  gdouble  delace;
+  gint32   flip_request;
+} GapStbCompiledMaskdef;
+
+/* read position in the loaded compiled file */
+typedef struct GapStbCompiledReader
+{
+  const gchar *ptr;
+  const gchar *end;
+  gboolean     ok;
+} GapStbCompiledReader;
+
+
+extern int gap_debug;  /* 1 == print debug infos , 0 dont print debug infos */
+
+
+static gchar *    p_compiled_filename(const char *storyboard_file);
+static void       p_content_checksum(const gchar *content, gsize length, gchar *checksum);
+static void       p_get_file_stamp(const char *filename, gint64 *mtime, gint64 *size);
+static void       p_add_ref(GPtrArray *refs, GHashTable *ref_hash, gchar *filename);
+static GPtrArray * p_collect_refs(GapStoryBoard *stb, const char *storyboard_file);
+
+static void       p_write_data(FILE *fp, gboolean *ok, const void *data, gsize length);
+static void       p_write_string(FILE *fp, gboolean *ok, const char *string);
+static void       p_write_gint64(FILE *fp, gboolean *ok, gint64 value);
+static void       p_write_gint32(FILE *fp, gboolean *ok, gint32 value);
+
+static void       p_read_data(GapStbCompiledReader *rd, void *data, gsize length);
+static gchar *    p_read_string(GapStbCompiledReader *rd);
+static gint64     p_read_gint64(GapStbCompiledReader *rd);
+static gint32     p_read_gint32(GapStbCompiledReader *rd);
+
+static void       p_free_sections(GapStoryRenderSection *section_list);
+
+
+/* ----------------------------------------------------
+ * gap_story_render_compiled_is_enabled
+ * ----------------------------------------------------
+ */
+gboolean
+gap_story_render_compiled_is_enabled(void)
+{
+  return (gap_base_get_gimprc_gboolean_value(GAP_GIMPRC_VIDEO_STORYBOARD_COMPILED_CACHE
+                                            , FALSE  /* default (opt-in, writes hidden files) */
+                                            ));
+}  /* end gap_story_render_compiled_is_enabled */
+
+
+/* ----------------------------------------------------
+ * p_compiled_filename
+ * ----------------------------------------------------
+ * the compiled file is a hidden file in the directory of the storyboard.
+ * e.g. /video/.mystory.txt.compiled for the storyboard /video/mystory.txt
+ */
+static gchar *
+p_compiled_filename(const char *storyboard_file)
+{
+  gchar *dirname;
+  gchar *basename;
+  gchar *hidden_name;
+  gchar *compiled_filename;
+
+  dirname = g_path_get_dirname(storyboard_file);
+  basename = g_path_get_basename(storyboard_file);
+  hidden_name = g_strdup_printf(".%s.compiled", basename);
+  compiled_filename = g_build_filename(dirname, hidden_name, NULL);
+
+  g_free(dirname);
+  g_free(basename);
+  g_free(hidden_name);
+
+  return (compiled_filename);
+}  /* end p_compiled_filename */
+
+
+/* ----------------------------------------------------
+ * p_content_checksum
+ * ----------------------------------------------------
+ * deliver the MD5 checksum of the storyboard file content
+ * as hex string in checksum (GAP_STB_CHECKSUM_LENGTH bytes).
+ */
+static void
+p_content_checksum(const gchar *content, gsize length, gchar *checksum)
+{
+  gchar *l_md5;
+
+  l_md5 = g_compute_checksum_for_data(G_CHECKSUM_MD5, (const guchar *)content, length);
+  g_strlcpy(checksum, l_md5, GAP_STB_CHECKSUM_LENGTH);
+  g_free(l_md5);
+}  /* end p_content_checksum */
+
+
+/* ----------------------------------------------------
+ * p_get_file_stamp
+ * ----------------------------------------------------
+ * deliver modification time (nanoseconds) and size of the specified file
+ * (-1 for both values if the file does not exist)
+ */
+static void
+p_get_file_stamp(const char *filename, gint64 *mtime, gint64 *size)
+{
+  if(!gap_file_get_stamp(filename, mtime, size))
+  {
+    *mtime = -1;
+    *size = -1;
+  }
+}  /* end p_get_file_stamp */
+
+
+/* ----------------------------------------------------
+ * p_add_ref
+ * ----------------------------------------------------
+ * add filename to the list of refered files (takes ownership of filename)
+ */
+static void
+p_add_ref(GPtrArray *refs, GHashTable *ref_hash, gchar *filename)
+{
+  if(filename == NULL)
+  {
+    return;
+  }
+  if((*filename == '\0')
+  || (g_hash_table_lookup(ref_hash, filename) != NULL))
+  {
+    g_free(filename);
+    return;
+  }
+  g_hash_table_insert(ref_hash, filename, filename);
+  g_ptr_array_add(refs, filename);
+}  /* end p_add_ref */
+
+
+/* ----------------------------------------------------
+ * p_collect_refs
+ * ----------------------------------------------------
+ * collect the names of all files that are checked or probed
+ * when the storyboard is converted to the render representation.
+ * The names are resolved the same way as the render processor does
+ * (relative to the storyboard file).
+ * Files that are refered but not found are included too, because
+ * their later creation changes the render representation.
+ */
+static GPtrArray *
+p_collect_refs(GapStoryBoard *stb, const char *storyboard_file)
+{
+  GPtrArray       *refs;
+  GHashTable      *ref_hash;
+  GapStorySection *section;
+  GapStoryElem    *stb_elem;
+
+  refs = g_ptr_array_new();
+  ref_hash = g_hash_table_new(g_str_hash, g_str_equal);
+
+  for(section = stb->stb_section; section != NULL; section = section->next)
+  {
+    for(stb_elem = section->stb_elem; stb_elem != NULL; stb_elem = stb_elem->next)
+    {
+      switch(stb_elem->record_type)
+      {
+        case GAP_STBREC_VID_IMAGE:
+        case GAP_STBREC_VID_ANIMIMAGE:
+        case GAP_STBREC_VID_MOVIE:
+        case GAP_STBREC_AUD_SOUND:
+        case GAP_STBREC_AUD_MOVIE:
+          if(stb_elem->orig_filename)
+          {
+            p_add_ref(refs, ref_hash
+                     , gap_file_make_abspath_filename(stb_elem->orig_filename, storyboard_file));
+          }
+          break;
+        case GAP_STBREC_VID_FRAMES:
+          if(stb_elem->basename)
+          {
+            gint32 l_fnr;
+            gint32 l_fnr_lo;
+            gint32 l_fnr_hi;
+
+            /* each frame file of the frame sequence */
+            l_fnr_lo = MIN(stb_elem->from_frame, stb_elem->to_frame);
+            l_fnr_hi = MAX(stb_elem->from_frame, stb_elem->to_frame);
+            for(l_fnr = l_fnr_lo; l_fnr <= l_fnr_hi; l_fnr++)
+            {
+              gchar *l_framename;
+
+              l_framename = gap_lib_alloc_fname(stb_elem->basename, l_fnr, stb_elem->ext);
+              if(l_framename)
+              {
+                p_add_ref(refs, ref_hash
+                         , gap_file_make_abspath_filename(l_framename, storyboard_file));
+                g_free(l_framename);
+              }
+            }
+          }
+          break;
+        default:
+          break;
+      }
+
+      if(stb_elem->filtermacro_file)
+      {
+        gchar *l_fmac_file;
+
+        l_fmac_file = gap_file_make_abspath_filename(stb_elem->filtermacro_file, storyboard_file);
+        p_add_ref(refs, ref_hash, gap_fmac_get_alternate_name(stb_elem->filtermacro_file));
+        p_add_ref(refs, ref_hash, l_fmac_file);
+      }
+      if(stb_elem->colormask_file)
+      {
+        p_add_ref(refs, ref_hash
+                 , gap_file_make_abspath_filename(stb_elem->colormask_file, storyboard_file));
+      }
+      if(stb_elem->att_movepath_file_xml)
+      {
+        p_add_ref(refs, ref_hash, g_strdup(stb_elem->att_movepath_file_xml));
+      }
+    }
+  }
+
+  g_hash_table_destroy(ref_hash);
+  return (refs);
+}  /* end p_collect_refs */
+
+
+/* ----------------------------------------------------
+ * p_write_data
+ * ----------------------------------------------------
+ */
+static void
+p_write_data(FILE *fp, gboolean *ok, const void *data, gsize length)
+{
+  if(*ok && (length > 0))
+  {
+    if(fwrite(data, 1, length, fp) != length)
+    {
+      *ok = FALSE;
+    }
+  }
+}  /* end p_write_data */
+
+static void
+p_write_gint32(FILE *fp, gboolean *ok, gint32 value)
+{
+  p_write_data(fp, ok, &value, sizeof(value));
+}  /* end p_write_gint32 */
+
+static void
+p_write_gint64(FILE *fp, gboolean *ok, gint64 value)
+{
+  p_write_data(fp, ok, &value, sizeof(value));
+}  /* end p_write_gint64 */
+
+/* ----------------------------------------------------
+ * p_write_string
+ * ----------------------------------------------------
+ * write length (-1 for NULL) followed by the characters (without \0)
+ */
+static void
+p_write_string(FILE *fp, gboolean *ok, const char *string)
+{
+  gint32 l_len;
+
+  l_len = -1;
+  if(string)
+  {
+    l_len = strlen(string);
+  }
+  p_write_gint32(fp, ok, l_len);
+  if(l_len > 0)
+  {
+    p_write_data(fp, ok, string, l_len);
+  }
+}  /* end p_write_string */
+
+
+/* ----------------------------------------------------
+ * p_read_data
+ * ----------------------------------------------------
+ */
+static void
+p_read_data(GapStbCompiledReader *rd, void *data, gsize length)
+{
+  if((!rd->ok) || ((gsize)(rd->end - rd->ptr) < length))
+  {
+    rd->ok = FALSE;
+    memset(data, 0, length);
+    return;
+  }
+  memcpy(data, rd->ptr, length);
+  rd->ptr += length;
+}  /* end p_read_data */
+
+static gint32
+p_read_gint32(GapStbCompiledReader *rd)
+{
+  gint32 value;
+
+  p_read_data(rd, &value, sizeof(value));
+  return (value);
+}  /* end p_read_gint32 */
+
+static gint64
+p_read_gint64(GapStbCompiledReader *rd)
+{
+  gint64 value;
+
+  p_read_data(rd, &value, sizeof(value));
+  return (value);
+}  /* end p_read_gint64 */
+
+/* ----------------------------------------------------
+ * p_read_string
+ * ----------------------------------------------------
+ * returns a newly allocated string or NULL
+ */
+static gchar *
+p_read_string(GapStbCompiledReader *rd)
+{
+  gint32 l_len;
+  gchar *string;
+
+  l_len = p_read_gint32(rd);
+  if((!rd->ok) || (l_len < 0))
+  {
+    return (NULL);
+  }
+  if((gsize)(rd->end - rd->ptr) < (gsize)l_len)
+  {
+    rd->ok = FALSE;
+    return (NULL);
+  }
+  string = g_strndup(rd->ptr, l_len);
+  rd->ptr += l_len;
+  return (string);
+}  /* end p_read_string */
+
+
+/* ----------------------------------------------------
+ * p_free_sections
+ * ----------------------------------------------------
+ * free sections that were partly read from an invalid compiled file.
+ */
+static void
+p_free_sections(GapStoryRenderSection *section_list)
+{
+  GapStoryRenderSection *section;
+  GapStoryRenderSection *next_section;
+
+  for(section = section_list; section != NULL; section = next_section)
+  {
+    GapStoryRenderFrameRangeElem *frn_elem;
+    GapStoryRenderFrameRangeElem *frn_next;
+
+    for(frn_elem = section->frn_list; frn_elem != NULL; frn_elem = frn_next)
+    {
+      frn_next = frn_elem->next;
+      g_free(frn_elem->basename);
+      g_free(frn_elem->ext);
+      g_free(frn_elem->filtermacro_file);
+      g_free(frn_elem->filtermacro_file_to);
+      g_free(frn_elem->mask_name);
+      g_free(frn_elem->colormask_file);
+      g_free(frn_elem->movepath_file_xml);
+      g_free(frn_elem);
+    }
+    next_section = section->next;
+    g_free(section->section_name);
+    g_free(section);
+  }
+}  /* end p_free_sections */
+
+
+/* ----------------------------------------------------
+ * gap_story_render_compiled_save
+ * ----------------------------------------------------
+ * save the render representation of the storyboard
+ * (the section list, master settings of the vidhand and the refered mask
+ * definitions of the stb) as compiled file next to the storyboard_file.
+ * this shall be called after successful analyze of the storyboard
+ * (without errors) that was parsed from storyboard_file.
+ * failures are not reported to the user (the cache is just not available).
+ */
+void
+gap_story_render_compiled_save(const char *storyboard_file
+                 , GapStoryRenderVidHandle *vidhand
+                 , gint32 frame_count
+                 , GapStoryBoard *stb
+                 )
+{
+  GapStbCompiledHeader   hdr;
+  GapStoryRenderSection *section;
+  GapStoryElem          *stb_elem;
+  GPtrArray *refs;
+  gchar     *content;
+  gsize      content_length;
+  gchar     *compiled_filename;
+  gchar     *tmp_filename;
+  FILE      *fp;
+  gboolean   ok;
+  gint       ii;
+
+  if((storyboard_file == NULL) || (stb == NULL))
+  {
+    return;
+  }
+  if(!gap_story_render_compiled_is_enabled())
+  {
+    return;
+  }
+
+  if(!g_file_get_contents(storyboard_file, &content, &content_length, NULL))
+  {
+    return;
+  }
+
+  memset(&hdr, 0, sizeof(hdr));
+  g_strlcpy(hdr.magic, GAP_STB_COMPILED_MAGIC, sizeof(hdr.magic));
+  hdr.version = GAP_STB_COMPILED_VERSION;
+  hdr.sizeof_frn_elem = sizeof(GapStoryRenderFrameRangeElem);
+  hdr.sizeof_header = sizeof(GapStbCompiledHeader);
+  p_content_checksum(content, content_length, hdr.content_checksum);
+  hdr.content_size = content_length;
+  g_free(content);
+
+  hdr.audio_complete = !vidhand->ignore_audio;
+  hdr.has_audio = FALSE;
+  hdr.frame_count = frame_count;
+  hdr.master_framerate = vidhand->master_framerate;
+  hdr.master_width = vidhand->master_width;
+  hdr.master_height = vidhand->master_height;
+  hdr.master_samplerate = vidhand->master_samplerate;
+  hdr.master_volume = vidhand->master_volume;
+  hdr.master_insert_alpha_format_has_videobasename = vidhand->master_insert_alpha_format_has_videobasename;
+  hdr.master_insert_alpha_format_has_framenumber = vidhand->master_insert_alpha_format_has_framenumber;
+  hdr.master_insert_area_format_has_videobasename = vidhand->master_insert_area_format_has_videobasename;
+  hdr.master_insert_area_format_has_framenumber = vidhand->master_insert_area_format_has_framenumber;
+
+  for(section = vidhand->section_list; section != NULL; section = section->next)
+  {
+    hdr.count_sections++;
+    if(section->aud_list != NULL)
+    {
+      hdr.has_audio = TRUE;
+    }
+  }
+
+  refs = p_collect_refs(stb, storyboard_file);
+  hdr.count_refs = refs->len;
+
+  if(stb->mask_section)
+  {
+    for(stb_elem = stb->mask_section->stb_elem; stb_elem != NULL; stb_elem = stb_elem->next)
+    {
+      if((stb_elem->track == GAP_STB_MASK_TRACK_NUMBER)
+      && (stb_elem->record_type != GAP_STBREC_VID_SECTION)
+      && (stb_elem->record_type != GAP_STBREC_VID_BLACKSECTION)
+      && (stb_elem->mask_name)
+      && (gap_story_find_mask_reference_by_name(stb, stb_elem->mask_name) != NULL))
+      {
+        hdr.count_maskdefs++;
+      }
+    }
+  }
+
+  compiled_filename = p_compiled_filename(storyboard_file);
+  tmp_filename = g_strdup_printf("%s.%d.tmp", compiled_filename, (int)getpid());
+
+  ok = TRUE;
+  fp = g_fopen(tmp_filename, "wb");
+  if(fp == NULL)
+  {
+    ok = FALSE;
+  }
+  else
+  {
+    p_write_data(fp, &ok, &hdr, sizeof(hdr));
+
+    p_write_string(fp, &ok, vidhand->preferred_decoder);
+    p_write_string(fp, &ok, vidhand->master_insert_alpha_format);
+    p_write_string(fp, &ok, vidhand->master_insert_area_format);
+
+    for(ii = 0; ii < refs->len; ii++)
+    {
+      const gchar *l_ref;
+      gint64 l_mtime;
+      gint64 l_size;
+
+      l_ref = g_ptr_array_index(refs, ii);
+      p_get_file_stamp(l_ref, &l_mtime, &l_size);
+      p_write_string(fp, &ok, l_ref);
+      p_write_gint64(fp, &ok, l_mtime);
+      p_write_gint64(fp, &ok, l_size);
+    }
+
+    for(section = vidhand->section_list; section != NULL; section = section->next)
+    {
+      GapStoryRenderFrameRangeElem *frn_elem;
+      gint32 l_count_frn;
+
+      l_count_frn = 0;
+      for(frn_elem = section->frn_list; frn_elem != NULL; frn_elem = frn_elem->next)
+      {
+        l_count_frn++;
+      }
+      p_write_string(fp, &ok, section->section_name);
+      p_write_gint32(fp, &ok, l_count_frn);
+
+      for(frn_elem = section->frn_list; frn_elem != NULL; frn_elem = frn_elem->next)
+      {
+        GapStoryRenderFrameRangeElem l_frn;
+
+        /* write the struct without pointers, followed by the strings */
+        l_frn = *frn_elem;
+        l_frn.basename = NULL;
+        l_frn.ext = NULL;
+        l_frn.gvahand = NULL;
+        l_frn.filtermacro_file = NULL;
+        l_frn.filtermacro_file_to = NULL;
+        l_frn.mask_name = NULL;
+        l_frn.colormask_file = NULL;
+        l_frn.movepath_file_xml = NULL;
+        l_frn.next = NULL;
+        p_write_data(fp, &ok, &l_frn, sizeof(l_frn));
+
+        p_write_string(fp, &ok, frn_elem->basename);
+        p_write_string(fp, &ok, frn_elem->ext);
+        p_write_string(fp, &ok, frn_elem->filtermacro_file);
+        p_write_string(fp, &ok, frn_elem->filtermacro_file_to);
+        p_write_string(fp, &ok, frn_elem->mask_name);
+        p_write_string(fp, &ok, frn_elem->colormask_file);
+        p_write_string(fp, &ok, frn_elem->movepath_file_xml);
+      }
+    }
+
+    if(stb->mask_section)
+    {
+      for(stb_elem = stb->mask_section->stb_elem; stb_elem != NULL; stb_elem = stb_elem->next)
+      {
+        GapStbCompiledMaskdef l_maskdef;
+
+        if((stb_elem->track != GAP_STB_MASK_TRACK_NUMBER)
+        || (stb_elem->record_type == GAP_STBREC_VID_SECTION)
+        || (stb_elem->record_type == GAP_STBREC_VID_BLACKSECTION)
+        || (stb_elem->mask_name == NULL)
+        || (gap_story_find_mask_reference_by_name(stb, stb_elem->mask_name) == NULL))
+        {
+          continue;
+        }
+
+        memset(&l_maskdef, 0, sizeof(l_maskdef));
+        l_maskdef.record_type = stb_elem->record_type;
+        l_maskdef.track = stb_elem->track;
+        l_maskdef.from_frame = stb_elem->from_frame;
+        l_maskdef.to_frame = stb_elem->to_frame;
+        l_maskdef.seltrack = stb_elem->seltrack;
+        l_maskdef.exact_seek = stb_elem->exact_seek;
+        l_maskdef.delace = stb_elem->delace;
+        l_maskdef.flip_request = stb_elem->flip_request;
+        p_write_data(fp, &ok, &l_maskdef, sizeof(l_maskdef));
+
+        p_write_string(fp, &ok, stb_elem->mask_name);
+        p_write_string(fp, &ok, stb_elem->orig_filename);
+        p_write_string(fp, &ok, stb_elem->basename);
+        p_write_string(fp, &ok, stb_elem->ext);
+        p_write_string(fp, &ok, stb_elem->preferred_decoder);
+      }
+    }
+
+    if(fclose(fp) != 0)
+    {
+      ok = FALSE;
+    }
+  }
+
+  /* rename the completely written file, a concurrent reader
+   * shall never see a partly written compiled file
+   */
+  if(ok)
+  {
+    if(g_rename(tmp_filename, compiled_filename) != 0)
+    {
+      ok = FALSE;
+    }
+  }
+  if(!ok)
+  {
+    g_remove(tmp_filename);
+  }
+
+  if(gap_debug)
+  {
+    printf("gap_story_render_compiled_save: %s ok:%d sections:%d refs:%d maskdefs:%d\n"
+      , compiled_filename
+      , (int)ok
+      , (int)hdr.count_sections
+      , (int)hdr.count_refs
+      , (int)hdr.count_maskdefs
+      );
+  }
+
+  for(ii = 0; ii < refs->len; ii++)
+  {
+    g_free(g_ptr_array_index(refs, ii));
+  }
+  g_ptr_array_free(refs, TRUE);
+  g_free(tmp_filename);
+  g_free(compiled_filename);
+
+}  /* end gap_story_render_compiled_save */
+
+
+/* ----------------------------------------------------
+ * gap_story_render_compiled_load
+ * ----------------------------------------------------
+ * load the render representation of the storyboard_file
+ * from its compiled file into the specified vidhand
+ * (section_list and master settings).
+ * The mask definitions are delivered as list of GapStoryElem
+ * in *maskdef_list, the caller shall open the mask handles
+ * and free the list.
+ *
+ * returns TRUE on success,
+ *         FALSE if there is no valid compiled file for the current
+ *         storyboard content and refered files. (vidhand is unchanged in this case)
+ */
+gboolean
+gap_story_render_compiled_load(const char *storyboard_file
+                 , GapStoryRenderVidHandle *vidhand
+                 , gint32 *frame_count
+                 , GapStoryElem **maskdef_list
+                 )
+{
+  GapStbCompiledHeader   hdr;
+  GapStbCompiledReader   rd;
+  GapStoryRenderSection *section_list;
+  GapStoryRenderSection *section_tail;
+  GapStoryElem          *mask_list;
+  gchar     *compiled_data;
+  gsize      compiled_length;
+  gchar     *compiled_filename;
+  gchar     *content;
+  gsize      content_length;
+  gchar     *preferred_decoder;
+  gchar     *alpha_format;
+  gchar     *area_format;
+  gint       ii;
+
+  *maskdef_list = NULL;
+  if(storyboard_file == NULL)
+  {
+    return (FALSE);
+  }
+  if(!gap_story_render_compiled_is_enabled())
+  {
+    return (FALSE);
+  }
+
+  compiled_filename = p_compiled_filename(storyboard_file);
+  if(!g_file_get_contents(compiled_filename, &compiled_data, &compiled_length, NULL))
+  {
+    g_free(compiled_filename);
+    return (FALSE);
+  }
+
+  rd.ptr = compiled_data;
+  rd.end = compiled_data + compiled_length;
+  rd.ok = TRUE;
+  p_read_data(&rd, &hdr, sizeof(hdr));
+
+  if((!rd.ok)
+  || (strncmp(hdr.magic, GAP_STB_COMPILED_MAGIC, sizeof(hdr.magic)) != 0)
+  || (hdr.version != GAP_STB_COMPILED_VERSION)
+  || (hdr.sizeof_frn_elem != sizeof(GapStoryRenderFrameRangeElem))
+  || (hdr.sizeof_header != sizeof(GapStbCompiledHeader)))
+  {
+    rd.ok = FALSE;
+  }
+
+  /* audio is not part of the compiled file. it can be used
+   * for video handles that ignore audio, or if there is no audio at all.
+   */
+  if((rd.ok)
+  && (!vidhand->ignore_audio)
+  && ((!hdr.audio_complete) || (hdr.has_audio)))
+  {
+    rd.ok = FALSE;
+  }
+
+  if(rd.ok)
+  {
+    rd.ok = FALSE;
+    if(g_file_get_contents(storyboard_file, &content, &content_length, NULL))
+    {
+      if((gint64)content_length == hdr.content_size)
+      {
+        gchar l_checksum[GAP_STB_CHECKSUM_LENGTH];
+
+        p_content_checksum(content, content_length, l_checksum);
+        if(strncmp(l_checksum, hdr.content_checksum, GAP_STB_CHECKSUM_LENGTH) == 0)
+        {
+          rd.ok = TRUE;
+        }
+      }
+      g_free(content);
+    }
+  }
+
+  preferred_decoder = p_read_string(&rd);
+  alpha_format = p_read_string(&rd);
+  area_format = p_read_string(&rd);
+
+  /* check the refered files */
+  for(ii = 0; (ii < hdr.count_refs) && (rd.ok); ii++)
+  {
+    gchar *l_ref;
+    gint64 l_mtime;
+    gint64 l_size;
+    gint64 l_mtime_now;
+    gint64 l_size_now;
+
+    l_ref = p_read_string(&rd);
+    l_mtime = p_read_gint64(&rd);
+    l_size = p_read_gint64(&rd);
+    if((rd.ok) && (l_ref))
+    {
+      p_get_file_stamp(l_ref, &l_mtime_now, &l_size_now);
+      if((l_mtime_now != l_mtime) || (l_size_now != l_size))
+      {
+        if(gap_debug)
+        {
+          printf("gap_story_render_compiled_load: refered file changed: %s\n", l_ref);
+        }
+        rd.ok = FALSE;
+      }
+    }
+    g_free(l_ref);
+  }
+
+  /* read sections with their frame range lists */
+  section_list = NULL;
+  section_tail = NULL;
+  for(ii = 0; (ii < hdr.count_sections) && (rd.ok); ii++)
+  {
+    GapStoryRenderSection        *section;
+    GapStoryRenderFrameRangeElem *frn_tail;
+    gint32 l_count_frn;
+    gint32 jj;
+
+    section = g_new0(GapStoryRenderSection, 1);
+    section->section_name = p_read_string(&rd);
+    if(section_tail == NULL)
+    {
+      section_list = section;
+    }
+    else
+    {
+      section_tail->next = section;
+    }
+    section_tail = section;
+
+    l_count_frn = p_read_gint32(&rd);
+    frn_tail = NULL;
+    for(jj = 0; (jj < l_count_frn) && (rd.ok); jj++)
+    {
+      GapStoryRenderFrameRangeElem *frn_elem;
+
+      frn_elem = g_new0(GapStoryRenderFrameRangeElem, 1);
+      p_read_data(&rd, frn_elem, sizeof(GapStoryRenderFrameRangeElem));
+      frn_elem->gvahand = NULL;
+      frn_elem->next = NULL;
+      frn_elem->basename = p_read_string(&rd);
+      frn_elem->ext = p_read_string(&rd);
+      frn_elem->filtermacro_file = p_read_string(&rd);
+      frn_elem->filtermacro_file_to = p_read_string(&rd);
+      frn_elem->mask_name = p_read_string(&rd);
+      frn_elem->colormask_file = p_read_string(&rd);
+      frn_elem->movepath_file_xml = p_read_string(&rd);
+
+      if(frn_tail == NULL)
+      {
+        section->frn_list = frn_elem;
+      }
+      else
+      {
+        frn_tail->next = frn_elem;
+      }
+      frn_tail = frn_elem;
+    }
+  }
+
+  /* read mask definitions */
+  mask_list = NULL;
+  for(ii = 0; (ii < hdr.count_maskdefs) && (rd.ok); ii++)
+  {
+    GapStbCompiledMaskdef l_maskdef;
+    GapStoryElem *stb_elem;
+
+    p_read_data(&rd, &l_maskdef, sizeof(l_maskdef));
+    stb_elem = gap_story_new_elem((GapStoryRecordType)l_maskdef.record_type);
+    if(stb_elem == NULL)
+    {
+      rd.ok = FALSE;
+      break;
+    }
+    stb_elem->track = l_maskdef.track;
+    stb_elem->from_frame = l_maskdef.from_frame;
+    stb_elem->to_frame = l_maskdef.to_frame;
+    stb_elem->seltrack = l_maskdef.seltrack;
+    stb_elem->exact_seek = l_maskdef.exact_seek;
+    stb_elem->delace = l_maskdef.delace;
+    stb_elem->flip_request = l_maskdef.flip_request;
+    stb_elem->mask_name = p_read_string(&rd);
+    stb_elem->orig_filename = p_read_string(&rd);
+    stb_elem->basename = p_read_string(&rd);
+    stb_elem->ext = p_read_string(&rd);
+    stb_elem->preferred_decoder = p_read_string(&rd);
+
+    stb_elem->next = mask_list;
+    mask_list = stb_elem;
+  }
+
+  g_free(compiled_data);
+
+  if(!rd.ok)
+  {
+    GapStoryElem *stb_next;
+
+    if(gap_debug)
+    {
+      printf("gap_story_render_compiled_load: %s is not valid\n", compiled_filename);
+    }
+    p_free_sections(section_list);
+    while(mask_list)
+    {
+      stb_next = mask_list->next;
+      gap_story_elem_free(&mask_list);
+      mask_list = stb_next;
+    }
+    g_free(preferred_decoder);
+    g_free(alpha_format);
+    g_free(area_format);
+    g_free(compiled_filename);
+    return (FALSE);
+  }
+
+  vidhand->section_list = section_list;
+  vidhand->parsing_section = section_tail;
+  vidhand->master_framerate = hdr.master_framerate;
+  vidhand->master_width = hdr.master_width;
+  vidhand->master_height = hdr.master_height;
+  vidhand->master_samplerate = hdr.master_samplerate;
+  vidhand->master_volume = hdr.master_volume;
+  vidhand->preferred_decoder = preferred_decoder;
+  vidhand->master_insert_alpha_format = alpha_format;
+  vidhand->master_insert_alpha_format_has_videobasename = hdr.master_insert_alpha_format_has_videobasename;
+  vidhand->master_insert_alpha_format_has_framenumber = hdr.master_insert_alpha_format_has_framenumber;
+  vidhand->master_insert_area_format = area_format;
+  vidhand->master_insert_area_format_has_videobasename = hdr.master_insert_area_format_has_videobasename;
+  vidhand->master_insert_area_format_has_framenumber = hdr.master_insert_area_format_has_framenumber;
+  *frame_count = hdr.frame_count;
+  *maskdef_list = mask_list;
+
+  if(gap_debug)
+  {
+    printf("gap_story_render_compiled_load: %s loaded, frame_count:%d\n"
+      , compiled_filename
+      , (int)hdr.frame_count
+      );
+  }
+  g_free(compiled_filename);
+
+  return (TRUE);
+}  /* end gap_story_render_compiled_load */
@@ -0,0 +1,53 @@
+/* gap_story_render_compiled.h
+ *
+ *  GAP storyboard rendering processor.
+ *  compiled storyboard cache (the render representation of a storyboard file
+ *  saved next to the storyboard for fast reopen)
+ *
+ */
+
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026/10/18  agent: created
+ */
+
+#ifndef GAP_STORY_RENDER_COMPILED_H
+#define GAP_STORY_RENDER_COMPILED_H
+
+#include "libgimp/gimp.h"
+#include "gap_story_file.h"
+#include "gap_story_render_types.h"
+
+#define GAP_GIMPRC_VIDEO_STORYBOARD_COMPILED_CACHE  "video-storyboard-compiled-cache"
+
+gboolean   gap_story_render_compiled_is_enabled(void);
+
+gboolean   gap_story_render_compiled_load(const char *storyboard_file
+                 , GapStoryRenderVidHandle *vidhand
+                 , gint32 *frame_count
+                 , GapStoryElem **maskdef_list
+                 );
+void       gap_story_render_compiled_save(const char *storyboard_file
+                 , GapStoryRenderVidHandle *vidhand
+                 , gint32 frame_count
+                 , GapStoryBoard *stb
+                 );
+
+#endif
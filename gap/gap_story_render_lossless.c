@@ -1097,6 +1097,24 @@ gap_story_render_fetch_composite_image_or_chunk(GapStoryRenderVidHandle *vidhand
 
   l_videofile = NULL;     /* NULL: also used as flag for "MUST fetch regular uncompressed frame" */
 
+  /* incremental encoding: copy the frames of unchanged segments from the previous encode */
+  if(gap_story_render_segcache_fetch_chunk(vidhand->segcache
+                                          , master_frame_nr
+                                          , video_frame_chunk_data
+                                          , video_frame_chunk_size
+                                          , video_frame_chunk_maxsize
+                                          , force_keyframe
+                                          ))
+  {
+    last_fetch_was_compressed_chunk = FALSE;
+    if(last_videofile)
+    {
+      g_free(last_videofile);
+      last_videofile = NULL;
+    }
+    return(TRUE);
+  }
+
 
 #ifdef GAP_ENABLE_VIDEOAPI_SUPPORT
 
@@ -1152,6 +1170,11 @@ gap_story_render_fetch_composite_image_or_chunk(GapStoryRenderVidHandle *vidhand
 
 #endif
 
+  if(gap_story_render_segcache_force_keyframe(vidhand->segcache, master_frame_nr))
+  {
+    *force_keyframe = TRUE;
+  }
+
   if(l_videofile != NULL)
   {
      /* chunk fetch was successful */
@@ -1302,11 +1325,30 @@ gap_story_render_fetch_composite_image_or_buffer_or_chunk(GapStoryRenderVidHandl
   l_enable_chunk_fetch = dont_recode_flag;
   
   if ((gapStoryFetchResult->video_frame_chunk_data == NULL)
-  && (l_enable_chunk_fetch == TRUE))
+  && ((l_enable_chunk_fetch == TRUE) || (vidhand->segcache != NULL)))
   {
     gapStoryFetchResult->video_frame_chunk_data = g_malloc(vid_width * vid_height * 4);
   }
 
+  /* incremental encoding: copy the frames of unchanged segments from the previous encode */
+  if(gap_story_render_segcache_fetch_chunk(vidhand->segcache
+                                          , master_frame_nr
+                                          , gapStoryFetchResult->video_frame_chunk_data
+                                          , &gapStoryFetchResult->video_frame_chunk_size
+                                          , video_frame_chunk_maxsize
+                                          , &gapStoryFetchResult->force_keyframe
+                                          ))
+  {
+    last_fetch_was_compressed_chunk = FALSE;
+    if(last_videofile)
+    {
+      g_free(last_videofile);
+      last_videofile = NULL;
+    }
+    gapStoryFetchResult->resultEnum = GAP_STORY_FETCH_RESULT_IS_COMPRESSED_CHUNK;
+    return;
+  }
+
   if(gap_debug)
   {
     printf("gap_story_render_fetch_composite_image_or_buffer_or_chunk START  master_frame_nr:%d  %dx%d dont_recode:%d\n"
@@ -1377,6 +1419,11 @@ gap_story_render_fetch_composite_image_or_buffer_or_chunk(GapStoryRenderVidHandl
 
 #endif
 
+  if(gap_story_render_segcache_force_keyframe(vidhand->segcache, master_frame_nr))
+  {
+    gapStoryFetchResult->force_keyframe = TRUE;
+  }
+
   if(l_videofile != NULL)
   {
      /* chunk fetch was successful */
@@ -77,6 +77,10 @@
 #include "gap_story_main.h"
 #include "gap_story_render_audio.h"
 #include "gap_story_render_processor.h"
+#include "gap_story_render_compiled.h"
+#include "gap_story_render_buffer.h"
+#include "gap_story_render_scache.h"
+#include "gap_story_render_segcache.h"
 #include "gap_fmac_name.h"
 #include "gap_frame_fetcher.h"
 #include "gap_image.h"
@@ -121,6 +125,9 @@ typedef struct GapStbFetchData {   /* nick: gfd */
   GapStoryFetchResult *gapStoryFetchResult;
   gboolean             isRgb888Result;        /* TRUE use rgb888 buffer to bypass convert to gimp drawable */
 
+  /* scaled source cache */
+  gboolean             isScacheLookupDone;    /* TRUE the caller has already checked the scaled source cache */
+
 }  GapStbFetchData;
 
 
@@ -162,6 +169,19 @@ typedef struct StbMutexPool   /* mutxp */
 } StbMutexPool;
 
 
+/* an open GVA handle that is not in current access
+ * and may be closed when the limit of open videofiles is reached
+ */
+typedef struct StbGvahandEvictCandidate   /* evc */
+{
+  GapStoryRenderVidHandle      *owner_vidhand;
+  GapStoryRenderFrameRangeElem *frn_elem;
+  gchar                        *pool_key;
+  gint32                        next_use;
+
+} StbGvahandEvictCandidate;
+
+
 
 /*************************************************************
  *         STORYBOARD FUNCTIONS                              *
@@ -186,6 +206,14 @@ typedef struct StbMutexPool   /* mutxp */
 #define GVAHAND_HOLDER_RANK_4                4
 #define GVAHAND_HOLDER_RANK_MAX_LEVEL        5
 
+/* next use of an open GVA handle (master frame number) as calculated by the lookahead
+ * at eviction when the limit video-storyboard-max-open-videofiles is reached.
+ * (handles in sub sections and mask sections use local frame numbers
+ * where no lookahead is done)
+ */
+#define GVAHAND_NEXT_USE_NEVER               G_MAXINT
+#define GVAHAND_NEXT_USE_UNKNOWN             (G_MAXINT - 1)
+
 #define GAP_VIDEO_STORYBOARD_PRESCALE_ENABLE_DOWNSCALE_CHAIN "video-storyboard-prescale-enable-downscale-chain"
 
 
@@ -316,6 +344,8 @@ static void       p_append_render_section_to_vidhand(GapStoryRenderVidHandle *vi
 
 static void       p_open_mask_vidhand(GapStoryElem *stb_elem
                           , GapStoryRenderMaskDefElem *maskdef_elem);
+static void       p_add_maskdef_to_vidhand(GapStoryElem *stb_elem
+                          , GapStoryRenderVidHandle *vidhand);
 static void       p_copy_mask_definitions_to_vidhand(GapStoryBoard *stb_ptr
                           , GapStoryRenderVidHandle *vidhand);
 static void       p_free_mask_definitions(GapStoryRenderVidHandle *vidhand);
@@ -422,6 +452,24 @@ static gint32     p_transform_and_add_layer( gint32 comp_image_id
                          );
 static gint32     p_prepare_RGB_image(gint32 image_id);
 
+#ifdef GAP_ENABLE_VIDEOAPI_SUPPORT
+static gchar *    p_gvahand_pool_key(GapStoryRenderVidHandle *vidhand
+                      , GapStoryRenderFrameRangeElem *frn_elem);
+static gboolean   p_gvahand_is_same_pool_key(GapStoryRenderFrameRangeElem *frn_elem
+                      , GapStoryRenderFrameRangeElem *frn_elem_ref);
+static gint32     p_gvahand_lookahead_next_use(GapStoryRenderVidHandle *vidhand
+                      , GapStoryRenderSection *section
+                      , GapStoryRenderFrameRangeElem *frn_elem_holder
+                      , gint32 master_frame_nr);
+static GSList *   p_gvahand_collect_evict_candidates(GapStoryRenderVidHandle *vidhand
+                      , gint32 master_frame_nr
+                      , GSList *candidates);
+static gint       p_gvahand_compare_evict_candidates(gconstpointer a, gconstpointer b);
+static void       p_gvahand_register_open(GapStoryRenderVidHandle *vidhand
+                      , GapStoryRenderFrameRangeElem *frn_elem
+                      , gint32 master_frame_nr);
+#endif
+static void       p_gvahand_print_pool_statistics(GapStoryRenderVidHandle *vidhand);
 static void       p_limit_open_videohandles(GapStoryRenderVidHandle *vidhand
                       , gint32 master_frame_nr
                       , gint32 currently_open_videohandles
@@ -460,7 +508,10 @@ static gint32     p_prescale_image_size_handling(GapStbFetchData *gfdCurrent
                       , gint32 master_frame_nr
                       , gint32 vid_width
                       , gint32 vid_height
+                      , gint32 *originalWidthPtr
+                      , gint32 *originalHeightPtr
                       );
+static GapStoryRenderPixelBuffer * p_buffer_from_layer(gint32 layer_id);
 
 static void       p_stb_render_image_or_animimage(GapStbFetchData *gfd
                       , GapStoryRenderVidHandle *vidhand
@@ -477,6 +528,9 @@ static void       p_check_and_open_video_handle(GapStoryRenderFrameRangeElem *fr
 #define NEAR_FRAME_DISTANCE 36
 
 static void    p_initOptionalMulitprocessorSupport(GapStoryRenderVidHandle *vidhand);
+static void    p_initOptionalBufferCompositing(GapStoryRenderVidHandle *vidhand);
+static void    p_initOptionalScaledSourceCache(GapStoryRenderVidHandle *vidhand);
+static void    p_preload_track_images(GapStoryRenderVidHandle *vidhand, gint32 master_frame_nr);
 
 #ifdef GAP_ENABLE_VIDEOAPI_SUPPORT
 static void    p_call_GVA_close(t_GVA_Handle *gvahand);
@@ -3328,6 +3382,10 @@ p_storyboard_analyze(GapStoryBoard *stb
  * this procedure builds up a framerange list
  * from the  given storyboard structure in MEMORY
  * or by parsing the specified storyboard_file.
+ * For storyboard files the render representation is taken from
+ * the compiled storyboard cache when it is valid for the current
+ * storyboard content, otherwise the cache is (re)written
+ * after successful parsing and analyze.
  *
  * return the framerange_list (scanned from storyboard or storyboard_file)
  */
@@ -3367,8 +3425,33 @@ p_framerange_list_from_storyboard(const char *storyboard_file
    */
   {
     GapStoryBoard *stb;
+    GapStoryElem  *maskdef_list;
+    gboolean       compiled_loaded;
 
     stb = NULL;
+    compiled_loaded = FALSE;
+
+    if((stb_mem_ptr == NULL) && (storyboard_file != NULL))
+    {
+      compiled_loaded = gap_story_render_compiled_load(storyboard_file
+                                 , vidhand
+                                 , frame_count
+                                 , &maskdef_list
+                                 );
+      if(compiled_loaded)
+      {
+        GapStoryElem *stb_elem;
+        GapStoryElem *stb_next;
+
+        vidhand->maskdef_elem = NULL;
+        for(stb_elem = maskdef_list; stb_elem != NULL; stb_elem = stb_next)
+        {
+          stb_next = stb_elem->next;
+          p_add_maskdef_to_vidhand(stb_elem, vidhand);
+          gap_story_elem_free(&stb_elem);
+        }
+      }
+    }
 
     if(stb_mem_ptr)
     {
@@ -3378,9 +3461,11 @@ p_framerange_list_from_storyboard(const char *storyboard_file
       stb = gap_story_duplicate_full(stb_mem_ptr);
     }
 
-    if(stb == NULL)
+    if((stb == NULL) && (!compiled_loaded))
     {
-      /* load and parse the storyboard structure from file */
+      /* load and parse the storyboard structure from file
+       * (the compiled file was not available or is outdated)
+       */
       stb = gap_story_parse(storyboard_file);
     }
 
@@ -3410,6 +3495,17 @@ p_framerange_list_from_storyboard(const char *storyboard_file
 
         /* mask definitions */
         p_copy_mask_definitions_to_vidhand(stb, vidhand);
+
+        if((stb_mem_ptr == NULL)
+        && (sterr->errtext == NULL)
+        && (*frame_count > 0))
+        {
+          gap_story_render_compiled_save(storyboard_file
+                                        , vidhand
+                                        , *frame_count
+                                        , stb
+                                        );
+        }
       }
       gap_story_free_storyboard(&stb);
 
@@ -3592,6 +3688,42 @@ p_open_mask_vidhand(GapStoryElem *stb_elem, GapStoryRenderMaskDefElem *maskdef_e
 
 
 
+/* ----------------------------------------------------
+ * p_add_maskdef_to_vidhand
+ * ----------------------------------------------------
+ * create a mask definition for the specified stb_elem
+ * and open its sub GapStoryRenderVidHandle.
+ */
+static void
+p_add_maskdef_to_vidhand(GapStoryElem *stb_elem, GapStoryRenderVidHandle *vidhand)
+{
+  GapStoryRenderMaskDefElem *maskdef_elem;
+
+  if(gap_debug)
+  {
+    printf("p_add_maskdef_to_vidhand: \n");
+    gap_story_debug_print_elem(stb_elem);
+  }
+
+  maskdef_elem = g_new(GapStoryRenderMaskDefElem, 1);
+  if(maskdef_elem)
+  {
+      maskdef_elem->mask_name = g_strdup(stb_elem->mask_name);
+      maskdef_elem->record_type = (gint32)stb_elem->record_type;
+      maskdef_elem->frame_count = 0;
+      maskdef_elem->flip_request = stb_elem->flip_request;
+      maskdef_elem->mask_vidhand = NULL;
+      maskdef_elem->next = vidhand->maskdef_elem;
+
+      p_open_mask_vidhand(stb_elem, maskdef_elem);
+
+      /* link mask definition element as 1st element to the list */
+      vidhand->maskdef_elem = maskdef_elem;
+  }
+
+}  /* end p_add_maskdef_to_vidhand */
+
+
 /* ----------------------------------------------------
  * p_copy_mask_definitions
  * ----------------------------------------------------
@@ -3629,7 +3761,6 @@ p_copy_mask_definitions_to_vidhand(GapStoryBoard *stb_ptr, GapStoryRenderVidHand
     }
     if(stb_elem->mask_name)
     {
-      GapStoryRenderMaskDefElem *maskdef_elem;
       GapStoryElem      *stb_elem_ref;
 
       /* check if there are references (in any section) to this mask definition */
@@ -3642,28 +3773,7 @@ p_copy_mask_definitions_to_vidhand(GapStoryBoard *stb_ptr, GapStoryRenderVidHand
         continue;
       }
 
-      if(gap_debug)
-      {
-        printf("p_copy_mask_definitions_to_vidhand: \n");
-        gap_story_debug_print_elem(stb_elem);
-      }
-
-
-      maskdef_elem = g_new(GapStoryRenderMaskDefElem, 1);
-      if(maskdef_elem)
-      {
-          maskdef_elem->mask_name = g_strdup(stb_elem->mask_name);
-          maskdef_elem->record_type = (gint32)stb_elem->record_type;
-          maskdef_elem->frame_count = 0;
-          maskdef_elem->flip_request = stb_elem->flip_request;
-          maskdef_elem->mask_vidhand = NULL;
-          maskdef_elem->next = vidhand->maskdef_elem;
-
-          p_open_mask_vidhand(stb_elem, maskdef_elem);
-
-          /* link mask definition element as 1st element to the list */
-          vidhand->maskdef_elem = maskdef_elem;
-      }
+      p_add_maskdef_to_vidhand(stb_elem, vidhand);
     }
   }
 
@@ -3733,6 +3843,48 @@ gap_story_render_close_vid_handle(GapStoryRenderVidHandle *vidhand)
    p_free_stb_error(vidhand->sterr);
    p_free_mask_definitions(vidhand);
 
+   if(vidhand->gvahandOpenCount > 0)
+   {
+     if((vidhand->isLogResourceUsage) || (gap_debug))
+     {
+       p_gvahand_print_pool_statistics(vidhand);
+     }
+   }
+   if(vidhand->gvahandClosedKeys != NULL)
+   {
+     g_hash_table_destroy(vidhand->gvahandClosedKeys);
+     vidhand->gvahandClosedKeys = NULL;
+   }
+
+   if(vidhand->scache != NULL)
+   {
+     if((vidhand->isLogResourceUsage) || (gap_debug))
+     {
+       gap_story_render_scache_print_statistics(vidhand->scache, "scaled source cache");
+     }
+     gap_story_render_scache_free(vidhand->scache);
+     vidhand->scache = NULL;
+   }
+   if(vidhand->mask_cache != NULL)
+   {
+     if((vidhand->isLogResourceUsage) || (gap_debug))
+     {
+       gap_story_render_scache_print_statistics(vidhand->mask_cache, "layermask cache");
+     }
+     gap_story_render_scache_free(vidhand->mask_cache);
+     vidhand->mask_cache = NULL;
+   }
+   if(vidhand->segcache != NULL)
+   {
+     /* the hashes are stored for the next incremental encode
+      * (only if all frames were fetched)
+      */
+     gap_story_render_segcache_print_statistics(vidhand->segcache);
+     gap_story_render_segcache_save(vidhand->segcache);
+     gap_story_render_segcache_free(vidhand->segcache);
+     vidhand->segcache = NULL;
+   }
+
    /* unregister frame fetcher resource usage (i.e. the image cache) */
    gap_frame_fetch_unregister_user(vidhand->ffetch_user_id);
    vidhand->section_list = NULL;
@@ -3905,9 +4057,149 @@ p_mask_fetcher(GapStoryRenderVidHandle *vidhand
 
 
 
+/* ----------------------------------------------------
+ * p_mask_cache_key
+ * ----------------------------------------------------
+ * returns the key for the layermask cache (mask name and the relevant
+ * frame number in the mask section) or NULL if the mask definition is not found.
+ * the caller is responsible to g_free the returned string.
+ */
+static gchar *
+p_mask_cache_key(GapStoryRenderVidHandle *vidhand
+   , const char *mask_name
+   , gint32 master_frame_nr
+   )
+{
+  GapStoryRenderMaskDefElem *maskdef_elem;
+  gint32 l_framenr;
+
+  maskdef_elem = p_find_maskdef_by_name(vidhand, mask_name);
+  if(maskdef_elem == NULL)
+  {
+    return (NULL);
+  }
+
+  /* same limit to the last available frame as in p_mask_fetcher */
+  l_framenr = MIN(master_frame_nr, maskdef_elem->frame_count);
+  return (g_strdup_printf("%s#%06d", mask_name, (int)l_framenr));
+
+}  /* end p_mask_cache_key */
+
+
+/* ----------------------------------------------------
+ * p_mask_cache_lookup
+ * ----------------------------------------------------
+ * returns the cached gray mask (owned by the cache) at mask_width x mask_height
+ * or NULL if not cached.
+ */
+static GapStoryRenderPixelBuffer *
+p_mask_cache_lookup(GapStoryRenderVidHandle *vidhand
+   , const char *mask_name
+   , gint32 master_frame_nr
+   , gint32 mask_width
+   , gint32 mask_height
+   )
+{
+  GapStoryRenderPixelBuffer *pbuf;
+  gchar *key;
+
+  if(vidhand->mask_cache == NULL)
+  {
+    return (NULL);
+  }
+  key = p_mask_cache_key(vidhand, mask_name, master_frame_nr);
+  pbuf = gap_story_render_scache_lookup(vidhand->mask_cache
+                    , key
+                    , 0            /* mtime */
+                    , mask_width
+                    , mask_height
+                    , 0            /* interpolation */
+                    );
+  g_free(key);
+
+  return (pbuf);
+
+}  /* end p_mask_cache_lookup */
+
+
+/* ----------------------------------------------------
+ * p_mask_cache_store
+ * ----------------------------------------------------
+ * add a copy of the fetched gray mask layer to the layermask cache.
+ */
+static void
+p_mask_cache_store(GapStoryRenderVidHandle *vidhand
+   , const char *mask_name
+   , gint32 master_frame_nr
+   , gint32 mask_layer_id
+   )
+{
+  GapStoryRenderPixelBuffer *pbuf;
+  gchar *key;
+
+  if(vidhand->mask_cache == NULL)
+  {
+    return;
+  }
+  key = p_mask_cache_key(vidhand, mask_name, master_frame_nr);
+  if(key == NULL)
+  {
+    return;
+  }
+  pbuf = p_buffer_from_layer(mask_layer_id);
+  if((pbuf != NULL) && (pbuf->bpp != 1))
+  {
+    /* only gray masks are cached */
+    gap_story_render_buffer_free(pbuf);
+    pbuf = NULL;
+  }
+  if(pbuf != NULL)
+  {
+    gap_story_render_scache_store(vidhand->mask_cache
+                    , key
+                    , 0            /* mtime */
+                    , 0            /* interpolation */
+                    , pbuf->width
+                    , pbuf->height
+                    , pbuf
+                    );
+  }
+  g_free(key);
+
+}  /* end p_mask_cache_store */
+
+
+/* ----------------------------------------------------
+ * p_write_buffer_to_drawable
+ * ----------------------------------------------------
+ * copy the pixels of pbuf to the specified drawable
+ * (that must have the same size and bpp, e.g. a layermask for gray buffers)
+ */
+static void
+p_write_buffer_to_drawable(gint32 drawable_id, GapStoryRenderPixelBuffer *pbuf)
+{
+  GimpDrawable *drawable;
+  GimpPixelRgn  pixel_rgn;
+
+  drawable = gimp_drawable_get(drawable_id);
+  gimp_pixel_rgn_init (&pixel_rgn, drawable, 0, 0
+                      , pbuf->width, pbuf->height
+                      , TRUE      /* dirty */
+                      , FALSE     /* shadow */
+                      );
+  gimp_pixel_rgn_set_rect (&pixel_rgn, pbuf->data, 0, 0, pbuf->width, pbuf->height);
+  gimp_drawable_flush (drawable);
+  gimp_drawable_detach(drawable);
+
+}  /* end p_write_buffer_to_drawable */
+
+
 /* ----------------------------------------------------
  * p_fetch_and_add_layermask
  * ----------------------------------------------------
+ * fetch the mask frame and add it as layermask to layer_id.
+ * gray masks are taken from the layermask cache when the same mask frame
+ * was already fetched at the same size.
  */
 static void
 p_fetch_and_add_layermask(GapStoryRenderVidHandle *vidhand
@@ -3925,6 +4217,7 @@ p_fetch_and_add_layermask(GapStoryRenderVidHandle *vidhand
   gboolean l_found_in_cache;
   gboolean l_was_last_maskframe;
   gboolean l_makeGrayFlattened;
+  GapStoryRenderPixelBuffer *l_cached_mask;
 
   /* both local_stepcount and mask_framecount start with 0 for the 1st element */
   l_framenr = frn_elem->mask_stepsize * (gdouble)(frn_elem->mask_framecount + local_stepcount);
@@ -3948,8 +4241,23 @@ p_fetch_and_add_layermask(GapStoryRenderVidHandle *vidhand
 
 
   l_found_in_cache = FALSE;
+  l_tmp_mask_image_id = -1;
+  l_tmp_mask_layer_id = -1;
+  l_cached_mask = NULL;
 
-  // l_tmp_mask_image_id = TODO lookup in the cache ################
+  if (l_makeGrayFlattened == TRUE)
+  {
+    l_cached_mask = p_mask_cache_lookup(vidhand
+                              , frn_elem->mask_name
+                              , l_master_framenr
+                              , gimp_drawable_width(layer_id)
+                              , gimp_drawable_height(layer_id)
+                              );
+    if (l_cached_mask != NULL)
+    {
+      l_found_in_cache = TRUE;
+    }
+  }
 
   if(l_found_in_cache)
   {
@@ -3972,6 +4280,11 @@ p_fetch_and_add_layermask(GapStoryRenderVidHandle *vidhand
                               ,&l_was_last_maskframe
                               , l_makeGrayFlattened
                               );
+    if ((l_tmp_mask_image_id >= 0)
+    &&  (l_makeGrayFlattened == TRUE))
+    {
+      p_mask_cache_store(vidhand, frn_elem->mask_name, l_master_framenr, l_tmp_mask_layer_id);
+    }
   }
 
   if(gap_debug)
@@ -3982,7 +4295,7 @@ p_fetch_and_add_layermask(GapStoryRenderVidHandle *vidhand
            );
   }
 
-  if(l_tmp_mask_image_id >= 0)
+  if((l_tmp_mask_image_id >= 0) || (l_found_in_cache))
   {
      gint32 l_new_layer_mask_id;
 
@@ -4018,28 +4331,23 @@ p_fetch_and_add_layermask(GapStoryRenderVidHandle *vidhand
 
 
        /* overwrite the white layer mask with the fetched mask */
-       gap_layer_copy_content(l_new_layer_mask_id   /* dst_drawable_id */
-                             ,l_tmp_mask_layer_id     /* src_drawable_id */
-                             );
+       if(l_found_in_cache)
+       {
+         p_write_buffer_to_drawable(l_new_layer_mask_id, l_cached_mask);
+       }
+       else
+       {
+         gap_layer_copy_content(l_new_layer_mask_id   /* dst_drawable_id */
+                               ,l_tmp_mask_layer_id     /* src_drawable_id */
+                               );
+       }
      }
 
 
 
      if(!l_found_in_cache)
      {
-       // TODO: decide if l_tmp_mask_image_id should be stored in cache or to delete immediate.
-       // store if:
-       //  - there are more than one references
-       //  - if mask stepsize < 1.0
-       //  - the last frame of the mask sequence  (l_framenr == maskdef_elem->frame_count)
-       //     (that has to be repeated for all remaining frame in the clip)
-
-       // if((frn_elem->mask_stepsize < 1.0)
-       // || (l_was_last_maskframe)
-       // )
-
-
-
+       /* gray masks were already copied to the layermask cache */
        gap_image_delete_immediate(l_tmp_mask_image_id);
      }
   }
@@ -4125,6 +4433,9 @@ p_open_video_handle_private(    gboolean ignore_audio
     vidhand->isLogResourceUsage = TRUE;
   }
   p_initOptionalMulitprocessorSupport(vidhand);
+  p_initOptionalBufferCompositing(vidhand);
+  p_initOptionalScaledSourceCache(vidhand);
+  vidhand->segcache = NULL;   /* enabled by the encoder (gap_story_render_enable_segment_cache) */
 
   vidhand->frn_list = NULL;
   vidhand->preferred_decoder = NULL;
@@ -5806,103 +6117,395 @@ p_prepare_RGB_image(gint32 image_id)
   return(l_layer_id);
 } /* end p_prepare_RGB_image */
 
+#ifdef GAP_ENABLE_VIDEOAPI_SUPPORT
 /* ----------------------------------------------------
- * p_limit_open_videohandles
+ * p_gvahand_pool_key
  * ----------------------------------------------------
- * if the number of currently_open_videohandles exceeds a limit,
- * then try to close the handle(s) until the number is below the limit.
- * (but do not close handles that are involved in fetching the current master_frame_nr)
- *
- * This kind of garbage collection is useful for storyboards that are using many
- * different videofile references and would run into memory and other resource problems
- * when all handles are kept open until the end of rendering process.
- * (note that each video handle has its own frame cache)
+ * returns the key (videofile, decoder, videotrack and seek mode)
+ * that identifies GVA video handles that can be shared
+ * between clips. (the caller must g_free the returned string)
+ */
+static gchar *
+p_gvahand_pool_key(GapStoryRenderVidHandle *vidhand
+                 , GapStoryRenderFrameRangeElem *frn_elem)
+{
+  const char *decoder;
+
+  decoder = vidhand->preferred_decoder;
+  if (decoder == NULL)
+  {
+    decoder = "";
+  }
+  return (g_strdup_printf("%s#%s#%d#%d"
+                         , frn_elem->basename
+                         , decoder
+                         , (int)frn_elem->seltrack
+                         , (int)frn_elem->exact_seek
+                         ));
+
+}  /* end p_gvahand_pool_key */
+
+
+/* ----------------------------------------------------
+ * p_gvahand_is_same_pool_key
+ * ----------------------------------------------------
+ * check if both elements refer to the same videofile, videotrack and seek mode
+ * (the decoder is the same for all elements of one storyboard video handle)
+ */
+static gboolean
+p_gvahand_is_same_pool_key(GapStoryRenderFrameRangeElem *frn_elem
+                         , GapStoryRenderFrameRangeElem *frn_elem_ref)
+{
+  if((frn_elem->frn_type != GAP_FRN_MOVIE)
+  || (frn_elem->basename == NULL)
+  || (frn_elem_ref->basename == NULL))
+  {
+    return (FALSE);
+  }
+  if((frn_elem->seltrack == frn_elem_ref->seltrack)
+  && (frn_elem->exact_seek == frn_elem_ref->exact_seek)
+  && (strcmp(frn_elem->basename, frn_elem_ref->basename) == 0))
+  {
+    return (TRUE);
+  }
+  return (FALSE);
+
+}  /* end p_gvahand_is_same_pool_key */
+
+
+/* ----------------------------------------------------
+ * p_gvahand_lookahead_next_use
+ * ----------------------------------------------------
+ * returns the lowest master frame number (>= master_frame_nr)
+ * where a clip that refers the same videofile (videotrack and seek mode)
+ * as frn_elem_holder is played in the specified section.
+ * The frame ranges are calculated the same way as p_fetch_framename does.
  *
- * TODO check for videohandles in the mask section
+ * returns GVAHAND_NEXT_USE_NEVER if the videofile is not used anymore
+ * and GVAHAND_NEXT_USE_UNKNOWN for sub sections and mask sections,
+ * where the local frame numbers do not correspond to master_frame_nr.
  */
-static void
-p_limit_open_videohandles(GapStoryRenderVidHandle *vidhand
-                      , gint32 master_frame_nr
-                      , gint32 currently_open_videohandles
-                      , gint32 max_open_videohandles
-                      )
+static gint32
+p_gvahand_lookahead_next_use(GapStoryRenderVidHandle *vidhand
+                      , GapStoryRenderSection *section
+                      , GapStoryRenderFrameRangeElem *frn_elem_holder
+                      , gint32 master_frame_nr)
 {
-#ifdef GAP_ENABLE_VIDEOAPI_SUPPORT
-#define GAP_STB_DEFAULT_MAX_OPEN_VIDEOFILES 12
-  GapStoryRenderSection *section;
   GapStoryRenderFrameRangeElem *frn_elem;
-  gint32 l_count_open_videohandles;
+  gint32  l_frame_group_count[GAP_STB_MAX_VID_INTERNAL_TRACKS];
+  gint32  l_frames_to_handle;
+  gint32  l_first;
+  gint32  l_last;
+  gint32  l_next_use;
+  gint32  l_track;
 
-  l_count_open_videohandles = currently_open_videohandles;
+  if((vidhand->is_mask_handle == TRUE)
+  || (section->section_name != NULL))
+  {
+    return (GVAHAND_NEXT_USE_UNKNOWN);
+  }
 
-  if (l_count_open_videohandles < max_open_videohandles)
+  for(l_track = 0; l_track < GAP_STB_MAX_VID_INTERNAL_TRACKS; l_track++)
   {
-    /* we are below the limit, nothing left to do in that case */
-    return;
+    l_frame_group_count[l_track] = 0;
   }
 
-  for(section = vidhand->section_list; section != NULL; section = section->next)
+  l_next_use = GVAHAND_NEXT_USE_NEVER;
+  for (frn_elem = section->frn_list; frn_elem != NULL; frn_elem = (GapStoryRenderFrameRangeElem *)frn_elem->next)
   {
-    for (frn_elem = section->frn_list; frn_elem != NULL; frn_elem = (GapStoryRenderFrameRangeElem *)frn_elem->next)
+    l_track = frn_elem->track;
+    if((l_track < 0) || (l_track >= GAP_STB_MAX_VID_INTERNAL_TRACKS))
     {
-      if((frn_elem->last_master_frame_access < master_frame_nr)
-      && (frn_elem->gvahand != NULL))
-      {
-         if(gap_debug)
-         {
-           printf("too many open videofiles %d detected (limit:%d) at master_frame_nr:%d\n"
-                  " CLOSING GVA handle for video read access %s\n"
-              , (int)l_count_open_videohandles
-              , (int)max_open_videohandles
-              , (int)master_frame_nr
-              , frn_elem->basename
-              );
-         }
-         p_call_GVA_close(frn_elem->gvahand);
-         frn_elem->gvahand = NULL;
-         l_count_open_videohandles--;
-
-         if (l_count_open_videohandles < max_open_videohandles)
-         {
-           return;
-         }
-
-      }
+      continue;
     }
-  }
 
-  /* at this point there are still too many GVA video handles open
-   * (this may occure if videos are used as masks, therefore try to close
-   * mask video handles too.)
-   */
-  if(vidhand->is_mask_handle != TRUE)
-  {
-    GapStoryRenderMaskDefElem *maskdef_elem;
+    l_frames_to_handle = frn_elem->frames_to_handle;
+    if (frn_elem->wait_untiltime_sec > 0)
+    {
+      l_frames_to_handle += MAX(0, frn_elem->wait_untilframes - l_frame_group_count[l_track]);
+    }
+    l_first = l_frame_group_count[l_track] + 1;
+    l_last = l_frame_group_count[l_track] + l_frames_to_handle;
+    l_frame_group_count[l_track] = l_last;
 
-    maskdef_elem = vidhand->maskdef_elem;
-    if(maskdef_elem != NULL)
+    if((l_last < master_frame_nr)
+    || (l_first >= l_next_use))
     {
-      if(maskdef_elem->mask_vidhand != NULL)
-      {
-        p_limit_open_videohandles(maskdef_elem->mask_vidhand
-                                 , master_frame_nr
-                                 , l_count_open_videohandles
-                                 , max_open_videohandles
-                                 );
-      }
+      continue;
+    }
+    if(p_gvahand_is_same_pool_key(frn_elem, frn_elem_holder))
+    {
+      l_next_use = MAX(l_first, master_frame_nr);
     }
   }
 
-#endif
-  return;
+  return (l_next_use);
 
-} /* end p_limit_open_videohandles */
+}  /* end p_gvahand_lookahead_next_use */
 
 
-/* -----------------------------------------
- * p_calculateGvahandHolderRank
- * -----------------------------------------
- * calculate rank for potential  reusage of an already open gva video handle
+/* ----------------------------------------------------
+ * p_gvahand_collect_evict_candidates
+ * ----------------------------------------------------
+ * add all open GVA handles of the specified storyboard video handle
+ * that are not in current access to the list of candidates
+ * and calculate their next use via lookahead.
+ */
+static GSList *
+p_gvahand_collect_evict_candidates(GapStoryRenderVidHandle *vidhand
+                      , gint32 master_frame_nr
+                      , GSList *candidates)
+{
+  GapStoryRenderSection *section;
+  GapStoryRenderFrameRangeElem *frn_elem;
+
+  for(section = vidhand->section_list; section != NULL; section = section->next)
+  {
+    for (frn_elem = section->frn_list; frn_elem != NULL; frn_elem = (GapStoryRenderFrameRangeElem *)frn_elem->next)
+    {
+      if((frn_elem->last_master_frame_access < master_frame_nr)
+      && (frn_elem->gvahand != NULL))
+      {
+        StbGvahandEvictCandidate *evc;
+
+        evc = g_new0(StbGvahandEvictCandidate, 1);
+        evc->owner_vidhand = vidhand;
+        evc->frn_elem = frn_elem;
+        evc->pool_key = p_gvahand_pool_key(vidhand, frn_elem);
+        evc->next_use = p_gvahand_lookahead_next_use(vidhand, section, frn_elem, master_frame_nr);
+        candidates = g_slist_prepend(candidates, evc);
+      }
+    }
+  }
+  return (candidates);
+
+}  /* end p_gvahand_collect_evict_candidates */
+
+
+/* ----------------------------------------------------
+ * p_gvahand_compare_evict_candidates
+ * ----------------------------------------------------
+ * sort order for closing: the handle with the most distant next use first,
+ * the least recently accessed first for equal next use.
+ */
+static gint
+p_gvahand_compare_evict_candidates(gconstpointer a, gconstpointer b)
+{
+  const StbGvahandEvictCandidate *evcA;
+  const StbGvahandEvictCandidate *evcB;
+
+  evcA = (const StbGvahandEvictCandidate *)a;
+  evcB = (const StbGvahandEvictCandidate *)b;
+
+  if(evcA->next_use != evcB->next_use)
+  {
+    return ((evcA->next_use > evcB->next_use) ? -1 : 1);
+  }
+  if(evcA->frn_elem->last_master_frame_access != evcB->frn_elem->last_master_frame_access)
+  {
+    return ((evcA->frn_elem->last_master_frame_access < evcB->frn_elem->last_master_frame_access) ? -1 : 1);
+  }
+  return (0);
+
+}  /* end p_gvahand_compare_evict_candidates */
+
+
+/* ----------------------------------------------------
+ * p_gvahand_register_open
+ * ----------------------------------------------------
+ * count a successful GVA open for the statistics of the handle pool
+ * and detect reopen of a videofile that was closed due to the
+ * limit of open videofiles.
+ */
+static void
+p_gvahand_register_open(GapStoryRenderVidHandle *vidhand
+                      , GapStoryRenderFrameRangeElem *frn_elem
+                      , gint32 master_frame_nr)
+{
+  gchar *pool_key;
+
+  vidhand->gvahandOpenCount++;
+  if(vidhand->gvahandClosedKeys == NULL)
+  {
+    return;
+  }
+
+  pool_key = p_gvahand_pool_key(vidhand, frn_elem);
+  if(g_hash_table_remove(vidhand->gvahandClosedKeys, pool_key))
+  {
+    vidhand->gvahandReopenCount++;
+    if(gap_debug)
+    {
+      printf("p_gvahand_register_open: REOPEN (%d) at master_frame_nr:%d %s\n"
+        , (int)vidhand->gvahandReopenCount
+        , (int)master_frame_nr
+        , pool_key
+        );
+    }
+  }
+  g_free(pool_key);
+
+}  /* end p_gvahand_register_open */
+#endif
+
+
+/* ----------------------------------------------------
+ * p_gvahand_print_pool_statistics
+ * ----------------------------------------------------
+ * a high number of reopens indicates a storyboard that refers
+ * more videofiles at the same time than the limit
+ * video-storyboard-max-open-videofiles allows.
+ */
+static void
+p_gvahand_print_pool_statistics(GapStoryRenderVidHandle *vidhand)
+{
+  printf("STB %s GVA handle pool: opens:%d reopens:%d closed by limit:%d\n"
+    , (vidhand->is_mask_handle == TRUE) ? "MASK" : "MAIN"
+    , (int)vidhand->gvahandOpenCount
+    , (int)vidhand->gvahandReopenCount
+    , (int)vidhand->gvahandLimitCloseCount
+    );
+}  /* end p_gvahand_print_pool_statistics */
+
+
+/* ----------------------------------------------------
+ * p_limit_open_videohandles
+ * ----------------------------------------------------
+ * if the number of currently_open_videohandles exceeds a limit,
+ * then try to close the handle(s) until the number is below the limit.
+ * (but do not close handles that are involved in fetching the current master_frame_nr)
+ *
+ * This kind of garbage collection is useful for storyboards that are using many
+ * different videofile references and would run into memory and other resource problems
+ * when all handles are kept open until the end of rendering process.
+ * (note that each video handle has its own frame cache)
+ *
+ * The open handles of the main storyboard and of the mask sections
+ * are treated as one pool. The handles are closed in the order of their
+ * next use (lookahead in the frame ranges of the MAIN section),
+ * handles that are not used anymore first, handles that will be used
+ * again soon last. Additional handles for the same videofile
+ * (that will be reused by stealing anyway) are closed first.
+ */
+static void
+p_limit_open_videohandles(GapStoryRenderVidHandle *vidhand
+                      , gint32 master_frame_nr
+                      , gint32 currently_open_videohandles
+                      , gint32 max_open_videohandles
+                      )
+{
+#ifdef GAP_ENABLE_VIDEOAPI_SUPPORT
+#define GAP_STB_DEFAULT_MAX_OPEN_VIDEOFILES 12
+  GSList     *candidates;
+  GSList     *list;
+  GHashTable *creditedKeys;
+  gint32      l_count_open_videohandles;
+
+  l_count_open_videohandles = currently_open_videohandles;
+
+  if (l_count_open_videohandles < max_open_videohandles)
+  {
+    /* we are below the limit, nothing left to do in that case */
+    return;
+  }
+
+  candidates = p_gvahand_collect_evict_candidates(vidhand, master_frame_nr, NULL);
+  if(vidhand->is_mask_handle != TRUE)
+  {
+    GapStoryRenderMaskDefElem *maskdef_elem;
+
+    for(maskdef_elem = vidhand->maskdef_elem; maskdef_elem != NULL;  maskdef_elem = maskdef_elem->next)
+    {
+      if(maskdef_elem->mask_vidhand != NULL)
+      {
+        candidates = p_gvahand_collect_evict_candidates(maskdef_elem->mask_vidhand
+                                                       , master_frame_nr
+                                                       , candidates
+                                                       );
+      }
+    }
+  }
+
+  /* only the most recently accessed handle per videofile keeps the credit
+   * of the lookahead, further handles for the same videofile are spare.
+   */
+  creditedKeys = g_hash_table_new(g_str_hash, g_str_equal);
+  candidates = g_slist_sort(candidates, p_gvahand_compare_evict_candidates);
+  candidates = g_slist_reverse(candidates);  /* nearest next use and most recent access first */
+  for(list = candidates; list != NULL; list = list->next)
+  {
+    StbGvahandEvictCandidate *evc;
+
+    evc = (StbGvahandEvictCandidate *)list->data;
+    if(evc->next_use == GVAHAND_NEXT_USE_NEVER)
+    {
+      continue;
+    }
+    if(g_hash_table_lookup(creditedKeys, evc->pool_key) != NULL)
+    {
+      evc->next_use = GVAHAND_NEXT_USE_NEVER;
+    }
+    else
+    {
+      g_hash_table_insert(creditedKeys, evc->pool_key, evc);
+    }
+  }
+  g_hash_table_destroy(creditedKeys);
+  candidates = g_slist_sort(candidates, p_gvahand_compare_evict_candidates);
+
+  for(list = candidates; list != NULL; list = list->next)
+  {
+    StbGvahandEvictCandidate *evc;
+
+    evc = (StbGvahandEvictCandidate *)list->data;
+    if (l_count_open_videohandles < max_open_videohandles)
+    {
+      break;
+    }
+
+    if(gap_debug)
+    {
+      printf("too many open videofiles %d detected (limit:%d) at master_frame_nr:%d\n"
+             " CLOSING GVA handle for video read access %s next use:%d\n"
+         , (int)l_count_open_videohandles
+         , (int)max_open_videohandles
+         , (int)master_frame_nr
+         , evc->pool_key
+         , (int)evc->next_use
+         );
+    }
+    if(evc->owner_vidhand->gvahandClosedKeys == NULL)
+    {
+      evc->owner_vidhand->gvahandClosedKeys = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    }
+    g_hash_table_replace(evc->owner_vidhand->gvahandClosedKeys, g_strdup(evc->pool_key), GINT_TO_POINTER(1));
+    evc->owner_vidhand->gvahandLimitCloseCount++;
+
+    p_call_GVA_close(evc->frn_elem->gvahand);
+    evc->frn_elem->gvahand = NULL;
+    l_count_open_videohandles--;
+  }
+
+  for(list = candidates; list != NULL; list = list->next)
+  {
+    StbGvahandEvictCandidate *evc;
+
+    evc = (StbGvahandEvictCandidate *)list->data;
+    g_free(evc->pool_key);
+    g_free(evc);
+  }
+  g_slist_free(candidates);
+
+#endif
+  return;
+
+} /* end p_limit_open_videohandles */
+
+
+/* -----------------------------------------
+ * p_calculateGvahandHolderRank
+ * -----------------------------------------
+ * calculate rank for potential  reusage of an already open gva video handle
  *
  * return rank
  *    5 .. videoFrameNrToBeReadNext is available in fcache and curent position >= videoFrameNrToBeReadNext same track
@@ -6334,6 +6937,7 @@ p_dump_stb_resources_gvahand(GapStoryRenderVidHandle *vidhand
     ,(int)l_count_open_videohandles
     ,(int)l_max_open_videohandles
     );
+  p_gvahand_print_pool_statistics(vidhand);
 
 #endif
 }  /* end p_dump_stb_resources_gvahand */
@@ -6406,6 +7010,8 @@ p_story_render_fetch_composite_image_or_buffer(GapStoryRenderVidHandle *vidhand
     {
       gap_frame_fetch_dump_resources();
       p_dump_stb_resources_gvahand(vidhand, master_frame_nr);
+      gap_story_render_scache_print_statistics(vidhand->scache, "scaled source cache");
+      gap_story_render_scache_print_statistics(vidhand->mask_cache, "layermask cache");
     }
   }
 
@@ -6467,88 +7073,684 @@ gap_story_render_fetch_composite_image(GapStoryRenderVidHandle *vidhand
 }  /* end gap_story_render_fetch_composite_image */
 
 
-
-/* ------------------------------------------------
- * p_split_delace_value
- * ------------------------------------------------
- * split the specified delace value:
- *    integer part is deinterlace mode,
- *      (0 NO,
- *       1 Odd,
- *       2 Even,
- *       3 Odd First,
- *       4 Even first)
- *    rest is the threshold value.
- * The localframe_tween_rest is a positive value < 1.0.
- * This is only relevant in case delace mode is 3 Odd First or 4 Even first.
- * For clips with standard stepsize 1 localframe_tween_rest is always 0.
- * In Clips with non-integer stepsize localframe_tween_rest referes
- * between 2 framenumbers, where the value 0.5 is the middle.
- * An Interlaced frame contains 2 half-frames where one half-frame is represented by
- * the even, the other half-frame by the odd lines.
- *
- * therfore localframe_tween_rest values >= 0.5 selects the other half-frame,
- * in case the enable_interlace_tween_pick option is enabled.
+/* ----------------------------------------------------
+ * gap_story_render_is_clip_boundary
+ * ----------------------------------------------------
+ * check if a new clip starts at master_frame_nr in any of the video tracks
+ * of the main section (i.e. there is a cut or the begin of a transition).
+ * Elements that continue the same source as their predecessor in the track
+ * (internal splitting of a clip) are not reported as boundary.
+ * encoders can use this information to place keyframes at the cuts.
  *
- * OUT: *deinterlace_ptr
- *       0 NO,
- *       1 Odd,
- *       2 Even,
- * OUT: *threshold_ptr  The threshold < 1.0 for smooth mix of 2 pixel rows.
+ * returns TRUE for the 1st frame and at clip boundaries.
  */
-static void
-p_split_delace_value(gdouble delace, gdouble localframe_tween_rest, gint32 *deinterlace_ptr, gdouble *threshold_ptr)
+gboolean
+gap_story_render_is_clip_boundary(GapStoryRenderVidHandle *vidhand
+                    , gint32 master_frame_nr  /* starts at 1 */
+                    )
 {
-  gint32 delace_int;
+  GapStbFetchData gapStbFetchData;
+  GapStbFetchData *gfd;
+  gint32           l_track;
 
-  delace_int = delace;
-  *threshold_ptr = delace - (gdouble)delace_int;
+  if(master_frame_nr <= 1)
+  {
+    return (TRUE);
+  }
 
-  switch (delace_int)
+  p_select_section_by_name(vidhand, NULL);
+
+  gfd = &gapStbFetchData;
+  p_init_gfd(gfd);
+
+  for(l_track = vidhand->minVidTrack; l_track <= vidhand->maxVidTrack; l_track++)
   {
-    case 4:
-      *deinterlace_ptr = 2;
-      if (localframe_tween_rest >= 0.5)
+    GapStoryRenderFrameRangeElem *frn_elem;
+    GapStoryRenderFrameRangeElem *frn_prev;
+
+    gfd->framename = p_fetch_framename(vidhand->frn_list
+                 , master_frame_nr /* starts at 1 */
+                 , l_track
+                 , gfd
+                 );
+    if(gfd->framename != NULL)
+    {
+      g_free(gfd->framename);
+      gfd->framename = NULL;
+    }
+
+    if((gfd->frn_elem == NULL)
+    || (gfd->local_stepcount != 0))
+    {
+      continue;  /* no frame or not the 1st frame of an element in this track */
+    }
+
+    /* find the predecessor of the element in the same track */
+    frn_prev = NULL;
+    for(frn_elem = vidhand->frn_list; frn_elem != NULL; frn_elem = (GapStoryRenderFrameRangeElem *)frn_elem->next)
+    {
+      if(frn_elem == gfd->frn_elem)
       {
-        *deinterlace_ptr = 1;
+        break;
       }
-      break;
-    case 3:
-      *deinterlace_ptr = 1;
-      if (localframe_tween_rest >= 0.5)
+      if(frn_elem->track == l_track)
       {
-        *deinterlace_ptr = 2;
+        frn_prev = frn_elem;
       }
-      break;
-    case 2:
-      *deinterlace_ptr = 2;
-      break;
-    case 1:
-      *deinterlace_ptr = 1;
-      break;
-    default:
-      *deinterlace_ptr = 0;
-      break;
+    }
+
+    if((frn_prev == NULL)
+    || (frn_prev->frn_type != gfd->frn_elem->frn_type)
+    || ((frn_prev->basename == NULL) != (gfd->frn_elem->basename == NULL))
+    || ((frn_prev->basename != NULL) && (strcmp(frn_prev->basename, gfd->frn_elem->basename) != 0))
+    || (fabs(gfd->frn_elem->frame_from - frn_prev->frame_to) > MAX(1.0, gfd->frn_elem->step_density) + 0.001))
+    {
+      if(gap_debug)
+      {
+        printf("gap_story_render_is_clip_boundary: master_frame_nr:%d track:%d\n"
+          ,(int)master_frame_nr
+          ,(int)l_track
+          );
+      }
+      return (TRUE);
+    }
   }
 
-}  /* end p_split_delace_value */
+  return (FALSE);
 
+}  /* end gap_story_render_is_clip_boundary */
 
-/* -------------------------------------------------------------------
- * p_conditional_delace_drawable
- * -------------------------------------------------------------------
- * general deinterlace handling for frames, images an animimages
- * (except cliptype movie)
+
+/* hash one attribute value (of fixed size) into the segment hash */
+#define SEGCACHE_HASH_VALUE(hash, value)  hash = gap_story_render_segcache_hash_bytes(hash, &(value), sizeof(value))
+
+/* ----------------------------------------------------
+ * p_segcache_file_stamp
+ * ----------------------------------------------------
+ * returns a stamp of modification time and size of a source file
+ * (0 if the file does not exist). The stamps are kept in the stampTable
+ * to stat each file only once.
  */
-static void
-p_conditional_delace_drawable(GapStbFetchData *gfd, gint32 drawable_id)
+static guint64
+p_segcache_file_stamp(GHashTable *stampTable, const char *filename)
 {
-  gint32  l_deinterlace;
-  gdouble l_threshold;
+  guint64   *stampPtr;
+  GStatBuf   l_stat;
 
-  if(gfd->frn_type == GAP_FRN_MOVIE)
+  stampPtr = g_hash_table_lookup(stampTable, filename);
+  if(stampPtr == NULL)
   {
-    /* deinterlace for cliptype movie is already handled by the API at fetching.
+    stampPtr = g_new0(guint64, 1);
+    if(g_stat(filename, &l_stat) == 0)
+    {
+      gint64 mtime;
+      gint64 size;
+
+      mtime = l_stat.st_mtime;
+      size = l_stat.st_size;
+      SEGCACHE_HASH_VALUE(*stampPtr, mtime);
+      SEGCACHE_HASH_VALUE(*stampPtr, size);
+    }
+    g_hash_table_insert(stampTable, g_strdup(filename), stampPtr);
+  }
+  return (*stampPtr);
+
+}  /* end p_segcache_file_stamp */
+
+
+/* ----------------------------------------------------
+ * p_segcache_optional_file_stamp
+ * ----------------------------------------------------
+ * stamp of an optional referenced file (filtermacro, movepath, colormask)
+ * returns 0 if no file is referenced.
+ */
+static guint64
+p_segcache_optional_file_stamp(GHashTable *stampTable, const char *filename)
+{
+  if((filename == NULL)
+  || (*filename == '\0'))
+  {
+    return (0);
+  }
+  return (p_segcache_file_stamp(stampTable, filename));
+
+}  /* end p_segcache_optional_file_stamp */
+
+
+static guint64  p_segcache_section_stamp(GapStoryRenderVidHandle *vidhand, GHashTable *stampTable
+                  , const char *section_name);
+static guint64  p_segcache_mask_stamp(GapStoryRenderVidHandle *vidhand, GHashTable *stampTable
+                  , const char *mask_name);
+
+
+/* ----------------------------------------------------
+ * p_segcache_frn_list_stamp
+ * ----------------------------------------------------
+ * continue the stamp with all elements of a frame range list
+ * (of a sub section or of a mask definition) including the contents
+ * of all referenced files: each frame file of frame ranges,
+ * nested sections, masks, filtermacro, movepath and colormask files.
+ */
+static guint64
+p_segcache_frn_list_stamp(GapStoryRenderVidHandle *vidhand, GHashTable *stampTable
+  , GapStoryRenderFrameRangeElem *frn_list, guint64 stamp)
+{
+  GapStoryRenderFrameRangeElem *frn_elem;
+
+  for(frn_elem = frn_list; frn_elem != NULL; frn_elem = (GapStoryRenderFrameRangeElem *)frn_elem->next)
+  {
+    guint64 fileStamp;
+
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->frn_type);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->track);
+    stamp = gap_story_render_segcache_hash_string(stamp, frn_elem->basename);
+    stamp = gap_story_render_segcache_hash_string(stamp, frn_elem->ext);
+    stamp = gap_story_render_segcache_hash_string(stamp, frn_elem->filtermacro_file);
+    stamp = gap_story_render_segcache_hash_string(stamp, frn_elem->filtermacro_file_to);
+    stamp = gap_story_render_segcache_hash_string(stamp, frn_elem->mask_name);
+    stamp = gap_story_render_segcache_hash_string(stamp, frn_elem->colormask_file);
+    stamp = gap_story_render_segcache_hash_string(stamp, frn_elem->movepath_file_xml);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->frame_from);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->frame_to);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->frames_to_handle);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->step_density);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->red_f);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->green_f);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->blue_f);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->alpha_f);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->flip_request);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->opacity_from);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->opacity_to);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->opacity_dur);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->rotate_from);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->rotate_to);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->rotate_dur);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->scale_x_from);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->scale_x_to);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->scale_x_dur);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->scale_y_from);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->scale_y_to);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->scale_y_dur);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->move_x_from);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->move_x_to);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->move_x_dur);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->move_y_from);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->move_y_to);
+    SEGCACHE_HASH_VALUE(stamp, frn_elem->move_y_dur);
+
+    /* contents of the referenced parameter files */
+    fileStamp = p_segcache_optional_file_stamp(stampTable, frn_elem->filtermacro_file);
+    SEGCACHE_HASH_VALUE(stamp, fileStamp);
+    fileStamp = p_segcache_optional_file_stamp(stampTable, frn_elem->filtermacro_file_to);
+    SEGCACHE_HASH_VALUE(stamp, fileStamp);
+    fileStamp = p_segcache_optional_file_stamp(stampTable, frn_elem->colormask_file);
+    SEGCACHE_HASH_VALUE(stamp, fileStamp);
+    fileStamp = p_segcache_optional_file_stamp(stampTable, frn_elem->movepath_file_xml);
+    SEGCACHE_HASH_VALUE(stamp, fileStamp);
+    if(frn_elem->mask_name != NULL)
+    {
+      fileStamp = p_segcache_mask_stamp(vidhand, stampTable, frn_elem->mask_name);
+      SEGCACHE_HASH_VALUE(stamp, fileStamp);
+    }
+
+    /* contents of the source */
+    if(frn_elem->basename == NULL)
+    {
+      continue;
+    }
+    if(frn_elem->frn_type == GAP_FRN_SECTION)
+    {
+      fileStamp = p_segcache_section_stamp(vidhand, stampTable, frn_elem->basename);
+      SEGCACHE_HASH_VALUE(stamp, fileStamp);
+    }
+    else if(frn_elem->frn_type == GAP_FRN_FRAMES)
+    {
+      gint32 l_fnr;
+      gint32 l_fnr_lo;
+      gint32 l_fnr_hi;
+
+      /* each frame file of the frame range */
+      l_fnr_lo = MIN(frn_elem->frame_from, frn_elem->frame_to);
+      l_fnr_hi = MAX(frn_elem->frame_from, frn_elem->frame_to);
+      for(l_fnr = l_fnr_lo; l_fnr <= l_fnr_hi; l_fnr++)
+      {
+        char *l_framename;
+
+        l_framename = gap_lib_alloc_fname(frn_elem->basename, l_fnr, frn_elem->ext);
+        fileStamp = p_segcache_file_stamp(stampTable, l_framename);
+        SEGCACHE_HASH_VALUE(stamp, fileStamp);
+        g_free(l_framename);
+      }
+    }
+    else
+    {
+      fileStamp = p_segcache_file_stamp(stampTable, frn_elem->basename);
+      SEGCACHE_HASH_VALUE(stamp, fileStamp);
+    }
+  }
+
+  return (stamp);
+
+}  /* end p_segcache_frn_list_stamp */
+
+
+/* ----------------------------------------------------
+ * p_segcache_section_stamp
+ * ----------------------------------------------------
+ * returns a stamp of all video elements of a sub section
+ * (recursive for nested sections).
+ * any change in the sub section changes the hash of all segments
+ * that refer to the sub section.
+ */
+static guint64
+p_segcache_section_stamp(GapStoryRenderVidHandle *vidhand, GHashTable *stampTable
+  , const char *section_name)
+{
+  GapStoryRenderSection        *section;
+  guint64   *stampPtr;
+  gchar     *key;
+
+  key = g_strdup_printf("section:%s", section_name);
+  stampPtr = g_hash_table_lookup(stampTable, key);
+  if(stampPtr != NULL)
+  {
+    g_free(key);
+    return (*stampPtr);
+  }
+
+  /* the (incomplete) stamp is registered before the elements are processed,
+   * this terminates the recursion for sections that refer to themselves
+   */
+  stampPtr = g_new0(guint64, 1);
+  g_hash_table_insert(stampTable, key, stampPtr);
+
+  for(section = vidhand->section_list; section != NULL; section = (GapStoryRenderSection *)section->next)
+  {
+    if((section->section_name == NULL)
+    || (strcmp(section->section_name, section_name) != 0))
+    {
+      continue;
+    }
+    *stampPtr = p_segcache_frn_list_stamp(vidhand, stampTable, section->frn_list, *stampPtr);
+  }
+
+  return (*stampPtr);
+
+}  /* end p_segcache_section_stamp */
+
+
+/* ----------------------------------------------------
+ * p_segcache_mask_stamp
+ * ----------------------------------------------------
+ * returns a stamp of the mask definition mask_name
+ * (attributes and all elements of the mask clip, including the
+ * contents of the mask source files)
+ */
+static guint64
+p_segcache_mask_stamp(GapStoryRenderVidHandle *vidhand, GHashTable *stampTable
+  , const char *mask_name)
+{
+  GapStoryRenderMaskDefElem *maskdef_elem;
+  guint64   *stampPtr;
+  gchar     *key;
+
+  key = g_strdup_printf("mask:%s", mask_name);
+  stampPtr = g_hash_table_lookup(stampTable, key);
+  if(stampPtr != NULL)
+  {
+    g_free(key);
+    return (*stampPtr);
+  }
+
+  stampPtr = g_new0(guint64, 1);
+  g_hash_table_insert(stampTable, key, stampPtr);
+
+  maskdef_elem = p_find_maskdef_by_name(vidhand, mask_name);
+  if(maskdef_elem != NULL)
+  {
+    SEGCACHE_HASH_VALUE(*stampPtr, maskdef_elem->record_type);
+    SEGCACHE_HASH_VALUE(*stampPtr, maskdef_elem->frame_count);
+    SEGCACHE_HASH_VALUE(*stampPtr, maskdef_elem->flip_request);
+    if(maskdef_elem->mask_vidhand != NULL)
+    {
+      *stampPtr = p_segcache_frn_list_stamp(maskdef_elem->mask_vidhand
+                                           , stampTable
+                                           , maskdef_elem->mask_vidhand->frn_list
+                                           , *stampPtr);
+    }
+  }
+
+  return (*stampPtr);
+
+}  /* end p_segcache_mask_stamp */
+
+
+/* ----------------------------------------------------
+ * p_segcache_hash_frame
+ * ----------------------------------------------------
+ * continue the segment hash with all attributes that contribute
+ * to the frame at master_frame_nr in the specified track
+ * (source frame, transitions, masks, filtermacros and the stamp of the source file)
+ */
+static guint64
+p_segcache_hash_frame(GapStoryRenderVidHandle *vidhand, GHashTable *stampTable
+  , gint32 master_frame_nr, gint32 track, guint64 hash)
+{
+  GapStbFetchData gapStbFetchData;
+  GapStbFetchData *gfd;
+  GapStoryRenderFrameRangeElem *frn_elem;
+  guint64          stamp;
+
+  gfd = &gapStbFetchData;
+  p_init_gfd(gfd);
+  gfd->framename = p_fetch_framename(vidhand->frn_list
+                 , master_frame_nr /* starts at 1 */
+                 , track
+                 , gfd
+                 );
+
+  SEGCACHE_HASH_VALUE(hash, track);
+  SEGCACHE_HASH_VALUE(hash, gfd->frn_type);
+  hash = gap_story_render_segcache_hash_string(hash, gfd->framename);
+  SEGCACHE_HASH_VALUE(hash, gfd->localframe_index);
+  SEGCACHE_HASH_VALUE(hash, gfd->localframe_tween_rest);
+  SEGCACHE_HASH_VALUE(hash, gfd->rotate);
+  SEGCACHE_HASH_VALUE(hash, gfd->opacity);
+  SEGCACHE_HASH_VALUE(hash, gfd->scale_x);
+  SEGCACHE_HASH_VALUE(hash, gfd->scale_y);
+  SEGCACHE_HASH_VALUE(hash, gfd->move_x);
+  SEGCACHE_HASH_VALUE(hash, gfd->move_y);
+  SEGCACHE_HASH_VALUE(hash, gfd->keep_proportions);
+  SEGCACHE_HASH_VALUE(hash, gfd->fit_width);
+  SEGCACHE_HASH_VALUE(hash, gfd->fit_height);
+  SEGCACHE_HASH_VALUE(hash, gfd->red_f);
+  SEGCACHE_HASH_VALUE(hash, gfd->green_f);
+  SEGCACHE_HASH_VALUE(hash, gfd->blue_f);
+  SEGCACHE_HASH_VALUE(hash, gfd->alpha_f);
+  hash = gap_story_render_segcache_hash_string(hash, gfd->trak_filtermacro_file);
+  hash = gap_story_render_segcache_hash_string(hash, gfd->movepath_file_xml);
+  SEGCACHE_HASH_VALUE(hash, gfd->movepath_framePhase);
+
+  frn_elem = gfd->frn_elem;
+  if(frn_elem != NULL)
+  {
+    SEGCACHE_HASH_VALUE(hash, frn_elem->seltrack);
+    SEGCACHE_HASH_VALUE(hash, frn_elem->exact_seek);
+    SEGCACHE_HASH_VALUE(hash, frn_elem->delace);
+    SEGCACHE_HASH_VALUE(hash, frn_elem->flip_request);
+    hash = gap_story_render_segcache_hash_string(hash, frn_elem->colormask_file);
+    hash = gap_story_render_segcache_hash_string(hash, frn_elem->mask_name);
+    if(frn_elem->mask_name != NULL)
+    {
+      /* the mask frame depends on the progress within the clip */
+      SEGCACHE_HASH_VALUE(hash, frn_elem->mask_anchor);
+      SEGCACHE_HASH_VALUE(hash, frn_elem->mask_stepsize);
+      SEGCACHE_HASH_VALUE(hash, frn_elem->mask_framecount);
+      SEGCACHE_HASH_VALUE(hash, gfd->local_stepcount);
+    }
+    hash = gap_story_render_segcache_hash_string(hash, frn_elem->filtermacro_file_to);
+    if(frn_elem->filtermacro_file_to != NULL)
+    {
+      /* varying filtermacro values depend on the progress within the clip */
+      SEGCACHE_HASH_VALUE(hash, frn_elem->fmac_total_steps);
+      SEGCACHE_HASH_VALUE(hash, frn_elem->fmac_accel);
+      SEGCACHE_HASH_VALUE(hash, gfd->local_stepcount);
+    }
+
+    /* contents of the referenced parameter files and of the mask definition */
+    stamp = p_segcache_optional_file_stamp(stampTable, frn_elem->filtermacro_file);
+    SEGCACHE_HASH_VALUE(hash, stamp);
+    stamp = p_segcache_optional_file_stamp(stampTable, frn_elem->filtermacro_file_to);
+    SEGCACHE_HASH_VALUE(hash, stamp);
+    stamp = p_segcache_optional_file_stamp(stampTable, frn_elem->colormask_file);
+    SEGCACHE_HASH_VALUE(hash, stamp);
+    if(frn_elem->mask_name != NULL)
+    {
+      stamp = p_segcache_mask_stamp(vidhand, stampTable, frn_elem->mask_name);
+      SEGCACHE_HASH_VALUE(hash, stamp);
+    }
+  }
+  stamp = p_segcache_optional_file_stamp(stampTable, gfd->trak_filtermacro_file);
+  SEGCACHE_HASH_VALUE(hash, stamp);
+  stamp = p_segcache_optional_file_stamp(stampTable, gfd->movepath_file_xml);
+  SEGCACHE_HASH_VALUE(hash, stamp);
+
+  if(gfd->framename != NULL)
+  {
+    if(gfd->frn_type == GAP_FRN_SECTION)
+    {
+      stamp = p_segcache_section_stamp(vidhand, stampTable, gfd->framename);
+    }
+    else
+    {
+      stamp = p_segcache_file_stamp(stampTable, gfd->framename);
+    }
+    SEGCACHE_HASH_VALUE(hash, stamp);
+    g_free(gfd->framename);
+    gfd->framename = NULL;
+  }
+
+  return (hash);
+
+}  /* end p_segcache_hash_frame */
+
+
+/* ----------------------------------------------------
+ * gap_story_render_enable_segment_cache
+ * ----------------------------------------------------
+ * enable incremental encoding for the frames range_from upto range_to
+ * of the output video videoname.
+ * The segment size is configured by the gimprc parameter
+ * video-encoder-incremental-segment-frames (0 disables incremental encoding)
+ * and is rounded up to a multiple of gop_size.
+ *
+ * The encoder must call this procedure before it creates the output video
+ * (the output video of the previous encode is renamed, it is the source of the
+ * frames that are copied for unchanged segments).
+ * settings shall describe all encoder parameters, the previous encode is
+ * reused only if the settings are equal.
+ * The encoder passes allowReuse FALSE when it can not write copied chunks
+ * (the segment hashes are calculated and stored anyway).
+ *
+ * While the segment cache is enabled, frames of unchanged segments
+ * are delivered as compressed chunk by the fetch procedures, and
+ * force_keyframe is set at segment start and at the 1st frame after copied frames.
+ *
+ * returns TRUE if the segment cache is enabled.
+ */
+gboolean
+gap_story_render_enable_segment_cache(GapStoryRenderVidHandle *vidhand
+                    , const char *videoname
+                    , gint32 range_from
+                    , gint32 range_to
+                    , gint32 gop_size
+                    , const char *settings
+                    , gboolean allowReuse
+                    )
+{
+  GapStoryRenderFrameRangeElem *frn_elem;
+  GHashTable *stampTable;
+  guint64    *hashes;
+  guint64     seed;
+  gint32     *lastAccess;
+  gint32      segmentFrames;
+  gint32      numFrames;
+  gint32      numElems;
+  gint32      master_frame_nr;
+  gint32      ii;
+
+  if((vidhand == NULL) || (videoname == NULL))
+  {
+    return (FALSE);
+  }
+  segmentFrames = gap_base_get_gimprc_int_value(GAP_GIMPRC_VIDEO_ENCODER_INCREMENTAL_SEGMENT_FRAMES
+                                               , GAP_STB_DEFAULT_INCREMENTAL_SEGMENT_FRAMES
+                                               , 0
+                                               , 100000
+                                               );
+  if((segmentFrames <= 0)
+  || (range_from < 1)
+  || (range_from > range_to))
+  {
+    /* disabled (or backwards encoding, that is not supported) */
+    return (FALSE);
+  }
+  if(gop_size > 1)
+  {
+    /* GOP aligned segments */
+    segmentFrames = ((segmentFrames + gop_size - 1) / gop_size) * gop_size;
+  }
+
+  p_select_section_by_name(vidhand, NULL);
+
+  /* p_fetch_framename records the last access in the elements,
+   * keep the values of the render session
+   */
+  numElems = 0;
+  for(frn_elem = vidhand->frn_list; frn_elem != NULL; frn_elem = (GapStoryRenderFrameRangeElem *)frn_elem->next)
+  {
+    numElems++;
+  }
+  lastAccess = g_new0(gint32, MAX(1, numElems));
+  ii = 0;
+  for(frn_elem = vidhand->frn_list; frn_elem != NULL; frn_elem = (GapStoryRenderFrameRangeElem *)frn_elem->next)
+  {
+    lastAccess[ii++] = frn_elem->last_master_frame_access;
+  }
+
+  /* settings of the storyboard that apply to all frames */
+  seed = 0;
+  seed = gap_story_render_segcache_hash_string(seed, vidhand->master_insert_alpha_format);
+  seed = gap_story_render_segcache_hash_string(seed, vidhand->master_insert_area_format);
+  seed = gap_story_render_segcache_hash_string(seed, vidhand->preferred_decoder);
+
+  numFrames = 1 + (range_to - range_from);
+  hashes = g_new0(guint64, (numFrames + segmentFrames - 1) / segmentFrames);
+  stampTable = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+  for(master_frame_nr = range_from; master_frame_nr <= range_to; master_frame_nr++)
+  {
+    gint32 segIdx;
+    gint32 l_track;
+
+    segIdx = (master_frame_nr - range_from) / segmentFrames;
+    if(((master_frame_nr - range_from) % segmentFrames) == 0)
+    {
+      hashes[segIdx] = seed;
+    }
+    for(l_track = vidhand->minVidTrack; l_track <= vidhand->maxVidTrack; l_track++)
+    {
+      hashes[segIdx] = p_segcache_hash_frame(vidhand, stampTable, master_frame_nr, l_track, hashes[segIdx]);
+    }
+  }
+
+  g_hash_table_destroy(stampTable);
+  ii = 0;
+  for(frn_elem = vidhand->frn_list; frn_elem != NULL; frn_elem = (GapStoryRenderFrameRangeElem *)frn_elem->next)
+  {
+    frn_elem->last_master_frame_access = lastAccess[ii++];
+  }
+  g_free(lastAccess);
+
+  if(vidhand->segcache != NULL)
+  {
+    gap_story_render_segcache_free(vidhand->segcache);
+  }
+  vidhand->segcache = gap_story_render_segcache_new(videoname
+                          , settings
+                          , segmentFrames
+                          , range_from
+                          , numFrames
+                          , hashes      /* the segment cache takes the ownership */
+                          , allowReuse
+                          );
+  return (TRUE);
+
+}  /* end gap_story_render_enable_segment_cache */
+
+
+
+/* ------------------------------------------------
+ * p_split_delace_value
+ * ------------------------------------------------
+ * split the specified delace value:
+ *    integer part is deinterlace mode,
+ *      (0 NO,
+ *       1 Odd,
+ *       2 Even,
+ *       3 Odd First,
+ *       4 Even first)
+ *    rest is the threshold value.
+ * The localframe_tween_rest is a positive value < 1.0.
+ * This is only relevant in case delace mode is 3 Odd First or 4 Even first.
+ * For clips with standard stepsize 1 localframe_tween_rest is always 0.
+ * In Clips with non-integer stepsize localframe_tween_rest referes
+ * between 2 framenumbers, where the value 0.5 is the middle.
+ * An Interlaced frame contains 2 half-frames where one half-frame is represented by
+ * the even, the other half-frame by the odd lines.
+ *
+ * therfore localframe_tween_rest values >= 0.5 selects the other half-frame,
+ * in case the enable_interlace_tween_pick option is enabled.
+ *
+ * OUT: *deinterlace_ptr
+ *       0 NO,
+ *       1 Odd,
+ *       2 Even,
+ * OUT: *threshold_ptr  The threshold < 1.0 for smooth mix of 2 pixel rows.
+ */
+static void
+p_split_delace_value(gdouble delace, gdouble localframe_tween_rest, gint32 *deinterlace_ptr, gdouble *threshold_ptr)
+{
+  gint32 delace_int;
+
+  delace_int = delace;
+  *threshold_ptr = delace - (gdouble)delace_int;
+
+  switch (delace_int)
+  {
+    case 4:
+      *deinterlace_ptr = 2;
+      if (localframe_tween_rest >= 0.5)
+      {
+        *deinterlace_ptr = 1;
+      }
+      break;
+    case 3:
+      *deinterlace_ptr = 1;
+      if (localframe_tween_rest >= 0.5)
+      {
+        *deinterlace_ptr = 2;
+      }
+      break;
+    case 2:
+      *deinterlace_ptr = 2;
+      break;
+    case 1:
+      *deinterlace_ptr = 1;
+      break;
+    default:
+      *deinterlace_ptr = 0;
+      break;
+  }
+
+}  /* end p_split_delace_value */
+
+
+/* -------------------------------------------------------------------
+ * p_conditional_delace_drawable
+ * -------------------------------------------------------------------
+ * general deinterlace handling for frames, images an animimages
+ * (except cliptype movie)
+ */
+static void
+p_conditional_delace_drawable(GapStbFetchData *gfd, gint32 drawable_id)
+{
+  gint32  l_deinterlace;
+  gdouble l_threshold;
+
+  if(gfd->frn_type == GAP_FRN_MOVIE)
+  {
+    /* deinterlace for cliptype movie is already handled by the API at fetching.
      */
     return;
   }
@@ -6580,6 +7782,7 @@ p_init_gfd(GapStbFetchData *gfd)
   gfd->layer_id        = -1;
   gfd->gapStoryFetchResult = NULL;
   gfd->isRgb888Result      = FALSE;
+  gfd->isScacheLookupDone  = FALSE;
 }  /* end p_init_gfd */
 
 
@@ -6710,6 +7913,8 @@ p_prescale_image_size_handling(GapStbFetchData *gfdCurrent
   , gint32 master_frame_nr
   , gint32 vid_width
   , gint32 vid_height
+  , gint32 *originalWidthPtr
+  , gint32 *originalHeightPtr
   )
 {
   gint32 l_fetched_image_id;
@@ -6741,6 +7946,8 @@ p_prescale_image_size_handling(GapStbFetchData *gfdCurrent
     /* failed to fetch image */
     return (l_fetched_image_id);
   }
+  *originalWidthPtr = originalWidth;
+  *originalHeightPtr = originalHeight;
 
   calculated = &calculate_attributes;
 
@@ -7020,6 +8227,268 @@ p_prescale_image_size_handling(GapStbFetchData *gfdCurrent
 }  /* end p_prescale_image_size_handling */
 
 
+/* -------------------------------------------------------------------
+ * p_image_from_buffer
+ * -------------------------------------------------------------------
+ * create a new gimp image with one layer from the specified pixel buffer
+ * return the image id.
+ */
+static gint32
+p_image_from_buffer(GapStoryRenderPixelBuffer *pbuf, gint32 *layer_id)
+{
+  GimpDrawable *drawable;
+  GimpPixelRgn  pixel_rgn;
+  gint32        image_id;
+
+  image_id = gimp_image_new(pbuf->width, pbuf->height, GIMP_RGB);
+  gimp_image_undo_disable(image_id);
+  *layer_id = gimp_layer_new(image_id, "scaled_source"
+                            , pbuf->width
+                            , pbuf->height
+                            , (pbuf->bpp == 4) ? GIMP_RGBA_IMAGE : GIMP_RGB_IMAGE
+                            , 100.0     /* full opaque */
+                            , GIMP_NORMAL_MODE
+                            );
+  gimp_image_insert_layer(image_id, *layer_id, 0, 0);
+
+  drawable = gimp_drawable_get(*layer_id);
+  gimp_pixel_rgn_init (&pixel_rgn, drawable, 0, 0
+                      , pbuf->width, pbuf->height
+                      , TRUE      /* dirty */
+                      , FALSE     /* shadow */
+                      );
+  gimp_pixel_rgn_set_rect (&pixel_rgn, pbuf->data, 0, 0, pbuf->width, pbuf->height);
+  gimp_drawable_flush (drawable);
+  gimp_drawable_detach(drawable);
+
+  return (image_id);
+
+}  /* end p_image_from_buffer */
+
+
+/* -------------------------------------------------------------------
+ * p_scache_is_clip_scale_constant
+ * -------------------------------------------------------------------
+ * returns FALSE if the scale of the clip changes within its frames
+ * (zoom transitions). Such clips are not cached, because each frame
+ * would store another scaled variant of the same image.
+ */
+static gboolean
+p_scache_is_clip_scale_constant(GapStoryRenderFrameRangeElem *frn_elem)
+{
+  gint32 l_last_step;
+
+  l_last_step = MAX(0, frn_elem->frames_to_handle - 1);
+  if((p_attribute_query_at_step(0
+                          , frn_elem->scale_x_from
+                          , frn_elem->scale_x_to
+                          , frn_elem->scale_x_dur
+                          , frn_elem->scale_x_frames_done
+                          , frn_elem->scale_x_accel
+                          )
+   != p_attribute_query_at_step(l_last_step
+                          , frn_elem->scale_x_from
+                          , frn_elem->scale_x_to
+                          , frn_elem->scale_x_dur
+                          , frn_elem->scale_x_frames_done
+                          , frn_elem->scale_x_accel
+                          ))
+  || (p_attribute_query_at_step(0
+                          , frn_elem->scale_y_from
+                          , frn_elem->scale_y_to
+                          , frn_elem->scale_y_dur
+                          , frn_elem->scale_y_frames_done
+                          , frn_elem->scale_y_accel
+                          )
+   != p_attribute_query_at_step(l_last_step
+                          , frn_elem->scale_y_from
+                          , frn_elem->scale_y_to
+                          , frn_elem->scale_y_dur
+                          , frn_elem->scale_y_frames_done
+                          , frn_elem->scale_y_accel
+                          )))
+  {
+    return (FALSE);
+  }
+  return (TRUE);
+
+}  /* end p_scache_is_clip_scale_constant */
+
+
+/* -------------------------------------------------------------------
+ * p_scache_calculate_size
+ * -------------------------------------------------------------------
+ * calculate the size of the source image for rendering the current clip.
+ * returns TRUE in case this size is a candidate for the scaled source cache.
+ * (only downscaled variants of clips with constant scale are cached,
+ * upscaled images are rendered via the clipped rectangle processing
+ * in p_transform_and_add_layer)
+ */
+static gboolean
+p_scache_calculate_size(GapStbFetchData *gfd
+  , gint32 vid_width
+  , gint32 vid_height
+  , gint32 orig_width
+  , gint32 orig_height
+  , gint32 *scaled_width
+  , gint32 *scaled_height
+  )
+{
+  GapStoryCalcAttr  calculate_attributes;
+
+  if(p_scache_is_clip_scale_constant(gfd->frn_elem) != TRUE)
+  {
+    return (FALSE);
+  }
+
+  gap_story_file_calculate_render_attributes(&calculate_attributes
+      , vid_width
+      , vid_height
+      , vid_width
+      , vid_height
+      , orig_width
+      , orig_height
+      , gfd->keep_proportions
+      , gfd->fit_width
+      , gfd->fit_height
+      , gfd->rotate
+      , gfd->opacity
+      , gfd->scale_x
+      , gfd->scale_y
+      , gfd->move_x
+      , gfd->move_y
+      );
+  *scaled_width = calculate_attributes.width;
+  *scaled_height = calculate_attributes.height;
+
+  if((*scaled_width <= 0)
+  || (*scaled_height <= 0)
+  || (*scaled_width > orig_width)
+  || (*scaled_height > orig_height))
+  {
+    return (FALSE);
+  }
+  return (TRUE);
+
+}  /* end p_scache_calculate_size */
+
+
+/* -------------------------------------------------------------------
+ * p_scache_lookup_image
+ * -------------------------------------------------------------------
+ * lookup the image of the current clip (gfd->framename) in the scaled source cache
+ * at the size required for rendering.
+ * returns the cached pixel buffer (owned by the cache) or NULL.
+ * (hits and misses are counted by gap_story_render_scache_lookup,
+ * clips that are no cache candidates are not counted)
+ */
+static GapStoryRenderPixelBuffer *
+p_scache_lookup_image(GapStbFetchData *gfd
+  , GapStoryRenderVidHandle *vidhand
+  , gint32 vid_width
+  , gint32 vid_height
+  )
+{
+  time_t  mtime;
+  gint32  orig_width;
+  gint32  orig_height;
+  gint32  scaled_width;
+  gint32  scaled_height;
+
+  if((vidhand->scache == NULL) || (gfd->framename == NULL))
+  {
+    return (NULL);
+  }
+
+  mtime = gap_file_get_mtime(gfd->framename);
+
+  /* the size is unknown if no variant of the image is cached
+   * (such a size never matches, the lookup counts the miss)
+   */
+  scaled_width = -1;
+  scaled_height = -1;
+  if(gap_story_render_scache_get_orig_size(vidhand->scache, gfd->framename, mtime
+                                           , &orig_width, &orig_height) == TRUE)
+  {
+    if(p_scache_calculate_size(gfd, vid_width, vid_height, orig_width, orig_height
+                              , &scaled_width, &scaled_height) != TRUE)
+    {
+      return (NULL);
+    }
+  }
+  else if(p_scache_is_clip_scale_constant(gfd->frn_elem) != TRUE)
+  {
+    return (NULL);
+  }
+
+  return (gap_story_render_scache_lookup(vidhand->scache
+                    , gfd->framename
+                    , mtime
+                    , scaled_width
+                    , scaled_height
+                    , (gint32)gimp_context_get_interpolation()
+                    ));
+
+}  /* end p_scache_lookup_image */
+
+
+/* -------------------------------------------------------------------
+ * p_scache_store_image
+ * -------------------------------------------------------------------
+ * scale the fetched image (gfd->tmp_image_id with its only layer gfd->layer_id)
+ * to the size required for rendering and add a copy of its pixels
+ * to the scaled source cache.
+ * (the following transformation will not scale again,
+ * because the image has already the calculated size)
+ */
+static void
+p_scache_store_image(GapStbFetchData *gfd
+  , GapStoryRenderVidHandle *vidhand
+  , gint32 vid_width
+  , gint32 vid_height
+  , gint32 orig_width
+  , gint32 orig_height
+  )
+{
+  GapStoryRenderPixelBuffer *pbuf;
+  gint32  scaled_width;
+  gint32  scaled_height;
+
+  if((vidhand->scache == NULL)
+  || (gfd->framename == NULL)
+  || (gfd->tmp_image_id < 0)
+  || (gfd->layer_id < 0))
+  {
+    return;
+  }
+  if(p_scache_calculate_size(gfd, vid_width, vid_height, orig_width, orig_height
+                            , &scaled_width, &scaled_height) != TRUE)
+  {
+    return;
+  }
+
+  if((gimp_image_width(gfd->tmp_image_id) != scaled_width)
+  || (gimp_image_height(gfd->tmp_image_id) != scaled_height))
+  {
+    gap_frame_fetch_image_scale(gfd->tmp_image_id, scaled_width, scaled_height);
+  }
+
+  pbuf = p_buffer_from_layer(gfd->layer_id);
+  if(pbuf != NULL)
+  {
+    gap_story_render_scache_store(vidhand->scache
+                    , gfd->framename
+                    , gap_file_get_mtime(gfd->framename)
+                    , (gint32)gimp_context_get_interpolation()
+                    , orig_width
+                    , orig_height
+                    , pbuf
+                    );
+  }
+
+}  /* end p_scache_store_image */
+
+
 /* -------------------------------------------------------------------
  * p_stb_render_image_or_animimage (GAP_FRN_ANIMIMAGE or GAP_FRN_IMAGE
  * -------------------------------------------------------------------
@@ -7033,6 +8502,9 @@ p_stb_render_image_or_animimage(GapStbFetchData *gfd
   gint32        l_orig_image_id;
   gint          l_nlayers;
   gint32       *l_layers_list;
+  gint32        l_orig_width;
+  gint32        l_orig_height;
+  gboolean      l_is_scache_candidate;
 
 
   if(gap_debug)
@@ -7042,6 +8514,30 @@ p_stb_render_image_or_animimage(GapStbFetchData *gfd
        );
   }
 
+  l_orig_width = 0;
+  l_orig_height = 0;
+  l_is_scache_candidate = FALSE;
+  if ((gfd->frn_type == GAP_FRN_IMAGE)
+  &&  (gfd->trak_filtermacro_file == NULL)
+  &&  (gfd->movepath_file_xml == NULL)
+  &&  (gfd->frn_elem->delace == 0.0)
+  &&  (vidhand->scache != NULL))
+  {
+    l_is_scache_candidate = TRUE;
+    if(gfd->isScacheLookupDone != TRUE)
+    {
+      GapStoryRenderPixelBuffer *pbuf;
+
+      pbuf = p_scache_lookup_image(gfd, vidhand, vid_width, vid_height);
+      if(pbuf != NULL)
+      {
+        /* the image is already available at the scaled size */
+        gfd->tmp_image_id = p_image_from_buffer(pbuf, &gfd->layer_id);
+        return;
+      }
+    }
+  }
+
 
   /* filtermacro shall be applied at original image size
    * therefore disable prescale handling when filtermacro or
@@ -7058,7 +8554,8 @@ p_stb_render_image_or_animimage(GapStbFetchData *gfd
     }
     /* prescale handling */
     l_orig_image_id =
-       p_prescale_image_size_handling(gfd, vidhand, master_frame_nr, vid_width, vid_height);
+       p_prescale_image_size_handling(gfd, vidhand, master_frame_nr, vid_width, vid_height
+                                     , &l_orig_width, &l_orig_height);
   }
   else
   {
@@ -7086,6 +8583,10 @@ p_stb_render_image_or_animimage(GapStbFetchData *gfd
     gfd->tmp_image_id = gap_frame_fetch_image_duplicate(l_orig_image_id);
     gfd->layer_id = p_prepare_RGB_image(gfd->tmp_image_id);
     gap_frame_fetch_remove_parasite(gfd->tmp_image_id);
+    if ((l_is_scache_candidate) && (l_orig_width > 0))
+    {
+      p_scache_store_image(gfd, vidhand, vid_width, vid_height, l_orig_width, l_orig_height);
+    }
     if(gap_debug)
     {
       printf("IMAGE fetch  master_frame_nr:%d  (dup)tmp_image_id:%d layer_id:%d l_orig_image_id:%d\n"
@@ -7248,6 +8749,8 @@ p_check_and_open_video_handle(GapStoryRenderFrameRangeElem *frn_elem
        {
          gint32   fcacheSize;
 
+         p_gvahand_register_open(vidhand, frn_elem, master_frame_nr);
+
          fcacheSize = gap_base_get_gimprc_int_value(GAP_GIMPRC_VIDEO_STORYBOARD_FCACHE_SIZE_PER_VIDEOFILE
                                                      , GAP_STB_RENDER_GVA_FRAMES_TO_KEEP_CACHED  /* default */
                                                      , 2   /* min */
@@ -7317,26 +8820,137 @@ p_get_PrefetchThreadPool()
  * further the vidhand->isMultithreadEnabled is set accordingly.
  * Note that gimprc configuration is ignored in case
  * GIMP_GAP was compiled without GAP_ENABLE_VIDEOAPI_SUPPORT.
+ * (except for the parallel preload of track images,
+ * that is available without video api support)
  */
 static void
 p_initOptionalMulitprocessorSupport(GapStoryRenderVidHandle *vidhand)
 {
   vidhand->isMultithreadEnabled = FALSE;
+  vidhand->isParallelTrackFetchEnabled = FALSE;
+  if (gap_story_isMultiprocessorSupportEnabled())
+  {
+    vidhand->isParallelTrackFetchEnabled = gap_base_thread_init();
+  }
+
+#ifdef GAP_ENABLE_VIDEOAPI_SUPPORT
+  vidhand->isMultithreadEnabled = gap_story_isMultiprocessorSupportEnabled();
+  if (vidhand->isMultithreadEnabled)
+  {
+    /* check and init thread system */
+    vidhand->isMultithreadEnabled = gap_base_thread_init();
+  }
+
+  if (vidhand->isMultithreadEnabled)
+  {
+    p_get_PrefetchThreadPool();
+  }
+#endif
+}  /* end p_initOptionalMulitprocessorSupport */
+
+
+/* ----------------------------------------------------
+ * p_initOptionalBufferCompositing
+ * ----------------------------------------------------
+ * configure the buffer based compositing engine
+ * (the rows of a composite frame are processed with one worker thread
+ * per processor in case multiprocessor support is enabled)
+ */
+static void
+p_initOptionalBufferCompositing(GapStoryRenderVidHandle *vidhand)
+{
+  vidhand->isBufferCompositingEnabled =
+    gap_base_get_gimprc_gboolean_value(GAP_GIMPRC_VIDEO_STORYBOARD_BUFFER_COMPOSITING
+                                      , FALSE  /* default (opt-in, the bilinear scaling changes the output) */
+                                      );
+  vidhand->bufferCompositingThreads = 1;
+  if((vidhand->isBufferCompositingEnabled)
+  && (vidhand->isParallelTrackFetchEnabled))
+  {
+    /* thread system is already initialized for the parallel track fetch */
+    vidhand->bufferCompositingThreads = MAX(1, gap_base_get_numProcessors());
+  }
+}  /* end p_initOptionalBufferCompositing */
+
+
+/* ----------------------------------------------------
+ * p_initOptionalScaledSourceCache
+ * ----------------------------------------------------
+ * create the scaled source cache and the layermask cache for the render session
+ * with the byte budgets configured in gimprc (0 disables the cache)
+ */
+static void
+p_initOptionalScaledSourceCache(GapStoryRenderVidHandle *vidhand)
+{
+  gint32 cacheSizeMB;
+
+  vidhand->scache = NULL;
+  cacheSizeMB = gap_base_get_gimprc_int_value(GAP_GIMPRC_VIDEO_STORYBOARD_SCALED_SOURCE_CACHE_MB
+                                             , GAP_STB_DEFAULT_SCALED_SOURCE_CACHE_MB
+                                             , 0
+                                             , 4096
+                                             );
+  if(cacheSizeMB > 0)
+  {
+    vidhand->scache = gap_story_render_scache_new((gint64)cacheSizeMB * 1024 * 1024);
+  }
+
+  /* the layermask cache holds gray mask frames at the size of the target layer */
+  vidhand->mask_cache = NULL;
+  cacheSizeMB = gap_base_get_gimprc_int_value(GAP_GIMPRC_VIDEO_STORYBOARD_MASK_CACHE_MB
+                                             , GAP_STB_DEFAULT_MASK_CACHE_MB
+                                             , 0
+                                             , 4096
+                                             );
+  if(cacheSizeMB > 0)
+  {
+    vidhand->mask_cache = gap_story_render_scache_new((gint64)cacheSizeMB * 1024 * 1024);
+  }
+}  /* end p_initOptionalScaledSourceCache */
+
+
+/* -------------------------------------------
+ * p_preload_track_images
+ * -------------------------------------------
+ * start parallel decoding of the frame images of all tracks
+ * at master_frame_nr (before the tracks are fetched and composed
+ * in sequence). The preload is done by the frame fetcher worker threads
+ * and covers single images and frame image clips.
+ * Gimp calls (fetch as image, transformations and compositing)
+ * stay in the serial track loop, therefore the composite result
+ * is the same as without preload.
+ */
+static void
+p_preload_track_images(GapStoryRenderVidHandle *vidhand, gint32 master_frame_nr)
+{
+  GapStbFetchData gapStbFetchData;
+  GapStbFetchData *gfd;
+  gint32  l_track;
+
+  gfd = &gapStbFetchData;
+  p_init_gfd(gfd);
 
-#ifdef GAP_ENABLE_VIDEOAPI_SUPPORT
-  vidhand->isMultithreadEnabled = gap_story_isMultiprocessorSupportEnabled();
-  if (vidhand->isMultithreadEnabled)
+  /* same track order as the compositing loop, the first required image is decoded first */
+  for(l_track = vidhand->maxVidTrack; l_track >= vidhand->minVidTrack; l_track--)
   {
-    /* check and init thread system */
-    vidhand->isMultithreadEnabled = gap_base_thread_init();
+    gfd->framename = p_fetch_framename(vidhand->frn_list
+                 , master_frame_nr /* starts at 1 */
+                 , l_track
+                 , gfd
+                 );
+    if(gfd->framename)
+    {
+      if((gfd->frn_type == GAP_FRN_IMAGE)
+      || (gfd->frn_type == GAP_FRN_ANIMIMAGE)
+      || (gfd->frn_type == GAP_FRN_FRAMES))
+      {
+        gap_frame_fetch_preload_image(vidhand->ffetch_user_id, gfd->framename);
+      }
+      g_free(gfd->framename);
+    }
   }
 
-  if (vidhand->isMultithreadEnabled)
-  {
-    p_get_PrefetchThreadPool();
-  }
-#endif
-}  /* end p_initOptionalMulitprocessorSupport */
+}  /* end p_preload_track_images */
 
 
 /* ---------------------------------------------------
@@ -8951,149 +10565,709 @@ p_get_insert_alpha_filename(GapStbFetchData *gfd
     }
     else
     {
-      alpha_imagename =
-         g_strdup_printf(vidhand->master_insert_alpha_format
-                       , gfd->localframe_index   /* videoFrameNr */
-                       );
+      alpha_imagename =
+         g_strdup_printf(vidhand->master_insert_alpha_format
+                       , gfd->localframe_index   /* videoFrameNr */
+                       );
+    }
+  }
+  else
+  {
+    if (vidhand->master_insert_alpha_format_has_videobasename)
+    {
+      alpha_imagename =
+         g_strdup_printf(vidhand->master_insert_alpha_format
+                       , videofilename_without_path
+                       );
+    }
+    else
+    {
+      alpha_imagename = g_strdup(vidhand->master_insert_alpha_format);
+    }
+  }
+
+  if(gap_debug)
+  {
+    printf("p_get_insert_alpha_filename: format:%s\n video:%s\n alpha_imagename:%s\n"
+        , vidhand->master_insert_alpha_format
+        , videofilename_without_path
+        , alpha_imagename
+        );
+  }
+
+  g_free(videofilename_without_path);
+
+  return(alpha_imagename);
+
+}  /* end p_get_insert_alpha_filename */
+
+/* -------------------------------------
+ * p_do_insert_alpha_processing
+ * -------------------------------------
+ * adds alpha channel for videoframes
+ * based on an image or series of frames
+ * matching the configured format string.
+ * (VID_MASTER_INSERT_ALPHA)
+ *
+ */
+static void
+p_do_insert_alpha_processing(GapStbFetchData *gfd
+  , GapStoryRenderVidHandle *vidhand)
+{
+  char *alpha_imagename;
+
+  alpha_imagename = p_get_insert_alpha_filename(gfd, vidhand);
+
+
+  if(g_file_test(alpha_imagename, G_FILE_TEST_EXISTS))
+  {
+    gint32 alpha_image_id;
+    gint32 alpha_layer_id;
+    gint   vid_width;
+    gint   vid_height;
+
+    if (vidhand->master_insert_alpha_format_has_framenumber)
+    {
+      alpha_image_id = gap_lib_load_image(alpha_imagename);
+    }
+    else
+    {
+      /* use framefetcher cache in case all frames shall get alpha from the same image */
+      alpha_image_id = gap_frame_fetch_orig_image(vidhand->ffetch_user_id
+                            , alpha_imagename
+                            , TRUE /*  enable caching */
+                           );
+    }
+
+    if(alpha_image_id < 0)
+    {
+      printf("p_do_insert_alpha_processing: ERROR could not load alpha_imagename:%s\n"
+            , alpha_imagename
+            );
+      g_free(alpha_imagename);
+      return;
+    }
+
+
+    gimp_selection_none(alpha_image_id);
+    alpha_layer_id = p_prepare_GRAY_image(alpha_image_id);
+
+    vid_width = gimp_image_width(gfd->tmp_image_id);
+    vid_height = gimp_image_height(gfd->tmp_image_id);
+
+    /* scale alpha image to Videosize (if not already equal) */
+    if ((gimp_image_width(alpha_image_id) != vid_width)
+    ||  (gimp_image_height(alpha_image_id) != vid_height) )
+    {
+       if(gap_debug)
+       {
+         printf("DEBUG: p_do_insert_alpha_processing scaling alpha image\n");
+       }
+       gap_frame_fetch_image_scale(gfd->comp_image_id, vid_width, vid_height);
+    }
+
+    if(! gimp_drawable_has_alpha(gfd->layer_id))
+    {
+      /* have to add alpha channel */
+      gimp_layer_add_alpha(gfd->layer_id);
+    }
+
+
+    /* copy alpha_layer_id into the alpha channel of the current frame */
+    gap_layer_copy_picked_channel(gfd->layer_id, 3  /* dst_pick is the alpha channel */
+                               ,alpha_layer_id, 0   /* gray value */
+                               ,FALSE  /* shadow */
+                               );
+
+    if (vidhand->master_insert_alpha_format_has_framenumber)
+    {
+      /* do not keep individual per frame alpha images cached
+       */
+      gap_image_delete_immediate(alpha_image_id);
+    }
+  }
+
+  g_free(alpha_imagename);
+
+}  /* end p_do_insert_alpha_processing */
+
+/* --------------------------------------------
+ * p_isFiltermacroActive
+ * --------------------------------------------
+ */
+static gboolean
+p_isFiltermacroActive(const char *filtermacro_file)
+{
+  if(filtermacro_file)
+  {
+     if(*filtermacro_file != '\0')
+     {
+       return(TRUE);
+     }
+  }
+  return(FALSE);
+
+}  /* end p_isFiltermacroActive */
+
+
+/* --------------------------------------------
+ * p_is_frame_debug_output_active
+ * --------------------------------------------
+ * check for the debug features that require the composite frame as gimp image
+ * (save multilayer or flat backup frames and encoding monitor)
+ */
+static gboolean
+p_is_frame_debug_output_active(void)
+{
+  if((gimp_get_data_size(GAP_VID_ENC_SAVE_MULTILAYER) > 0)
+  || (gimp_get_data_size(GAP_VID_ENC_SAVE_FLAT) > 0)
+  || (gimp_get_data_size(GAP_VID_ENC_MONITOR) > 0))
+  {
+    return (TRUE);
+  }
+  return (FALSE);
+
+}  /* end p_is_frame_debug_output_active */
+
+
+/* --------------------------------------------
+ * p_buffer_from_layer
+ * --------------------------------------------
+ * read the pixels of the specified RGB, RGBA or GRAY layer (or layermask)
+ * into a newly allocated pixel buffer.
+ */
+static GapStoryRenderPixelBuffer *
+p_buffer_from_layer(gint32 layer_id)
+{
+  GimpDrawable *drawable;
+  GimpPixelRgn  pixel_rgn;
+  GapStoryRenderPixelBuffer *pbuf;
+
+  drawable = gimp_drawable_get(layer_id);
+  if(drawable == NULL)
+  {
+    return (NULL);
+  }
+  if((drawable->bpp != 1) && (drawable->bpp != 3) && (drawable->bpp != 4))
+  {
+    gimp_drawable_detach(drawable);
+    return (NULL);
+  }
+
+  pbuf = gap_story_render_buffer_new(drawable->width, drawable->height, drawable->bpp);
+  gimp_pixel_rgn_init (&pixel_rgn, drawable, 0, 0
+                      , drawable->width, drawable->height
+                      , FALSE     /* dirty */
+                      , FALSE     /* shadow */
+                      );
+  gimp_pixel_rgn_get_rect (&pixel_rgn, pbuf->data
+                          , 0
+                          , 0
+                          , drawable->width
+                          , drawable->height
+                          );
+  gimp_drawable_detach(drawable);
+
+  return (pbuf);
+
+}  /* end p_buffer_from_layer */
+
+
+/* --------------------------------------------
+ * p_fetch_mask_buffer
+ * --------------------------------------------
+ * fetch the layermask of the specified clip as 8 bit gray buffer
+ * at mask_width x mask_height.
+ * (same mask frame selection as p_fetch_and_add_layermask)
+ * returns NULL if the mask is not available.
+ */
+static guchar *
+p_fetch_mask_buffer(GapStoryRenderVidHandle *vidhand
+                  , GapStoryRenderFrameRangeElem *frn_elem
+                  , gint32 local_stepcount
+                  , gint32 mask_width
+                  , gint32 mask_height
+                  )
+{
+  gint32   l_tmp_mask_image_id;
+  gint32   l_tmp_mask_layer_id;
+  gint32   l_master_framenr;
+  gdouble  l_framenr;
+  gboolean l_was_last_maskframe;
+  guchar  *mask_data;
+  GapStoryRenderPixelBuffer *l_cached_mask;
+
+  if((mask_width <= 0) || (mask_height <= 0))
+  {
+    return (NULL);
+  }
+
+  /* both local_stepcount and mask_framecount start with 0 for the 1st element */
+  l_framenr = frn_elem->mask_stepsize * (gdouble)(frn_elem->mask_framecount + local_stepcount);
+  l_master_framenr = 1 + (gint32)(l_framenr);
+
+  l_cached_mask = p_mask_cache_lookup(vidhand, frn_elem->mask_name
+                                     , l_master_framenr, mask_width, mask_height);
+  if(l_cached_mask != NULL)
+  {
+    return (g_memdup(l_cached_mask->data, mask_width * mask_height));
+  }
+
+  mask_data = NULL;
+  l_tmp_mask_image_id = p_mask_fetcher(vidhand
+                              , frn_elem->mask_name
+                              , l_master_framenr
+                              , mask_width
+                              , mask_height
+                              ,&l_tmp_mask_layer_id
+                              ,&l_was_last_maskframe
+                              , TRUE    /* makeGrayFlattened */
+                              );
+  if(l_tmp_mask_image_id < 0)
+  {
+    return (NULL);
+  }
+
+  if((gimp_drawable_width(l_tmp_mask_layer_id) == mask_width)
+  && (gimp_drawable_height(l_tmp_mask_layer_id) == mask_height)
+  && (gimp_drawable_bpp(l_tmp_mask_layer_id) == 1))
+  {
+    GimpDrawable *drawable;
+    GimpPixelRgn  pixel_rgn;
+
+    drawable = gimp_drawable_get(l_tmp_mask_layer_id);
+    mask_data = g_malloc(mask_width * mask_height);
+    gimp_pixel_rgn_init (&pixel_rgn, drawable, 0, 0
+                        , mask_width, mask_height
+                        , FALSE     /* dirty */
+                        , FALSE     /* shadow */
+                        );
+    gimp_pixel_rgn_get_rect (&pixel_rgn, mask_data, 0, 0, mask_width, mask_height);
+    gimp_drawable_detach(drawable);
+
+    p_mask_cache_store(vidhand, frn_elem->mask_name, l_master_framenr, l_tmp_mask_layer_id);
+  }
+  gap_image_delete_immediate(l_tmp_mask_image_id);
+
+  return (mask_data);
+
+}  /* end p_fetch_mask_buffer */
+
+
+/* --------------------------------------------
+ * p_is_buffer_compositing_possible
+ * --------------------------------------------
+ * check if all tracks at master_frame_nr can be handled by the
+ * buffer based compositing engine.
+ * (clip types that are not supported, track specific filtermacros,
+ * move paths, colormasks and automatic insert of logo areas or alpha channels
+ * in movie clips require the gimp layer based processing)
+ */
+static gboolean
+p_is_buffer_compositing_possible(GapStoryRenderVidHandle *vidhand
+                    , gint32 master_frame_nr  /* starts at 1 */
+                    )
+{
+  GapStbFetchData gapStbFetchData;
+  GapStbFetchData *gfd;
+  gint32           l_track;
+  gboolean         isPossible;
+
+  gfd = &gapStbFetchData;
+  p_init_gfd(gfd);
+  isPossible = TRUE;
+
+  for(l_track = vidhand->minVidTrack; l_track <= vidhand->maxVidTrack; l_track++)
+  {
+    gfd->framename = p_fetch_framename(vidhand->frn_list
+                 , master_frame_nr /* starts at 1 */
+                 , l_track
+                 , gfd
+                 );
+    if(gfd->framename != NULL)
+    {
+      g_free(gfd->framename);
+      gfd->framename = NULL;
+    }
+    else
+    {
+      if(gfd->frn_type != GAP_FRN_COLOR)
+      {
+        continue;  /* no frame in this track */
+      }
     }
-  }
-  else
-  {
-    if (vidhand->master_insert_alpha_format_has_videobasename)
+
+    switch(gfd->frn_type)
     {
-      alpha_imagename =
-         g_strdup_printf(vidhand->master_insert_alpha_format
-                       , videofilename_without_path
-                       );
+      case GAP_FRN_COLOR:
+      case GAP_FRN_IMAGE:
+      case GAP_FRN_FRAMES:
+        break;
+      case GAP_FRN_MOVIE:
+        if((vidhand->master_insert_alpha_format != NULL)
+        || (vidhand->master_insert_area_format != NULL))
+        {
+          isPossible = FALSE;
+        }
+        break;
+      default:
+        isPossible = FALSE;
+        break;
     }
-    else
+
+    if((p_isFiltermacroActive(gfd->trak_filtermacro_file) == TRUE)
+    || (gfd->movepath_file_xml != NULL))
     {
-      alpha_imagename = g_strdup(vidhand->master_insert_alpha_format);
+      isPossible = FALSE;
+    }
+    if((gfd->frn_elem->mask_name != NULL)
+    && (gfd->frn_elem->mask_anchor == GAP_MSK_ANCHOR_XCOLOR))
+    {
+      isPossible = FALSE;
     }
-  }
 
-  if(gap_debug)
-  {
-    printf("p_get_insert_alpha_filename: format:%s\n video:%s\n alpha_imagename:%s\n"
-        , vidhand->master_insert_alpha_format
-        , videofilename_without_path
-        , alpha_imagename
-        );
+    if(isPossible != TRUE)
+    {
+      if(gap_debug)
+      {
+        printf("p_is_buffer_compositing_possible: NO master_frame_nr:%d track:%d frn_type:%d\n"
+          ,(int)master_frame_nr
+          ,(int)l_track
+          ,(int)gfd->frn_type
+          );
+      }
+      break;
+    }
   }
 
-  g_free(videofilename_without_path);
+  return (isPossible);
 
-  return(alpha_imagename);
+}  /* end p_is_buffer_compositing_possible */
 
-}  /* end p_get_insert_alpha_filename */
 
-/* -------------------------------------
- * p_do_insert_alpha_processing
- * -------------------------------------
- * adds alpha channel for videoframes
- * based on an image or series of frames
- * matching the configured format string.
- * (VID_MASTER_INSERT_ALPHA)
+/* --------------------------------------------
+ * p_story_render_composite_buffer_where_possible    rgb888 handling
+ * --------------------------------------------
+ * this procedure renders the composite frame at master_frame_nr with the
+ * buffer based compositing engine (see gap_story_render_buffer.c)
+ * and delivers the result as rgb888 buffer in the gapStoryFetchResult struct.
+ * The tracks are fetched as before, but scaling, moving, rotation,
+ * flipping, opacity, layermasks and flattening are done in memory
+ * without creating a composite gimp image and without layer copy/paste.
  *
+ * returns TRUE if the frame was rendered.
+ * returns FALSE if the frame requires the gimp layer based processing
+ * (or any of the fetches failed). In this case the caller
+ * shall continue with the standard render processing.
  */
-static void
-p_do_insert_alpha_processing(GapStbFetchData *gfd
-  , GapStoryRenderVidHandle *vidhand)
+static gboolean
+p_story_render_composite_buffer_where_possible(GapStoryRenderVidHandle *vidhand
+                    , gint32 master_frame_nr  /* starts at 1 */
+                    , gint32  vid_width       /* desired Video Width in pixels */
+                    , gint32  vid_height      /* desired Video Height in pixels */
+                    , GapStoryFetchResult      *gapStoryFetchResult
+                 )
 {
-  char *alpha_imagename;
+  GapStbFetchData gapStbFetchData;
+  GapStbFetchData *gfd;
+  guchar          *rgb888;
+  gint32           l_track;
+  gboolean         isFirstTrack;
+  gboolean         isPreloadActive;
+  gboolean         isOk;
 
-  alpha_imagename = p_get_insert_alpha_filename(gfd, vidhand);
+  static gint32 funcId = -1;
+
+  if(p_is_frame_debug_output_active() == TRUE)
+  {
+    return (FALSE);
+  }
+  if(p_is_buffer_compositing_possible(vidhand, master_frame_nr) != TRUE)
+  {
+    return (FALSE);
+  }
 
+  GAP_TIMM_GET_FUNCTION_ID(funcId, "p_story_render_composite_buffer_where_possible");
+  GAP_TIMM_START_FUNCTION(funcId);
 
-  if(g_file_test(alpha_imagename, G_FILE_TEST_EXISTS))
+  gfd = &gapStbFetchData;
+  p_init_gfd(gfd);
+
+  isPreloadActive = FALSE;
+  if((vidhand->isParallelTrackFetchEnabled)
+  && (vidhand->maxVidTrack > vidhand->minVidTrack))
   {
-    gint32 alpha_image_id;
-    gint32 alpha_layer_id;
-    gint   vid_width;
-    gint   vid_height;
+    p_preload_track_images(vidhand, master_frame_nr);
+    isPreloadActive = TRUE;
+  }
 
-    if (vidhand->master_insert_alpha_format_has_framenumber)
+  /* compose directly into the buffer provided by the caller (if any) */
+  rgb888 = gapStoryFetchResult->raw_rgb_data;
+  if(rgb888 == NULL)
+  {
+    rgb888 = g_malloc(vid_width * vid_height * 3);
+  }
+  gap_story_render_buffer_fill_rgb888(rgb888, vid_width, vid_height, 0, 0, 0);
+  isFirstTrack = TRUE;
+  isOk = TRUE;
+
+  /* reverse order, track 0 is composed as last track (i.e. in the foreground) */
+  for(l_track = vidhand->maxVidTrack; l_track >= vidhand->minVidTrack; l_track--)
+  {
+    GapStoryRenderBufferLayer  bufferLayer;
+    GapStoryRenderPixelBuffer  movieBuffer;
+    GapStoryFetchResult        movieFetchResult;
+    GapStoryRenderPixelBuffer *pbuf;
+    GapStoryCalcAttr           calculate_attributes;
+    gint32                     src_width;
+    gint32                     src_height;
+
+    gfd->framename = p_fetch_framename(vidhand->frn_list
+                 , master_frame_nr /* starts at 1 */
+                 , l_track
+                 , gfd
+                 );
+    if((gfd->framename == NULL) && (gfd->frn_type != GAP_FRN_COLOR))
     {
-      alpha_image_id = gap_lib_load_image(alpha_imagename);
+      continue;
+    }
+
+    pbuf = NULL;
+    movieFetchResult.raw_rgb_data = NULL;
+    bufferLayer.src = NULL;
+    bufferLayer.color[0] = 0;
+    bufferLayer.color[1] = 0;
+    bufferLayer.color[2] = 0;
+    bufferLayer.color[3] = 255;
+    src_width = vid_width;
+    src_height = vid_height;
+    gfd->tmp_image_id = -1;
+
+    if(gfd->frn_type == GAP_FRN_COLOR)
+    {
+      bufferLayer.color[0] = (guchar)(CLAMP(gfd->red_f, 0.0, 1.0) * 255.0 + 0.5);
+      bufferLayer.color[1] = (guchar)(CLAMP(gfd->green_f, 0.0, 1.0) * 255.0 + 0.5);
+      bufferLayer.color[2] = (guchar)(CLAMP(gfd->blue_f, 0.0, 1.0) * 255.0 + 0.5);
+      bufferLayer.color[3] = (guchar)(CLAMP(gfd->alpha_f, 0.0, 1.0) * 255.0 + 0.5);
     }
     else
     {
-      /* use framefetcher cache in case all frames shall get alpha from the same image */
-      alpha_image_id = gap_frame_fetch_orig_image(vidhand->ffetch_user_id
-                            , alpha_imagename
-                            , TRUE /*  enable caching */
-                           );
+      if(gfd->frn_type == GAP_FRN_MOVIE)
+      {
+        /* prefer the rgb888 fetch (without conversion to gimp drawable) */
+        movieFetchResult.resultEnum = GAP_STORY_FETCH_RESULT_IS_ERROR;
+        movieFetchResult.image_id = -1;
+        movieFetchResult.layer_id = -1;
+        movieFetchResult.video_frame_chunk_data = NULL;
+        gfd->gapStoryFetchResult = &movieFetchResult;
+        gfd->isRgb888Result      = TRUE;
+        p_stb_render_movie(gfd, vidhand, master_frame_nr, vid_width, vid_height);
+        gfd->gapStoryFetchResult = NULL;
+        gfd->isRgb888Result      = FALSE;
+
+        if((movieFetchResult.resultEnum == GAP_STORY_FETCH_RESULT_IS_RAW_RGB888)
+        && (movieFetchResult.raw_rgb_data != NULL))
+        {
+          movieBuffer.data = movieFetchResult.raw_rgb_data;
+          movieBuffer.width = gfd->frn_elem->gvahand->width;
+          movieBuffer.height = gfd->frn_elem->gvahand->height;
+          movieBuffer.bpp = 3;
+          movieBuffer.rowstride = movieBuffer.width * 3;
+          bufferLayer.src = &movieBuffer;
+          gfd->tmp_image_id = -1;
+        }
+        else if(gfd->tmp_image_id < 0)
+        {
+          isOk = FALSE;
+        }
+      }
+      else if(gfd->frn_type == GAP_FRN_IMAGE)
+      {
+        if(gfd->frn_elem->delace == 0.0)
+        {
+          /* use the image pixels from the scaled source cache (owned by the cache) */
+          bufferLayer.src = p_scache_lookup_image(gfd, vidhand, vid_width, vid_height);
+          gfd->isScacheLookupDone = TRUE;
+        }
+        if(bufferLayer.src == NULL)
+        {
+          p_stb_render_image_or_animimage(gfd, vidhand, master_frame_nr, vid_width, vid_height);
+        }
+        gfd->isScacheLookupDone = FALSE;
+      }
+      else
+      {
+        /* GAP_FRN_FRAMES */
+        p_stb_render_frame_images(gfd, vidhand, master_frame_nr, vid_width, vid_height);
+      }
+
+      if((isOk == TRUE)
+      && (bufferLayer.src == NULL))
+      {
+        if(gfd->tmp_image_id < 0)
+        {
+          isOk = FALSE;
+        }
+        else
+        {
+          gfd->layer_id = p_prepare_RGB_image(gfd->tmp_image_id);
+          p_conditional_delace_drawable(gfd, gfd->layer_id);
+          pbuf = p_buffer_from_layer(gfd->layer_id);
+          gap_image_delete_immediate(gfd->tmp_image_id);
+          gfd->tmp_image_id = -1;
+          if(pbuf == NULL)
+          {
+            isOk = FALSE;
+          }
+          bufferLayer.src = pbuf;
+        }
+      }
+      g_free(gfd->framename);
+      gfd->framename = NULL;
     }
 
-    if(alpha_image_id < 0)
+    if(isOk != TRUE)
     {
-      printf("p_do_insert_alpha_processing: ERROR could not load alpha_imagename:%s\n"
-            , alpha_imagename
-            );
-      g_free(alpha_imagename);
-      return;
+      if(movieFetchResult.raw_rgb_data != NULL)
+      {
+        g_free(movieFetchResult.raw_rgb_data);
+      }
+      break;
     }
 
+    if(bufferLayer.src != NULL)
+    {
+      src_width = bufferLayer.src->width;
+      src_height = bufferLayer.src->height;
+    }
 
-    gimp_selection_none(alpha_image_id);
-    alpha_layer_id = p_prepare_GRAY_image(alpha_image_id);
+    if(isFirstTrack)
+    {
+      isFirstTrack = FALSE;
+      if((gfd->opacity == 1.0)
+      && (gfd->rotate == 0.0)
+      && (gfd->scale_x == 1.0)
+      && (gfd->scale_y == 1.0)
+      && (gfd->move_x == 0.0)
+      && (gfd->move_y == 0.0)
+      && (gfd->fit_width)
+      && (gfd->fit_height)
+      && (!gfd->keep_proportions)
+      && (gfd->frn_elem->flip_request == GAP_STB_FLIP_NONE)
+      && (gfd->frn_elem->mask_name == NULL))
+      {
+        GimpRGB  bck_color;
+        guchar   red;
+        guchar   green;
+        guchar   blue;
+
+        /* the gimp layer based processing uses the first track as composite image
+         * in this case, where transparent pixels are flattened against
+         * the background color of the gimp context
+         */
+        gimp_context_get_background(&bck_color);
+        gimp_rgb_get_uchar (&bck_color, &red, &green, &blue);
+        gap_story_render_buffer_fill_rgb888(rgb888, vid_width, vid_height, red, green, blue);
+      }
+    }
 
-    vid_width = gimp_image_width(gfd->tmp_image_id);
-    vid_height = gimp_image_height(gfd->tmp_image_id);
+    /* calculate scaling, offsets and opacity  according to current attributes */
+    gap_story_file_calculate_render_attributes(&calculate_attributes
+      , vid_width
+      , vid_height
+      , vid_width
+      , vid_height
+      , src_width
+      , src_height
+      , gfd->keep_proportions
+      , gfd->fit_width
+      , gfd->fit_height
+      , gfd->rotate
+      , gfd->opacity
+      , gfd->scale_x
+      , gfd->scale_y
+      , gfd->move_x
+      , gfd->move_y
+      );
 
-    /* scale alpha image to Videosize (if not already equal) */
-    if ((gimp_image_width(alpha_image_id) != vid_width)
-    ||  (gimp_image_height(alpha_image_id) != vid_height) )
+    bufferLayer.width = calculate_attributes.width;
+    bufferLayer.height = calculate_attributes.height;
+    bufferLayer.x_offs = calculate_attributes.x_offs;
+    bufferLayer.y_offs = calculate_attributes.y_offs;
+    bufferLayer.rotate = gfd->rotate;
+    bufferLayer.opacity = CLAMP(calculate_attributes.opacity / 100.0, 0.0, 1.0);
+    bufferLayer.flip_request = gfd->frn_elem->flip_request;
+    bufferLayer.clip_mask = NULL;
+    bufferLayer.master_mask = NULL;
+
+    if(gfd->frn_elem->mask_name != NULL)
     {
-       if(gap_debug)
-       {
-         printf("DEBUG: p_do_insert_alpha_processing scaling alpha image\n");
-       }
-       gap_frame_fetch_image_scale(gfd->comp_image_id, vid_width, vid_height);
+      if(gfd->frn_elem->mask_anchor == GAP_MSK_ANCHOR_MASTER)
+      {
+        bufferLayer.master_mask = p_fetch_mask_buffer(vidhand, gfd->frn_elem
+                                    , gfd->local_stepcount
+                                    , vid_width
+                                    , vid_height
+                                    );
+      }
+      else
+      {
+        bufferLayer.clip_mask = p_fetch_mask_buffer(vidhand, gfd->frn_elem
+                                    , gfd->local_stepcount
+                                    , bufferLayer.width
+                                    , bufferLayer.height
+                                    );
+      }
     }
 
-    if(! gimp_drawable_has_alpha(gfd->layer_id))
+    gap_story_render_buffer_composite_layer(rgb888, vid_width, vid_height
+                                           , &bufferLayer
+                                           , vidhand->bufferCompositingThreads
+                                           );
+
+    g_free(bufferLayer.clip_mask);
+    g_free(bufferLayer.master_mask);
+    gap_story_render_buffer_free(pbuf);
+    if(movieFetchResult.raw_rgb_data != NULL)
     {
-      /* have to add alpha channel */
-      gimp_layer_add_alpha(gfd->layer_id);
+      g_free(movieFetchResult.raw_rgb_data);
     }
 
+  }       /* end for loop over all video tracks */
 
-    /* copy alpha_layer_id into the alpha channel of the current frame */
-    gap_layer_copy_picked_channel(gfd->layer_id, 3  /* dst_pick is the alpha channel */
-                               ,alpha_layer_id, 0   /* gray value */
-                               ,FALSE  /* shadow */
-                               );
+  if(isPreloadActive)
+  {
+    gap_frame_fetch_preload_drop();
+  }
 
-    if (vidhand->master_insert_alpha_format_has_framenumber)
+  if(isOk == TRUE)
+  {
+    /* deliver the composite buffer (the caller is responsible to free it) */
+    gapStoryFetchResult->raw_rgb_data = rgb888;
+    gapStoryFetchResult->resultEnum = GAP_STORY_FETCH_RESULT_IS_RAW_RGB888;
+    gapStoryFetchResult->image_id = -1;
+    gapStoryFetchResult->layer_id = -1;
+  }
+  else
+  {
+    if(rgb888 != gapStoryFetchResult->raw_rgb_data)
     {
-      /* do not keep individual per frame alpha images cached
-       */
-      gap_image_delete_immediate(alpha_image_id);
+      g_free(rgb888);
+    }
+    if(gap_debug)
+    {
+      printf("p_story_render_composite_buffer_where_possible: fetch failed at master_frame_nr:%d"
+             " (continue with gimp layer processing)\n"
+        ,(int)master_frame_nr
+        );
     }
   }
 
-  g_free(alpha_imagename);
-
-}  /* end p_do_insert_alpha_processing */
+  GAP_TIMM_STOP_FUNCTION(funcId);
 
-/* --------------------------------------------
- * p_isFiltermacroActive
- * --------------------------------------------
- */
-static gboolean
-p_isFiltermacroActive(const char *filtermacro_file)
-{
-  if(filtermacro_file)
-  {
-     if(*filtermacro_file != '\0')
-     {
-       return(TRUE);
-     }
-  }
-  return(FALSE);
+  return (isOk);
 
-}  /* end p_isFiltermacroActive */
+}  /* end p_story_render_composite_buffer_where_possible */
 
 
 /* --------------------------------------------
@@ -9347,6 +11521,7 @@ p_story_render_fetch_composite_image_private(GapStoryRenderVidHandle *vidhand
   GapStbFetchData *gfd;
 
   gint32  l_track;
+  gboolean isPreloadActive;
 
   static gint32 funcId = -1;
   static gint32 funcIdDirect = -1;
@@ -9432,6 +11607,38 @@ p_story_render_fetch_composite_image_private(GapStoryRenderVidHandle *vidhand
        */
       return (-1);
     }
+
+    if((vidhand->isBufferCompositingEnabled == TRUE)
+    && (vidhand->is_mask_handle != TRUE))
+    {
+      if(p_story_render_composite_buffer_where_possible(vidhand
+                    , master_frame_nr
+                    , vid_width
+                    , vid_height
+                    , gapStoryFetchResult
+                    ) == TRUE)
+      {
+        /* the result is available as rgb888 buffer in the gapStoryFetchResult struct
+         * (composed by the buffer based compositing engine without gimp layers)
+         */
+        GAP_TIMM_STOP_FUNCTION(funcId);
+        return (-1);
+      }
+    }
+  }
+
+  isPreloadActive = FALSE;
+  if((vidhand->isParallelTrackFetchEnabled)
+  && (vidhand->is_mask_handle != TRUE)
+  && (section_name == NULL)
+  && (vidhand->maxVidTrack > vidhand->minVidTrack))
+  {
+    /* decode images of all tracks in parallel,
+     * (mask and sub section fetches while compositing take
+     * preloaded images too, but do not start a preload on their own)
+     */
+    p_preload_track_images(vidhand, master_frame_nr);
+    isPreloadActive = TRUE;
   }
 
   /* reverse order, has the effect, that track 0 is processed as last track
@@ -9498,6 +11705,10 @@ p_story_render_fetch_composite_image_private(GapStoryRenderVidHandle *vidhand
               gap_story_render_debug_print_frame_elem(gfd->frn_elem, -1);
               printf("\n** storyboard render processing failed\n");
               g_free(gfd->framename);
+              if(isPreloadActive)
+              {
+                gap_frame_fetch_preload_drop();
+              }
 
               GAP_TIMM_STOP_FUNCTION(funcId);
               return -1;
@@ -9614,6 +11825,11 @@ p_story_render_fetch_composite_image_private(GapStoryRenderVidHandle *vidhand
      }
   }       /* end for loop over all video tracks */
 
+  if(isPreloadActive)
+  {
+    /* drop preloaded images that were not fetched */
+    gap_frame_fetch_preload_drop();
+  }
 
   p_stb_render_composite_image_postprocessing(gfd
           , vidhand, master_frame_nr
@@ -190,6 +190,35 @@ gint32   gap_story_render_fetch_composite_image(GapStoryRenderVidHandle *vidhand
 
 
 
+/* ----------------------------------------------------
+ * gap_story_render_is_clip_boundary
+ * ----------------------------------------------------
+ * returns TRUE if a new clip (cut or begin of a transition) starts
+ * at master_frame_nr in any video track of the main section.
+ * (encoders can use this to force keyframes at the cuts)
+ */
+gboolean gap_story_render_is_clip_boundary(GapStoryRenderVidHandle *vidhand
+                    , gint32 master_frame_nr  /* starts at 1 */
+                 );
+
+
+/* ----------------------------------------------------
+ * gap_story_render_enable_segment_cache
+ * ----------------------------------------------------
+ * enable incremental encoding (reuse of unchanged segments of the previous
+ * encode of videoname). Must be called before the output video is created.
+ * returns TRUE if enabled (gimprc video-encoder-incremental-segment-frames > 0)
+ */
+gboolean gap_story_render_enable_segment_cache(GapStoryRenderVidHandle *vidhand
+                    , const char *videoname
+                    , gint32 range_from
+                    , gint32 range_to
+                    , gint32 gop_size         /* segments are rounded to a multiple of gop_size */
+                    , const char *settings    /* encoder settings (reuse requires equal settings) */
+                    , gboolean allowReuse     /* FALSE: the encoder can not write copied chunks */
+                 );
+
+
 /* ------------------------------------------------------------------------
  * gap_story_render_fetch_composite_image_or_buffer_or_chunk (extended API)
  * ------------------------------------------------------------------------
@@ -0,0 +1,393 @@
+/* gap_story_render_scache.c
+ *
+ *  GAP storyboard rendering processor.
+ *
+ *  This module is the scaled source cache.
+ *  Still images that are refered in many frames of a storyboard
+ *  (title cards, backgrounds, holds) are scaled once to the size
+ *  required for rendering and kept as pixel buffers for the render session.
+ *  The elements are identified by filename, modification time,
+ *  interpolation type and scaled size.
+ *  The total size of the cached pixel buffers is limited by a byte budget,
+ *  the least recently used elements are removed when the budget is exceeded.
+ *
+ *  The same cache type is used by the render processor as layermask cache,
+ *  where the elements are identified by mask name and frame number
+ *  (as filename) and the size of the target layer.
+ *
+ *  Note: this module does not call the gimp PDB.
+ */
+
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026/10/18  agent: created
+ * version 2.8.xx;  2026/10/18  agent: used as layermask cache too
+ */
+
+#include <config.h>
+
+/* SYTEM (UNIX) includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* GIMP includes */
+#include "libgimp/gimp.h"
+
+/* GAP includes */
+#include "gap_story_render_scache.h"
+
+
+extern int gap_debug;  /* 1 == print debug infos , 0 dont print debug infos */
+
+static void      p_unlink_elem(GapStoryRenderScaledSourceCache *scache
+                      , GapStoryRenderScaledSourceElem *selem);
+static void      p_link_elem_as_first(GapStoryRenderScaledSourceCache *scache
+                      , GapStoryRenderScaledSourceElem *selem);
+static void      p_free_elem(GapStoryRenderScaledSourceElem *selem);
+static GapStoryRenderScaledSourceElem * p_find_elem(GapStoryRenderScaledSourceCache *scache
+                      , const char *filename, time_t mtime
+                      , gint32 width, gint32 height, gint32 interpolation);
+
+
+/* ----------------------------------------------------
+ * gap_story_render_scache_new
+ * ----------------------------------------------------
+ */
+GapStoryRenderScaledSourceCache *
+gap_story_render_scache_new(gint64 byte_budget)
+{
+  GapStoryRenderScaledSourceCache *scache;
+
+  scache = g_new0(GapStoryRenderScaledSourceCache, 1);
+  scache->byte_budget = byte_budget;
+
+  return (scache);
+}  /* end gap_story_render_scache_new */
+
+
+/* ----------------------------------------------------
+ * p_free_elem
+ * ----------------------------------------------------
+ */
+static void
+p_free_elem(GapStoryRenderScaledSourceElem *selem)
+{
+  g_free(selem->filename);
+  gap_story_render_buffer_free(selem->pbuf);
+  g_free(selem);
+}  /* end p_free_elem */
+
+
+/* ----------------------------------------------------
+ * gap_story_render_scache_free
+ * ----------------------------------------------------
+ */
+void
+gap_story_render_scache_free(GapStoryRenderScaledSourceCache *scache)
+{
+  GapStoryRenderScaledSourceElem *selem;
+  GapStoryRenderScaledSourceElem *selem_next;
+
+  if(scache == NULL)
+  {
+    return;
+  }
+  for(selem = scache->lru_first; selem != NULL; selem = selem_next)
+  {
+    selem_next = selem->next;
+    p_free_elem(selem);
+  }
+  g_free(scache);
+}  /* end gap_story_render_scache_free */
+
+
+/* ----------------------------------------------------
+ * p_unlink_elem
+ * ----------------------------------------------------
+ */
+static void
+p_unlink_elem(GapStoryRenderScaledSourceCache *scache, GapStoryRenderScaledSourceElem *selem)
+{
+  if(selem->prev != NULL)
+  {
+    selem->prev->next = selem->next;
+  }
+  else
+  {
+    scache->lru_first = selem->next;
+  }
+  if(selem->next != NULL)
+  {
+    selem->next->prev = selem->prev;
+  }
+  else
+  {
+    scache->lru_last = selem->prev;
+  }
+  selem->prev = NULL;
+  selem->next = NULL;
+}  /* end p_unlink_elem */
+
+
+/* ----------------------------------------------------
+ * p_link_elem_as_first
+ * ----------------------------------------------------
+ */
+static void
+p_link_elem_as_first(GapStoryRenderScaledSourceCache *scache, GapStoryRenderScaledSourceElem *selem)
+{
+  selem->prev = NULL;
+  selem->next = scache->lru_first;
+  if(scache->lru_first != NULL)
+  {
+    scache->lru_first->prev = selem;
+  }
+  scache->lru_first = selem;
+  if(scache->lru_last == NULL)
+  {
+    scache->lru_last = selem;
+  }
+}  /* end p_link_elem_as_first */
+
+
+/* ----------------------------------------------------
+ * p_find_elem
+ * ----------------------------------------------------
+ * width and height 0 match any size,
+ * negative width and height (size unknown) match no element.
+ */
+static GapStoryRenderScaledSourceElem *
+p_find_elem(GapStoryRenderScaledSourceCache *scache
+  , const char *filename, time_t mtime
+  , gint32 width, gint32 height, gint32 interpolation)
+{
+  GapStoryRenderScaledSourceElem *selem;
+
+  for(selem = scache->lru_first; selem != NULL; selem = selem->next)
+  {
+    if((selem->mtime != mtime)
+    || (strcmp(selem->filename, filename) != 0))
+    {
+      continue;
+    }
+    if((width == 0) && (height == 0))
+    {
+      return (selem);
+    }
+    if((selem->pbuf->width == width)
+    && (selem->pbuf->height == height)
+    && (selem->interpolation == interpolation))
+    {
+      return (selem);
+    }
+  }
+  return (NULL);
+
+}  /* end p_find_elem */
+
+
+/* ----------------------------------------------------
+ * gap_story_render_scache_get_orig_size
+ * ----------------------------------------------------
+ * deliver the unscaled size of the specified source image
+ * in case any scaled variant of it is in the cache.
+ * (the caller needs the original size to calculate the scaled size for the lookup)
+ */
+gboolean
+gap_story_render_scache_get_orig_size(GapStoryRenderScaledSourceCache *scache
+  , const char *filename
+  , time_t mtime
+  , gint32 *orig_width
+  , gint32 *orig_height
+  )
+{
+  GapStoryRenderScaledSourceElem *selem;
+
+  if((scache == NULL) || (filename == NULL))
+  {
+    return (FALSE);
+  }
+  selem = p_find_elem(scache, filename, mtime, 0, 0, 0);
+  if(selem == NULL)
+  {
+    return (FALSE);
+  }
+  *orig_width = selem->orig_width;
+  *orig_height = selem->orig_height;
+  return (TRUE);
+
+}  /* end gap_story_render_scache_get_orig_size */
+
+
+/* ----------------------------------------------------
+ * gap_story_render_scache_lookup
+ * ----------------------------------------------------
+ * returns the cached pixel buffer of the specified source image
+ * at the specified scaled size or NULL if not cached.
+ * This is the only place where hits and misses are counted.
+ * The returned buffer is owned by the cache, it stays valid until
+ * the next call of gap_story_render_scache_store or gap_story_render_scache_free.
+ */
+GapStoryRenderPixelBuffer *
+gap_story_render_scache_lookup(GapStoryRenderScaledSourceCache *scache
+  , const char *filename
+  , time_t mtime
+  , gint32 width
+  , gint32 height
+  , gint32 interpolation
+  )
+{
+  GapStoryRenderScaledSourceElem *selem;
+
+  if((scache == NULL) || (filename == NULL))
+  {
+    return (NULL);
+  }
+
+  selem = p_find_elem(scache, filename, mtime, width, height, interpolation);
+  if(selem == NULL)
+  {
+    scache->misses++;
+    return (NULL);
+  }
+
+  scache->hits++;
+  if(selem != scache->lru_first)
+  {
+    p_unlink_elem(scache, selem);
+    p_link_elem_as_first(scache, selem);
+  }
+  if(gap_debug)
+  {
+    printf("gap_story_render_scache_lookup: HIT (%dx%d) %s\n"
+      , (int)width
+      , (int)height
+      , filename
+      );
+  }
+  return (selem->pbuf);
+
+}  /* end gap_story_render_scache_lookup */
+
+
+/* ----------------------------------------------------
+ * gap_story_render_scache_store
+ * ----------------------------------------------------
+ * add the scaled pixel buffer pbuf as new cache element.
+ * the cache takes the ownership of pbuf.
+ * least recently used elements are removed until the byte budget fits.
+ */
+void
+gap_story_render_scache_store(GapStoryRenderScaledSourceCache *scache
+  , const char *filename
+  , time_t mtime
+  , gint32 interpolation
+  , gint32 orig_width
+  , gint32 orig_height
+  , GapStoryRenderPixelBuffer *pbuf
+  )
+{
+  GapStoryRenderScaledSourceElem *selem;
+  gint64 bytes;
+
+  if((scache == NULL) || (filename == NULL) || (pbuf == NULL))
+  {
+    gap_story_render_buffer_free(pbuf);
+    return;
+  }
+
+  bytes = (gint64)pbuf->rowstride * (gint64)pbuf->height;
+  if(bytes > scache->byte_budget)
+  {
+    gap_story_render_buffer_free(pbuf);
+    return;
+  }
+
+  /* replace an existing element with the same key */
+  selem = p_find_elem(scache, filename, mtime, pbuf->width, pbuf->height, interpolation);
+  if(selem != NULL)
+  {
+    p_unlink_elem(scache, selem);
+    scache->bytes_used -= selem->bytes;
+    scache->numElems--;
+    p_free_elem(selem);
+  }
+
+  while((scache->lru_last != NULL)
+  &&    (scache->bytes_used + bytes > scache->byte_budget))
+  {
+    selem = scache->lru_last;
+    p_unlink_elem(scache, selem);
+    scache->bytes_used -= selem->bytes;
+    scache->numElems--;
+    scache->evictions++;
+    if(gap_debug)
+    {
+      printf("gap_story_render_scache_store: EVICT (%dx%d) %s\n"
+        , (int)selem->pbuf->width
+        , (int)selem->pbuf->height
+        , selem->filename
+        );
+    }
+    p_free_elem(selem);
+  }
+
+  selem = g_new0(GapStoryRenderScaledSourceElem, 1);
+  selem->filename = g_strdup(filename);
+  selem->mtime = mtime;
+  selem->interpolation = interpolation;
+  selem->orig_width = orig_width;
+  selem->orig_height = orig_height;
+  selem->pbuf = pbuf;
+  selem->bytes = bytes;
+  p_link_elem_as_first(scache, selem);
+  scache->bytes_used += bytes;
+  scache->numElems++;
+  scache->stores++;
+
+}  /* end gap_story_render_scache_store */
+
+
+/* ----------------------------------------------------
+ * gap_story_render_scache_print_statistics
+ * ----------------------------------------------------
+ */
+void
+gap_story_render_scache_print_statistics(GapStoryRenderScaledSourceCache *scache
+  , const char *cache_name
+  )
+{
+  if(scache == NULL)
+  {
+    return;
+  }
+  printf("STB %s: hits:%d misses:%d stores:%d evictions:%d"
+         " elements:%d bytes used:%.0f budget:%.0f\n"
+    , cache_name
+    , (int)scache->hits
+    , (int)scache->misses
+    , (int)scache->stores
+    , (int)scache->evictions
+    , (int)scache->numElems
+    , (gdouble)scache->bytes_used
+    , (gdouble)scache->byte_budget
+    );
+}  /* end gap_story_render_scache_print_statistics */
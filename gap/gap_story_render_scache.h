@@ -0,0 +1,105 @@
+/* gap_story_render_scache.h
+ *
+ *  GAP storyboard rendering processor.
+ *  scaled source cache (source images already scaled to the size
+ *  required for rendering, kept as pixel buffers for the render session)
+ *  the same cache type is used as layermask cache (gray mask frames
+ *  at the size of the target layer).
+ *
+ */
+
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026/10/18  agent: created
+ * version 2.8.xx;  2026/10/18  agent: used as layermask cache too
+ */
+
+#ifndef GAP_STORY_RENDER_SCACHE_H
+#define GAP_STORY_RENDER_SCACHE_H
+
+#include "libgimp/gimp.h"
+#include <time.h>
+#include "gap_story_render_buffer.h"
+
+#define GAP_GIMPRC_VIDEO_STORYBOARD_SCALED_SOURCE_CACHE_MB  "video-storyboard-scaled-source-cache-mb"
+#define GAP_STB_DEFAULT_SCALED_SOURCE_CACHE_MB              64
+#define GAP_GIMPRC_VIDEO_STORYBOARD_MASK_CACHE_MB           "video-storyboard-mask-cache-mb"
+#define GAP_STB_DEFAULT_MASK_CACHE_MB                       32
+
+
+typedef struct GapStoryRenderScaledSourceElem  /* nick: selem */
+{
+  gchar    *filename;             /* filename (or mask name and frame number for the layermask cache) */
+  time_t    mtime;
+  gint32    interpolation;
+  gint32    orig_width;           /* size of the unscaled source image */
+  gint32    orig_height;
+  GapStoryRenderPixelBuffer *pbuf; /* pixels at the scaled size (key width and height) */
+  gint64    bytes;
+
+  struct GapStoryRenderScaledSourceElem *prev;  /* more recently used */
+  struct GapStoryRenderScaledSourceElem *next;  /* less recently used */
+} GapStoryRenderScaledSourceElem;
+
+typedef struct GapStoryRenderScaledSourceCache  /* nick: scache */
+{
+  GapStoryRenderScaledSourceElem *lru_first;  /* most recently used */
+  GapStoryRenderScaledSourceElem *lru_last;   /* least recently used */
+  gint64    byte_budget;
+  gint64    bytes_used;
+  gint32    numElems;
+
+  /* statistics of the render session */
+  gint32    hits;
+  gint32    misses;
+  gint32    stores;
+  gint32    evictions;
+} GapStoryRenderScaledSourceCache;
+
+
+GapStoryRenderScaledSourceCache * gap_story_render_scache_new(gint64 byte_budget);
+void       gap_story_render_scache_free(GapStoryRenderScaledSourceCache *scache);
+
+gboolean   gap_story_render_scache_get_orig_size(GapStoryRenderScaledSourceCache *scache
+                 , const char *filename
+                 , time_t mtime
+                 , gint32 *orig_width
+                 , gint32 *orig_height
+                 );
+GapStoryRenderPixelBuffer * gap_story_render_scache_lookup(GapStoryRenderScaledSourceCache *scache
+                 , const char *filename
+                 , time_t mtime
+                 , gint32 width
+                 , gint32 height
+                 , gint32 interpolation
+                 );
+void       gap_story_render_scache_store(GapStoryRenderScaledSourceCache *scache
+                 , const char *filename
+                 , time_t mtime
+                 , gint32 interpolation
+                 , gint32 orig_width
+                 , gint32 orig_height
+                 , GapStoryRenderPixelBuffer *pbuf
+                 );
+void       gap_story_render_scache_print_statistics(GapStoryRenderScaledSourceCache *scache
+                 , const char *cache_name
+                 );
+
+#endif
@@ -0,0 +1,578 @@
+/* gap_story_render_segcache.c
+ *
+ *  GAP storyboard rendering processor.
+ *
+ *  This module is the segment cache for incremental encoding.
+ *  The output video is split into segments of a fixed number of frames.
+ *  For each segment the render processor calculates a hash of all storyboard
+ *  elements (and their source files) that contribute to the frames of the segment.
+ *  The hashes of a complete encode are stored in the file <videoname>.segcache.
+ *  At the next encode of the same video, the output video of the previous encode
+ *  is renamed and the frames of all segments with unchanged hash are copied
+ *  from there as compressed chunks (via the lossless chunk copy of the encoders)
+ *  instead of rendering and encoding them again.
+ *
+ *  The encoder must write a keyframe at the start of each segment
+ *  and at the 1st encoded frame after copied frames
+ *  (see gap_story_render_segcache_force_keyframe), so that each segment
+ *  can be decoded independent of the frames of other segments.
+ *
+ *  Note: this module does not call the gimp PDB.
+ */
+
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026/10/19  agent: created
+ */
+
+#include <config.h>
+
+/* SYTEM (UNIX) includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* GIMP includes */
+#include "libgimp/gimp.h"
+#include <glib/gstdio.h>
+
+/* GAP includes */
+#include "gap_story_render_segcache.h"
+
+
+extern int gap_debug;  /* 1 == print debug infos , 0 dont print debug infos */
+
+#define SEGCACHE_FILE_MAGIC     "GAP-SEGMENT-CACHE 1"
+#define SEGCACHE_LINE_SIZE      4096
+
+/* FNV-1a 64 bit */
+#define SEGCACHE_HASH_OFFSET    G_GUINT64_CONSTANT(14695981039346656037)
+#define SEGCACHE_HASH_PRIME     G_GUINT64_CONSTANT(1099511628211)
+
+static gchar *    p_prev_videofile_name(const char *videoname);
+static guint64 *  p_load_cachefile(GapStoryRenderSegmentCache *segc, gint32 *numSegments);
+static gint32     p_segment_index(GapStoryRenderSegmentCache *segc, gint32 master_frame_nr);
+
+
+/* --------------------------------
+ * gap_story_render_segcache_hash_bytes
+ * --------------------------------
+ * continue the hash with len bytes of data.
+ * (start with hash value 0)
+ */
+guint64
+gap_story_render_segcache_hash_bytes(guint64 hash, gconstpointer data, gsize len)
+{
+  const guchar *ptr;
+  gsize         ii;
+
+  if(hash == 0)
+  {
+    hash = SEGCACHE_HASH_OFFSET;
+  }
+  ptr = (const guchar *)data;
+  for(ii = 0; ii < len; ii++)
+  {
+    hash ^= ptr[ii];
+    hash *= SEGCACHE_HASH_PRIME;
+  }
+  return (hash);
+
+}  /* end gap_story_render_segcache_hash_bytes */
+
+
+/* --------------------------------
+ * gap_story_render_segcache_hash_string
+ * --------------------------------
+ * continue the hash with the string including the terminating 0
+ * (NULL is hashed different from an empty string)
+ */
+guint64
+gap_story_render_segcache_hash_string(guint64 hash, const char *str)
+{
+  if(str == NULL)
+  {
+    guchar nullMarker = 0xff;
+
+    return (gap_story_render_segcache_hash_bytes(hash, &nullMarker, 1));
+  }
+  return (gap_story_render_segcache_hash_bytes(hash, str, strlen(str) + 1));
+
+}  /* end gap_story_render_segcache_hash_string */
+
+
+/* --------------------------------
+ * p_prev_videofile_name
+ * --------------------------------
+ * name for the renamed output video of the previous encode
+ * (the extension is kept for the decoder detection)
+ */
+static gchar *
+p_prev_videofile_name(const char *videoname)
+{
+  const char *ext;
+  const char *base;
+
+  base = strrchr(videoname, G_DIR_SEPARATOR);
+  if(base == NULL)
+  {
+    base = videoname;
+  }
+  ext = strrchr(base, '.');
+  if(ext == NULL)
+  {
+    return (g_strdup_printf("%s%s", videoname, GAP_STB_SEGCACHE_PREV_VIDEO_INFIX));
+  }
+  return (g_strdup_printf("%.*s%s%s"
+                         , (int)(ext - videoname)
+                         , videoname
+                         , GAP_STB_SEGCACHE_PREV_VIDEO_INFIX
+                         , ext
+                         ));
+
+}  /* end p_prev_videofile_name */
+
+
+/* --------------------------------
+ * p_load_cachefile
+ * --------------------------------
+ * read the segment hashes of the previous encode.
+ * returns NULL if there is no cachefile or if it was written
+ * with other settings, first frame or segment size.
+ */
+static guint64 *
+p_load_cachefile(GapStoryRenderSegmentCache *segc, gint32 *numSegments)
+{
+  FILE    *fp;
+  gchar   *line;
+  guint64 *oldHashes;
+  gint32   firstFrameNr;
+  gint32   segmentFrames;
+  gint32   ii;
+  gboolean ok;
+
+  *numSegments = 0;
+  fp = g_fopen(segc->cachefile, "r");
+  if(fp == NULL)
+  {
+    return (NULL);
+  }
+
+  line = g_malloc(SEGCACHE_LINE_SIZE);
+  oldHashes = NULL;
+  ok = FALSE;
+  firstFrameNr = -1;
+  segmentFrames = -1;
+
+  if((fgets(line, SEGCACHE_LINE_SIZE, fp) != NULL)
+  && (strncmp(line, SEGCACHE_FILE_MAGIC, strlen(SEGCACHE_FILE_MAGIC)) == 0)
+  && (fgets(line, SEGCACHE_LINE_SIZE, fp) != NULL)
+  && (strncmp(line, "settings ", 9) == 0))
+  {
+    g_strchomp(line);
+    ok = (strcmp(&line[9], segc->settings) == 0);
+  }
+  if(ok)
+  {
+    ok = ((fgets(line, SEGCACHE_LINE_SIZE, fp) != NULL)
+       && (sscanf(line, "first_frame %d", &firstFrameNr) == 1)
+       && (fgets(line, SEGCACHE_LINE_SIZE, fp) != NULL)
+       && (sscanf(line, "segment_frames %d", &segmentFrames) == 1)
+       && (fgets(line, SEGCACHE_LINE_SIZE, fp) != NULL)
+       && (sscanf(line, "segments %d", numSegments) == 1)
+       && (firstFrameNr == segc->firstFrameNr)
+       && (segmentFrames == segc->segmentFrames)
+       && (*numSegments > 0));
+  }
+  if(ok)
+  {
+    oldHashes = g_new0(guint64, *numSegments);
+    for(ii = 0; ii < *numSegments; ii++)
+    {
+      gchar *endptr;
+
+      if(fgets(line, SEGCACHE_LINE_SIZE, fp) == NULL)
+      {
+        break;
+      }
+      oldHashes[ii] = g_ascii_strtoull(line, &endptr, 16);
+      if(endptr == line)
+      {
+        break;
+      }
+    }
+    /* a truncated file can only be used up to the last complete line */
+    *numSegments = ii;
+  }
+  else
+  {
+    *numSegments = 0;
+    if(gap_debug)
+    {
+      printf("p_load_cachefile: %s does not match the current encoder settings\n"
+        , segc->cachefile
+        );
+    }
+  }
+
+  g_free(line);
+  fclose(fp);
+  return (oldHashes);
+
+}  /* end p_load_cachefile */
+
+
+/* --------------------------------
+ * gap_story_render_segcache_new
+ * --------------------------------
+ * create the segment cache for an encode of numFrames frames starting at firstFrameNr.
+ * The hashes (one per segment) are calculated by the caller,
+ * the segment cache takes the ownership of the hashes array.
+ * If allowReuse is TRUE and the cachefile of the previous encode matches
+ * the settings, the unchanged segments are marked as reusable and the
+ * existing output video is renamed (it is the source of the copied frames).
+ * Must be called before the encoder creates the output video.
+ */
+GapStoryRenderSegmentCache *
+gap_story_render_segcache_new(const char *videoname
+  , const char *settings
+  , gint32 segmentFrames
+  , gint32 firstFrameNr
+  , gint32 numFrames
+  , guint64 *hashes
+  , gboolean allowReuse
+  )
+{
+  GapStoryRenderSegmentCache *segc;
+  guint64 *oldHashes;
+  gint32   oldNumSegments;
+  gint32   ii;
+
+  segc = g_new0(GapStoryRenderSegmentCache, 1);
+  segc->videoname = g_strdup(videoname);
+  segc->cachefile = g_strdup_printf("%s%s", videoname, GAP_STB_SEGCACHE_EXTENSION);
+  segc->settings = g_strdup(settings);
+  segc->segmentFrames = MAX(1, segmentFrames);
+  segc->firstFrameNr = firstFrameNr;
+  segc->numFrames = numFrames;
+  segc->numSegments = (numFrames + segc->segmentFrames - 1) / segc->segmentFrames;
+  segc->hashes = hashes;
+  segc->reusable = g_new0(gboolean, MAX(1, segc->numSegments));
+
+  oldHashes = p_load_cachefile(segc, &oldNumSegments);
+
+  /* the cachefile is written again after the encode is complete.
+   * (an interrupted encode must not leave a cachefile that refers to
+   * an incomplete video)
+   */
+  g_remove(segc->cachefile);
+
+  if((allowReuse)
+  && (oldHashes != NULL)
+  && (g_file_test(videoname, G_FILE_TEST_IS_REGULAR)))
+  {
+    for(ii = 0; ii < segc->numSegments; ii++)
+    {
+      if((ii < oldNumSegments)
+      && (oldHashes[ii] == segc->hashes[ii]))
+      {
+        segc->reusable[ii] = TRUE;
+        segc->segmentsReusable++;
+      }
+    }
+
+    if(segc->segmentsReusable > 0)
+    {
+      gchar *prevVideofile;
+
+      prevVideofile = p_prev_videofile_name(videoname);
+      g_remove(prevVideofile);
+      if(g_rename(videoname, prevVideofile) == 0)
+      {
+        segc->prevVideofile = prevVideofile;
+      }
+      else
+      {
+        printf("segment cache: could not rename %s to %s (no segments are reused)\n"
+          , videoname
+          , prevVideofile
+          );
+        g_free(prevVideofile);
+        memset(segc->reusable, 0, segc->numSegments * sizeof(gboolean));
+        segc->segmentsReusable = 0;
+      }
+    }
+  }
+  g_free(oldHashes);
+
+  if(gap_debug)
+  {
+    printf("gap_story_render_segcache_new: %s segments:%d segmentFrames:%d reusable:%d prev:%s\n"
+      , segc->cachefile
+      , (int)segc->numSegments
+      , (int)segc->segmentFrames
+      , (int)segc->segmentsReusable
+      , (segc->prevVideofile != NULL) ? segc->prevVideofile : "(none)"
+      );
+  }
+  return (segc);
+
+}  /* end gap_story_render_segcache_new */
+
+
+/* --------------------------------
+ * p_segment_index
+ * --------------------------------
+ * returns the index of the segment of master_frame_nr (-1 if out of range)
+ */
+static gint32
+p_segment_index(GapStoryRenderSegmentCache *segc, gint32 master_frame_nr)
+{
+  gint32 offset;
+
+  offset = master_frame_nr - segc->firstFrameNr;
+  if((offset < 0) || (offset >= segc->numFrames))
+  {
+    return (-1);
+  }
+  return (offset / segc->segmentFrames);
+
+}  /* end p_segment_index */
+
+
+/* --------------------------------
+ * gap_story_render_segcache_fetch_chunk
+ * --------------------------------
+ * fetch the frame at master_frame_nr as compressed chunk from the output video
+ * of the previous encode if its segment is unchanged.
+ * *keyframe is set TRUE for the 1st frame of the segment.
+ * returns FALSE if the frame must be rendered.
+ * (a failed fetch disables the reuse for the rest of the segment)
+ */
+gboolean
+gap_story_render_segcache_fetch_chunk(GapStoryRenderSegmentCache *segc
+  , gint32 master_frame_nr
+  , unsigned char *video_frame_chunk_data
+  , gint32 *video_frame_chunk_size
+  , gint32 video_frame_chunk_maxsize
+  , gboolean *keyframe
+  )
+{
+  gint32 segIdx;
+
+  *keyframe = FALSE;
+  if(segc == NULL)
+  {
+    return (FALSE);
+  }
+  segIdx = p_segment_index(segc, master_frame_nr);
+  if((segIdx < 0) || (segc->reusable[segIdx] != TRUE))
+  {
+    return (FALSE);
+  }
+
+#ifdef GAP_ENABLE_VIDEOAPI_SUPPORT
+  if((segc->gvahand == NULL)
+  && (segc->gvahandFailed != TRUE))
+  {
+    segc->gvahand = GVA_open_read(segc->prevVideofile, 1 /* vid_track */, 1 /* aud_track */);
+    if(segc->gvahand != NULL)
+    {
+      if(GVA_has_video_chunk_proc(segc->gvahand) != TRUE)
+      {
+        GVA_close(segc->gvahand);
+        segc->gvahand = NULL;
+      }
+    }
+    if(segc->gvahand == NULL)
+    {
+      printf("segment cache: %s can not be read as compressed chunks (all segments are encoded)\n"
+        , segc->prevVideofile
+        );
+      segc->gvahandFailed = TRUE;
+    }
+  }
+
+  if(segc->gvahand != NULL)
+  {
+    t_GVA_RetCode  l_fcr;
+
+    l_fcr = GVA_get_video_chunk(segc->gvahand
+                               , 1 + (master_frame_nr - segc->firstFrameNr)
+                               , video_frame_chunk_data
+                               , video_frame_chunk_size
+                               , video_frame_chunk_maxsize
+                               );
+    if((l_fcr == GVA_RET_OK)
+    && (*video_frame_chunk_size > 0))
+    {
+      *keyframe = (((master_frame_nr - segc->firstFrameNr) % segc->segmentFrames) == 0);
+      segc->lastWasCopy = TRUE;
+      segc->framesCopied++;
+      segc->framesHandled++;
+      return (TRUE);
+    }
+  }
+#endif
+
+  segc->copyFailures++;
+  segc->reusable[segIdx] = FALSE;
+  *video_frame_chunk_size = 0;
+  if(gap_debug)
+  {
+    printf("gap_story_render_segcache_fetch_chunk: copy failed at master_frame_nr:%d segment:%d\n"
+      , (int)master_frame_nr
+      , (int)segIdx
+      );
+  }
+  return (FALSE);
+
+}  /* end gap_story_render_segcache_fetch_chunk */
+
+
+/* --------------------------------
+ * gap_story_render_segcache_force_keyframe
+ * --------------------------------
+ * must be called for each frame that was not copied by the segment cache.
+ * returns TRUE if the encoder must write this frame as keyframe
+ * (at segment start and at the 1st frame after copied frames)
+ */
+gboolean
+gap_story_render_segcache_force_keyframe(GapStoryRenderSegmentCache *segc
+  , gint32 master_frame_nr
+  )
+{
+  gboolean forceKeyframe;
+
+  if(segc == NULL)
+  {
+    return (FALSE);
+  }
+  segc->framesRendered++;
+  segc->framesHandled++;
+  forceKeyframe = ((segc->lastWasCopy)
+                || (((master_frame_nr - segc->firstFrameNr) % segc->segmentFrames) == 0));
+  segc->lastWasCopy = FALSE;
+
+  return (forceKeyframe);
+
+}  /* end gap_story_render_segcache_force_keyframe */
+
+
+/* --------------------------------
+ * gap_story_render_segcache_save
+ * --------------------------------
+ * write the segment hashes to the cachefile
+ * (only if all frames of the video were handled)
+ */
+void
+gap_story_render_segcache_save(GapStoryRenderSegmentCache *segc)
+{
+  FILE   *fp;
+  gint32  ii;
+
+  if(segc == NULL)
+  {
+    return;
+  }
+  if(segc->framesHandled < segc->numFrames)
+  {
+    printf("segment cache: encode incomplete (%d of %d frames), %s not written\n"
+      , (int)segc->framesHandled
+      , (int)segc->numFrames
+      , segc->cachefile
+      );
+    return;
+  }
+
+  fp = g_fopen(segc->cachefile, "w");
+  if(fp == NULL)
+  {
+    printf("segment cache: could not write %s\n", segc->cachefile);
+    return;
+  }
+  fprintf(fp, "%s\n", SEGCACHE_FILE_MAGIC);
+  fprintf(fp, "settings %s\n", segc->settings);
+  fprintf(fp, "first_frame %d\n", (int)segc->firstFrameNr);
+  fprintf(fp, "segment_frames %d\n", (int)segc->segmentFrames);
+  fprintf(fp, "segments %d\n", (int)segc->numSegments);
+  for(ii = 0; ii < segc->numSegments; ii++)
+  {
+    fprintf(fp, "%016" G_GINT64_MODIFIER "x\n", segc->hashes[ii]);
+  }
+  fclose(fp);
+
+}  /* end gap_story_render_segcache_save */
+
+
+/* --------------------------------
+ * gap_story_render_segcache_print_statistics
+ * --------------------------------
+ */
+void
+gap_story_render_segcache_print_statistics(GapStoryRenderSegmentCache *segc)
+{
+  if(segc == NULL)
+  {
+    return;
+  }
+  printf("segment cache: segments:%d (%d frames) unchanged:%d frames copied:%d encoded:%d copy failures:%d\n"
+    , (int)segc->numSegments
+    , (int)segc->segmentFrames
+    , (int)segc->segmentsReusable
+    , (int)segc->framesCopied
+    , (int)segc->framesRendered
+    , (int)segc->copyFailures
+    );
+
+}  /* end gap_story_render_segcache_print_statistics */
+
+
+/* --------------------------------
+ * gap_story_render_segcache_free
+ * --------------------------------
+ * closes and removes the renamed output video of the previous encode
+ */
+void
+gap_story_render_segcache_free(GapStoryRenderSegmentCache *segc)
+{
+  if(segc == NULL)
+  {
+    return;
+  }
+#ifdef GAP_ENABLE_VIDEOAPI_SUPPORT
+  if(segc->gvahand != NULL)
+  {
+    GVA_close(segc->gvahand);
+  }
+#endif
+  if(segc->prevVideofile != NULL)
+  {
+    g_remove(segc->prevVideofile);
+    g_free(segc->prevVideofile);
+  }
+  g_free(segc->videoname);
+  g_free(segc->cachefile);
+  g_free(segc->settings);
+  g_free(segc->hashes);
+  g_free(segc->reusable);
+  g_free(segc);
+
+}  /* end gap_story_render_segcache_free */
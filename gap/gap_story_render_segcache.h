@@ -0,0 +1,94 @@
+/* gap_story_render_segcache.h
+ *
+ *  GAP storyboard rendering processor.
+ *  segment cache for incremental encoding
+ *  (reuse of unchanged segments of the previously encoded video)
+ *
+ */
+
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026/10/19  agent: created
+ */
+
+#ifndef GAP_STORY_RENDER_SEGCACHE_H
+#define GAP_STORY_RENDER_SEGCACHE_H
+
+#include "libgimp/gimp.h"
+#include "gap_vid_api.h"
+
+#define GAP_GIMPRC_VIDEO_ENCODER_INCREMENTAL_SEGMENT_FRAMES  "video-encoder-incremental-segment-frames"
+#define GAP_STB_DEFAULT_INCREMENTAL_SEGMENT_FRAMES           0      /* 0 disables incremental encoding */
+#define GAP_STB_SEGCACHE_EXTENSION                           ".segcache"
+#define GAP_STB_SEGCACHE_PREV_VIDEO_INFIX                    "_segprev"
+
+
+typedef struct GapStoryRenderSegmentCache  /* nick: segc */
+{
+  gchar        *videoname;
+  gchar        *cachefile;          /* <videoname>.segcache holds the segment hashes of the last complete encode */
+  gchar        *prevVideofile;      /* output video of the last encode (source of reused chunks), NULL if nothing to reuse */
+  gchar        *settings;           /* encoder settings (segments are reused only if the settings are equal) */
+  gint32        segmentFrames;
+  gint32        firstFrameNr;       /* master frame number of the 1st frame of the 1st segment */
+  gint32        numFrames;
+  gint32        numSegments;
+  guint64      *hashes;             /* hash of the storyboard elements contributing to each segment */
+  gboolean     *reusable;           /* TRUE: segment is unchanged and is copied from prevVideofile */
+
+  t_GVA_Handle *gvahand;            /* reader for prevVideofile (opened at the 1st copied frame) */
+  gboolean      gvahandFailed;
+  gboolean      lastWasCopy;        /* the previous frame was copied (the next encoded frame must be a keyframe) */
+  gint32        framesHandled;
+
+  /* statistics */
+  gint32        segmentsReusable;
+  gint32        framesCopied;
+  gint32        framesRendered;
+  gint32        copyFailures;
+} GapStoryRenderSegmentCache;
+
+
+guint64    gap_story_render_segcache_hash_bytes(guint64 hash, gconstpointer data, gsize len);
+guint64    gap_story_render_segcache_hash_string(guint64 hash, const char *str);
+
+GapStoryRenderSegmentCache * gap_story_render_segcache_new(const char *videoname
+                 , const char *settings
+                 , gint32 segmentFrames
+                 , gint32 firstFrameNr
+                 , gint32 numFrames
+                 , guint64 *hashes
+                 , gboolean allowReuse
+                 );
+gboolean   gap_story_render_segcache_fetch_chunk(GapStoryRenderSegmentCache *segc
+                 , gint32 master_frame_nr
+                 , unsigned char *video_frame_chunk_data
+                 , gint32 *video_frame_chunk_size
+                 , gint32 video_frame_chunk_maxsize
+                 , gboolean *keyframe
+                 );
+gboolean   gap_story_render_segcache_force_keyframe(GapStoryRenderSegmentCache *segc
+                 , gint32 master_frame_nr
+                 );
+void       gap_story_render_segcache_save(GapStoryRenderSegmentCache *segc);
+void       gap_story_render_segcache_print_statistics(GapStoryRenderSegmentCache *segc);
+void       gap_story_render_segcache_free(GapStoryRenderSegmentCache *segc);
+
+#endif
@@ -396,6 +396,20 @@ typedef struct GapStoryRenderVidHandle  /* nick: vidhand */
   gboolean      isLogResourceUsage;      /* triggers logging of resources (open videohandles an cached images) */
   gint32        resourceLogInterval;
   gboolean      isMultithreadEnabled;    /* triggers prefetch of videoframes via thread pool parallel processing */
+  gboolean      isParallelTrackFetchEnabled; /* triggers parallel preload of the images of all tracks */
+  gboolean      isBufferCompositingEnabled;  /* compose rgb888 frames in memory buffers (without gimp layers) where possible */
+  gint32        bufferCompositingThreads;    /* number of threads for the buffer based compositing */
+  struct GapStoryRenderScaledSourceCache *scache;  /* scaled source cache of the render session (NULL if disabled) */
+  struct GapStoryRenderScaledSourceCache *mask_cache;  /* layermask cache of the render session (NULL if disabled) */
+  struct GapStoryRenderSegmentCache *segcache;  /* segment cache for incremental encoding (NULL if disabled) */
+
+  /* GVA video handle pool statistics (to diagnose storyboards that exceed
+   * the limit video-storyboard-max-open-videofiles)
+   */
+  gint32        gvahandOpenCount;        /* number of GVA_open_read calls */
+  gint32        gvahandReopenCount;      /* number of opens for a pool key that was closed due to the limit */
+  gint32        gvahandLimitCloseCount;  /* number of handles closed due to the limit */
+  GHashTable   *gvahandClosedKeys;       /* pool keys of handles closed due to the limit (NULL if none) */
   
 } GapStoryRenderVidHandle;  /* used for storyboard processing */
 
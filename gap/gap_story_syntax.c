@@ -23,6 +23,7 @@
  */
 
 /* revision history:
+ * version 2.8.xx;     2026/10/18  agent: lookup record keys via hash table
  * version 2.1.0a;     2004/04/24  hof: created
  */
 
@@ -47,10 +48,12 @@ typedef struct GapStbSyntaxElem {
 
 
 static GapStbSyntaxElem  *global_syntax_par_list = NULL;
+static GHashTable        *global_syntax_hash = NULL;   /* record_key -> GapStbSyntaxElem */
 
 static void  p_add_keyword(const char *record_key
               , ...
               );
+static GapStbSyntaxElem * p_find_syntax_elem(const char *record_key);
 static void  p_create_syntax_list(void);
 
 
@@ -75,6 +78,12 @@ p_add_keyword(const char *record_key
   sxpar_elem->next = global_syntax_par_list;
   global_syntax_par_list = sxpar_elem;
 
+  if(global_syntax_hash == NULL)
+  {
+    global_syntax_hash = g_hash_table_new(g_str_hash, g_str_equal);
+  }
+  g_hash_table_insert(global_syntax_hash, sxpar_elem->record_key, sxpar_elem);
+
   par_idx = 1;
 
   va_start (args, record_key);
@@ -95,6 +104,32 @@ p_add_keyword(const char *record_key
 }  /* end p_add_keyword */
 
 
+/* -------------------------------------
+ * p_find_syntax_elem
+ * -------------------------------------
+ * return the syntax element for the specified record_key
+ * or NULL if record_key is not a known keyword.
+ * (the parser calls this for each named parameter,
+ * therefore record keys are looked up in a hash table
+ * rather than via strcmp in the syntax list)
+ */
+static GapStbSyntaxElem *
+p_find_syntax_elem(const char *record_key)
+{
+  if(global_syntax_par_list == NULL)
+  {
+    p_create_syntax_list();
+  }
+
+  if(record_key == NULL)
+  {
+    return(NULL);
+  }
+
+  return ((GapStbSyntaxElem *)g_hash_table_lookup(global_syntax_hash, record_key));
+}  /* end p_find_syntax_elem */
+
+
 
 /* -------------------------------------
  * gap_stb_syntax_get_parname_idx
@@ -109,33 +144,24 @@ gap_stb_syntax_get_parname_idx(const char *record_key
                  )
 {
   GapStbSyntaxElem  *sp_elem;
+  GapStbSyntaxParElem *par;
 
-  if(global_syntax_par_list == NULL)
+  if(parname == NULL)
   {
-    p_create_syntax_list();
+    return(-1);
   }
 
-  if((record_key == NULL)
-  || (parname == NULL))
+  sp_elem = p_find_syntax_elem(record_key);
+  if(sp_elem == NULL)
   {
     return(-1);
   }
 
-
-  for(sp_elem = global_syntax_par_list; sp_elem != NULL; sp_elem = (GapStbSyntaxElem  *)sp_elem->next)
+  for(par=sp_elem->par_list; par != NULL; par = (GapStbSyntaxParElem *)par->next)
   {
-    if(strcmp(record_key, sp_elem->record_key) == 0)
+    if(strcmp(par->parname, parname) == 0)
     {
-      GapStbSyntaxParElem *par;
-
-      for(par=sp_elem->par_list; par != NULL; par = (GapStbSyntaxParElem *)par->next)
-      {
-        if(strcmp(par->parname, parname) == 0)
-        {
-          return(par->par_idx);
-        }
-      }
-      return(-1);
+      return(par->par_idx);
     }
   }
   return(-1);
@@ -156,33 +182,21 @@ gap_stb_syntax_get_parname(const char *record_key
                  )
 {
   GapStbSyntaxElem  *sp_elem;
+  GapStbSyntaxParElem *par;
 
-  if(global_syntax_par_list == NULL)
-  {
-    p_create_syntax_list();
-  }
-
-  if(record_key == NULL)
+  sp_elem = p_find_syntax_elem(record_key);
+  if(sp_elem == NULL)
   {
     return(NULL);
   }
 
-  for(sp_elem = global_syntax_par_list; sp_elem != NULL; sp_elem = (GapStbSyntaxElem  *)sp_elem->next)
+  for(par=sp_elem->par_list; par != NULL; par = (GapStbSyntaxParElem *)par->next)
   {
-    if(strcmp(record_key, sp_elem->record_key) == 0)
+    if(par->par_idx == par_idx)
     {
-      GapStbSyntaxParElem *par;
-
-      for(par=sp_elem->par_list; par != NULL; par = (GapStbSyntaxParElem *)par->next)
+      if(par->parname)
       {
-        if(par->par_idx == par_idx)
-        {
-          if(par->parname)
-          {
-            return(g_strdup(par->parname));
-          }
-          return(NULL);
-        }
+        return(g_strdup(par->parname));
       }
       return(NULL);
     }
@@ -201,31 +215,20 @@ gap_stb_syntax_get_parname_tab(const char *record_key
                  )
 {
   GapStbSyntaxElem  *sp_elem;
+  GapStbSyntaxParElem *par;
 
   par_tab->tabsize = 0;
-  if(global_syntax_par_list == NULL)
-  {
-    p_create_syntax_list();
-  }
 
-  if(record_key == NULL)
+  sp_elem = p_find_syntax_elem(record_key);
+  if(sp_elem == NULL)
   {
     return;
   }
 
-  for(sp_elem = global_syntax_par_list; sp_elem != NULL; sp_elem = (GapStbSyntaxElem  *)sp_elem->next)
+  for(par=sp_elem->par_list; par != NULL; par = (GapStbSyntaxParElem *)par->next)
   {
-    if(strcmp(record_key, sp_elem->record_key) == 0)
-    {
-      GapStbSyntaxParElem *par;
-
-      for(par=sp_elem->par_list; par != NULL; par = (GapStbSyntaxParElem *)par->next)
-      {
-        par_tab->parname[par->par_idx] = par->parname;
-        par_tab->tabsize++;
-      }
-      return;
-    }
+    par_tab->parname[par->par_idx] = par->parname;
+    par_tab->tabsize++;
   }
   return;
 }  /* end gap_stb_syntax_get_parname_tab */
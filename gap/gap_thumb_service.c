@@ -0,0 +1,578 @@
+/*  gap_thumb_service.c
+ *
+ *  GAP ... Gimp Animation Plugins
+ *
+ *  This module provides background creation of frame thumbnails
+ *  for the video navigator.
+ *  The thumbnail update of the navigator did load each frame via gimp
+ *  and saved its thumbnail on the GUI thread, the dialog was blocked
+ *  until all frames were processed.
+ *  The service creates thumbnails of frames in formats that
+ *  are readable by the GdkPixbuf loaders in a pool of worker threads
+ *  (requests for frames that are visible in the navigator first),
+ *  and hands the results back to the main thread where the navigator
+ *  renders each thumbnail as soon as it is available.
+ *
+ *  Note that the libgimp PDB interface is not thread save,
+ *  therefore the worker threads do not make any gimp calls.
+ *  Frames that only gimp can read (.xcf) are processed
+ *  one by one on the main thread via gap_thumb_service_process_gimp_request.
+ */
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026/10/18  agent: created
+ */
+
+#include "config.h"
+
+/* SYSTEM (UNIX) includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* GIMP includes */
+#include "libgimp/gimp.h"
+
+/* GAP includes */
+#include "gap_thumb_service.h"
+#include "gap_thumbnail.h"
+#include "gap_lib.h"
+#include "gap_pdb_calls.h"
+#include "gap_base.h"
+
+extern int gap_debug;
+
+/* internal status for frames that must be processed via gimp on the main thread */
+#define P_STATUS_NEEDS_GIMP  100
+
+typedef struct GapThumbServiceJob {
+  gint32     frame_nr;
+  gint32     priority;
+  gint32     seq;
+  gint       generation;
+  gboolean   force;
+  gchar     *filename;
+} GapThumbServiceJob;
+
+typedef struct GapThumbServiceResult {
+  gint32     frame_nr;
+  gint       generation;
+  gint32     status;
+} GapThumbServiceResult;
+
+typedef struct GapThumbServicePending {
+  gint32     priority;
+  gboolean   force;
+} GapThumbServicePending;
+
+
+static gint      p_job_compare(gconstpointer a, gconstpointer b, gpointer user_data);
+static void      p_push_job(GapThumbService *tsv, gint32 frame_nr, gint32 priority, gboolean force);
+static void      p_thumb_worker(GapThumbServiceJob *job, GapThumbService *tsv);
+static void      p_drain_results(GapThumbService *tsv);
+
+
+/* ---------------------------------
+ * p_job_compare
+ * ---------------------------------
+ * sort function for the thread pool queue:
+ * lower priority value first, FIFO order within the same priority.
+ */
+static gint
+p_job_compare(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  const GapThumbServiceJob *job_a;
+  const GapThumbServiceJob *job_b;
+
+  job_a = (const GapThumbServiceJob *)a;
+  job_b = (const GapThumbServiceJob *)b;
+
+  if(job_a->priority != job_b->priority)
+  {
+    return ((job_a->priority < job_b->priority) ? -1 : 1);
+  }
+  if(job_a->seq != job_b->seq)
+  {
+    return ((job_a->seq < job_b->seq) ? -1 : 1);
+  }
+  return (0);
+}  /* end p_job_compare */
+
+
+/* ---------------------------------
+ * p_push_job
+ * ---------------------------------
+ */
+static void
+p_push_job(GapThumbService *tsv, gint32 frame_nr, gint32 priority, gboolean force)
+{
+  GapThumbServiceJob *job;
+
+  job = g_new(GapThumbServiceJob, 1);
+  job->frame_nr = frame_nr;
+  job->priority = priority;
+  job->seq = tsv->seq++;
+  job->generation = g_atomic_int_get(&tsv->generation);
+  job->force = force;
+  job->filename = gap_lib_alloc_fname(tsv->basename, frame_nr, tsv->extension);
+
+  g_thread_pool_push(tsv->pool, job, NULL);
+
+}  /* end p_push_job */
+
+
+/* ---------------------------------
+ * p_thumb_worker
+ * ---------------------------------
+ * thread pool function, processes one request.
+ * requests of a cancelled generation are dropped without result.
+ */
+static void
+p_thumb_worker(GapThumbServiceJob *job, GapThumbService *tsv)
+{
+  GapThumbServiceResult *result;
+
+  if(job->generation == g_atomic_int_get(&tsv->generation))
+  {
+    result = g_new(GapThumbServiceResult, 1);
+    result->frame_nr = job->frame_nr;
+    result->generation = job->generation;
+
+    if(job->filename == NULL)
+    {
+      result->status = GAP_THUMB_SERVICE_STATUS_FAILED;
+    }
+    else if((!job->force)
+         && (gap_thumb_file_has_valid_thumbnail(job->filename, tsv->thumb_size)))
+    {
+      result->status = GAP_THUMB_SERVICE_STATUS_VALID;
+    }
+    else if(gap_thumb_file_create_thumbnail_via_pixbuf(job->filename, tsv->thumb_size))
+    {
+      result->status = GAP_THUMB_SERVICE_STATUS_DONE;
+    }
+    else if(g_file_test(job->filename, G_FILE_TEST_IS_REGULAR))
+    {
+      result->status = P_STATUS_NEEDS_GIMP;
+    }
+    else
+    {
+      result->status = GAP_THUMB_SERVICE_STATUS_FAILED;
+    }
+
+    if(gap_debug)
+    {
+      printf("p_thumb_worker: frame_nr:%d priority:%d status:%d\n"
+        , (int)job->frame_nr
+        , (int)job->priority
+        , (int)result->status
+        );
+    }
+    g_async_queue_push(tsv->results, result);
+  }
+
+  g_free(job->filename);
+  g_free(job);
+
+}  /* end p_thumb_worker */
+
+
+/* ---------------------------------
+ * p_drain_results
+ * ---------------------------------
+ */
+static void
+p_drain_results(GapThumbService *tsv)
+{
+  GapThumbServiceResult *result;
+
+  while((result = (GapThumbServiceResult *)g_async_queue_try_pop(tsv->results)) != NULL)
+  {
+    g_free(result);
+  }
+}  /* end p_drain_results */
+
+
+/* ---------------------------------
+ * gap_thumb_service_get_gimprc_threads
+ * ---------------------------------
+ * get the configured number of thumbnail worker threads
+ * (gimprc parameter video-navigator-thumbnail-threads,
+ * 0 turns the background thumbnail creation off)
+ */
+gint32
+gap_thumb_service_get_gimprc_threads(void)
+{
+  gint32 l_default;
+
+  l_default = MAX(2, gap_base_get_numProcessors());
+  return (gap_base_get_gimprc_int_value(GAP_GIMPRC_VIDEO_NAVIGATOR_THUMBNAIL_THREADS
+                                       , l_default
+                                       , 0
+                                       , GAP_THUMB_SERVICE_MAX_THREADS
+                                       ));
+}  /* end gap_thumb_service_get_gimprc_threads */
+
+
+/* ---------------------------------
+ * gap_thumb_service_new
+ * ---------------------------------
+ * create a thumbnail service for the frames basename<nr>extension.
+ * thumb_size: GIMP_THUMB_SIZE_NORMAL or GIMP_THUMB_SIZE_LARGE
+ *             (see gap_thumb_get_thumbnail_size)
+ *
+ * returns NULL if num_threads < 1 or in case thread support is not available.
+ * (the caller shall create the thumbnails synchronous in that case)
+ */
+GapThumbService *
+gap_thumb_service_new(const char *basename, const char *extension
+                     , gint32 thumb_size, gint32 num_threads)
+{
+  GapThumbService *tsv;
+  GError          *error = NULL;
+
+  if((num_threads < 1) || (basename == NULL) || (thumb_size <= 0))
+  {
+    return (NULL);
+  }
+  if(!gap_base_thread_init())
+  {
+    return (NULL);
+  }
+
+  /* libgimpthumb must be initialized before the workers use it */
+  gap_thumb_init();
+
+  tsv = g_new0(GapThumbService, 1);
+  tsv->basename = g_strdup(basename);
+  tsv->extension = g_strdup(extension);
+  tsv->thumb_size = thumb_size;
+  tsv->results = g_async_queue_new();
+  tsv->pending_hash = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+  tsv->gimp_queue = g_queue_new();
+  tsv->generation = 0;
+  tsv->seq = 0;
+
+  tsv->pool = g_thread_pool_new((GFunc)p_thumb_worker
+                               , tsv
+                               , MIN(num_threads, GAP_THUMB_SERVICE_MAX_THREADS)
+                               , FALSE     /* exclusive */
+                               , &error
+                               );
+  if(tsv->pool == NULL)
+  {
+    printf("gap_thumb_service_new: could not create thread pool %s\n"
+          , (error != NULL) ? error->message : ""
+          );
+    if(error != NULL)
+    {
+      g_error_free(error);
+    }
+    g_async_queue_unref(tsv->results);
+    g_hash_table_destroy(tsv->pending_hash);
+    g_queue_free(tsv->gimp_queue);
+    g_free(tsv->basename);
+    g_free(tsv->extension);
+    g_free(tsv);
+    return (NULL);
+  }
+  g_thread_pool_set_sort_function(tsv->pool, p_job_compare, NULL);
+
+  if(gap_debug)
+  {
+    printf("gap_thumb_service_new: basename:%s threads:%d thumb_size:%d\n"
+      , tsv->basename
+      , (int)num_threads
+      , (int)tsv->thumb_size
+      );
+  }
+
+  return (tsv);
+}  /* end gap_thumb_service_new */
+
+
+/* ---------------------------------
+ * gap_thumb_service_request
+ * ---------------------------------
+ * request thumbnail creation for frame_nr.
+ * priority: GAP_THUMB_SERVICE_PRIORITY_VISIBLE for frames that are visible
+ *           in the dialog, higher values for frames that are processed later.
+ * force:    FALSE create the thumbnail only if it is missing or outdated,
+ *           TRUE  always (re)create the thumbnail.
+ *
+ * a request for a frame that is already pending is only repeated
+ * when the new request has better priority (or force was not set before).
+ * returns TRUE if the request was queued.
+ */
+gboolean
+gap_thumb_service_request(GapThumbService *tsv, gint32 frame_nr
+                         , gint32 priority, gboolean force)
+{
+  GapThumbServicePending *pending;
+
+  if(tsv == NULL)
+  {
+    return (FALSE);
+  }
+
+  pending = (GapThumbServicePending *)g_hash_table_lookup(tsv->pending_hash
+                                                         , GINT_TO_POINTER(frame_nr));
+  if(pending != NULL)
+  {
+    if((priority >= pending->priority)
+    && ((force == FALSE) || (pending->force == TRUE)))
+    {
+      return (FALSE);
+    }
+    /* the older request stays queued, its result is ignored
+     * because the first result for the frame completes the request.
+     */
+    pending->priority = MIN(priority, pending->priority);
+    pending->force |= force;
+    p_push_job(tsv, frame_nr, pending->priority, pending->force);
+    return (TRUE);
+  }
+
+  if(g_queue_find(tsv->gimp_queue, GINT_TO_POINTER(frame_nr)) != NULL)
+  {
+    /* already waiting for processing via gimp */
+    return (FALSE);
+  }
+
+  pending = g_new(GapThumbServicePending, 1);
+  pending->priority = priority;
+  pending->force = force;
+  g_hash_table_insert(tsv->pending_hash, GINT_TO_POINTER(frame_nr), pending);
+  p_push_job(tsv, frame_nr, priority, force);
+
+  return (TRUE);
+}  /* end gap_thumb_service_request */
+
+
+/* ---------------------------------
+ * gap_thumb_service_raise_priority
+ * ---------------------------------
+ * raise the priority of an already pending request for frame_nr
+ * (typically called for frames that were scrolled into the visible area).
+ * frames that are not pending are ignored.
+ */
+void
+gap_thumb_service_raise_priority(GapThumbService *tsv, gint32 frame_nr, gint32 priority)
+{
+  GList *l_link;
+
+  if(tsv == NULL)
+  {
+    return;
+  }
+
+  if(g_hash_table_lookup(tsv->pending_hash, GINT_TO_POINTER(frame_nr)) != NULL)
+  {
+    gap_thumb_service_request(tsv, frame_nr, priority, FALSE);
+    return;
+  }
+
+  l_link = g_queue_find(tsv->gimp_queue, GINT_TO_POINTER(frame_nr));
+  if(l_link != NULL)
+  {
+    g_queue_delete_link(tsv->gimp_queue, l_link);
+    g_queue_push_head(tsv->gimp_queue, GINT_TO_POINTER(frame_nr));
+  }
+}  /* end gap_thumb_service_raise_priority */
+
+
+/* ---------------------------------
+ * gap_thumb_service_pop_result
+ * ---------------------------------
+ * fetch the next completed request without waiting.
+ * returns TRUE and sets frame_nr and status if a result was available.
+ * frames that must be processed via gimp are moved to the gimp queue
+ * and are not reported here.
+ */
+gboolean
+gap_thumb_service_pop_result(GapThumbService *tsv
+                            , gint32 *frame_nr, GapThumbServiceStatus *status)
+{
+  GapThumbServiceResult *result;
+
+  if(tsv == NULL)
+  {
+    return (FALSE);
+  }
+
+  while((result = (GapThumbServiceResult *)g_async_queue_try_pop(tsv->results)) != NULL)
+  {
+    gint32  l_frame_nr;
+    gint32  l_status;
+
+    l_frame_nr = result->frame_nr;
+    l_status = result->status;
+    if((result->generation != g_atomic_int_get(&tsv->generation))
+    || (g_hash_table_remove(tsv->pending_hash, GINT_TO_POINTER(l_frame_nr)) != TRUE))
+    {
+      /* result of a cancelled or of an already completed request */
+      g_free(result);
+      continue;
+    }
+    g_free(result);
+
+    if(l_status == P_STATUS_NEEDS_GIMP)
+    {
+      g_queue_push_tail(tsv->gimp_queue, GINT_TO_POINTER(l_frame_nr));
+      continue;
+    }
+
+    *frame_nr = l_frame_nr;
+    *status = l_status;
+    return (TRUE);
+  }
+
+  return (FALSE);
+}  /* end gap_thumb_service_pop_result */
+
+
+/* ----------------------------------------
+ * gap_thumb_service_process_gimp_request
+ * ----------------------------------------
+ * create the thumbnail for the next frame that can not be read
+ * without gimp (load via gimp and gimp_file_save_thumbnail).
+ * processes only one frame per call to keep the calling dialog responsive.
+ * returns TRUE and sets frame_nr and status if a frame was processed.
+ */
+gboolean
+gap_thumb_service_process_gimp_request(GapThumbService *tsv
+                                      , gint32 *frame_nr, GapThumbServiceStatus *status)
+{
+  gchar  *l_filename;
+  gint32  l_frame_nr;
+  gint32  l_image_id;
+
+  if(tsv == NULL)
+  {
+    return (FALSE);
+  }
+  if(g_queue_is_empty(tsv->gimp_queue))
+  {
+    return (FALSE);
+  }
+
+  l_frame_nr = GPOINTER_TO_INT(g_queue_pop_head(tsv->gimp_queue));
+  *frame_nr = l_frame_nr;
+  *status = GAP_THUMB_SERVICE_STATUS_FAILED;
+
+  l_filename = gap_lib_alloc_fname(tsv->basename, l_frame_nr, tsv->extension);
+  if(l_filename != NULL)
+  {
+    if(gap_debug)
+    {
+      printf("gap_thumb_service_process_gimp_request: frame_nr:%d\n", (int)l_frame_nr);
+    }
+    l_image_id = gap_lib_load_image(l_filename);
+    if(l_image_id >= 0)
+    {
+      if(gap_pdb_gimp_file_save_thumbnail(l_image_id, l_filename))
+      {
+        *status = GAP_THUMB_SERVICE_STATUS_DONE;
+      }
+      gimp_image_delete(l_image_id);
+    }
+    g_free(l_filename);
+  }
+
+  return (TRUE);
+}  /* end gap_thumb_service_process_gimp_request */
+
+
+/* ---------------------------------
+ * gap_thumb_service_is_busy
+ * ---------------------------------
+ * returns TRUE while requests are pending (in the workers or in the gimp queue)
+ */
+gboolean
+gap_thumb_service_is_busy(GapThumbService *tsv)
+{
+  if(tsv == NULL)
+  {
+    return (FALSE);
+  }
+  return ((g_hash_table_size(tsv->pending_hash) > 0)
+       || (!g_queue_is_empty(tsv->gimp_queue)));
+}  /* end gap_thumb_service_is_busy */
+
+
+/* ---------------------------------
+ * gap_thumb_service_cancel
+ * ---------------------------------
+ * drop all pending requests.
+ * requests that are already running in a worker thread complete,
+ * but their results are ignored.
+ */
+void
+gap_thumb_service_cancel(GapThumbService *tsv)
+{
+  if(tsv == NULL)
+  {
+    return;
+  }
+
+  g_atomic_int_inc(&tsv->generation);
+  g_hash_table_remove_all(tsv->pending_hash);
+  while(!g_queue_is_empty(tsv->gimp_queue))
+  {
+    g_queue_pop_head(tsv->gimp_queue);
+  }
+  p_drain_results(tsv);
+
+}  /* end gap_thumb_service_cancel */
+
+
+/* ---------------------------------
+ * gap_thumb_service_free
+ * ---------------------------------
+ * cancel all pending requests, wait until the worker threads
+ * have finished and free all resources.
+ */
+void
+gap_thumb_service_free(GapThumbService *tsv)
+{
+  if(tsv == NULL)
+  {
+    return;
+  }
+
+  gap_thumb_service_cancel(tsv);
+
+  /* the queued jobs of the cancelled generation are dropped
+   * immediately by the workers (and their memory is freed there)
+   */
+  g_thread_pool_free(tsv->pool
+                    , FALSE   /* immediate */
+                    , TRUE    /* wait */
+                    );
+  p_drain_results(tsv);
+  g_async_queue_unref(tsv->results);
+  g_hash_table_destroy(tsv->pending_hash);
+  g_queue_free(tsv->gimp_queue);
+
+  g_free(tsv->basename);
+  g_free(tsv->extension);
+  g_free(tsv);
+
+}  /* end gap_thumb_service_free */
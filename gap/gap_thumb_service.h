@@ -0,0 +1,91 @@
+/*  gap_thumb_service.h
+ *
+ *  GAP ... Gimp Animation Plugins
+ *
+ *  This module provides background creation of frame thumbnails
+ *  for the video navigator.
+ */
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026/10/18  agent: created
+ */
+
+#ifndef _GAP_THUMB_SERVICE_H
+#define _GAP_THUMB_SERVICE_H
+
+#include "libgimp/gimp.h"
+
+#define GAP_GIMPRC_VIDEO_NAVIGATOR_THUMBNAIL_THREADS  "video-navigator-thumbnail-threads"
+#define GAP_THUMB_SERVICE_MAX_THREADS                 16
+
+/* priority of requests for frames that are visible in the dialog
+ * (higher values are processed later)
+ */
+#define GAP_THUMB_SERVICE_PRIORITY_VISIBLE            0
+
+typedef enum GapThumbServiceStatus {
+   GAP_THUMB_SERVICE_STATUS_DONE          /* thumbnail was created */
+  ,GAP_THUMB_SERVICE_STATUS_VALID         /* thumbnail was already up to date */
+  ,GAP_THUMB_SERVICE_STATUS_FAILED        /* thumbnail could not be created */
+} GapThumbServiceStatus;
+
+/* a GapThumbService creates thumbnails of the frames basename<nr>extension.
+ *
+ * thumbnails of frames in formats that can be read by the GdkPixbuf loaders
+ * are created by a pool of worker threads, requests are processed in order
+ * of their priority (frames visible in the navigator first).
+ * Frames in formats that only gimp can read (.xcf) are passed back
+ * to the main thread, where gap_thumb_service_process_gimp_request
+ * creates one thumbnail per call via the gimp PDB.
+ *
+ * all gap_thumb_service procedures must be called from the main thread.
+ */
+typedef struct GapThumbService {
+  gchar        *basename;
+  gchar        *extension;
+  gint32        thumb_size;      /* GIMP_THUMB_SIZE_NORMAL or GIMP_THUMB_SIZE_LARGE */
+
+  GThreadPool  *pool;
+  GAsyncQueue  *results;         /* of GapThumbServiceResult (worker to main thread) */
+  GHashTable   *pending_hash;    /* key: frame_nr, value: GapThumbServicePending (main thread only) */
+  GQueue       *gimp_queue;      /* frame_nr of requests to be processed via gimp (main thread only) */
+
+  volatile gint generation;      /* incremented on cancel, workers drop requests of older generations */
+  gint32        seq;             /* request sequence number (FIFO order within same priority) */
+} GapThumbService;
+
+
+gint32            gap_thumb_service_get_gimprc_threads(void);
+
+GapThumbService * gap_thumb_service_new(const char *basename, const char *extension
+                                       , gint32 thumb_size, gint32 num_threads);
+gboolean          gap_thumb_service_request(GapThumbService *tsv, gint32 frame_nr
+                                       , gint32 priority, gboolean force);
+void              gap_thumb_service_raise_priority(GapThumbService *tsv, gint32 frame_nr
+                                       , gint32 priority);
+gboolean          gap_thumb_service_pop_result(GapThumbService *tsv
+                                       , gint32 *frame_nr, GapThumbServiceStatus *status);
+gboolean          gap_thumb_service_process_gimp_request(GapThumbService *tsv
+                                       , gint32 *frame_nr, GapThumbServiceStatus *status);
+gboolean          gap_thumb_service_is_busy(GapThumbService *tsv);
+void              gap_thumb_service_cancel(GapThumbService *tsv);
+void              gap_thumb_service_free(GapThumbService *tsv);
+
+#endif
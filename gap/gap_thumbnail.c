@@ -27,6 +27,10 @@
  */
 
 /* revision history: 
+ * 2.8.xx   2026/10/18   agent: added gap_thumb_init, gap_thumb_get_thumbnail_size,
+ *                              gap_thumb_file_has_valid_thumbnail and
+ *                              gap_thumb_file_create_thumbnail_via_pixbuf
+ *                              (thread usable thumbnail creation without gimp PDB calls)
  * 2.0.0a   2004/04/19   hof: bugfix p_gap_filename_to_uri
  * 1.3.25a  2004/01/21   hof: removed xvpics support (GIMP-2.0 has no more xvpics support too)
  *                            added gap_thumb_file_load_pixbuf_thumbnail,
@@ -51,6 +55,9 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <errno.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #include <glib/gstdio.h>
 
@@ -87,6 +94,9 @@ static void            p_gap_thumb_init(void);
 static gchar *         p_gap_filename_to_uri(const char *filename);
 
 static void            p_copy_png_thumb(char *filename_src, char *filename_dst);
+static gboolean        p_save_png_thumb_atomic(GdkPixbuf *pixbuf, const char *thumb_name
+                                              , const char *uri, GStatBuf *stat_buf
+                                              , gint image_width, gint image_height);
 
 /* --------------------------------
  * p_gap_thumb_init
@@ -315,6 +325,109 @@ p_copy_png_thumb(char *filename_src, char *filename_dst)
 } /* end p_copy_png_thumb  */
 
 
+/* ------------------------------
+ * p_save_png_thumb_atomic
+ * ------------------------------
+ * save the pixbuf as PNG thumbnail file thumb_name
+ * including the freedesktop thumbnail information tags.
+ * The PNG is written to a temporary file in the same directory
+ * and renamed to thumb_name when complete, therefore readers
+ * (the navigator, the gimp file open dialog, other gap processes)
+ * never see a partially written thumbnail file.
+ *
+ * this procedure does not make any gimp PDB calls and may be called
+ * from worker threads.
+ */
+static gboolean
+p_save_png_thumb_atomic(GdkPixbuf *pixbuf, const char *thumb_name
+                       , const char *uri, GStatBuf *stat_buf
+                       , gint image_width, gint image_height)
+{
+  gchar    *l_dirname;
+  gchar    *l_tmpname;
+  gchar    *l_mtime_str;
+  gchar    *l_size_str;
+  gchar    *l_width_str;
+  gchar    *l_height_str;
+  GError   *error = NULL;
+  gint      l_fd;
+  gboolean  l_ok;
+
+  l_dirname = g_path_get_dirname(thumb_name);
+  l_tmpname = g_build_filename(l_dirname, "gap-thumb-XXXXXX", NULL);
+  g_free(l_dirname);
+
+  l_fd = g_mkstemp(l_tmpname);
+  if(l_fd < 0)
+  {
+    if(gap_debug)
+    {
+      printf("p_save_png_thumb_atomic: cant create tempfile %s %s\n"
+            , l_tmpname
+            , g_strerror(errno)
+            );
+    }
+    g_free(l_tmpname);
+    return (FALSE);
+  }
+  close(l_fd);
+
+  l_mtime_str  = g_strdup_printf("%ld", (long)stat_buf->st_mtime);
+  l_size_str   = g_strdup_printf("%ld", (long)stat_buf->st_size);
+  l_width_str  = g_strdup_printf("%d", (int)image_width);
+  l_height_str = g_strdup_printf("%d", (int)image_height);
+
+  l_ok = gdk_pixbuf_save(pixbuf, l_tmpname, "png", &error
+                        , "tEXt::Thumb::URI",          uri
+                        , "tEXt::Thumb::MTime",        l_mtime_str
+                        , "tEXt::Thumb::Size",         l_size_str
+                        , "tEXt::Thumb::Image::Width", l_width_str
+                        , "tEXt::Thumb::Image::Height", l_height_str
+                        , "tEXt::Software",            global_creator_software
+                        , NULL
+                        );
+  if(l_ok)
+  {
+#ifdef G_OS_WIN32
+    /* rename does not replace existing files on windows */
+    g_remove(thumb_name);
+#endif
+    if(g_rename(l_tmpname, thumb_name) != 0)
+    {
+      l_ok = FALSE;
+    }
+  }
+  else
+  {
+    if(gap_debug)
+    {
+      printf("p_save_png_thumb_atomic: save failed %s %s\n"
+            , l_tmpname
+            , (error != NULL) ? error->message : ""
+            );
+    }
+  }
+
+  if(!l_ok)
+  {
+    g_remove(l_tmpname);
+  }
+  if(error != NULL)
+  {
+    g_error_free(error);
+  }
+
+  g_free(l_tmpname);
+  g_free(l_mtime_str);
+  g_free(l_size_str);
+  g_free(l_width_str);
+  g_free(l_height_str);
+
+  return (l_ok);
+
+}  /* end p_save_png_thumb_atomic */
+
+
 /* ============= external procedures ============== */
 
 
@@ -688,3 +801,178 @@ gap_thumb_file_load_thumbnail(char* filename, gint32 *th_width, gint32 *th_heigh
   return (rc);
 
 }       /* end gap_thumb_file_load_thumbnail */
+
+
+
+/* --------------------------------
+ * gap_thumb_init
+ * --------------------------------
+ * init the libgimpthumb environment.
+ * must be called (from the main thread) before the thread usable
+ * procedures gap_thumb_file_has_valid_thumbnail
+ * and gap_thumb_file_create_thumbnail_via_pixbuf are called from worker threads.
+ */
+void
+gap_thumb_init(void)
+{
+  if(!gap_thumb_initialized)
+  {
+    p_gap_thumb_init();
+  }
+}  /* end gap_thumb_init */
+
+
+/* --------------------------------
+ * gap_thumb_get_thumbnail_size
+ * --------------------------------
+ * return the GimpThumbSize value matching the gimprc "thumbnail-size"
+ * (GIMP_THUMB_SIZE_NORMAL or GIMP_THUMB_SIZE_LARGE)
+ * or 0 if thumbnail saving is turned off.
+ */
+gint32
+gap_thumb_get_thumbnail_size(void)
+{
+  gint32 l_size;
+
+  l_size = 0;
+  if(gap_thumb_thumbnailsave_is_on())
+  {
+    l_size = GIMP_THUMB_SIZE_NORMAL;
+    if((global_thumbnail_mode != NULL)
+    && (strcmp(global_thumbnail_mode, "large") == 0))
+    {
+      l_size = GIMP_THUMB_SIZE_LARGE;
+    }
+  }
+  return (l_size);
+}  /* end gap_thumb_get_thumbnail_size */
+
+
+/* ----------------------------------
+ * gap_thumb_file_has_valid_thumbnail
+ * ----------------------------------
+ * check if filename has a thumbnail of the specified thumb_size
+ * (GIMP_THUMB_SIZE_NORMAL or GIMP_THUMB_SIZE_LARGE)
+ * that is up to date (the tEXt::Thumb::MTime tag matches
+ * the modification time of the image file).
+ *
+ * does not make gimp PDB calls and may be called from worker threads
+ * (after gap_thumb_init was called from the main thread)
+ */
+gboolean
+gap_thumb_file_has_valid_thumbnail(const char *filename, gint32 thumb_size)
+{
+  GimpThumbnail *thumbnail;
+  GError        *error = NULL;
+  gboolean       l_valid;
+
+  l_valid = FALSE;
+  thumbnail = gimp_thumbnail_new();
+  if(thumbnail)
+  {
+    if(gimp_thumbnail_set_filename(thumbnail, filename, &error))
+    {
+      if(gimp_thumbnail_check_thumb(thumbnail, thumb_size) == GIMP_THUMB_STATE_OK)
+      {
+        l_valid = TRUE;
+      }
+    }
+    g_object_unref(thumbnail);
+  }
+  if(error != NULL)
+  {
+    g_error_free(error);
+  }
+
+  return (l_valid);
+}  /* end gap_thumb_file_has_valid_thumbnail */
+
+
+/* ------------------------------------------
+ * gap_thumb_file_create_thumbnail_via_pixbuf
+ * ------------------------------------------
+ * create the PNG thumbnail file for filename without using the gimp core.
+ * The image is loaded (downscaled) via the GdkPixbuf loaders,
+ * the thumbnail is written atomically (tempfile and rename).
+ *
+ * thumb_size: GIMP_THUMB_SIZE_NORMAL or GIMP_THUMB_SIZE_LARGE
+ *
+ * returns FALSE if the image format is not supported by GdkPixbuf
+ * (for example .xcf frames) or on write errors. In that case the
+ * caller may create the thumbnail via gap_pdb_gimp_file_save_thumbnail
+ * (from the main thread).
+ *
+ * does not make gimp PDB calls and may be called from worker threads
+ * (after gap_thumb_init was called from the main thread)
+ */
+gboolean
+gap_thumb_file_create_thumbnail_via_pixbuf(const char *filename, gint32 thumb_size)
+{
+  GdkPixbuf *pixbuf;
+  GStatBuf   l_stat;
+  gchar     *l_uri;
+  gchar     *l_thumb_name;
+  gint       l_image_width;
+  gint       l_image_height;
+  gboolean   l_ok;
+
+  if((thumb_size != GIMP_THUMB_SIZE_NORMAL)
+  && (thumb_size != GIMP_THUMB_SIZE_LARGE))
+  {
+    return (FALSE);
+  }
+  if(g_stat(filename, &l_stat) != 0)
+  {
+    return (FALSE);
+  }
+  if(gdk_pixbuf_get_file_info(filename, &l_image_width, &l_image_height) == NULL)
+  {
+    /* format not supported by the GdkPixbuf loaders */
+    return (FALSE);
+  }
+
+  l_uri = p_gap_filename_to_uri(filename);
+  if(l_uri == NULL)
+  {
+    return (FALSE);
+  }
+
+  l_ok = FALSE;
+  l_thumb_name = gimp_thumb_name_from_uri(l_uri, thumb_size);
+  if(l_thumb_name != NULL)
+  {
+    if(gimp_thumb_ensure_thumb_dir(thumb_size, NULL))
+    {
+      /* the GimpThumbSize value is the max. pixelsize of the thumbnail
+       * (small images are not upscaled)
+       */
+      if((l_image_width <= thumb_size) && (l_image_height <= thumb_size))
+      {
+        pixbuf = gdk_pixbuf_new_from_file(filename, NULL);
+      }
+      else
+      {
+        pixbuf = gdk_pixbuf_new_from_file_at_size(filename, thumb_size, thumb_size, NULL);
+      }
+
+      if(pixbuf != NULL)
+      {
+        l_ok = p_save_png_thumb_atomic(pixbuf, l_thumb_name, l_uri, &l_stat
+                                      , l_image_width, l_image_height);
+        g_object_unref(pixbuf);
+      }
+    }
+    g_free(l_thumb_name);
+  }
+  g_free(l_uri);
+
+  if(gap_debug)
+  {
+    printf("gap_thumb_file_create_thumbnail_via_pixbuf: %s ok:%d\n"
+          , filename
+          , (int)l_ok
+          );
+  }
+
+  return (l_ok);
+}  /* end gap_thumb_file_create_thumbnail_via_pixbuf */
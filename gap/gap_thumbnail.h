@@ -26,6 +26,8 @@
  */
 
 /* revision history:
+ * 2.8.xx   2026/10/18   agent: added thread usable procedures gap_thumb_file_has_valid_thumbnail
+ *                              and gap_thumb_file_create_thumbnail_via_pixbuf
  * 1.3.25a  2004/01/21   hof: added gap_thumb_file_load_pixbuf_thumbnail
  * 1.3.24a  2004/01/16   hof: added gap_thumb_file_load_thumbnail
  * 1.3.14b  2003/06/03   hof: removed p_gimp_file_has_valid_thumbnail
@@ -76,4 +78,13 @@ GdkPixbuf *       gap_thumb_file_load_pixbuf_thumbnail(char* filename
                                     , gint32 *th_width
                                     , gint32 *th_height
                                     , gint32 *th_bpp);
+
+/* thread usable thumbnail procedures (no gimp PDB calls),
+ * thumb_size is a GimpThumbSize value (GIMP_THUMB_SIZE_NORMAL or GIMP_THUMB_SIZE_LARGE)
+ */
+void              gap_thumb_init(void);
+gint32            gap_thumb_get_thumbnail_size(void);
+gboolean          gap_thumb_file_has_valid_thumbnail(const char *filename, gint32 thumb_size);
+gboolean          gap_thumb_file_create_thumbnail_via_pixbuf(const char *filename, gint32 thumb_size);
+
 #endif
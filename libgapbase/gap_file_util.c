@@ -24,9 +24,12 @@
  */
 
 /* revision history:
+ * version 2.8.xx;  2026.10.19   agent: added gap_file_get_stamp
  * version 1.2.1a;  2004.05.14   hof: created
  */
 
+#include "config.h"
+
 /* SYTEM (UNIX) includes */
 #include <stdlib.h>
 #include <string.h>
@@ -343,6 +346,38 @@ gap_file_get_mtime(const char *filename)
 }  /* end gap_file_get_mtime */
 
 
+/* --------------------------------
+ * gap_file_get_stamp
+ * --------------------------------
+ * deliver the modification time in nanoseconds (the sub-second part
+ * is 0 on systems without struct stat st_mtim) and the size of the file,
+ * to detect changes that happen within the same second.
+ * returns FALSE if the file does not exist (mtime_nsec and size are set to 0)
+ */
+gboolean
+gap_file_get_stamp(const char *filename, gint64 *mtime_nsec, gint64 *size)
+{
+  GStatBuf  l_stat;
+
+  *mtime_nsec = 0;
+  *size = 0;
+  if(filename != NULL)
+  {
+    if (0 == g_stat(filename, &l_stat))
+    {
+      *mtime_nsec = (gint64)l_stat.st_mtime * G_GINT64_CONSTANT(1000000000);
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+      *mtime_nsec += (gint64)l_stat.st_mtim.tv_nsec;
+#endif
+      *size = (gint64)l_stat.st_size;
+      return (TRUE);
+    }
+  }
+  return (FALSE);
+
+}  /* end gap_file_get_stamp */
+
+
 /* --------------------------------
  * gap_file_printf
  * --------------------------------
@@ -87,6 +87,7 @@ char *      gap_file_make_abspath_filename(const char *filename
 
 char *      gap_file_build_absolute_filename(const char * filename);
 time_t      gap_file_get_mtime(const char *filename);
+gboolean    gap_file_get_stamp(const char *filename, gint64 *mtime_nsec, gint64 *size);
 
 void        gap_file_printf(const char *fmt, ...);
 
@@ -0,0 +1,348 @@
+/* gap_gve_audio_reader.c
+ *
+ *  GAP common encoder tool procedures
+ *
+ *  This module reads uncompressed audio data (the data part of a WAV file)
+ *  in a reader thread into a ring buffer, where the encoder picks up
+ *  the audio chunks for interleaving with the video frames.
+ *  This way the file IO for audio is done ahead and not on the critical path
+ *  of the encode loop.
+ *  The reader thread blocks when the ring buffer is full,
+ *  the caller blocks when the requested bytes are not yet available.
+ *
+ *  The size of the ring buffer is configured with the gimprc parameter
+ *  video-encoder-audio-reader-buffer-kb, missing thread support
+ *  reads synchronously in the calling thread.
+ *
+ *  Note: the reader thread does not call the gimp PDB.
+ */
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026.10.18   agent: created
+ */
+
+/* SYTEM (UNIX) includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* GIMP includes */
+#include "libgimp/gimp.h"
+
+#include "gap_libgapbase.h"
+#include "gap_gve_audio_reader.h"
+
+
+extern int gap_debug;  /* 1 == print debug infos , 0 dont print debug infos */
+
+#define AUDIO_READER_BLOCK_SIZE   (64 * 1024)
+
+
+static gint32    p_read_block(GapGveAudioReader *ardr, guchar *dest, gint32 bytes);
+static gpointer  p_reader_thread_function(GapGveAudioReader *ardr);
+
+
+/* --------------------------------
+ * p_read_block
+ * --------------------------------
+ * read up to bytes from the file (without locking)
+ */
+static gint32
+p_read_block(GapGveAudioReader *ardr, guchar *dest, gint32 bytes)
+{
+  GTimer *timer;
+  gint32  datasize;
+
+  timer = g_timer_new();
+  datasize = fread(dest, 1, bytes, ardr->fp);
+  ardr->readSeconds += g_timer_elapsed(timer, NULL);
+  g_timer_destroy(timer);
+
+  if (datasize != bytes)
+  {
+    printf("Warning: Read %d bytes from wav file failed. (got %d bytes)\n"
+          ,(int)bytes
+          ,(int)datasize
+          );
+  }
+  return (datasize);
+
+}  /* end p_read_block */
+
+
+/* --------------------------------
+ * p_reader_thread_function
+ * --------------------------------
+ * fills the free part of the ring buffer until all data is read
+ * or the stopRequest is set.
+ */
+static gpointer
+p_reader_thread_function(GapGveAudioReader *ardr)
+{
+  g_mutex_lock(ardr->mutex);
+  while (TRUE)
+  {
+    gint32 writePos;
+    gint32 len;
+    gint32 datasize;
+
+    while ((ardr->fillLevel >= ardr->ringSize)
+    &&     (!ardr->stopRequest))
+    {
+      g_cond_wait(ardr->cond, ardr->mutex);
+    }
+    if (ardr->stopRequest)
+    {
+      break;
+    }
+
+    /* the free region behind the buffered data is not touched by the consumer */
+    writePos = (ardr->readPos + ardr->fillLevel) % ardr->ringSize;
+    len = MIN(ardr->blockSize, ardr->ringSize - ardr->fillLevel);
+    len = MIN(len, ardr->ringSize - writePos);
+    len = MIN(len, ardr->bytesToRead);
+    g_mutex_unlock(ardr->mutex);
+
+    datasize = p_read_block(ardr, &ardr->ring[writePos], len);
+
+    g_mutex_lock(ardr->mutex);
+    ardr->fillLevel += datasize;
+    ardr->bytesToRead -= datasize;
+    if ((datasize != len) || (ardr->bytesToRead <= 0))
+    {
+      ardr->readError = (datasize != len);
+      ardr->eof = TRUE;
+    }
+    g_cond_broadcast(ardr->cond);
+    if (ardr->eof)
+    {
+      break;
+    }
+  }
+  g_mutex_unlock(ardr->mutex);
+
+  return (NULL);
+
+}  /* end p_reader_thread_function */
+
+
+/* --------------------------------
+ * gap_gve_audio_reader_new
+ * --------------------------------
+ * create a reader for dataBytes of audio data from fp
+ * (fp must be positioned at the 1st audio data byte,
+ * for example by gap_audio_wav_open_seek_data)
+ * The reader thread starts reading immediately.
+ */
+GapGveAudioReader *
+gap_gve_audio_reader_new(FILE *fp, gint64 dataBytes)
+{
+  GapGveAudioReader *ardr;
+  gint32             bufferKb;
+
+  ardr = g_new0(GapGveAudioReader, 1);
+  ardr->fp = fp;
+  ardr->bytesToRead = MAX(0, dataBytes);
+  ardr->eof = (ardr->bytesToRead <= 0);
+  ardr->minFillLevel = -1;
+
+  bufferKb = gap_base_get_gimprc_int_value(GAP_GIMPRC_VIDEO_ENCODER_AUDIO_READER_BUFFER_KB
+                                          , GAP_GVE_DEFAULT_AUDIO_READER_BUFFER_KB  /* default */
+                                          , 0      /* min */
+                                          , 65536  /* max */
+                                          );
+
+  if ((bufferKb > 0)
+  &&  (!ardr->eof)
+  &&  (gap_base_thread_init()))
+  {
+    GError *error = NULL;
+
+    ardr->ringSize = MIN((gint64)bufferKb * 1024, ardr->bytesToRead);
+    ardr->blockSize = MIN(AUDIO_READER_BLOCK_SIZE, MAX(1, ardr->ringSize / 4));
+    ardr->ring = g_malloc(ardr->ringSize);
+    ardr->mutex = g_mutex_new();
+    ardr->cond = g_cond_new();
+    ardr->readerThread = g_thread_create((GThreadFunc) p_reader_thread_function
+                                        , ardr
+                                        , TRUE       /* joinable */
+                                        , &error     /* GError **error */
+                                        );
+    if (ardr->readerThread == NULL)
+    {
+      printf("gap_gve_audio_reader_new: thread not available, using synchronous read %s\n"
+        , (error != NULL) ? error->message : ""
+        );
+      if (error != NULL)
+      {
+        g_error_free(error);
+      }
+      g_cond_free(ardr->cond);
+      g_mutex_free(ardr->mutex);
+      g_free(ardr->ring);
+      ardr->cond = NULL;
+      ardr->mutex = NULL;
+      ardr->ring = NULL;
+      ardr->ringSize = 0;
+    }
+  }
+
+  if (gap_debug)
+  {
+    printf("gap_gve_audio_reader_new: dataBytes:%.0f threaded:%d ringSize:%d blockSize:%d\n"
+      , (gdouble)dataBytes
+      , (int)(ardr->readerThread != NULL)
+      , (int)ardr->ringSize
+      , (int)ardr->blockSize
+      );
+  }
+  return (ardr);
+
+}  /* end gap_gve_audio_reader_new */
+
+
+/* --------------------------------
+ * gap_gve_audio_reader_read
+ * --------------------------------
+ * copy the next bytes of audio data to dest.
+ * blocks until the requested bytes are available.
+ * returns the number of delivered bytes, this is less than
+ * the requested bytes only at the end of the audio data (or on read errors).
+ */
+gint32
+gap_gve_audio_reader_read(GapGveAudioReader *ardr
+  , guchar *dest
+  , gint32 bytes
+  )
+{
+  gint32 delivered;
+
+  if (ardr->readerThread == NULL)
+  {
+    bytes = MIN(bytes, ardr->bytesToRead);
+    if (bytes <= 0)
+    {
+      return (0);
+    }
+    delivered = p_read_block(ardr, dest, bytes);
+    ardr->bytesToRead -= delivered;
+    ardr->bytesDelivered += delivered;
+    ardr->requests++;
+    return (delivered);
+  }
+
+  delivered = 0;
+  g_mutex_lock(ardr->mutex);
+  ardr->requests++;
+  if ((ardr->minFillLevel < 0)
+  ||  (ardr->fillLevel < ardr->minFillLevel))
+  {
+    ardr->minFillLevel = ardr->fillLevel;
+  }
+  if ((ardr->fillLevel < bytes) && (!ardr->eof))
+  {
+    ardr->waitCount++;
+  }
+
+  while (delivered < bytes)
+  {
+    gint32 len;
+
+    while ((ardr->fillLevel == 0) && (!ardr->eof))
+    {
+      g_cond_wait(ardr->cond, ardr->mutex);
+    }
+    if (ardr->fillLevel == 0)
+    {
+      break;
+    }
+    len = MIN(bytes - delivered, ardr->fillLevel);
+    len = MIN(len, ardr->ringSize - ardr->readPos);
+    memcpy(&dest[delivered], &ardr->ring[ardr->readPos], len);
+    ardr->readPos = (ardr->readPos + len) % ardr->ringSize;
+    ardr->fillLevel -= len;
+    delivered += len;
+    g_cond_broadcast(ardr->cond);
+  }
+  ardr->bytesDelivered += delivered;
+  g_mutex_unlock(ardr->mutex);
+
+  return (delivered);
+
+}  /* end gap_gve_audio_reader_read */
+
+
+/* --------------------------------
+ * gap_gve_audio_reader_print_statistics
+ * --------------------------------
+ */
+void
+gap_gve_audio_reader_print_statistics(GapGveAudioReader *ardr
+  , const char *reader_name
+  )
+{
+  if (ardr == NULL)
+  {
+    return;
+  }
+  printf("%s audio reader: threaded:%d ring buffer:%d bytes, requests:%d waits:%d"
+         " min fill level:%d delivered:%.0f bytes, read time:%.3f sec%s\n"
+    , reader_name
+    , (int)(ardr->readerThread != NULL)
+    , (int)ardr->ringSize
+    , (int)ardr->requests
+    , (int)ardr->waitCount
+    , (int)ardr->minFillLevel
+    , (gdouble)ardr->bytesDelivered
+    , (float)ardr->readSeconds
+    , (ardr->readError) ? " (READ ERROR)" : ""
+    );
+
+}  /* end gap_gve_audio_reader_print_statistics */
+
+
+/* --------------------------------
+ * gap_gve_audio_reader_free
+ * --------------------------------
+ * stops the reader thread and frees all resources.
+ * (the file is not closed)
+ */
+void
+gap_gve_audio_reader_free(GapGveAudioReader *ardr)
+{
+  if (ardr == NULL)
+  {
+    return;
+  }
+  if (ardr->readerThread != NULL)
+  {
+    g_mutex_lock(ardr->mutex);
+    ardr->stopRequest = TRUE;
+    g_cond_broadcast(ardr->cond);
+    g_mutex_unlock(ardr->mutex);
+
+    g_thread_join(ardr->readerThread);
+    g_cond_free(ardr->cond);
+    g_mutex_free(ardr->mutex);
+  }
+  g_free(ardr->ring);
+  g_free(ardr);
+
+}  /* end gap_gve_audio_reader_free */
@@ -0,0 +1,74 @@
+/* gap_gve_audio_reader.h
+ *
+ *  GAP common encoder tool procedures
+ *  buffered reader for uncompressed audio input (WAV data)
+ *
+ */
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026.10.18   agent: created
+ */
+
+#ifndef GAP_GVE_AUDIO_READER_H
+#define GAP_GVE_AUDIO_READER_H
+
+#include <stdio.h>
+#include "libgimp/gimp.h"
+
+#define GAP_GIMPRC_VIDEO_ENCODER_AUDIO_READER_BUFFER_KB  "video-encoder-audio-reader-buffer-kb"
+#define GAP_GVE_DEFAULT_AUDIO_READER_BUFFER_KB           2048
+
+typedef struct GapGveAudioReader   /* nick: ardr */
+{
+  FILE        *fp;               /* positioned at the 1st audio data byte (not closed by the reader) */
+  gint64       bytesToRead;      /* remaining bytes in the file (not yet read into the ring buffer) */
+  guchar      *ring;
+  gint32       ringSize;
+  gint32       blockSize;        /* max bytes per fread call of the reader thread */
+  gint32       readPos;          /* position of the next byte to deliver */
+  gint32       fillLevel;        /* number of bytes in the ring buffer */
+  gboolean     eof;              /* TRUE when all data was read into the ring buffer (or read error) */
+  gboolean     readError;
+  gboolean     stopRequest;
+
+  GThread     *readerThread;     /* NULL in synchronous mode (the caller reads) */
+  GMutex      *mutex;
+  GCond       *cond;
+
+  /* telemetry */
+  gdouble      readSeconds;      /* time spent in fread (reader thread or caller) */
+  gint64       bytesDelivered;
+  gint32       requests;
+  gint32       waitCount;        /* number of requests that had to wait for the reader thread */
+  gint32       minFillLevel;     /* lowest fill level seen at request time (-1 no request yet) */
+} GapGveAudioReader;
+
+
+GapGveAudioReader * gap_gve_audio_reader_new(FILE *fp, gint64 dataBytes);
+gint32              gap_gve_audio_reader_read(GapGveAudioReader *ardr
+                       , guchar *dest
+                       , gint32 bytes
+                       );
+void                gap_gve_audio_reader_print_statistics(GapGveAudioReader *ardr
+                       , const char *reader_name
+                       );
+void                gap_gve_audio_reader_free(GapGveAudioReader *ardr);
+
+#endif
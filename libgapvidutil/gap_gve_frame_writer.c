@@ -0,0 +1,623 @@
+/* gap_gve_frame_writer.c
+ *
+ *  GAP common encoder tool procedures
+ *
+ *  This module writes frames that are already available as encoded data
+ *  in memory (for example 1:1 copied JPEG chunks of the rawframes encoder)
+ *  as single files. The files are written by a bounded pool of writer
+ *  threads while the calling encoder fetches the next frames
+ *  from the storyboard render processor.
+ *  Frames that had to be recoded can be passed as RGB buffer
+ *  (read from the drawable by the caller in the main thread),
+ *  the writer threads compress them to JPEG (libjpeg) or PNG (libpng)
+ *  before writing.
+ *  The caller blocks when the configured number of pending frames is reached.
+ *  The filenames are built by the caller (deterministic per frame number).
+ *  Write errors are recorded per frame and reported to the caller
+ *  at the next write request and when finishing.
+ *
+ *  The number of threads is configured with the gimprc parameter
+ *  video-encoder-frame-writer-threads, where 1 (or missing thread support)
+ *  writes synchronously in the calling thread.
+ *  The JPEG quality and PNG compression level are configured with the gimprc
+ *  parameters video-encoder-frame-writer-jpeg-quality
+ *  and video-encoder-frame-writer-png-compression.
+ *
+ *  Note: the writer threads do not call the gimp PDB.
+ */
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026.10.18   agent: created
+ */
+
+/* SYTEM (UNIX) includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+/* GIMP includes */
+#include "libgimp/gimp.h"
+
+#include "gap_libgapbase.h"
+#include "gap_gve_raw.h"
+#include "gap_gve_jpeg.h"
+#include "gap_gve_png.h"
+#include "gap_gve_frame_writer.h"
+
+
+extern int gap_debug;  /* 1 == print debug infos , 0 dont print debug infos */
+
+typedef struct GapGveFrameWriterJob   /* nick: fjob */
+{
+  gchar   *filename;
+  gint32   frame_nr;
+  guchar  *data;
+  gint32   data_size;
+
+  GapRgbPixelBuffer *rgbBuffer;   /* != NULL: compress to format before writing */
+  GapGveFrameFormat  format;
+} GapGveFrameWriterJob;
+
+
+static gboolean  p_write_file(const char *filename, const guchar *data, gint32 data_size);
+static GapGveJpegEncoder * p_get_jpeg_encoder(GapGveFrameWriter *fwr);
+static void      p_release_jpeg_encoder(GapGveFrameWriter *fwr, GapGveJpegEncoder *jenc);
+static gboolean  p_compress_and_write_file(GapGveFrameWriter *fwr, GapGveFrameWriterJob *fjob);
+static gboolean  p_process_job(GapGveFrameWriter *fwr, GapGveFrameWriterJob *fjob);
+static void      p_free_job(GapGveFrameWriterJob *fjob);
+static void      p_register_result(GapGveFrameWriter *fwr, GapGveFrameWriterJob *fjob, gboolean writeOk);
+static void      p_writer_thread_function(GapGveFrameWriterJob *fjob, GapGveFrameWriter *fwr);
+static gboolean  p_push_job(GapGveFrameWriter *fwr, GapGveFrameWriterJob *fjob);
+
+
+/* --------------------------------
+ * p_write_file
+ * --------------------------------
+ */
+static gboolean
+p_write_file(const char *filename, const guchar *data, gint32 data_size)
+{
+  FILE     *fp;
+  gboolean  writeOk;
+
+  fp = g_fopen(filename, "wb");
+  if (fp == NULL)
+  {
+    printf("ERROR cant write to file:%s %s\n", filename, g_strerror (errno));
+    return (FALSE);
+  }
+
+  writeOk = TRUE;
+  if (data_size > 0)
+  {
+    if (fwrite(data, data_size, 1, fp) != 1)
+    {
+      writeOk = FALSE;
+    }
+  }
+  if (fclose(fp) != 0)
+  {
+    writeOk = FALSE;
+  }
+  if (!writeOk)
+  {
+    printf("ERROR write to file:%s failed %s\n", filename, g_strerror (errno));
+  }
+  return (writeOk);
+
+}  /* end p_write_file */
+
+
+/* --------------------------------
+ * p_get_jpeg_encoder
+ * --------------------------------
+ * pick an idle JPEG encoder context (or create a new one if all are busy)
+ * the number of contexts is limited by the number of writer threads.
+ */
+static GapGveJpegEncoder *
+p_get_jpeg_encoder(GapGveFrameWriter *fwr)
+{
+  GapGveJpegEncoder *jenc;
+
+  jenc = NULL;
+  if (fwr->mutex != NULL)
+  {
+    g_mutex_lock(fwr->mutex);
+  }
+  if (fwr->jpegEncoders != NULL)
+  {
+    jenc = (GapGveJpegEncoder *)fwr->jpegEncoders->data;
+    fwr->jpegEncoders = g_slist_delete_link(fwr->jpegEncoders, fwr->jpegEncoders);
+  }
+  if (fwr->mutex != NULL)
+  {
+    g_mutex_unlock(fwr->mutex);
+  }
+
+  if (jenc == NULL)
+  {
+    jenc = gap_gve_jpeg_encoder_new(FALSE             /* jpeg_interlaced */
+                     , fwr->jpegQuality
+                     , FALSE                          /* odd_even */
+                     , FALSE                          /* use_YUV411 */
+                     , fwr->jpegOptimizeCoding
+                     );
+    /* the frames are standalone files (not AVI chunks) */
+    gap_gve_jpeg_encoder_set_jfif(jenc);
+  }
+  return (jenc);
+
+}  /* end p_get_jpeg_encoder */
+
+
+/* --------------------------------
+ * p_release_jpeg_encoder
+ * --------------------------------
+ */
+static void
+p_release_jpeg_encoder(GapGveFrameWriter *fwr, GapGveJpegEncoder *jenc)
+{
+  if (fwr->mutex != NULL)
+  {
+    g_mutex_lock(fwr->mutex);
+  }
+  fwr->jpegEncoders = g_slist_prepend(fwr->jpegEncoders, jenc);
+  if (fwr->mutex != NULL)
+  {
+    g_mutex_unlock(fwr->mutex);
+  }
+
+}  /* end p_release_jpeg_encoder */
+
+
+/* --------------------------------
+ * p_compress_and_write_file
+ * --------------------------------
+ * compress the rgbBuffer of the job to JPEG or PNG and write the result
+ * as file fjob->filename.
+ */
+static gboolean
+p_compress_and_write_file(GapGveFrameWriter *fwr, GapGveFrameWriterJob *fjob)
+{
+  guchar  *data;
+  gint32   data_size;
+  gboolean writeOk;
+
+  writeOk = FALSE;
+  data_size = 0;
+  if (fjob->format == GAP_GVE_FRAME_FORMAT_JPEG)
+  {
+    GapGveJpegEncoder *jenc;
+
+    /* data refers to the output memory of the context (valid until the next encode call) */
+    jenc = p_get_jpeg_encoder(fwr);
+    data = gap_gve_jpeg_encoder_encode_rgb_buffer(jenc, fjob->rgbBuffer, &data_size, NULL, 0);
+    if (data != NULL)
+    {
+      writeOk = p_write_file(fjob->filename, data, data_size);
+    }
+    p_release_jpeg_encoder(fwr, jenc);
+  }
+  else
+  {
+    data = gap_gve_png_rgb_buffer_encode_png(fjob->rgbBuffer, &data_size, fwr->pngCompression);
+    if (data != NULL)
+    {
+      writeOk = p_write_file(fjob->filename, data, data_size);
+      g_free(data);
+    }
+  }
+
+  if (data == NULL)
+  {
+    printf("ERROR compression of frame:%d failed, file:%s\n"
+      , (int)fjob->frame_nr
+      , fjob->filename
+      );
+  }
+  return (writeOk);
+
+}  /* end p_compress_and_write_file */
+
+
+/* --------------------------------
+ * p_process_job
+ * --------------------------------
+ */
+static gboolean
+p_process_job(GapGveFrameWriter *fwr, GapGveFrameWriterJob *fjob)
+{
+  if (fjob->rgbBuffer != NULL)
+  {
+    return (p_compress_and_write_file(fwr, fjob));
+  }
+  return (p_write_file(fjob->filename, fjob->data, fjob->data_size));
+
+}  /* end p_process_job */
+
+
+/* --------------------------------
+ * p_free_job
+ * --------------------------------
+ */
+static void
+p_free_job(GapGveFrameWriterJob *fjob)
+{
+  gap_gve_free_GapRgbPixelBuffer(fjob->rgbBuffer);
+  g_free(fjob->filename);
+  g_free(fjob->data);
+  g_free(fjob);
+
+}  /* end p_free_job */
+
+
+/* --------------------------------
+ * p_register_result
+ * --------------------------------
+ * the caller must hold the mutex (in threaded mode)
+ */
+static void
+p_register_result(GapGveFrameWriter *fwr, GapGveFrameWriterJob *fjob, gboolean writeOk)
+{
+  if (writeOk)
+  {
+    fwr->framesWritten++;
+    return;
+  }
+
+  fwr->framesFailed++;
+  if ((fwr->firstFailedFrameNr < 0)
+  ||  (fjob->frame_nr < fwr->firstFailedFrameNr))
+  {
+    g_free(fwr->firstFailedFilename);
+    fwr->firstFailedFilename = g_strdup(fjob->filename);
+    fwr->firstFailedFrameNr = fjob->frame_nr;
+  }
+
+}  /* end p_register_result */
+
+
+/* --------------------------------
+ * p_writer_thread_function
+ * --------------------------------
+ */
+static void
+p_writer_thread_function(GapGveFrameWriterJob *fjob, GapGveFrameWriter *fwr)
+{
+  gboolean writeOk;
+
+  writeOk = p_process_job(fwr, fjob);
+
+  g_mutex_lock(fwr->mutex);
+  p_register_result(fwr, fjob, writeOk);
+  fwr->pendingJobs--;
+  g_cond_signal(fwr->jobDoneCond);
+  g_mutex_unlock(fwr->mutex);
+
+  if (gap_debug)
+  {
+    printf("p_writer_thread_function: frame:%d ok:%d %s\n"
+      , (int)fjob->frame_nr
+      , (int)writeOk
+      , fjob->filename
+      );
+  }
+
+  p_free_job(fjob);
+
+}  /* end p_writer_thread_function */
+
+
+/* --------------------------------
+ * p_push_job
+ * --------------------------------
+ * process the job synchronously or queue it for the writer threads
+ * (blocks while the maximum number of pending frames is reached).
+ * the job is freed in all cases.
+ */
+static gboolean
+p_push_job(GapGveFrameWriter *fwr, GapGveFrameWriterJob *fjob)
+{
+  gboolean isOk;
+
+  if (fwr->threadPool == NULL)
+  {
+    p_register_result(fwr, fjob, p_process_job(fwr, fjob));
+    p_free_job(fjob);
+    return (fwr->framesFailed == 0);
+  }
+
+  g_mutex_lock(fwr->mutex);
+  while (fwr->pendingJobs >= fwr->maxPendingJobs)
+  {
+    g_cond_wait(fwr->jobDoneCond, fwr->mutex);
+  }
+  isOk = (fwr->framesFailed == 0);
+  if (isOk)
+  {
+    fwr->pendingJobs++;
+  }
+  g_mutex_unlock(fwr->mutex);
+
+  if (!isOk)
+  {
+    p_free_job(fjob);
+    return (FALSE);
+  }
+
+  g_thread_pool_push(fwr->threadPool, fjob, NULL);
+  return (TRUE);
+
+}  /* end p_push_job */
+
+
+/* --------------------------------
+ * gap_gve_frame_writer_new
+ * --------------------------------
+ */
+GapGveFrameWriter *
+gap_gve_frame_writer_new(void)
+{
+  GapGveFrameWriter *fwr;
+  gint32             numThreads;
+
+  fwr = g_new0(GapGveFrameWriter, 1);
+  fwr->firstFailedFrameNr = -1;
+  fwr->compressFrames = gap_base_get_gimprc_gboolean_value(GAP_GIMPRC_VIDEO_ENCODER_FRAME_WRITER_COMPRESSION
+                                            , FALSE  /* default */
+                                            );
+  fwr->jpegQuality = gap_base_get_gimprc_int_value(GAP_GIMPRC_VIDEO_ENCODER_FRAME_WRITER_JPEG_QUALITY
+                                            , 90  /* default */
+                                            , 0   /* min */
+                                            , 100 /* max */
+                                            );
+  fwr->jpegOptimizeCoding = gap_base_get_gimprc_gboolean_value(GAP_GIMPRC_VIDEO_ENCODER_JPEG_OPTIMIZE_CODING
+                                            , FALSE  /* default */
+                                            );
+  fwr->pngCompression = gap_base_get_gimprc_int_value(GAP_GIMPRC_VIDEO_ENCODER_FRAME_WRITER_PNG_COMPRESSION
+                                            , 9   /* default */
+                                            , 0   /* min */
+                                            , 9   /* max */
+                                            );
+
+  numThreads = gap_base_get_gimprc_int_value(GAP_GIMPRC_VIDEO_ENCODER_FRAME_WRITER_THREADS
+                                            , MIN(4, gap_base_get_numProcessors())  /* default */
+                                            , 1   /* min */
+                                            , 16  /* max */
+                                            );
+  if ((numThreads > 1)
+  &&  (gap_base_thread_init()))
+  {
+    GError *error = NULL;
+
+    fwr->mutex = g_mutex_new();
+    fwr->jobDoneCond = g_cond_new();
+    fwr->maxPendingJobs = 2 * numThreads;
+    fwr->threadPool = g_thread_pool_new((GFunc) p_writer_thread_function
+                                       , fwr         /* user data */
+                                       , numThreads  /* max_threads */
+                                       , TRUE        /* exclusive */
+                                       , &error      /* GError **error */
+                                       );
+    if (fwr->threadPool == NULL)
+    {
+      printf("gap_gve_frame_writer_new: thread pool not available, using synchronous write %s\n"
+        , (error != NULL) ? error->message : ""
+        );
+      if (error != NULL)
+      {
+        g_error_free(error);
+      }
+      g_cond_free(fwr->jobDoneCond);
+      g_mutex_free(fwr->mutex);
+      fwr->jobDoneCond = NULL;
+      fwr->mutex = NULL;
+    }
+  }
+
+  if (gap_debug)
+  {
+    printf("gap_gve_frame_writer_new: threads:%d threaded:%d maxPendingJobs:%d\n"
+      , (int)numThreads
+      , (int)(fwr->threadPool != NULL)
+      , (int)fwr->maxPendingJobs
+      );
+  }
+  return (fwr);
+
+}  /* end gap_gve_frame_writer_new */
+
+
+/* --------------------------------
+ * gap_gve_frame_writer_write
+ * --------------------------------
+ * write data_size bytes of data as file filename.
+ * the data is copied, the caller can reuse its buffer immediately.
+ * In threaded mode the write is done by one of the writer threads,
+ * the caller blocks while the maximum number of pending frames is reached.
+ *
+ * returns FALSE if this frame (synchronous mode) or any previous frame
+ *   could not be written. (the caller shall stop processing in that case
+ *   and call gap_gve_frame_writer_finish to wait for the pending frames)
+ */
+gboolean
+gap_gve_frame_writer_write(GapGveFrameWriter *fwr
+  , const char *filename
+  , gint32 frame_nr
+  , const guchar *data
+  , gint32 data_size
+  )
+{
+  GapGveFrameWriterJob *fjob;
+
+  if (fwr->threadPool == NULL)
+  {
+    GapGveFrameWriterJob  fjobLocal;
+
+    fjobLocal.filename = (gchar *)filename;
+    fjobLocal.frame_nr = frame_nr;
+    p_register_result(fwr, &fjobLocal, p_write_file(filename, data, data_size));
+    return (fwr->framesFailed == 0);
+  }
+
+  fjob = g_new0(GapGveFrameWriterJob, 1);
+  fjob->filename = g_strdup(filename);
+  fjob->frame_nr = frame_nr;
+  fjob->data_size = data_size;
+  fjob->data = g_malloc(MAX(1, data_size));
+  memcpy(fjob->data, data, data_size);
+
+  return (p_push_job(fwr, fjob));
+
+}  /* end gap_gve_frame_writer_write */
+
+
+/* --------------------------------
+ * gap_gve_frame_writer_write_rgb_buffer
+ * --------------------------------
+ * compress the picture in rgbBuffer to format (JPEG or PNG)
+ * and write it as file filename.
+ * the rgbBuffer (allocated by gap_gve_new_GapRgbPixelBuffer) is owned
+ * and freed by the writer, the caller must not access it after this call.
+ * In threaded mode the compression is done by one of the writer threads.
+ * returns FALSE on errors (see gap_gve_frame_writer_write)
+ */
+gboolean
+gap_gve_frame_writer_write_rgb_buffer(GapGveFrameWriter *fwr
+  , const char *filename
+  , gint32 frame_nr
+  , GapRgbPixelBuffer *rgbBuffer
+  , GapGveFrameFormat format
+  )
+{
+  GapGveFrameWriterJob *fjob;
+
+  fjob = g_new0(GapGveFrameWriterJob, 1);
+  fjob->filename = g_strdup(filename);
+  fjob->frame_nr = frame_nr;
+  fjob->rgbBuffer = rgbBuffer;
+  fjob->format = format;
+
+  return (p_push_job(fwr, fjob));
+
+}  /* end gap_gve_frame_writer_write_rgb_buffer */
+
+
+/* --------------------------------
+ * gap_gve_frame_writer_get_format
+ * --------------------------------
+ * returns the format that the writer can compress for the extension
+ * of filename, GAP_GVE_FRAME_FORMAT_OTHER for all other extensions
+ * and if compression by the writer is not enabled in the gimprc.
+ */
+GapGveFrameFormat
+gap_gve_frame_writer_get_format(GapGveFrameWriter *fwr, const char *filename)
+{
+  const char *ext;
+
+  if (!fwr->compressFrames)
+  {
+    return (GAP_GVE_FRAME_FORMAT_OTHER);
+  }
+  ext = strrchr(filename, '.');
+  if (ext == NULL)
+  {
+    return (GAP_GVE_FRAME_FORMAT_OTHER);
+  }
+  ext++;
+  if ((g_ascii_strcasecmp(ext, "jpg") == 0)
+  ||  (g_ascii_strcasecmp(ext, "jpeg") == 0))
+  {
+    return (GAP_GVE_FRAME_FORMAT_JPEG);
+  }
+  if (g_ascii_strcasecmp(ext, "png") == 0)
+  {
+    return (GAP_GVE_FRAME_FORMAT_PNG);
+  }
+  return (GAP_GVE_FRAME_FORMAT_OTHER);
+
+}  /* end gap_gve_frame_writer_get_format */
+
+
+/* --------------------------------
+ * gap_gve_frame_writer_finish
+ * --------------------------------
+ * wait until all pending frames are written.
+ * returns TRUE if all frames were written successfully.
+ * (fwr->firstFailedFilename refers to the lowest frame number that failed otherwise)
+ */
+gboolean
+gap_gve_frame_writer_finish(GapGveFrameWriter *fwr)
+{
+  gboolean isOk;
+
+  if (fwr->threadPool != NULL)
+  {
+    g_mutex_lock(fwr->mutex);
+    while (fwr->pendingJobs > 0)
+    {
+      g_cond_wait(fwr->jobDoneCond, fwr->mutex);
+    }
+    g_mutex_unlock(fwr->mutex);
+  }
+
+  isOk = (fwr->framesFailed == 0);
+  if ((gap_debug) || (!isOk))
+  {
+    printf("gap_gve_frame_writer_finish: frames written:%d failed:%d (first failed frame:%d %s)\n"
+      , (int)fwr->framesWritten
+      , (int)fwr->framesFailed
+      , (int)fwr->firstFailedFrameNr
+      , (fwr->firstFailedFilename != NULL) ? fwr->firstFailedFilename : ""
+      );
+  }
+  return (isOk);
+
+}  /* end gap_gve_frame_writer_finish */
+
+
+/* --------------------------------
+ * gap_gve_frame_writer_free
+ * --------------------------------
+ * waits for pending frames and frees all resources.
+ */
+void
+gap_gve_frame_writer_free(GapGveFrameWriter *fwr)
+{
+  if (fwr == NULL)
+  {
+    return;
+  }
+  if (fwr->threadPool != NULL)
+  {
+    /* wait for all queued jobs (immediate == FALSE, wait_ == TRUE) */
+    g_thread_pool_free(fwr->threadPool, FALSE, TRUE);
+    g_cond_free(fwr->jobDoneCond);
+    g_mutex_free(fwr->mutex);
+  }
+  g_slist_foreach(fwr->jpegEncoders, (GFunc) gap_gve_jpeg_encoder_free, NULL);
+  g_slist_free(fwr->jpegEncoders);
+  g_free(fwr->firstFailedFilename);
+  g_free(fwr);
+
+}  /* end gap_gve_frame_writer_free */
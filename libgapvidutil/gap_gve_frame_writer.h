@@ -0,0 +1,88 @@
+/* gap_gve_frame_writer.h
+ *
+ *  GAP common encoder tool procedures
+ *  bounded pool of writer threads that write frames (already encoded
+ *  data in memory, or RGB buffers that are compressed to JPEG or PNG
+ *  by the writer threads) as single files while the caller fetches the next frames.
+ *
+ */
+
+/* The GIMP -- an image manipulation program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* revision history:
+ * version 2.8.xx;  2026.10.18   agent: created
+ */
+
+#ifndef GAP_GVE_FRAME_WRITER_H
+#define GAP_GVE_FRAME_WRITER_H
+
+#include "libgimp/gimp.h"
+#include "gap_gve_raw.h"
+
+#define GAP_GIMPRC_VIDEO_ENCODER_FRAME_WRITER_THREADS          "video-encoder-frame-writer-threads"
+#define GAP_GIMPRC_VIDEO_ENCODER_FRAME_WRITER_COMPRESSION      "video-encoder-frame-writer-compression"
+#define GAP_GIMPRC_VIDEO_ENCODER_FRAME_WRITER_JPEG_QUALITY     "video-encoder-frame-writer-jpeg-quality"
+#define GAP_GIMPRC_VIDEO_ENCODER_FRAME_WRITER_PNG_COMPRESSION  "video-encoder-frame-writer-png-compression"
+
+typedef enum
+{
+  GAP_GVE_FRAME_FORMAT_OTHER      /* not supported by the writer (save via gimp file save plug-ins) */
+ ,GAP_GVE_FRAME_FORMAT_JPEG
+ ,GAP_GVE_FRAME_FORMAT_PNG
+} GapGveFrameFormat;
+
+typedef struct GapGveFrameWriter   /* nick: fwr */
+{
+  GThreadPool *threadPool;        /* NULL in synchronous mode (frames are written by the caller) */
+  GMutex      *mutex;
+  GCond       *jobDoneCond;
+  gint32       maxPendingJobs;    /* number of frames that may be queued or in progress */
+  gint32       pendingJobs;
+
+  gint32       framesWritten;
+  gint32       framesFailed;
+  gint32       firstFailedFrameNr;   /* -1 if all frames were written successfully so far */
+  gchar       *firstFailedFilename;
+
+  gboolean     compressFrames;       /* TRUE: JPEG and PNG frames are compressed by the writer (opt-in) */
+  gint32       jpegQuality;          /* 0 - 100 */
+  gboolean     jpegOptimizeCoding;
+  gint32       pngCompression;       /* 0 - 9 */
+  GSList      *jpegEncoders;         /* idle GapGveJpegEncoder contexts (protected by mutex) */
+} GapGveFrameWriter;
+
+
+GapGveFrameWriter * gap_gve_frame_writer_new(void);
+gboolean            gap_gve_frame_writer_write(GapGveFrameWriter *fwr
+                       , const char *filename
+                       , gint32 frame_nr
+                       , const guchar *data
+                       , gint32 data_size
+                       );
+gboolean            gap_gve_frame_writer_write_rgb_buffer(GapGveFrameWriter *fwr
+                       , const char *filename
+                       , gint32 frame_nr
+                       , GapRgbPixelBuffer *rgbBuffer
+                       , GapGveFrameFormat format
+                       );
+GapGveFrameFormat   gap_gve_frame_writer_get_format(GapGveFrameWriter *fwr, const char *filename);
+gboolean            gap_gve_frame_writer_finish(GapGveFrameWriter *fwr);
+void                gap_gve_frame_writer_free(GapGveFrameWriter *fwr);
+
+#endif
@@ -28,6 +28,14 @@
 
 
 /* revision history:
+ * version 2.8.xx; 2026.10.19   agent: - added the persistent JPEG encoder context (gap_gve_jpeg_encoder_*)
+ *                                       with reusable output memory and optional optimized huffman tables.
+ *                                     - gap_gve_jpeg_rgb_buffer_encode_jpeg uses a temporary encoder context.
+ *                                     - gap_gve_jpeg_encoder_set_jfif for standalone JPEG files.
+ * version 2.8.xx; 2026.10.18   agent: - memory destination grows on demand (was limited to 512 kB per frame)
+ *                                     - interlaced fields are appended (2nd field did overwrite the 1st one)
+ *                                     - added gap_gve_jpeg_rgb_buffer_encode_jpeg (without gimp calls,
+ *                                       can be used in encoder worker threads)
  * version 1.2.2; 2002.11.29   hof: rename from gap_encode_main.c -> gap_encode_jpeg.c
  *                              removed codeparts that does not deal with jpeg
  *                              ported to gimp-1.2 API
@@ -49,6 +57,8 @@
 #include "libgimp/gimp.h"
 
 /* GAP includes */
+#include "gap_gve_raw.h"
+#include "gap_gve_jpeg.h"
 
 
 /* JPEGlib includes */
@@ -56,6 +66,18 @@
 #include "jerror.h"
 
 
+struct GapGveJpegEncoder   /* nick: jenc */
+{
+  struct jpeg_compress_struct cinfo;
+  struct jpeg_error_mgr       jerr;
+  gint32              jpeg_interlaced;
+  gint32              odd_even;
+  JSAMPROW           *rowPointers;     /* row pointers of one field (or frame) */
+  guint               rowPointersSize;
+  GapRgbPixelBuffer   rgbBuffer;       /* drawable readback buffer */
+};
+
+
 /* ------------------------
  * DEBUG switch
  * ------------------------
@@ -77,17 +99,17 @@ static int jpeg_debug = FALSE;  /* set TRUE for test and  FALSE fro productive u
    These extensions define functions to compress a JPEG in memory.
    (see libJPEGs source doc for more info on dest-managers) */
 
-/* Expanded data destination object for stdio output */
+/* Expanded data destination object for memory output */
 typedef struct {
   struct jpeg_destination_mgr pub; /* public fields */
   JOCTET * buffer;              /* start of buffer */
+  size_t   bufsize;             /* allocated size of buffer */
+  size_t   datasize;            /* bytes of all completed JPEGs in the buffer */
 } memjpeg_dest_mgr;
 
-/* That's the maximum size of the generated JPEGs.
-   As video pictures don't have a higher resolution
-   than 720x576, I don't see any reason to make
-   it larger than 256kb -gz-
-   I use 512kB just to be on the save side -hof-
+/* That's the initial size of the memory buffer for the generated JPEGs.
+ * The buffer grows (doubles its size) when the compressed data
+ * does not fit, so there is no limit for large frame sizes.
  */
 #define OUTPUT_BUF_SIZE  512*1024
 
@@ -105,6 +127,7 @@ struct jpeg_destination_mgr {
 /*
  * Initialize destination --- called by jpeg_start_compress
  * before any data is actually written.
+ * (the 2nd field of an interlaced frame is appended behind the 1st one)
  */
 
 static void
@@ -112,52 +135,37 @@ init_destination (j_compress_ptr cinfo)
 {
   memjpeg_dest_mgr *dest = (memjpeg_dest_mgr *) cinfo->dest;
 
-  /* printf("GAP_MOVTAR: Memory JPEG's init_destination called !\n"); */
-  dest->pub.next_output_byte = dest->buffer;
-  dest->pub.free_in_buffer = OUTPUT_BUF_SIZE;
+  dest->pub.next_output_byte = dest->buffer + dest->datasize;
+  dest->pub.free_in_buffer = dest->bufsize - dest->datasize;
 }
 
 /*
  * Empty the output buffer --- called whenever buffer fills up.
  *
- * In typical applications, this should write the entire output buffer
- * (ignoring the current state of next_output_byte & free_in_buffer),
- * reset the pointer & count to the start of the buffer, and return TRUE
- * indicating that the buffer has been dumped.
- *
- * In applications that need to be able to suspend compression due to output
- * overrun, a FALSE return indicates that the buffer cannot be emptied now.
- * In this situation, the compressor will return to its caller (possibly with
- * an indication that it has not accepted all the supplied scanlines).  The
- * application should resume compression after it has made more room in the
- * output buffer.  Note that there are substantial restrictions on the use of
- * suspension --- see the documentation.
- *
- * When suspending, the compressor will back up to a convenient restart point
- * (typically the start of the current MCU). next_output_byte & free_in_buffer
- * indicate where the restart point will be if the current call returns FALSE.
- * Data beyond this point will be regenerated after resumption, so do not
- * write it out when emptying the buffer externally.
+ * The whole buffer is filled at this point, we double its size
+ * and continue behind the already compressed data.
  */
 
 static boolean
 empty_output_buffer (j_compress_ptr cinfo)
 {
   memjpeg_dest_mgr * dest = (memjpeg_dest_mgr *) cinfo->dest;
+  size_t oldsize;
 
-  printf("EMERGENCY in gap_movtar: The jpeg memory compression\n is limited to 256 kb/frame !\n"
-         "Consult gz@lysator.liu.se to fix this problem !\n");
-  ERREXIT(cinfo, JERR_FILE_WRITE);
+  oldsize = dest->bufsize;
+  dest->bufsize = 2 * oldsize;
+  dest->buffer = (JOCTET *)g_realloc(dest->buffer, dest->bufsize);
+  if (jpeg_debug) fprintf(stderr, "GAP_AVI: encode_jpeg: grow buffer to %d bytes\n", (int)dest->bufsize);
 
-  dest->pub.next_output_byte = dest->buffer;
-  dest->pub.free_in_buffer = OUTPUT_BUF_SIZE;
+  dest->pub.next_output_byte = dest->buffer + oldsize;
+  dest->pub.free_in_buffer = dest->bufsize - oldsize;
 
   return TRUE;
 }
 
 /*
  * Terminate destination --- called by jpeg_finish_compress
- * after all data has been written.  Usually needs to flush buffer.
+ * after all data has been written.
  *
  * NB: *not* called by jpeg_abort or jpeg_destroy; surrounding
  * application must deal with any cleanup that should happen even
@@ -167,28 +175,28 @@ empty_output_buffer (j_compress_ptr cinfo)
 static void
 term_destination (j_compress_ptr cinfo)
 {
+  memjpeg_dest_mgr *dest = (memjpeg_dest_mgr *) cinfo->dest;
+
+  dest->datasize = dest->bufsize - dest->pub.free_in_buffer;
 }
 
 /*
- * Prepare for output to a stdio stream.
- * The caller must have already opened the stream, and is responsible
- * for closing it after finishing compression.
- * ATTENTION ! memjpeg has to have at least OUTPUT_BUF_SIZE reserved !
+ * Prepare for output to a memory buffer.
+ * The buffer is allocated here (with initial size bufsize) and grows on demand.
+ * Use jpeg_memio_dest_release to take over the compressed data.
  */
 
 static void
-jpeg_memio_dest (j_compress_ptr cinfo, guchar *memjpeg, size_t **remaining)
+jpeg_memio_dest (j_compress_ptr cinfo, size_t bufsize)
 {
    memjpeg_dest_mgr *dest;
 
   /* The destination object is made permanent so that multiple JPEG images
-   * can be written to the same file without re-executing jpeg_stdio_dest.
+   * can be written to the same buffer without re-executing jpeg_memio_dest.
    * This makes it dangerous to use this manager and a different destination
    * manager serially with the same JPEG object, because their private object
    * sizes may be different.  Caveat programmer.
    */
-   /*  printf("GAP_MOVTAR: Running jpeg_memio_dest !\n");
-    */
   if (cinfo->dest == NULL)
     {   /* first time for this JPEG object? */
       cinfo->dest = (struct jpeg_destination_mgr *)
@@ -200,8 +208,65 @@ jpeg_memio_dest (j_compress_ptr cinfo, guchar *memjpeg, size_t **remaining)
   dest->pub.init_destination = init_destination;
   dest->pub.empty_output_buffer = empty_output_buffer;
   dest->pub.term_destination = term_destination;
-  dest->buffer = memjpeg;
-  *remaining = &(dest->pub.free_in_buffer);
+  dest->bufsize = MAX(bufsize, 4096);
+  dest->buffer = (JOCTET *)g_malloc0(dest->bufsize);
+  dest->datasize = 0;
+}
+
+/*
+ * Deliver the compressed data (the caller takes ownership of the buffer)
+ */
+
+static guchar *
+jpeg_memio_dest_release (j_compress_ptr cinfo, gint32 *JPEG_size)
+{
+  memjpeg_dest_mgr *dest = (memjpeg_dest_mgr *) cinfo->dest;
+  guchar *JPEG_data;
+
+  JPEG_data = (guchar *)dest->buffer;
+  *JPEG_size = dest->datasize;
+  dest->buffer = NULL;
+  dest->bufsize = 0;
+  dest->datasize = 0;
+  return (JPEG_data);
+}
+
+/*
+ * Set the compression parameters that are common for all JPEG chunks
+ * of the AVI (and other) encoders.
+ */
+
+static void
+p_jpeg_set_avi_params (j_compress_ptr cinfo, gint32 jpeg_quality, gint32 use_YUV411)
+{
+  /* Now use the library's routine to set default compression parameters.
+   * (You must set at least cinfo.in_color_space before calling this,
+   * since the defaults depend on the source color space.)
+   */
+  jpeg_set_defaults (cinfo);
+  jpeg_set_quality (cinfo, (int) (jpeg_quality), TRUE);
+
+  /* Are these the evil AVI destroyers ? */
+  cinfo->write_Adobe_marker = FALSE;
+  cinfo->write_JFIF_header = FALSE;
+
+  /* That's the only allowed encoding in a movtar */
+  if (!use_YUV411)
+    {
+      cinfo->comp_info[0].h_samp_factor = 2;
+      cinfo->comp_info[0].v_samp_factor = 1;
+      cinfo->comp_info[1].h_samp_factor = 1;
+      cinfo->comp_info[1].v_samp_factor = 1;
+      cinfo->comp_info[2].h_samp_factor = 1;
+      cinfo->comp_info[2].v_samp_factor = 1;
+    }
+  else
+    if (jpeg_debug) fprintf(stderr, "Using YUV 4:1:1 encoding !");
+
+  cinfo->restart_interval = 0;
+  cinfo->restart_in_rows = FALSE;
+  /* could be _ISLOW or _FLOAT, too, but this is fastest */
+  cinfo->dct_method = JDCT_ISLOW;
 }
 
 /* gap_gve_jpeg_drawable_encode_jpeg
@@ -234,8 +299,6 @@ gap_gve_jpeg_drawable_encode_jpeg(GimpDrawable *drawable, gint32 jpeg_interlaced
   guint yend;
   int i, j, y;
   guchar *JPEG_data;
-  size_t *JPEG_buf_remain;
-  size_t totalsize = 0;
 
   drawable_type = gimp_drawable_type (drawable->drawable_id);
   gimp_pixel_rgn_init (&pixel_rgn, drawable, 0, 0, drawable->width, drawable->height, FALSE, FALSE);
@@ -255,11 +318,8 @@ gap_gve_jpeg_drawable_encode_jpeg(GimpDrawable *drawable, gint32 jpeg_interlaced
   /* Step 2: specify data destination (eg, a file) */
   /* Note: steps 2 and 3 can be done in either order. */
 
-  /* We use our own jpeg destination mgr */
-  JPEG_data = (guchar *)g_malloc0(OUTPUT_BUF_SIZE * sizeof(guchar));
-
   /* Install my memory destination manager (instead of stdio_dest) */
-  jpeg_memio_dest (&cinfo, JPEG_data, &JPEG_buf_remain);
+  jpeg_memio_dest (&cinfo, OUTPUT_BUF_SIZE);
 
   if (jpeg_debug) fprintf(stderr, "GAP_AVI: encode_jpeg: Cleared the initilization !\n");
 
@@ -283,11 +343,15 @@ gap_gve_jpeg_drawable_encode_jpeg(GimpDrawable *drawable, gint32 jpeg_interlaced
     case GIMP_INDEXED_IMAGE:
     case GIMP_INDEXEDA_IMAGE:
       printf ("jpeg: cannot operate on indexed color images");
-      return FALSE;
+      g_free(jpeg_memio_dest_release (&cinfo, JPEG_size));
+      jpeg_destroy_compress (&cinfo);
+      return NULL;
       break;
     default:
       printf ("jpeg: cannot operate on unknown image types");
-      return FALSE;
+      g_free(jpeg_memio_dest_release (&cinfo, JPEG_size));
+      jpeg_destroy_compress (&cinfo);
+      return NULL;
       break;
     }
 
@@ -303,39 +367,12 @@ gap_gve_jpeg_drawable_encode_jpeg(GimpDrawable *drawable, gint32 jpeg_interlaced
   cinfo.in_color_space = (drawable_type == GIMP_RGB_IMAGE ||
                           drawable_type == GIMP_RGBA_IMAGE)
     ? JCS_RGB : JCS_GRAYSCALE;
-  /* Now use the library's routine to set default compression parameters.
-   * (You must set at least cinfo.in_color_space before calling this,
-   * since the defaults depend on the source color space.)
-   */
-  jpeg_set_defaults (&cinfo);
-  jpeg_set_quality (&cinfo, (int) (jpeg_quality), TRUE);
+  p_jpeg_set_avi_params (&cinfo, jpeg_quality, use_YUV411);
 
   /* Smoothing is not possible for nonstandard sampling rates */
   /*  cinfo.smoothing_factor = (int) (50); */
   /* I wonder if this is slower: */
   /* cinfo.optimize_coding = 1; */
-
-  /* Are these the evil AVI destroyers ? */
-  cinfo.write_Adobe_marker = FALSE;
-  cinfo.write_JFIF_header = FALSE;
-
-  /* That's the only allowed encoding in a movtar */
-  if (!use_YUV411)
-    {
-      cinfo.comp_info[0].h_samp_factor = 2;
-      cinfo.comp_info[0].v_samp_factor = 1;
-      cinfo.comp_info[1].h_samp_factor = 1;
-      cinfo.comp_info[1].v_samp_factor = 1;
-      cinfo.comp_info[2].h_samp_factor = 1;
-      cinfo.comp_info[2].v_samp_factor = 1;
-    }
-  else
-    if (jpeg_debug) fprintf(stderr, "Using YUV 4:1:1 encoding !");
-
-  cinfo.restart_interval = 0;
-  cinfo.restart_in_rows = FALSE;
-  /* could be _ISLOW or _FLOAT, too, but this is fastest */
-  cinfo.dct_method = JDCT_ISLOW;
   if (jpeg_debug) fprintf(stderr, "GAP_AVI: encode_jpeg: Cleared parameter setting !\n");
 
   if (jpeg_interlaced)
@@ -384,8 +421,6 @@ gap_gve_jpeg_drawable_encode_jpeg(GimpDrawable *drawable, gint32 jpeg_interlaced
             }
 
           jpeg_finish_compress(&cinfo);
-          totalsize += (OUTPUT_BUF_SIZE - *JPEG_buf_remain);
-          /* JPEG_data = (guchar *)realloc(JPEG_data, sizeof(guchar)* *JPEG_size); */
         }
       /* fprintf(stderr, "2 fields written.\n"); */
     }
@@ -453,10 +488,10 @@ gap_gve_jpeg_drawable_encode_jpeg(GimpDrawable *drawable, gint32 jpeg_interlaced
 
       /* Step 6: Finish compression */
       jpeg_finish_compress (&cinfo);
-      totalsize += (OUTPUT_BUF_SIZE - *JPEG_buf_remain);
-      /* JPEG_data = (guchar *)realloc(JPEG_data, sizeof(guchar)* *JPEG_size); */
     }
 
+  JPEG_data = jpeg_memio_dest_release (&cinfo, JPEG_size);
+
   /* Step 7: release JPEG compression object */
   /* This is an important step since it will release a good deal of memory. */
   jpeg_destroy_compress (&cinfo);
@@ -465,6 +500,227 @@ gap_gve_jpeg_drawable_encode_jpeg(GimpDrawable *drawable, gint32 jpeg_interlaced
   g_free (temp);
   g_free (data);
 
-  *JPEG_size = totalsize;
   return JPEG_data;
 }
+
+
+/* ------------------------------------
+ * gap_gve_jpeg_rgb_buffer_encode_jpeg
+ * ------------------------------------
+ * same as gap_gve_jpeg_drawable_encode_jpeg but reads the picture
+ * from an RGB pixel buffer (bpp 3) instead of a GimpDrawable.
+ * This procedure does not call the gimp PDB and does not access
+ * gimp tiles, therefore it can run in encoder worker threads
+ * (each call uses its own temporary encoder context,
+ * use gap_gve_jpeg_encoder_new to encode a sequence of frames).
+ */
+guchar *
+gap_gve_jpeg_rgb_buffer_encode_jpeg(GapRgbPixelBuffer *rgbBuffer, gint32 jpeg_interlaced, gint32 *JPEG_size,
+                               gint32 jpeg_quality, gint32 odd_even, gint32 use_YUV411,
+                               void *app0_buffer, gint32 app0_length)
+{
+  GapGveJpegEncoder *jenc;
+  guchar *JPEG_data;
+
+  *JPEG_size = 0;
+  jenc = gap_gve_jpeg_encoder_new(jpeg_interlaced, jpeg_quality, odd_even, use_YUV411, FALSE);
+
+  JPEG_data = NULL;
+  if (gap_gve_jpeg_encoder_encode_rgb_buffer(jenc, rgbBuffer, JPEG_size, app0_buffer, app0_length) != NULL)
+    {
+      /* take over the output memory of the temporary context */
+      JPEG_data = jpeg_memio_dest_release (&jenc->cinfo, JPEG_size);
+    }
+  gap_gve_jpeg_encoder_free(jenc);
+
+  return JPEG_data;
+}  /* end gap_gve_jpeg_rgb_buffer_encode_jpeg */
+
+
+/* ------------------------------------
+ * gap_gve_jpeg_encoder_new
+ * ------------------------------------
+ * the compression parameters and quantization tables are set up here
+ * (once per context, they are kept by libjpeg between frames).
+ */
+GapGveJpegEncoder *
+gap_gve_jpeg_encoder_new(gint32 jpeg_interlaced, gint32 jpeg_quality
+                        , gint32 odd_even, gint32 use_YUV411, gboolean optimize_coding)
+{
+  GapGveJpegEncoder *jenc;
+
+  jenc = g_new0(GapGveJpegEncoder, 1);
+  jenc->jpeg_interlaced = jpeg_interlaced;
+  jenc->odd_even = odd_even;
+
+  jenc->cinfo.err = jpeg_std_error(&jenc->jerr);
+  jpeg_create_compress (&jenc->cinfo);
+
+  /* the output memory is kept (and grows on demand) for all frames */
+  jpeg_memio_dest (&jenc->cinfo, OUTPUT_BUF_SIZE);
+
+  jenc->cinfo.input_components = 3;
+  jenc->cinfo.in_color_space = JCS_RGB;
+  p_jpeg_set_avi_params (&jenc->cinfo, jpeg_quality, use_YUV411);
+  jenc->cinfo.optimize_coding = (optimize_coding) ? TRUE : FALSE;
+
+  return (jenc);
+}  /* end gap_gve_jpeg_encoder_new */
+
+
+/* ------------------------------------
+ * gap_gve_jpeg_encoder_set_jfif
+ * ------------------------------------
+ */
+void
+gap_gve_jpeg_encoder_set_jfif(GapGveJpegEncoder *jenc)
+{
+  jenc->cinfo.write_JFIF_header = TRUE;
+  jenc->cinfo.comp_info[0].h_samp_factor = 2;
+  jenc->cinfo.comp_info[0].v_samp_factor = 2;
+  jenc->cinfo.comp_info[1].h_samp_factor = 1;
+  jenc->cinfo.comp_info[1].v_samp_factor = 1;
+  jenc->cinfo.comp_info[2].h_samp_factor = 1;
+  jenc->cinfo.comp_info[2].v_samp_factor = 1;
+
+}  /* end gap_gve_jpeg_encoder_set_jfif */
+
+
+/* ------------------------------------
+ * gap_gve_jpeg_encoder_encode_rgb_buffer
+ * ------------------------------------
+ */
+guchar *
+gap_gve_jpeg_encoder_encode_rgb_buffer(GapGveJpegEncoder *jenc, GapRgbPixelBuffer *rgbBuffer
+                              , gint32 *JPEG_size, void *app0_buffer, gint32 app0_length)
+{
+  memjpeg_dest_mgr *dest;
+  guint   row;
+  int     y;
+
+  *JPEG_size = 0;
+  if ((rgbBuffer == NULL) || (rgbBuffer->data == NULL) || (rgbBuffer->bpp != 3))
+    {
+      printf ("jpeg: rgb buffer encode supports only RGB buffers (bpp 3)\n");
+      return NULL;
+    }
+
+  if (jenc->rowPointersSize < rgbBuffer->height)
+    {
+      g_free(jenc->rowPointers);
+      jenc->rowPointers = g_new(JSAMPROW, rgbBuffer->height);
+      jenc->rowPointersSize = rgbBuffer->height;
+    }
+
+  /* overwrite the compressed data of the previous frame */
+  dest = (memjpeg_dest_mgr *) jenc->cinfo.dest;
+  if (dest->buffer == NULL)
+    {
+      jpeg_memio_dest (&jenc->cinfo, OUTPUT_BUF_SIZE);
+    }
+  dest->datasize = 0;
+
+  jenc->cinfo.image_width = rgbBuffer->width;
+
+  if (jenc->jpeg_interlaced)
+    {
+      jenc->cinfo.image_height = rgbBuffer->height/2;
+
+      for (y = (jenc->odd_even) ? 1 : 0; (jenc->odd_even) ? (y >= 0) : (y <= 1); (jenc->odd_even) ? (y--) : (y++))
+        {
+          for (row = 0; row < jenc->cinfo.image_height; row++)
+            {
+              jenc->rowPointers[row] = rgbBuffer->data + ((2 * row + y) * rgbBuffer->rowstride);
+            }
+
+          jpeg_start_compress (&jenc->cinfo, TRUE);
+          if(app0_buffer)
+            jpeg_write_marker(&jenc->cinfo,
+                              JPEG_APP0,
+                              app0_buffer,
+                              app0_length);
+
+          while (jenc->cinfo.next_scanline < jenc->cinfo.image_height)
+            {
+              jpeg_write_scanlines (&jenc->cinfo
+                                   , &jenc->rowPointers[jenc->cinfo.next_scanline]
+                                   , jenc->cinfo.image_height - jenc->cinfo.next_scanline);
+            }
+          jpeg_finish_compress(&jenc->cinfo);
+        }
+    }
+  else
+    {
+      jenc->cinfo.image_height = rgbBuffer->height;
+      for (row = 0; row < jenc->cinfo.image_height; row++)
+        {
+          jenc->rowPointers[row] = rgbBuffer->data + (row * rgbBuffer->rowstride);
+        }
+
+      jpeg_start_compress (&jenc->cinfo, TRUE);
+      if(app0_buffer)
+        jpeg_write_marker(&jenc->cinfo,
+                          JPEG_APP0,
+                          app0_buffer,
+                          app0_length);
+
+      while (jenc->cinfo.next_scanline < jenc->cinfo.image_height)
+        {
+          jpeg_write_scanlines (&jenc->cinfo
+                               , &jenc->rowPointers[jenc->cinfo.next_scanline]
+                               , jenc->cinfo.image_height - jenc->cinfo.next_scanline);
+        }
+      jpeg_finish_compress (&jenc->cinfo);
+    }
+
+  *JPEG_size = dest->datasize;
+  return ((guchar *)dest->buffer);
+}  /* end gap_gve_jpeg_encoder_encode_rgb_buffer */
+
+
+/* ------------------------------------
+ * gap_gve_jpeg_encoder_encode_drawable
+ * ------------------------------------
+ * the drawable is read into the readback buffer of the context
+ * with one call (instead of row by row) and converted to RGB.
+ */
+guchar *
+gap_gve_jpeg_encoder_encode_drawable(GapGveJpegEncoder *jenc, GimpDrawable *drawable
+                              , gint32 *JPEG_size, void *app0_buffer, gint32 app0_length)
+{
+  GapRgbPixelBuffer *rgbBuffer;
+
+  rgbBuffer = &jenc->rgbBuffer;
+  if ((rgbBuffer->data == NULL)
+  ||  (rgbBuffer->width != drawable->width)
+  ||  (rgbBuffer->height != drawable->height))
+    {
+      g_free(rgbBuffer->data);
+      gap_gve_init_GapRgbPixelBuffer(rgbBuffer, drawable->width, drawable->height);
+      rgbBuffer->data = (guchar *)g_malloc0(rgbBuffer->height * rgbBuffer->rowstride);
+    }
+  gap_gve_drawable_to_RgbBuffer(drawable, rgbBuffer);
+
+  return (gap_gve_jpeg_encoder_encode_rgb_buffer(jenc, rgbBuffer, JPEG_size, app0_buffer, app0_length));
+}  /* end gap_gve_jpeg_encoder_encode_drawable */
+
+
+/* ------------------------------------
+ * gap_gve_jpeg_encoder_free
+ * ------------------------------------
+ */
+void
+gap_gve_jpeg_encoder_free(GapGveJpegEncoder *jenc)
+{
+  gint32 JPEG_size;
+
+  if (jenc == NULL)
+    {
+      return;
+    }
+  g_free(jpeg_memio_dest_release (&jenc->cinfo, &JPEG_size));
+  jpeg_destroy_compress (&jenc->cinfo);
+  g_free(jenc->rowPointers);
+  g_free(jenc->rgbBuffer.data);
+  g_free(jenc);
+}  /* end gap_gve_jpeg_encoder_free */
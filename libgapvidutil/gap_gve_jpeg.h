@@ -6,6 +6,8 @@
 
 
 /* revision history:
+ * version 2.8.xx; 2026.10.19   agent: added the persistent JPEG encoder context (gap_gve_jpeg_encoder_*)
+ * version 2.8.xx; 2026.10.18   agent: added gap_gve_jpeg_rgb_buffer_encode_jpeg
  * version 1.2.2; 2004.05.14   hof: rename from gap_encode_main.c -> gap_gve_jpeg.c
  *                              removed codeparts that does not deal with jpeg
  *                              ported to gimp-1.2 API
@@ -15,6 +17,17 @@
 #ifndef GAP_GVE_JPEG_H
 #define GAP_GVE_JPEG_H
 
+#include "gap_gve_raw.h"
+
+#define GAP_GIMPRC_VIDEO_ENCODER_JPEG_OPTIMIZE_CODING  "video-encoder-jpeg-optimize-coding"
+
+/* persistent JPEG encoder context (the libjpeg compression object,
+ * destination manager and quantization tables are set up once
+ * and are reused for all frames that are encoded with this context).
+ * A context must not be used by more than one thread at the same time.
+ */
+typedef struct GapGveJpegEncoder GapGveJpegEncoder;   /* nick: jenc */
+
 
 /* ------------------------------------
  *  gap_gve_jpeg_drawable_encode_jpeg
@@ -37,5 +50,61 @@ guchar *gap_gve_jpeg_drawable_encode_jpeg(GimpDrawable *drawable, gint32 jpeg_in
                                void *app0_buffer, gint32 app0_length);
 
 
+/* ------------------------------------
+ *  gap_gve_jpeg_rgb_buffer_encode_jpeg
+ * ------------------------------------
+ *  same as gap_gve_jpeg_drawable_encode_jpeg, but the picture is read
+ *  from rgbBuffer (bpp 3). This procedure does not call the gimp PDB
+ *  and can be used in encoder worker threads.
+ *  returns: guchar *: A buffer, allocated by this routines, which contains
+ *                     the compressed JPEG, NULL on error.
+ */
+guchar *gap_gve_jpeg_rgb_buffer_encode_jpeg(GapRgbPixelBuffer *rgbBuffer, gint32 jpeg_interlaced, gint32 *JPEG_size,
+                               gint32 jpeg_quality, gint32 odd_even, gint32 use_YUV411,
+                               void *app0_buffer, gint32 app0_length);
+
+
+/* ------------------------------------
+ *  gap_gve_jpeg_encoder_new
+ * ------------------------------------
+ *  create a persistent JPEG encoder context.
+ *  the parameters have the same meaning as in gap_gve_jpeg_drawable_encode_jpeg,
+ *  optimize_coding: TRUE: compute optimized huffman tables for each frame
+ *                   (smaller chunks, but slower encoding)
+ */
+GapGveJpegEncoder * gap_gve_jpeg_encoder_new(gint32 jpeg_interlaced, gint32 jpeg_quality
+                               , gint32 odd_even, gint32 use_YUV411, gboolean optimize_coding);
+
+/* ------------------------------------
+ *  gap_gve_jpeg_encoder_set_jfif
+ * ------------------------------------
+ *  switch the context jenc to standalone JPEG files
+ *  (JFIF header and the libjpeg default 2x2 chroma sampling
+ *  instead of the AVI/movtar settings)
+ */
+void                gap_gve_jpeg_encoder_set_jfif(GapGveJpegEncoder *jenc);
+
+/* ------------------------------------
+ *  gap_gve_jpeg_encoder_encode_rgb_buffer
+ * ------------------------------------
+ *  encode rgbBuffer (bpp 3) with the settings of the context jenc.
+ *  This procedure does not call the gimp PDB.
+ *  returns: guchar *: the compressed JPEG in the output memory of the context
+ *                     (owned by jenc, valid until the next encode call), NULL on error.
+ */
+guchar * gap_gve_jpeg_encoder_encode_rgb_buffer(GapGveJpegEncoder *jenc, GapRgbPixelBuffer *rgbBuffer
+                               , gint32 *JPEG_size, void *app0_buffer, gint32 app0_length);
+
+/* ------------------------------------
+ *  gap_gve_jpeg_encoder_encode_drawable
+ * ------------------------------------
+ *  same as gap_gve_jpeg_encoder_encode_rgb_buffer, but the picture is read
+ *  from the drawable (all rows at once into a buffer of the context).
+ */
+guchar * gap_gve_jpeg_encoder_encode_drawable(GapGveJpegEncoder *jenc, GimpDrawable *drawable
+                               , gint32 *JPEG_size, void *app0_buffer, gint32 app0_length);
+
+void     gap_gve_jpeg_encoder_free(GapGveJpegEncoder *jenc);
+
 
 #endif
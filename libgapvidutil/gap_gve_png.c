@@ -5,6 +5,7 @@
  *
  * In short, this module contains
  * .) software PNG encoder or
+ * .) PNG encoder for RGB buffers via libpng (no PDB calls, usable in worker threads)
  *
  */
 /* The GIMP -- an image manipulation program
@@ -27,6 +28,7 @@
 
 
 /* revision history (see svn)
+ * 2026.10.18   agent: added gap_gve_png_rgb_buffer_encode_png (libpng)
  * 2008.06.21   hof: created
  */
 
@@ -42,6 +44,8 @@
 
 #include <glib/gstdio.h>
 
+#include <png.h>
+
 /* GIMP includes */
 #include "gtk/gtk.h"
 #include "libgimp/gimp.h"
@@ -49,11 +53,24 @@
 /* GAP includes */
 #include "gap_libgapbase.h"
 #include "gap_pdb_calls.h"
+#include "gap_gve_raw.h"
+#include "gap_gve_png.h"
 
 #include "gtk/gtk.h"
 
 extern int gap_debug;
 
+typedef struct GapGvePngMemDest   /* nick: mdest */
+{
+  guchar  *data;
+  gsize    size;
+  gsize    allocated;
+} GapGvePngMemDest;
+
+static void      p_png_mem_write(png_structp png_ptr, png_bytep data, png_size_t length);
+static void      p_png_mem_flush(png_structp png_ptr);
+
+
 /* --------------------------------
  * p_save_as_tmp_png_file
  * --------------------------------
@@ -197,3 +214,115 @@ gap_gve_png_drawable_encode_png(GimpDrawable *drawable, gint32 png_interlaced, g
   return buffer;
   
 }  /* end gap_gve_png_drawable_encode_png */
+
+
+
+/* --------------------------------
+ * p_png_mem_write
+ * --------------------------------
+ * libpng write callback, appends the data to the (growing) memory destination.
+ */
+static void
+p_png_mem_write(png_structp png_ptr, png_bytep data, png_size_t length)
+{
+  GapGvePngMemDest *mdest;
+
+  mdest = (GapGvePngMemDest *)png_get_io_ptr(png_ptr);
+  if (mdest->size + length > mdest->allocated)
+  {
+    mdest->allocated = MAX(2 * mdest->allocated, mdest->size + length);
+    mdest->data = g_realloc(mdest->data, mdest->allocated);
+  }
+  memcpy(mdest->data + mdest->size, data, length);
+  mdest->size += length;
+
+}  /* end p_png_mem_write */
+
+
+/* --------------------------------
+ * p_png_mem_flush
+ * --------------------------------
+ */
+static void
+p_png_mem_flush(png_structp png_ptr)
+{
+  /* nothing to flush for memory destination */
+}  /* end p_png_mem_flush */
+
+
+/* --------------------------------
+ * gap_gve_png_rgb_buffer_encode_png
+ * --------------------------------
+ * compress the picture in rgbBuffer (bpp 3 or 4) to PNG via libpng.
+ *  in: rgbBuffer: the picture to be compressed.
+ *      png_compression: The compression of the generated PNG (0-9, where 9 is best, 0 fastest).
+ *  out:PNG_size: The size of the buffer that is returned.
+ *  returns: guchar *: A buffer, allocated by this routines, which contains
+ *                     the compressed PNG, NULL on error.
+ * This procedure does not call the gimp PDB and can be used in worker threads.
+ */
+guchar *
+gap_gve_png_rgb_buffer_encode_png(GapRgbPixelBuffer *rgbBuffer, gint32 *PNG_size
+                               , gint32 png_compression)
+{
+  png_structp        png_ptr;
+  png_infop          info_ptr;
+  GapGvePngMemDest  *mdest;
+  guchar            *PNG_data;
+  guint              row;
+
+  *PNG_size = 0;
+  png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if (png_ptr == NULL)
+  {
+    return (NULL);
+  }
+  info_ptr = png_create_info_struct(png_ptr);
+  if (info_ptr == NULL)
+  {
+    png_destroy_write_struct(&png_ptr, NULL);
+    return (NULL);
+  }
+
+  /* allocated before setjmp, the pointer itself is not changed by the write callback */
+  mdest = g_new0(GapGvePngMemDest, 1);
+
+  if (setjmp(png_jmpbuf(png_ptr)))
+  {
+    printf("gap_gve_png_rgb_buffer_encode_png: libpng error (width:%d height:%d bpp:%d)\n"
+      , (int)rgbBuffer->width
+      , (int)rgbBuffer->height
+      , (int)rgbBuffer->bpp
+      );
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+    g_free(mdest->data);
+    g_free(mdest);
+    return (NULL);
+  }
+
+  png_set_write_fn(png_ptr, mdest, p_png_mem_write, p_png_mem_flush);
+  png_set_compression_level(png_ptr, CLAMP(png_compression, 0, 9));
+  png_set_IHDR(png_ptr, info_ptr
+              , rgbBuffer->width
+              , rgbBuffer->height
+              , 8     /* bit_depth */
+              , (rgbBuffer->bpp == 4) ? PNG_COLOR_TYPE_RGB_ALPHA : PNG_COLOR_TYPE_RGB
+              , PNG_INTERLACE_NONE
+              , PNG_COMPRESSION_TYPE_DEFAULT
+              , PNG_FILTER_TYPE_DEFAULT
+              );
+  png_write_info(png_ptr, info_ptr);
+  for (row = 0; row < rgbBuffer->height; row++)
+  {
+    png_write_row(png_ptr, rgbBuffer->data + (row * rgbBuffer->rowstride));
+  }
+  png_write_end(png_ptr, info_ptr);
+  png_destroy_write_struct(&png_ptr, &info_ptr);
+
+  PNG_data = mdest->data;
+  *PNG_size = mdest->size;
+  g_free(mdest);
+
+  return (PNG_data);
+
+}  /* end gap_gve_png_rgb_buffer_encode_png */
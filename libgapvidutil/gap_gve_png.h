@@ -6,12 +6,14 @@
 
 
 /* revision history (see svn)
+ * 2026.10.18   agent: added gap_gve_png_rgb_buffer_encode_png
  * 2008.06.22   hof: created
  */
 
 #ifndef GAP_GVE_PNG_H
 #define GAP_GVE_PNG_H
 
+#include "gap_gve_raw.h"
 
 /* ------------------------------------
  *  gap_gve_png_drawable_encode_png
@@ -31,5 +33,17 @@ guchar *gap_gve_png_drawable_encode_png(GimpDrawable *drawable, gint32 png_inter
                                void *app0_buffer, gint32 app0_length);
 
 
+/* ------------------------------------
+ *  gap_gve_png_rgb_buffer_encode_png
+ * ------------------------------------
+ *  compress the picture in rgbBuffer via libpng (non interlaced).
+ *  This procedure does not call the gimp PDB and can be used in worker threads.
+ *  returns: guchar *: A buffer, allocated by this routines, which contains
+ *                     the compressed PNG, NULL on error.
+ */
+guchar *gap_gve_png_rgb_buffer_encode_png(GapRgbPixelBuffer *rgbBuffer, gint32 *PNG_size
+                               , gint32 png_compression);
+
+
 
 #endif
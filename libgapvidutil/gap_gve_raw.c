@@ -27,6 +27,7 @@
 
 
 /* revision history:
+ * version 2.8.xx; 2026.10.18  agent: added gap_gve_raw_RGB_or_BGR_rgb_buffer_encode
  * version 1.2.2; 2003.04.18  hof: gap_gve_raw_YUV420P_drawable_encode get all ros from gimp pixel region with one call
  *                                 (need full buffersize but is faster than get row by row)
  * version 1.2.2; 2002.12.15  hof: created
@@ -234,6 +235,58 @@ gap_gve_raw_RGB_or_BGR_drawable_encode(GimpDrawable *drawable, gint32 *RAW_size,
 }    /* end gap_gve_raw_RGB_or_BGR_drawable_encode */
 
 
+/* ----------------------------------------
+ * gap_gve_raw_RGB_or_BGR_rgb_buffer_encode
+ * ----------------------------------------
+ * Encode rgbBuffer to RAW Buffer (Bytesequence RGB or BGR)
+ * (no gimp calls, can run in encoder worker threads)
+ */
+guchar *
+gap_gve_raw_RGB_or_BGR_rgb_buffer_encode(GapRgbPixelBuffer *rgbBuffer, gint32 *RAW_size, gboolean vflip
+                        ,guchar *app0_buffer, gint32 app0_length, gboolean convertToBGR)
+{
+  GapRgbPixelBuffer  dstBufferLocal;
+  GapRgbPixelBuffer *dstBuffer;
+  guchar *RAW_data;
+  gint32  row;
+
+  if(app0_buffer == NULL)
+  {
+    app0_length = 0;
+  }
+  dstBuffer = &dstBufferLocal;
+  gap_gve_init_GapRgbPixelBuffer(dstBuffer, rgbBuffer->width, rgbBuffer->height);
+
+  *RAW_size = (rgbBuffer->width * rgbBuffer->height * 3) + app0_length;
+  RAW_data = (guchar *)g_malloc(*RAW_size);
+  if(app0_length > 0)
+  {
+    memcpy(RAW_data, app0_buffer, app0_length);
+  }
+
+  dstBuffer->data = RAW_data + app0_length;
+  for(row = 0; row < rgbBuffer->height; row++)
+  {
+    memcpy(&dstBuffer->data[row * dstBuffer->rowstride]
+          , &rgbBuffer->data[row * rgbBuffer->rowstride]
+          , dstBuffer->rowstride
+          );
+  }
+
+  if(convertToBGR)
+  {
+    gap_gve_convert_GapRgbPixelBuffer_To_BGR(dstBuffer);
+  }
+
+  if(vflip == TRUE)
+  {
+    gap_gve_vflip_GapRgbPixelBuffer(dstBuffer);
+  }
+
+  return(RAW_data);
+}    /* end gap_gve_raw_RGB_or_BGR_rgb_buffer_encode */
+
+
 /* ------------------------------------
  * gap_gve_raw_BGR_drawable_encode
  * ------------------------------------
@@ -27,6 +27,7 @@
 
 
 /* revision history:
+ * version 2.8.xx; 2026.10.18  agent: added gap_gve_raw_RGB_or_BGR_rgb_buffer_encode
  * version 1.2.2; 2002.12.15  hof: created
  */
 
@@ -185,6 +186,17 @@ guchar *
 gap_gve_raw_RGB_or_BGR_drawable_encode(GimpDrawable *drawable, gint32 *RAW_size, gboolean vflip
                         ,guchar *app0_buffer, gint32 app0_length, gboolean convertToBGR);
 
+/* ----------------------------------------
+ * gap_gve_raw_RGB_or_BGR_rgb_buffer_encode
+ * ----------------------------------------
+ * same as gap_gve_raw_RGB_or_BGR_drawable_encode, but the picture is read
+ * from rgbBuffer (bpp 3). This procedure does not call the gimp PDB
+ * and can be used in encoder worker threads.
+ */
+guchar *
+gap_gve_raw_RGB_or_BGR_rgb_buffer_encode(GapRgbPixelBuffer *rgbBuffer, gint32 *RAW_size, gboolean vflip
+                        ,guchar *app0_buffer, gint32 app0_length, gboolean convertToBGR);
+
 
 #endif
 
@@ -27,6 +27,10 @@
 
 
 /* revision history:
+ * version 2.8.xx; 2026.10.19  agent: added gap_gve_xvid_rgb_buffer_encode, conversion buffers are kept
+ *                                    per encoder session, xvidcore runs with the number of threads
+ *                                    configured in gimprc (video-encoder-xvid-threads)
+ *                                    gap_gve_xvid_init_with_threads (for use without gimprc access)
  * version 1.3.27; 2004.08.02  hof: updated to XVID-1.0 API (but does not work anymore)
  *                                  Colorspace XVID_CSP_RGB24 no longer supported
  * version 1.2.5;  2003.08.02  hof: use Colorspace XVID_CSP_RGB24  gives better quality and fixes Red-Blue colorflip errors
@@ -51,6 +55,7 @@
 #include "libgimp/gimp.h"
 
 /* GAP includes */
+#include "gap_libgapbase.h"
 #include "gap_gve_raw.h"
 #include "gap_gve_xvid.h"
 
@@ -204,10 +209,33 @@ gap_gve_xvid_algorithm_preset(GapGveXvidValues *xvid_val)
  * gap_gve_xvid_init
  * ------------------------------------
  * init XVID and create the encoder instance
- *
+ * (the number of encoder threads is configured in the gimprc)
  */
 GapGveXvidControl *
 gap_gve_xvid_init(gint32 width, gint32 height, gdouble framerate, GapGveXvidValues *xvid_val)
+{
+  gint32 numThreads;
+
+  numThreads = gap_base_get_gimprc_int_value(GAP_GIMPRC_VIDEO_ENCODER_XVID_THREADS
+                                            , gap_base_get_numProcessors()  /* default */
+                                            , 1    /* min */
+                                            , 16   /* max */
+                                            );
+  return (gap_gve_xvid_init_with_threads(width, height, framerate, xvid_val, numThreads));
+
+}   /* end gap_gve_xvid_init */
+
+
+/* ------------------------------------
+ * gap_gve_xvid_init_with_threads
+ * ------------------------------------
+ * init XVID and create the encoder instance with numThreads encoder threads
+ * (1 encodes in the calling thread).
+ * This procedure does not call the gimp PDB.
+ */
+GapGveXvidControl *
+gap_gve_xvid_init_with_threads(gint32 width, gint32 height, gdouble framerate, GapGveXvidValues *xvid_val
+                              , gint32 numThreads)
 {
   GapGveXvidControl     *xvid_control;
   xvid_gbl_init_t    *xvid_gbl_init;
@@ -328,8 +356,12 @@ gap_gve_xvid_init(gint32 width, gint32 height, gdouble framerate, GapGveXvidValu
   /* Maximum key frame interval */
   xvid_enc_create->max_key_interval          = xvid_val->max_key_interval;
 
-  /* No fancy thread tests */
-  xvid_enc_create->num_threads = 0;
+  /* encoder threads (1 encodes in the calling thread) */
+  xvid_enc_create->num_threads = (numThreads > 1) ? numThreads : 0;
+  if(gap_debug)
+  {
+    printf("gap_gve_xvid_init num_threads: %d\n", (int)xvid_enc_create->num_threads);
+  }
 
   /* Bframes settings TODO: pass params for Bframe settings  */
   xvid_enc_create->max_bframes = 0;                // ARG_MAXBFRAMES;
@@ -361,7 +393,7 @@ gap_gve_xvid_init(gint32 width, gint32 height, gdouble framerate, GapGveXvidValu
 
   xvid_enc_frame->version            = XVID_VERSION;
   xvid_enc_frame->length             = -1;      /* out: length returned by encoder */
-  xvid_enc_frame->input.csp          = XVID_CSP_YV12;  /*XVID_CSP_I420  XVID_CSP_BGR  | XVID_CSP_VFLIP */
+  xvid_enc_frame->input.csp          = XVID_CSP_BGR;  /* overwritten per frame in gap_gve_xvid_rgb_buffer_encode */
 
 
   /* Set up core's general features */
@@ -412,38 +444,86 @@ gap_gve_xvid_init(gint32 width, gint32 height, gdouble framerate, GapGveXvidValu
   }
 
   return(xvid_control);
-}   /* end gap_gve_xvid_init */
+}   /* end gap_gve_xvid_init_with_threads */
 
 
 /* ------------------------------------
- * gap_gve_xvid_drawable_encode
+ * p_xvid_rgb_to_bgr
  * ------------------------------------
- * Encode drawable to Buffer with xvid (Open DivX) encoding
- *
+ * copy rgbBuffer to the per session BGR conversion buffer
+ * (that is allocated at the first call)
+ */
+static guchar *
+p_xvid_rgb_to_bgr(GapRgbPixelBuffer *rgbBuffer, GapGveXvidControl  *xvid_control)
+{
+  gint32   bgrSize;
+  guint    row;
+
+  bgrSize = rgbBuffer->width * rgbBuffer->height * 3;
+  if(xvid_control->bgrSize != bgrSize)
+  {
+    g_free(xvid_control->bgrData);
+    xvid_control->bgrData = g_malloc(bgrSize);
+    xvid_control->bgrSize = bgrSize;
+  }
+
+  for(row = 0; row < rgbBuffer->height; row++)
+  {
+    guchar *src;
+    guchar *dst;
+    guint   col;
+
+    src = &rgbBuffer->data[row * rgbBuffer->rowstride];
+    dst = &xvid_control->bgrData[row * rgbBuffer->width * 3];
+    for(col = 0; col < rgbBuffer->width; col++)
+    {
+      dst[0] = src[2];
+      dst[1] = src[1];
+      dst[2] = src[0];
+      src += rgbBuffer->bpp;
+      dst += 3;
+    }
+  }
+
+  return (xvid_control->bgrData);
+
+}  /* end p_xvid_rgb_to_bgr */
+
+
+/* ------------------------------------
+ * gap_gve_xvid_rgb_buffer_encode
+ * ------------------------------------
+ * Encode rgbBuffer to Buffer with xvid (Open DivX) encoding
+ * (no gimp calls)
  */
 guchar *
-gap_gve_xvid_drawable_encode(GimpDrawable *drawable, gint32 *XVID_size,  GapGveXvidControl  *xvid_control
+gap_gve_xvid_rgb_buffer_encode(GapRgbPixelBuffer *rgbBuffer, gint32 *XVID_size,  GapGveXvidControl  *xvid_control
                       , int *keyframe
                       , void *app0_buffer, gint32 app0_length)
 {
-  gint32               RAW_size;
   guchar              *bitstream_data;
   guchar              *bitstream_ptr;
-  gboolean             l_vflip;
+  GTimer              *timer;
 
   xvid_enc_frame_t *xvid_enc_frame;
   xvid_enc_stats_t xvid_enc_stats;
   int xerr;
 
+  if(app0_buffer == NULL)
+  {
+    app0_length = 0;
+  }
   memset(&xvid_enc_stats, 0, sizeof(xvid_enc_stats));
   xvid_enc_stats.version = XVID_VERSION;
 
 
-  /* buffer for encoding (allocate in full uncompressed size to be on the save side) */
-  bitstream_data = (guchar *)g_malloc0((drawable->width * drawable->height * 3)
+  /* buffer for encoding (allocate in full uncompressed size to be on the save side)
+   * the caller takes the ownership of this buffer.
+   */
+  bitstream_data = (guchar *)g_malloc0((rgbBuffer->width * rgbBuffer->height * 3)
                                        + app0_length);
   bitstream_ptr = bitstream_data;
-  if(app0_buffer)
+  if(app0_length > 0)
   {
     memcpy(bitstream_data, app0_buffer, app0_length);
     bitstream_ptr += app0_length;
@@ -453,80 +533,133 @@ gap_gve_xvid_drawable_encode(GimpDrawable *drawable, gint32 *XVID_size,  GapGveX
 
   xvid_enc_frame->bitstream          = bitstream_ptr;
   xvid_enc_frame->length             = -1;      /* out: length returned by encoder */
-  /*xvid_enc_frame->input.csp         = XVID_CSP_YV12;*/  /*XVID_CSP_I420 XVID_CSP_BGR  | XVID_CSP_VFLIP */
-  xvid_enc_frame->input.csp          = XVID_CSP_BGR;  /*XVID_CSP_I420  XVID_CSP_BGR | XVID_CSP_VFLIP */
   xvid_enc_frame->quant_intra_matrix = NULL;   /* use built in default Matrix */
   xvid_enc_frame->quant_inter_matrix = NULL;   /* use built in default Matrix */
   xvid_enc_frame->quant              = 0;      /* 0: codec decides, 1..31 force quant for this frame */
   xvid_enc_frame->type               = XVID_TYPE_AUTO;     /* In/Out: let the codec decide between I-frame (1) and P-frame (0) */
 
-  /* XVID colorspace XVID_CSP_BGR uses  b,g,r packed 8bit per pixel (?? or r,g,b order ??)
-   * XVID colorspace I420 colorsapce (y,u,v planar)
-   *
-   * (we use the raw encoding procedure to convert the drawable to BGR
-   *  suitable for xvid input)
-   * (do?) we use vertical flip (yes for older xvid, no since 1.0.0)
-   * (RAW AVI and gimp have opposite vertical order of the pixel lines)
+  /* XVID colorspace XVID_CSP_BGR uses  b,g,r packed 8bit per pixel
+   * newer xvid versions (1.3) accept r,g,b packed (XVID_CSP_RGB), in that case
+   * the rgbBuffer is passed to the encoder without conversion.
+   * (no vertical flip since xvid 1.0.0)
    */
-  l_vflip = FALSE;
+  timer = g_timer_new();
+#ifdef XVID_CSP_RGB
+  xvid_enc_frame->input.csp          = XVID_CSP_RGB;
+  xvid_enc_frame->input.plane[0]     = rgbBuffer->data;
+  xvid_enc_frame->input.stride[0]    = rgbBuffer->rowstride;
+#else
+  xvid_enc_frame->input.csp          = XVID_CSP_BGR;
+  xvid_enc_frame->input.plane[0]     = p_xvid_rgb_to_bgr(rgbBuffer, xvid_control);
+  xvid_enc_frame->input.stride[0]    = (3 * rgbBuffer->width);
+  xvid_control->convertSeconds += g_timer_elapsed(timer, NULL);
+  g_timer_start(timer);
+#endif
+
+  /* This Call to xvid_encore Encodes one Frame with xvid compression */
+  xerr = xvid_encore(xvid_control->xvid_enc_create.handle, XVID_ENC_ENCODE, xvid_enc_frame, &xvid_enc_stats);
+  xvid_control->encodeSeconds += g_timer_elapsed(timer, NULL);
+  g_timer_destroy(timer);
 
-  /* XVID_CSP_BGR */
+  if(gap_debug)
   {
-    //xvid_enc_frame->input.plane[0] = gap_gve_raw_RGB_drawable_encode(drawable, &RAW_size, l_vflip, NULL, 0);
-    xvid_enc_frame->input.plane[0] = gap_gve_raw_BGR_drawable_encode(drawable, &RAW_size, l_vflip, NULL, 0);
-    xvid_enc_frame->input.stride [0] = (3 * xvid_control->xvid_enc_create.width);
+    printf("gap_gve_xvid_rgb_buffer_encode returnCODE: %d\n", (int)xerr);
+    printf("gap_gve_xvid_rgb_buffer_encode xvid_enc_frame->length: %d\n", (int)xvid_enc_frame->length);
   }
-//  /* XVID_CSP_YV12 */
-//  {
-//    xvid_enc_frame->input.plane[0] = gap_gve_raw_YUV420_drawable_encode(drawable, &RAW_size, l_vflip, NULL, 0);
-//    xvid_enc_frame->input.stride [0] = ???;
-//  }
 
-  if(xvid_enc_frame->input.plane[0])
+  /* since xvid 1.0 the encoded length  is returned,
+   * and errorcodes are negative values,
+   * the xvid_enc_frame->length field is ignored now
+   */
+  if(xerr>=0)
   {
-    /* This Call to xvid_encore Encodes one Frame with xvid compression */
-    xerr = xvid_encore(xvid_control->xvid_enc_create.handle, XVID_ENC_ENCODE, xvid_enc_frame, &xvid_enc_stats);
-    g_free(xvid_enc_frame->input.plane[0]);
-
-    if(gap_debug)
-    {
-      printf("gap_gve_xvid_drawable_encode returnCODE: %d\n", (int)xerr);
-      printf("gap_gve_xvid_drawable_encode xvid_enc_frame->length: %d\n", (int)xvid_enc_frame->length);
-    }
-    
-    /* since xvid 1.0 the encoded length  is returned,
-     * and errorcodes are negative values,
-     * the xvid_enc_frame->length field is ignored now
+    xvid_control->framesEncoded++;
+    *keyframe = xvid_enc_frame->type;
+    /*  *XVID_size = xvid_enc_frame->length + app0_length; */
+    *XVID_size = xerr + app0_length;
+
+    /*if(1==1)
+     *{
+     *   p_xvid_debug_write_mp4u_file(bitstream_data, *XVID_size);
+     *}
      */
-    if(xerr>=0)
-    {
-      *keyframe = xvid_enc_frame->type;
-      /*  *XVID_size = xvid_enc_frame->length + app0_length; */
-      *XVID_size = xerr + app0_length;
-
-      /*if(1==1)
-       *{
-       *   p_xvid_debug_write_mp4u_file(bitstream_data, *XVID_size);
-       *}
-       */
 
-      return(bitstream_data);
-    }
-    printf("gap_gve_xvid_drawable_encode returned ERRORCODE: %d\n", (int)xerr);
-  }
-  else
-  {
-    printf("gap_gve_xvid_drawable_encode ERROR gap_gve_raw_RGB_drawable_encode FAILED!\n");
+    return(bitstream_data);
   }
+  printf("gap_gve_xvid_rgb_buffer_encode returned ERRORCODE: %d\n", (int)xerr);
 
   *keyframe = FALSE;
   *XVID_size = 0;
   g_free(bitstream_data);
   return (NULL);
 
+} /* end gap_gve_xvid_rgb_buffer_encode */
+
+
+/* ------------------------------------
+ * gap_gve_xvid_drawable_encode
+ * ------------------------------------
+ * Encode drawable to Buffer with xvid (Open DivX) encoding
+ * (the pixels are read into the per session rgbBuffer of the xvid_control)
+ */
+guchar *
+gap_gve_xvid_drawable_encode(GimpDrawable *drawable, gint32 *XVID_size,  GapGveXvidControl  *xvid_control
+                      , int *keyframe
+                      , void *app0_buffer, gint32 app0_length)
+{
+  GapRgbPixelBuffer   *rgbBuffer;
+  GTimer              *timer;
+
+  rgbBuffer = &xvid_control->rgbBuffer;
+  if((rgbBuffer->data == NULL)
+  || (rgbBuffer->width != drawable->width)
+  || (rgbBuffer->height != drawable->height))
+  {
+    g_free(rgbBuffer->data);
+    gap_gve_init_GapRgbPixelBuffer(rgbBuffer, drawable->width, drawable->height);
+    rgbBuffer->data = (guchar *)g_malloc0(rgbBuffer->height * rgbBuffer->rowstride);
+  }
+
+  timer = g_timer_new();
+  gap_gve_drawable_to_RgbBuffer(drawable, rgbBuffer);
+  xvid_control->convertSeconds += g_timer_elapsed(timer, NULL);
+  g_timer_destroy(timer);
+
+  return (gap_gve_xvid_rgb_buffer_encode(rgbBuffer, XVID_size, xvid_control
+                                         , keyframe, app0_buffer, app0_length));
+
 } /* end gap_gve_xvid_drawable_encode */
 
 
+/* ------------------------------------
+ * gap_gve_xvid_print_statistics
+ * ------------------------------------
+ */
+void
+gap_gve_xvid_print_statistics(GapGveXvidControl  *xvid_control)
+{
+  gdouble fps;
+
+  if(xvid_control == NULL)
+  {
+    return;
+  }
+  fps = 0.0;
+  if(xvid_control->encodeSeconds > 0.0)
+  {
+    fps = (gdouble)xvid_control->framesEncoded / xvid_control->encodeSeconds;
+  }
+  printf("XVID encoder: threads:%d frames:%d convert:%.3f sec encode:%.3f sec (%.2f fps)\n"
+    , (int)MAX(1, xvid_control->xvid_enc_create.num_threads)
+    , (int)xvid_control->framesEncoded
+    , (float)xvid_control->convertSeconds
+    , (float)xvid_control->encodeSeconds
+    , (float)fps
+    );
+
+}  /* end gap_gve_xvid_print_statistics */
+
+
 /* ------------------------------------
  * gap_gve_xvid_cleanup
  * ------------------------------------
@@ -537,6 +670,12 @@ void
 gap_gve_xvid_cleanup(GapGveXvidControl  *xvid_control)
 {
   xvid_encore(xvid_control->xvid_enc_create.handle, XVID_ENC_DESTROY, NULL, NULL);
+
+  g_free(xvid_control->rgbBuffer.data);
+  g_free(xvid_control->bgrData);
+  xvid_control->rgbBuffer.data = NULL;
+  xvid_control->bgrData = NULL;
+  xvid_control->bgrSize = 0;
 }
 
 #endif /* ENABLE_LIBXVIDCORE */
@@ -35,6 +35,10 @@
 #include "gtk/gtk.h"
 #include "libgimp/gimp.h"
 
+#include "gap_gve_raw.h"
+
+#define GAP_GIMPRC_VIDEO_ENCODER_XVID_THREADS  "video-encoder-xvid-threads"
+
 typedef struct GapGveXvidValues
 {
   gint32  rc_bitrate;                  /* default 900000 */
@@ -75,6 +79,16 @@ typedef struct GapGveXvidControl
 
  xvid_enc_frame_t xvid_enc_frame;
  xvid_enc_stats_t xvid_enc_stats;
+
+ /* per session buffers (allocated at the 1st frame, reused for all further frames) */
+ GapRgbPixelBuffer rgbBuffer;         /* pixels read from the drawable */
+ guchar           *bgrData;           /* RGB to BGR conversion buffer (not used if xvid accepts RGB input) */
+ gint32            bgrSize;
+
+ /* statistics */
+ gint32            framesEncoded;
+ gdouble           convertSeconds;    /* drawable readback and colorspace conversion */
+ gdouble           encodeSeconds;     /* time spent in xvid_encore */
 } GapGveXvidControl;
 
 /* ------------------------------------
@@ -97,8 +111,25 @@ guchar *             gap_gve_xvid_drawable_encode(GimpDrawable *drawable
                                          , int *keyframe
                                          , void *app0_buffer, gint32 app0_length
                                          );
+
+/* ------------------------------------
+ *  gap_gve_xvid_rgb_buffer_encode
+ * ------------------------------------
+ *  same as gap_gve_xvid_drawable_encode, but the picture is read
+ *  from rgbBuffer (bpp 3, size as configured in gap_gve_xvid_init).
+ *  This procedure does not call the gimp PDB.
+ */
+guchar *             gap_gve_xvid_rgb_buffer_encode(GapRgbPixelBuffer *rgbBuffer
+                                         , gint32 *XVID_size
+                                         , GapGveXvidControl  *xvid_control
+                                         , int *keyframe
+                                         , void *app0_buffer, gint32 app0_length
+                                         );
+void                 gap_gve_xvid_print_statistics(GapGveXvidControl  *xvid_control);
 void                 gap_gve_xvid_algorithm_preset(GapGveXvidValues *xvid_val);
 GapGveXvidControl*   gap_gve_xvid_init(gint32 width, gint32 height, gdouble framerate, GapGveXvidValues *xvid_val);
+GapGveXvidControl*   gap_gve_xvid_init_with_threads(gint32 width, gint32 height, gdouble framerate
+                                         , GapGveXvidValues *xvid_val, gint32 numThreads);
 void                 gap_gve_xvid_cleanup(GapGveXvidControl  *xvid_control);
 
 
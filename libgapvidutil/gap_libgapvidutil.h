@@ -54,6 +54,8 @@
 #include "gap_gve_xvid.h"
 
 #include "gap_gve_misc_util.h"
+#include "gap_gve_frame_writer.h"
+#include "gap_gve_audio_reader.h"
 #include "gap_gve_story.h"
 #include "gap_gve_sox.h"
 
@@ -27,6 +27,13 @@
  */
 
 /* revision history:
+ * version 2.8.xx;  2026.10.19   agent: print XVID encoder statistics (threads, encode fps)
+ * version 2.8.xx;  2026.10.19   agent: optional incremental encoding (unchanged segments of the previous
+ *                                     encode are copied for the intra frame codecs JPEG, MJPG, PNG and RAW)
+ * version 2.8.xx;  2026.10.18   agent: audio is read by a buffered reader thread, the audio interleave period
+ *                                     is configurable (in milliseconds), added optional A/V sync check.
+ * version 2.8.xx;  2026.10.18   agent: video and audio chunks are written via the encode queue,
+ *                                     JPEG/MJPG/RAW frames are encoded in parallel encoder threads.
  * version 2.1.0b;  2004.10.07   hof: bugfix init xvid_control->plugins[xvid_enc_create->num_plugins]
  *                                    must start at index 0 (not at 1)
  *                  2004.10.05   hof: relinked with xvid-1.0.2 (same crash)
@@ -63,10 +70,15 @@
 #include "gap_gve_xvid.h"      /* for XVID CODEC support */
 #include "gap_enc_avi_main.h"
 #include "gap_enc_avi_gui.h"
+#include "gap_enc_avi_queue.h"
+#include "gap_gve_audio_reader.h"
+#include "gap_story_render_segcache.h"
 
 
 
 static gint p_avi_encode(GapGveAviGlobalParams *gpp);
+static void p_avi_check_av_sync(char *filename);
+static void p_avi_enable_segment_cache(GapGveAviGlobalParams *gpp, GapGveStoryVidHandle *vidhand);
 
 
 /* Includes for extra LIBS */
@@ -589,6 +601,159 @@ p_dimSizeOfRawFrame(GapGveAviGlobalParams *gpp)
 }  /* end p_dimSizeOfRawFrame */
 
 
+/* ============================================================================
+ * p_avi_check_av_sync
+ *    read back the index of the written AVI file and report
+ *    the audio/video drift:
+ *    - the interleave drift is the difference between the audio time
+ *      that is stored in front of a video frame and the end time of this frame
+ *      (positive values: audio leads, negative values: audio lags)
+ *    - the duration difference of the complete audio and video streams.
+ * ============================================================================
+ */
+static void
+p_avi_check_av_sync(char *filename)
+{
+  avi_t   *l_avi;
+  long     l_frames;
+  long     l_chunks;
+  long     l_frame_idx;
+  long     l_chunk_idx;
+  gdouble  l_fps;
+  gdouble  l_audio_bytes_per_sec;
+  gdouble  l_audio_bytes_before;
+  gdouble  l_drift;
+  gdouble  l_max_lead;
+  gdouble  l_max_lag;
+  gdouble  l_video_secs;
+  gdouble  l_audio_secs;
+  int      l_ii;
+
+  l_avi = AVI_open_input_file(filename, 1 /* getIndex */);
+  if(l_avi == NULL)
+  {
+    printf("AVI A/V sync check: can not read %s (%s)\n", filename, AVI_strerror());
+    return;
+  }
+
+  l_frames = AVI_video_frames(l_avi);
+  l_chunks = AVI_audio_chunks(l_avi);
+  l_fps = MAX(0.001, AVI_frame_rate(l_avi));
+  l_audio_bytes_per_sec = (gdouble)AVI_audio_rate(l_avi)
+                        * (gdouble)AVI_audio_channels(l_avi)
+                        * ((gdouble)AVI_audio_bits(l_avi) / 8.0);
+
+  if((l_chunks <= 0) || (l_audio_bytes_per_sec <= 0.0) || (l_frames <= 0))
+  {
+    printf("AVI A/V sync check: %s  video frames:%d  (no audio)\n", filename, (int)l_frames);
+  }
+  else
+  {
+    l_chunk_idx = 0;
+    l_audio_bytes_before = 0.0;
+    l_max_lead = 0.0;
+    l_max_lag = 0.0;
+    for(l_frame_idx = 0; l_frame_idx < l_frames; l_frame_idx++)
+    {
+      audio_index_entry *l_aidx;
+
+      l_aidx = l_avi->track[0].audio_index;
+      while((l_chunk_idx < l_chunks)
+      &&    (l_aidx[l_chunk_idx].pos < l_avi->video_index[l_frame_idx].pos))
+      {
+        l_audio_bytes_before = (gdouble)l_aidx[l_chunk_idx].tot + (gdouble)l_aidx[l_chunk_idx].len;
+        l_chunk_idx++;
+      }
+      l_drift = (l_audio_bytes_before / l_audio_bytes_per_sec)
+              - ((gdouble)(l_frame_idx + 1) / l_fps);
+      l_max_lead = MAX(l_max_lead, l_drift);
+      l_max_lag = MIN(l_max_lag, l_drift);
+    }
+
+    l_video_secs = (gdouble)l_frames / l_fps;
+    l_audio_secs = (gdouble)AVI_audio_bytes(l_avi) / l_audio_bytes_per_sec;
+    printf("AVI A/V sync check: %s  video frames:%d  audio chunks:%d\n"
+           "AVI A/V sync check: interleave drift: max audio lead:%.1f ms  max audio lag:%.1f ms\n"
+           "AVI A/V sync check: duration video:%.3f sec  audio:%.3f sec  (audio - video:%.1f ms)\n"
+      , filename
+      , (int)l_frames
+      , (int)l_chunks
+      , (float)(l_max_lead * 1000.0)
+      , (float)(-1.0 * l_max_lag * 1000.0)
+      , (float)l_video_secs
+      , (float)l_audio_secs
+      , (float)((l_audio_secs - l_video_secs) * 1000.0)
+      );
+  }
+
+  /* AVI_close does not free the audio index */
+  for(l_ii = 0; l_ii < l_avi->anum; l_ii++)
+  {
+    if(l_avi->track[l_ii].audio_index)
+    {
+      free(l_avi->track[l_ii].audio_index);
+      l_avi->track[l_ii].audio_index = NULL;
+    }
+  }
+  AVI_close(l_avi);
+
+}  /* end p_avi_check_av_sync */
+
+
+/* ---------------------------------
+ * p_avi_enable_segment_cache
+ * ---------------------------------
+ * enable incremental encoding (if configured in gimprc).
+ * This is done only for the intra frame codecs, where each frame
+ * is a keyframe and segments of any length can be copied.
+ */
+static void
+p_avi_enable_segment_cache(GapGveAviGlobalParams *gpp, GapGveStoryVidHandle *vidhand)
+{
+  GapGveAviValues *epp;
+  gchar           *settings;
+
+  epp = &gpp->evl;
+
+  if ((strcmp(epp->codec_name, GAP_AVI_CODEC_RGB) != 0)
+  && (strcmp(epp->codec_name, GAP_AVI_CODEC_RAW) != 0)
+  && (strcmp(epp->codec_name, GAP_AVI_CODEC_PNG) != 0)
+  && (strcmp(epp->codec_name, GAP_AVI_CODEC_MJPG) != 0)
+  && (strcmp(epp->codec_name, GAP_AVI_CODEC_JPEG) != 0))
+  {
+    return;
+  }
+
+  /* all encoder parameters must be equal to reuse the previous encode */
+  settings = g_strdup_printf("avi %s %d %d %d %d %d %d %d %d %dx%d %.4f %s"
+                            , epp->codec_name
+                            , (int)epp->APP0_marker
+                            , (int)epp->jpeg_interlaced
+                            , (int)epp->jpeg_quality
+                            , (int)epp->jpeg_odd_even
+                            , (int)epp->raw_vflip
+                            , (int)epp->raw_bgr
+                            , (int)epp->png_interlaced
+                            , (int)epp->png_compression
+                            , (int)gpp->val.vid_width
+                            , (int)gpp->val.vid_height
+                            , (float)gpp->val.framerate
+                            , gpp->val.filtermacro_file
+                            );
+
+  gap_story_render_enable_segment_cache(vidhand
+                                       , gpp->val.videoname
+                                       , gpp->val.range_from
+                                       , gpp->val.range_to
+                                       , 1       /* each frame is a keyframe */
+                                       , settings
+                                       , TRUE    /* allowReuse */
+                                       );
+  g_free(settings);
+
+}  /* end p_avi_enable_segment_cache */
+
+
 /* ============================================================================
  * p_avi_encode
  *    The main "productive" routine
@@ -603,7 +768,6 @@ p_dimSizeOfRawFrame(GapGveAviGlobalParams *gpp)
 static gint
 p_avi_encode(GapGveAviGlobalParams *gpp)
 {
-#define AUDIO_CHUNK_ADVANCE_FRAMES 16
   GapGveAviValues   *epp;
   avi_t               *l_avifile;
   static GapGveStoryVidHandle *l_vidhand = NULL;
@@ -637,14 +801,19 @@ p_avi_encode(GapGveAviGlobalParams *gpp)
   gdouble        audio_samples_per_frame;
   gint32         audio_samples_per_frame_gint32;
   gint32         audio_bytes_per_frame_gint32;
-  gint32         audio_bytes_done_in_advance = 0;
+  gint32         audio_interleave_ms;
+  gint32         audio_interleave_frames;
+  gint32         audio_frames_covered = 0;   /* number of frames that are covered by the written audio */
+  gint64         audio_samples_done = 0;
   gint32         l_frames_to_go;
 
   gint32 wavsize = 0; /* Data size of the wav file */
   long audio_margin = 8192; /* The audio chunk size */
 
-
-  guchar databuffer[300000]; /* For transferring audio data */
+  guchar  *l_audio_buffer;    /* For transferring audio data (owned by the encode queue after push) */
+  GapGveAudioReader *l_audio_reader = NULL;
+  GapAviEncodeQueue *l_equeue = NULL;
+  GTimer  *l_stage_timer;
   gint32   l_video_frame_chunk_size;
   gint32   l_video_frame_chunk_hdr_size;
   gboolean l_dont_recode_frames;
@@ -679,6 +848,7 @@ p_avi_encode(GapGveAviGlobalParams *gpp)
 
   l_maxSizeOfRawFrame = p_dimSizeOfRawFrame(gpp);
   l_video_chunk_ptr = g_malloc0(l_maxSizeOfRawFrame);
+  l_stage_timer = g_timer_new();
 
   l_out_frame_nr = 0;
   l_rc = 0;
@@ -705,6 +875,9 @@ p_avi_encode(GapGveAviGlobalParams *gpp)
                                          ,&l_total_framecount
                                          );
     l_vidhand->do_gimp_progress = FALSE;
+
+    /* incremental encoding must be set up before the output video is created */
+    p_avi_enable_segment_cache(gpp, l_vidhand);
   }
 
   /* TODO check for overwrite */
@@ -743,7 +916,12 @@ p_avi_encode(GapGveAviGlobalParams *gpp)
 
     /* open WAVE file and set position to the 1.st audio databyte */
     l_fp_inwav = gap_audio_wav_open_seek_data(gpp->val.audioname1);
-    
+    if(l_fp_inwav)
+    {
+      /* the audio data is read ahead by a reader thread */
+      l_audio_reader = gap_gve_audio_reader_new(l_fp_inwav, wavsize);
+    }
+
     if(gap_debug)
     {
       printf("Audiocheck results for file:%s\n", gpp->val.audioname1);
@@ -764,8 +942,20 @@ p_avi_encode(GapGveAviGlobalParams *gpp)
   audio_samples_per_frame_gint32 = (audio_samples_per_frame + 0.5);
   audio_bytes_per_frame_gint32 = audio_samples_per_frame_gint32 * l_bytes_per_sample;
 
+  /* audio chunks are written in advance for the duration of the interleave period */
+  audio_interleave_ms = gap_base_get_gimprc_int_value(GAP_GIMPRC_VIDEO_ENCODER_AVI_AUDIO_INTERLEAVE_MS
+                                          , GAP_AVI_DEFAULT_AUDIO_INTERLEAVE_MS  /* default */
+                                          , 1       /* min */
+                                          , 10000   /* max */
+                                          );
+  audio_interleave_frames = MAX(1, (((gdouble)audio_interleave_ms * gpp->val.framerate) / 1000.0) + 0.5);
+
   if(gap_debug)
   {
+    printf("  audio_interleave_ms:%d  audio_interleave_frames:%d\n"
+      , (int)audio_interleave_ms
+      , (int)audio_interleave_frames
+      );
     printf("  audio_samples_per_frame:%f\n", (float)audio_samples_per_frame);
     printf("  audio_samples_per_frame_gint32:%d\n", (int)audio_samples_per_frame_gint32);
     printf("  audio_bytes_per_frame_gint32:%d\n", (int)audio_bytes_per_frame_gint32);
@@ -846,6 +1036,14 @@ p_avi_encode(GapGveAviGlobalParams *gpp)
   }
 #endif
 
+  /* the encode queue writes all video and audio chunks in the pushed order
+   * (and encodes JPEG/MJPG/RAW frames in parallel encoder threads)
+   */
+  if(l_avifile != NULL)
+  {
+    l_equeue = gap_enc_avi_queue_new(l_avifile, epp);
+  }
+
   /* special setup (makes it possible to code sequences backwards)
    * (NOTE: Audio is NEVER played backwards)
    */
@@ -908,7 +1106,7 @@ p_avi_encode(GapGveAviGlobalParams *gpp)
     
       l_out_frame_nr++;
 
-
+      g_timer_start(l_stage_timer);
       l_fetch_ok = gap_story_render_fetch_composite_image_or_chunk(l_vidhand
                                            , l_cur_frame_nr
                                            , (gint32)  gpp->val.vid_width
@@ -927,6 +1125,8 @@ p_avi_encode(GapGveAviGlobalParams *gpp)
                                            , &l_video_frame_chunk_hdr_size
                                            , l_check_flags
                                            );
+      l_equeue->fetchSeconds += g_timer_elapsed(l_stage_timer, NULL);
+      l_equeue->framesFetched++;
       if(l_fetch_ok != TRUE)
       {
          l_rc = -1;
@@ -952,15 +1152,19 @@ p_avi_encode(GapGveAviGlobalParams *gpp)
               );
         }
         l_FRAME_size = l_video_frame_chunk_size - l_video_frame_chunk_hdr_size;
-        buffer = l_video_chunk_ptr + l_video_frame_chunk_hdr_size;
+        buffer = g_memdup(l_video_chunk_ptr + l_video_frame_chunk_hdr_size, l_FRAME_size);
 
-        AVI_write_frame(l_avifile, (char*)buffer, l_FRAME_size, TRUE /* all frames are keyframe for JPEG codec */);
+        if(!gap_enc_avi_queue_push_video_chunk(l_equeue, l_cur_frame_nr
+                          , buffer, l_FRAME_size
+                          , TRUE /* all frames are keyframe for JPEG codec */))
+        {
+          l_rc = -1;
+        }
 
       }
       else
       {
         /* encode one VIDEO FRAME */
-        gint32 l_nn;
         int    l_keyframe;
         guchar *l_app0_buffer;
         gint32  l_app0_len;
@@ -977,69 +1181,44 @@ p_avi_encode(GapGveAviGlobalParams *gpp)
         l_drawable = gimp_drawable_get (l_layer_id);
         if (gap_debug) printf("DEBUG: %s encoding frame %d\n", epp->codec_name, (int)l_cur_frame_nr);
 
+        /* the APP0 marker (if enabled) is prepared by the encode queue */
         l_app0_buffer = NULL;
-        l_app0_len = 0;
-
-        if(epp->APP0_marker)
+        l_app0_len = l_equeue->app0_length;
+        if(l_app0_len > 0)
         {
-          l_app0_len = 14;
-          l_app0_buffer = databuffer;  /* abusing databuffer for this */
-          /* ) */
-          for (l_nn = 0; l_nn < 14; l_nn++) l_app0_buffer[l_nn] = 0; /* abusing databuffer for this */
-          l_app0_buffer[0] = 'A';
-          l_app0_buffer[1] = 'V';
-          l_app0_buffer[2] = 'I';
-          l_app0_buffer[3] = '1';
-
-          if (epp->jpeg_interlaced)
-          {
-            l_app0_buffer[4] = (epp->jpeg_odd_even) ? 2 : 1;
-          }
+          l_app0_buffer = &l_equeue->app0_buffer[0];
         }
+        buffer = NULL;
 
-        if ((strcmp(epp->codec_name, GAP_AVI_CODEC_JPEG) == 0)
-        || (strcmp(epp->codec_name, GAP_AVI_CODEC_MJPG) == 0))
-        {
-          /* Compress the picture into a JPEG */
-          buffer = gap_gve_jpeg_drawable_encode_jpeg(l_drawable, epp->jpeg_interlaced,
-                                        &l_FRAME_size, epp->jpeg_quality, epp->jpeg_odd_even, FALSE, l_app0_buffer, l_app0_len);
-        }
-        else if (strcmp(epp->codec_name, GAP_AVI_CODEC_PNG) == 0)
+        if (l_equeue->codec != GAP_AVI_QUEUE_CODEC_NONE)
         {
-          /* Compress the picture into a PNG */
-          buffer = gap_gve_png_drawable_encode_png(l_drawable, epp->png_interlaced,
-                                        &l_FRAME_size, epp->png_compression, l_app0_buffer, l_app0_len);
+          GapRgbPixelBuffer *l_rgbBuffer;
+
+          /* JPEG, MJPG and RAW are encoded by the encode queue (in parallel encoder threads).
+           * here we only read the pixels from the drawable (requires gimp calls)
+           */
+          g_timer_start(l_stage_timer);
+          l_rgbBuffer = gap_gve_new_GapRgbPixelBuffer(l_drawable->width, l_drawable->height);
+          gap_gve_drawable_to_RgbBuffer(l_drawable, l_rgbBuffer);
+          l_equeue->fetchSeconds += g_timer_elapsed(l_stage_timer, NULL);
+
+          if(!gap_enc_avi_queue_push_rgb_buffer(l_equeue, l_cur_frame_nr, l_rgbBuffer))
+          {
+            g_message(_("ERROR: GAP AVI encoder CODEC %s failed at frame %d")
+                     , epp->codec_name
+                     , (int)l_cur_frame_nr
+                     );
+            l_rc = -1;
+          }
         }
         else
         {
-          if ((strcmp(epp->codec_name, GAP_AVI_CODEC_RAW) == 0)
-          ||  (strcmp(epp->codec_name, GAP_AVI_CODEC_RGB) == 0))
+          g_timer_start(l_stage_timer);
+          if (strcmp(epp->codec_name, GAP_AVI_CODEC_PNG) == 0)
           {
-            gboolean l_vflip;
-            gboolean l_convertToBGR;
-
-            /* fill buffer with raw 24bit data, optional flipped or converted to BGR.
-             * it seems that some AVI players (for instance the WinDVD and VLC player)
-             *  require the inverse row order than gimp anf BGR colormodel
-             *  other players (like gmplayer on unix) does not want vflipped images.
-             */
-            l_vflip = FALSE;
-            if(epp->raw_vflip != 0)
-            {
-              l_vflip = TRUE;
-            }
-            l_convertToBGR = FALSE;
-            if(epp->raw_bgr != 0)
-            {
-              l_convertToBGR = TRUE;
-            }
-            buffer = gap_gve_raw_RGB_or_BGR_drawable_encode(l_drawable
-                     , &l_FRAME_size
-                     , l_vflip
-                     , l_app0_buffer
-                     , l_app0_len
-                     , l_convertToBGR
-                     );
+            /* Compress the picture into a PNG (uses the gimp PDB) */
+            buffer = gap_gve_png_drawable_encode_png(l_drawable, epp->png_interlaced,
+                                          &l_FRAME_size, epp->png_compression, l_app0_buffer, l_app0_len);
           }
 #ifdef ENABLE_LIBXVIDCORE
           else
@@ -1048,34 +1227,30 @@ p_avi_encode(GapGveAviGlobalParams *gpp)
             buffer = gap_gve_xvid_drawable_encode(l_drawable, &l_FRAME_size, xvid_control, &l_keyframe, l_app0_buffer, l_app0_len);
           }
 #endif
-        }
-
+          l_equeue->callerEncodeSeconds += g_timer_elapsed(l_stage_timer, NULL);
 
-        if(buffer)
-        {
-          /* store the compressed video frame */
-          if (gap_debug)
+          if(buffer)
           {
-            printf("GAP_AVI: Writing frame nr. %d, size %d  l_keyframe:%d\n"
-                 , (int)l_cur_frame_nr
-                 , (int)l_FRAME_size
-                 , (int)l_keyframe
-                 );
+            /* queue the compressed video frame for writing
+             * (the encode queue takes the ownership of the buffer)
+             */
+            if(!gap_enc_avi_queue_push_video_chunk(l_equeue, l_cur_frame_nr
+                              , buffer, l_FRAME_size, l_keyframe))
+            {
+              l_rc = -1;
+            }
+          }
+          else
+          {
+            /* the CODEC delivered a NULL buffer
+             * there is something essential wrong (TERMINATE)
+             */
+            g_message(_("ERROR: GAP AVI encoder CODEC %s delivered empty buffer at frame %d")
+                     , epp->codec_name
+                     , (int)l_cur_frame_nr
+                     );
+            l_rc = -1;
           }
-          AVI_write_frame(l_avifile, (char *)buffer, l_FRAME_size, l_keyframe);
-          /* free the (un)compressed Frame data buffer */
-          g_free(buffer);
-        }
-        else
-        {
-          /* the CODEC delivered a NULL buffer
-           * there is something essential wrong (TERMINATE)
-           */
-          g_message(_("ERROR: GAP AVI encoder CODEC %s delivered empty buffer at frame %d")
-                   , epp->codec_name
-                   , (int)l_cur_frame_nr
-                   );
-          l_rc = -1;
         }
 
         gimp_drawable_detach (l_drawable);
@@ -1093,23 +1268,31 @@ p_avi_encode(GapGveAviGlobalParams *gpp)
 
       /* encode AUDIO PART */
       /* As long as there is a video frame, write audio chunks.
-       * set AUDIO_CHUNK_ADVANCE_FRAMES = 1 triggers writing of an audio chunk for each handled frame.
-       * values > 1 do write one longer audio chunk in advance for duration of the defined number of frames,
-       * in this case the next audio chunk is written after the number of video frames reached.
+       * one audio chunk is written in advance for the duration of the
+       * interleave period (gimprc parameter video-encoder-avi-audio-interleave-ms),
+       * the next audio chunk is written when the video frames have reached the
+       * end of the already written audio.
+       * The chunk sizes are calculated from the exact (not rounded) number of
+       * audio samples per frame, so there is no accumulated drift.
        * in case the audio input is shorter than video playtime write the rest
        * and stop writing audio for all further frame.
        * in case the audio input is longer than video playtime it is truncated.
        * (i.e. the remaining audio is not written to the resulting video file).
+       * The audio data is delivered by the buffered audio reader thread.
        */
-      if ((l_fp_inwav) && (wavsize > 0))
+      if ((l_audio_reader) && (wavsize > 0) && (l_out_frame_nr > audio_frames_covered))
       {
         gint32 datasize;
         gint32 l_frames_advance;
-        
-        
-        l_frames_advance = MIN(AUDIO_CHUNK_ADVANCE_FRAMES, l_frames_to_go);
-        audio_margin = MIN((audio_bytes_per_frame_gint32 * l_frames_advance), sizeof(databuffer) -1);
-        
+        gint64 l_target_samples;
+
+        l_frames_advance = MIN(audio_interleave_frames, l_frames_to_go);
+        audio_frames_covered = (l_out_frame_nr - 1) + l_frames_advance;
+        l_target_samples = ((gdouble)audio_frames_covered * audio_samples_per_frame) + 0.5;
+        audio_margin = (l_target_samples - audio_samples_done) * l_bytes_per_sample;
+        audio_margin = MIN(audio_margin, wavsize);
+        audio_samples_done = l_target_samples;
+
         if(gap_debug)
         {
           printf("audio_bytes_per_frame:%d  audio_margin: %d (to_go:%d advance:%d)\n"
@@ -1121,48 +1304,35 @@ p_avi_encode(GapGveAviGlobalParams *gpp)
         }
 
         datasize = 0;
-        if (audio_bytes_done_in_advance <= 0)
+        l_audio_buffer = NULL;
+        if (audio_margin > 0)
         {
-          if (wavsize >= audio_margin)
+          l_audio_buffer = g_malloc(audio_margin);
+          datasize = gap_gve_audio_reader_read(l_audio_reader, l_audio_buffer, audio_margin);
+          if (datasize != audio_margin)
           {
-              datasize = fread(databuffer, 1, audio_margin, l_fp_inwav);
-              if (datasize != audio_margin)
-              {
-                printf("Warning: Read %d bytes from wav file failed. (got %d bytes)\n"
-                      ,(int)audio_margin
-                      ,(int)datasize
-                      );
-              }
-              wavsize -= audio_margin;
+            /* stop audio on read errors */
+            wavsize = 0;
           }
           else
           {
-              datasize = fread(databuffer, 1, wavsize, l_fp_inwav);
-              if (datasize != wavsize)
-              {
-                printf("Warning: Read rest of %d bytes from wav file failed. (got %d bytes)\n"
-                      ,(int)wavsize
-                      ,(int)datasize
-                      );
-              }
-              wavsize = 0;
+            wavsize -= datasize;
           }
         }
         if (datasize > 0)
         {
           if(gap_debug)
           {
-            printf("Now saving audio frame datasize:%d\n", (int)datasize);
+            printf("Now queue audio frame datasize:%d\n", (int)datasize);
           }
-          AVI_write_audio(l_avifile, (char *)databuffer, datasize);
-
-          if(gap_debug)
+          /* the encode queue takes the ownership of the audio buffer */
+          if(!gap_enc_avi_queue_push_audio_chunk(l_equeue, l_audio_buffer, datasize))
           {
-            printf("audio chunk written\n");
+            l_rc = -1;
           }
-          audio_bytes_done_in_advance = datasize;
+          l_audio_buffer = NULL;
         }
-        audio_bytes_done_in_advance -= audio_bytes_per_frame_gint32;
+        g_free(l_audio_buffer);
       }
 
 
@@ -1199,12 +1369,41 @@ p_avi_encode(GapGveAviGlobalParams *gpp)
   }  /* end loop foreach frame */
 
 
+  if(l_equeue != NULL)
+  {
+    /* wait until all queued frames are encoded and written */
+    if(!gap_enc_avi_queue_finish(l_equeue))
+    {
+      g_message(_("ERROR: GAP AVI encoder failed to write file:%s")
+               , gpp->val.videoname
+               );
+      l_rc = -1;
+    }
+    if(gap_debug)
+    {
+      gap_enc_avi_queue_print_statistics(l_equeue);
+    }
+    gap_enc_avi_queue_free(l_equeue);
+  }
 
   if(l_avifile != NULL)
   {
     AVI_close(l_avifile);
+    if((l_rc >= 0)
+    && ((gap_debug) || (gap_base_get_gimprc_gboolean_value(GAP_GIMPRC_VIDEO_ENCODER_AVI_SYNC_CHECK, FALSE))))
+    {
+      p_avi_check_av_sync(gpp->val.videoname);
+    }
   }
 
+  if(l_audio_reader)
+  {
+    if(gap_debug)
+    {
+      gap_gve_audio_reader_print_statistics(l_audio_reader, "AVI");
+    }
+    gap_gve_audio_reader_free(l_audio_reader);
+  }
   if(l_fp_inwav)
   {
     fclose(l_fp_inwav);
@@ -1213,6 +1412,10 @@ p_avi_encode(GapGveAviGlobalParams *gpp)
 #ifdef ENABLE_LIBXVIDCORE
   if(xvid_control)
   {
+    if(gap_debug)
+    {
+      gap_gve_xvid_print_statistics(xvid_control);
+    }
     gap_gve_xvid_cleanup(xvid_control);
     g_free(xvid_control);
   }
@@ -1230,6 +1433,7 @@ p_avi_encode(GapGveAviGlobalParams *gpp)
     printf("1:1 copied    frames: %d\n", (int)l_cnt_reused_frames);
     printf("total handled frames: %d\n", (int)l_cnt_encoded_frames + l_cnt_reused_frames);
   }
+  g_timer_destroy(l_stage_timer);
   g_free(l_video_chunk_ptr);
   return l_rc;
 }    /* end p_avi_encode */
@@ -3,6 +3,7 @@
  */
 /*
  * Changelog:
+ * version 2.8.xx;  2026.10.18   gimprc names for audio interleave and sync check
  * version 2.1.0a;  2004.06.12   created
  */
 
@@ -36,6 +37,10 @@
 #define GAP_HELP_ID_AVI_PARAMS         "plug-in-gap-encpar-avi1"
 #define GAP_MENUNAME                   "AVI1"
 
+#define GAP_GIMPRC_VIDEO_ENCODER_AVI_AUDIO_INTERLEAVE_MS  "video-encoder-avi-audio-interleave-ms"
+#define GAP_AVI_DEFAULT_AUDIO_INTERLEAVE_MS               500
+#define GAP_GIMPRC_VIDEO_ENCODER_AVI_SYNC_CHECK           "video-encoder-avi-sync-check"
+
 
 #define GAP_AVI_VIDCODEC_00_JPEG   0
 #define GAP_AVI_VIDCODEC_01_MJPG   1
@@ -0,0 +1,817 @@
+/* gap_enc_avi_queue.c
+ *    encode queue of the GIMP/GAP AVI Video Encoder
+ *
+ *  The AVI encoder fetches the frames from the storyboard render processor
+ *  (this requires gimp PDB calls and must be done in the main thread)
+ *  and pushes them in output order into this queue:
+ *  - frames of the intra-only codecs JPEG, MJPG and RAW are pushed as
+ *    RGB buffers and are encoded in parallel by a pool of encoder threads
+ *    into dynamically sized buffers.
+ *  - frames that are already encoded (1:1 copied chunks, PNG and XVID frames
+ *    that are encoded by the caller) and audio chunks are pushed as ready chunks.
+ *  A single writer thread writes the chunks strictly in the order they were
+ *  pushed via AVI_write_frame and AVI_write_audio. (the audio/video interleave
+ *  of the resulting AVI file is the same as in synchronous mode)
+ *  The caller blocks when the configured number of queued jobs is reached.
+ *
+ *  The number of encoder threads is configured with the gimprc parameter
+ *  video-encoder-avi-encoder-threads, where 1 (or missing thread support)
+ *  encodes and writes synchronously in the calling thread.
+ *
+ *  Note: the encoder and writer threads do not call the gimp PDB.
+ */
+
+/*
+ * Changelog:
+ * version 2.8.xx;  2026.10.19   JPEG frames are encoded with persistent encoder contexts
+ * version 2.8.xx;  2026.10.18   created
+ */
+
+/*
+ * Copyright
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+/* SYTEM (UNIX) includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* GIMP includes */
+#include "libgimp/gimp.h"
+
+/* GAP includes */
+#include "gap_libgapbase.h"
+#include "gap_gve_jpeg.h"
+#include "gap_gve_raw.h"
+#include "gap_enc_avi_main.h"
+#include "gap_enc_avi_queue.h"
+
+
+extern int gap_debug;  /* 1 == print debug infos , 0 dont print debug infos */
+
+#define QJOB_TYPE_VIDEO_ENCODE  0   /* rgbBuffer must be encoded */
+#define QJOB_TYPE_VIDEO_CHUNK   1   /* data is a ready video chunk */
+#define QJOB_TYPE_AUDIO_CHUNK   2   /* data is a ready audio chunk */
+
+typedef struct GapAviQueueJob   /* nick: qjob */
+{
+  gint32             jobType;
+  gint32             frame_nr;
+  GapRgbPixelBuffer *rgbBuffer;
+  guchar            *data;
+  gint32             data_size;
+  gboolean           keyframe;
+  gboolean           isReady;       /* TRUE when data is available for the writer */
+
+  struct GapAviQueueJob *next;
+} GapAviQueueJob;
+
+
+static GapGveJpegEncoder * p_get_jpeg_encoder(GapAviEncodeQueue *equeue);
+static void       p_release_jpeg_encoder(GapAviEncodeQueue *equeue, GapGveJpegEncoder *jenc);
+static void       p_encode_job(GapAviEncodeQueue *equeue, GapAviQueueJob *qjob);
+static gboolean   p_write_job(GapAviEncodeQueue *equeue, GapAviQueueJob *qjob);
+static void       p_free_job(GapAviQueueJob *qjob);
+static void       p_register_write(GapAviEncodeQueue *equeue, GapAviQueueJob *qjob
+                      , gboolean writeOk, gdouble secs);
+static void       p_encoder_thread_function(GapAviQueueJob *qjob, GapAviEncodeQueue *equeue);
+static gpointer   p_writer_thread_function(GapAviEncodeQueue *equeue);
+static gboolean   p_push_job(GapAviEncodeQueue *equeue, GapAviQueueJob *qjob);
+
+
+/* --------------------------------
+ * p_get_jpeg_encoder
+ * --------------------------------
+ * pick an idle JPEG encoder context (or create a new one if all are busy)
+ * the number of contexts is limited by the number of encoder threads.
+ */
+static GapGveJpegEncoder *
+p_get_jpeg_encoder(GapAviEncodeQueue *equeue)
+{
+  GapGveJpegEncoder *jenc;
+  GapGveAviValues   *epp;
+
+  jenc = NULL;
+  if (equeue->mutex != NULL)
+  {
+    g_mutex_lock(equeue->mutex);
+  }
+  if (equeue->jpegEncoders != NULL)
+  {
+    jenc = (GapGveJpegEncoder *)equeue->jpegEncoders->data;
+    equeue->jpegEncoders = g_slist_delete_link(equeue->jpegEncoders, equeue->jpegEncoders);
+  }
+  if (equeue->mutex != NULL)
+  {
+    g_mutex_unlock(equeue->mutex);
+  }
+
+  if (jenc == NULL)
+  {
+    epp = equeue->epp;
+    jenc = gap_gve_jpeg_encoder_new(epp->jpeg_interlaced
+                     , epp->jpeg_quality
+                     , epp->jpeg_odd_even
+                     , FALSE
+                     , equeue->jpegOptimizeCoding
+                     );
+  }
+  return (jenc);
+
+}  /* end p_get_jpeg_encoder */
+
+
+/* --------------------------------
+ * p_release_jpeg_encoder
+ * --------------------------------
+ */
+static void
+p_release_jpeg_encoder(GapAviEncodeQueue *equeue, GapGveJpegEncoder *jenc)
+{
+  if (equeue->mutex != NULL)
+  {
+    g_mutex_lock(equeue->mutex);
+  }
+  equeue->jpegEncoders = g_slist_prepend(equeue->jpegEncoders, jenc);
+  if (equeue->mutex != NULL)
+  {
+    g_mutex_unlock(equeue->mutex);
+  }
+
+}  /* end p_release_jpeg_encoder */
+
+
+/* --------------------------------
+ * p_encode_job
+ * --------------------------------
+ * encode the rgbBuffer of the job into a new (dynamically sized) chunk
+ * and free the rgbBuffer. (runs in the encoder threads)
+ * qjob->data is NULL if the codec failed.
+ */
+static void
+p_encode_job(GapAviEncodeQueue *equeue, GapAviQueueJob *qjob)
+{
+  GapGveAviValues *epp;
+  guchar          *app0_buffer;
+
+  epp = equeue->epp;
+  app0_buffer = NULL;
+  if (equeue->app0_length > 0)
+  {
+    app0_buffer = &equeue->app0_buffer[0];
+  }
+
+  qjob->keyframe = TRUE;  /* all frames are keyframes for the intra-only codecs */
+  if (equeue->codec == GAP_AVI_QUEUE_CODEC_JPEG)
+  {
+    GapGveJpegEncoder *jenc;
+    guchar            *jpegData;
+
+    /* the compressed data is in the output memory of the encoder context
+     * and is copied in exact size for the writer.
+     */
+    jenc = p_get_jpeg_encoder(equeue);
+    jpegData = gap_gve_jpeg_encoder_encode_rgb_buffer(jenc
+                     , qjob->rgbBuffer
+                     , &qjob->data_size
+                     , app0_buffer
+                     , equeue->app0_length
+                     );
+    qjob->data = NULL;
+    if (jpegData != NULL)
+    {
+      qjob->data = g_memdup(jpegData, qjob->data_size);
+    }
+    p_release_jpeg_encoder(equeue, jenc);
+  }
+  else
+  {
+    /* raw 24bit data, optional flipped or converted to BGR.
+     * (some AVI players require the inverse row order than gimp and BGR colormodel,
+     * other players like gmplayer on unix do not want vflipped images)
+     */
+    qjob->data = gap_gve_raw_RGB_or_BGR_rgb_buffer_encode(qjob->rgbBuffer
+                     , &qjob->data_size
+                     , (epp->raw_vflip != 0)
+                     , app0_buffer
+                     , equeue->app0_length
+                     , (epp->raw_bgr != 0)
+                     );
+  }
+
+  gap_gve_free_GapRgbPixelBuffer(qjob->rgbBuffer);
+  qjob->rgbBuffer = NULL;
+
+}  /* end p_encode_job */
+
+
+/* --------------------------------
+ * p_write_job
+ * --------------------------------
+ * write the chunk of the job to the AVI file.
+ * (runs in the writer thread, or in the caller in synchronous mode)
+ */
+static gboolean
+p_write_job(GapAviEncodeQueue *equeue, GapAviQueueJob *qjob)
+{
+  if (qjob->data == NULL)
+  {
+    printf("GAP_AVI: encoder queue: CODEC %s delivered empty buffer at frame %d\n"
+      , equeue->epp->codec_name
+      , (int)qjob->frame_nr
+      );
+    return (FALSE);
+  }
+
+  if (qjob->jobType == QJOB_TYPE_AUDIO_CHUNK)
+  {
+    if (AVI_write_audio(equeue->avifile, (char *)qjob->data, qjob->data_size) != 0)
+    {
+      printf("GAP_AVI: encoder queue: writing audio chunk (%d bytes) failed\n"
+        , (int)qjob->data_size
+        );
+      return (FALSE);
+    }
+    return (TRUE);
+  }
+
+  if (gap_debug)
+  {
+    printf("GAP_AVI: encoder queue: Writing frame nr. %d, size %d  keyframe:%d\n"
+       , (int)qjob->frame_nr
+       , (int)qjob->data_size
+       , (int)qjob->keyframe
+       );
+  }
+  if (AVI_write_frame(equeue->avifile, (char *)qjob->data, qjob->data_size, qjob->keyframe) != 0)
+  {
+    printf("GAP_AVI: encoder queue: writing frame %d (%d bytes) failed\n"
+      , (int)qjob->frame_nr
+      , (int)qjob->data_size
+      );
+    return (FALSE);
+  }
+  return (TRUE);
+
+}  /* end p_write_job */
+
+
+/* --------------------------------
+ * p_free_job
+ * --------------------------------
+ */
+static void
+p_free_job(GapAviQueueJob *qjob)
+{
+  gap_gve_free_GapRgbPixelBuffer(qjob->rgbBuffer);
+  g_free(qjob->data);
+  g_free(qjob);
+
+}  /* end p_free_job */
+
+
+/* --------------------------------
+ * p_register_write
+ * --------------------------------
+ * the caller must hold the mutex (in threaded mode)
+ */
+static void
+p_register_write(GapAviEncodeQueue *equeue, GapAviQueueJob *qjob, gboolean writeOk, gdouble secs)
+{
+  equeue->writeSeconds += secs;
+  if (!writeOk)
+  {
+    if (!equeue->failed)
+    {
+      equeue->failed = TRUE;
+      equeue->failedFrameNr = qjob->frame_nr;
+    }
+    return;
+  }
+
+  if (qjob->jobType == QJOB_TYPE_AUDIO_CHUNK)
+  {
+    equeue->audioChunksWritten++;
+    equeue->audioBytesWritten += qjob->data_size;
+  }
+  else
+  {
+    equeue->framesWritten++;
+    equeue->videoBytesWritten += qjob->data_size;
+  }
+
+}  /* end p_register_write */
+
+
+/* --------------------------------
+ * p_encoder_thread_function
+ * --------------------------------
+ */
+static void
+p_encoder_thread_function(GapAviQueueJob *qjob, GapAviEncodeQueue *equeue)
+{
+  GTimer  *timer;
+  gdouble  secs;
+
+  timer = g_timer_new();
+  p_encode_job(equeue, qjob);
+  secs = g_timer_elapsed(timer, NULL);
+  g_timer_destroy(timer);
+
+  g_mutex_lock(equeue->mutex);
+  equeue->encodeSeconds += secs;
+  equeue->framesEncoded++;
+  qjob->isReady = TRUE;
+  g_cond_broadcast(equeue->jobCond);
+  g_mutex_unlock(equeue->mutex);
+
+}  /* end p_encoder_thread_function */
+
+
+/* --------------------------------
+ * p_writer_thread_function
+ * --------------------------------
+ * writes the queued jobs in the order they were pushed.
+ * (waits until the first job in the queue is encoded)
+ * terminates when the queue is empty and the finishRequest is set.
+ * after a failure the remaining jobs are dropped.
+ */
+static gpointer
+p_writer_thread_function(GapAviEncodeQueue *equeue)
+{
+  GapAviQueueJob *qjob;
+  GTimer         *timer;
+
+  timer = g_timer_new();
+
+  g_mutex_lock(equeue->mutex);
+  while (TRUE)
+  {
+    gboolean writeOk;
+    gboolean skipWrite;
+    gdouble  secs;
+
+    qjob = (GapAviQueueJob *)equeue->first;
+    if (qjob == NULL)
+    {
+      if (equeue->finishRequest)
+      {
+        break;
+      }
+      g_cond_wait(equeue->jobCond, equeue->mutex);
+      continue;
+    }
+    if (qjob->isReady != TRUE)
+    {
+      g_cond_wait(equeue->jobCond, equeue->mutex);
+      continue;
+    }
+
+    equeue->first = qjob->next;
+    if (equeue->first == NULL)
+    {
+      equeue->last = NULL;
+    }
+    skipWrite = equeue->failed;
+    g_mutex_unlock(equeue->mutex);
+
+    writeOk = TRUE;
+    secs = 0.0;
+    if (!skipWrite)
+    {
+      g_timer_start(timer);
+      writeOk = p_write_job(equeue, qjob);
+      secs = g_timer_elapsed(timer, NULL);
+    }
+
+    g_mutex_lock(equeue->mutex);
+    if (!skipWrite)
+    {
+      p_register_write(equeue, qjob, writeOk, secs);
+    }
+    equeue->queuedJobs--;
+    g_cond_broadcast(equeue->jobCond);
+    g_mutex_unlock(equeue->mutex);
+
+    p_free_job(qjob);
+
+    g_mutex_lock(equeue->mutex);
+  }
+  g_mutex_unlock(equeue->mutex);
+
+  g_timer_destroy(timer);
+  return (NULL);
+
+}  /* end p_writer_thread_function */
+
+
+/* --------------------------------
+ * gap_enc_avi_queue_new
+ * --------------------------------
+ * create the encode queue for the (already opened) avifile.
+ * epp must stay valid until the queue is freed.
+ */
+GapAviEncodeQueue *
+gap_enc_avi_queue_new(avi_t *avifile, GapGveAviValues *epp)
+{
+  GapAviEncodeQueue *equeue;
+  gint32             numThreads;
+
+  equeue = g_new0(GapAviEncodeQueue, 1);
+  equeue->avifile = avifile;
+  equeue->epp = epp;
+  equeue->failedFrameNr = -1;
+  equeue->numEncoderThreads = 1;
+  equeue->timer = g_timer_new();
+
+  equeue->codec = GAP_AVI_QUEUE_CODEC_NONE;
+  equeue->jpegOptimizeCoding = gap_base_get_gimprc_gboolean_value(GAP_GIMPRC_VIDEO_ENCODER_JPEG_OPTIMIZE_CODING
+                                            , FALSE  /* default */
+                                            );
+  if ((strcmp(epp->codec_name, GAP_AVI_CODEC_JPEG) == 0)
+  ||  (strcmp(epp->codec_name, GAP_AVI_CODEC_MJPG) == 0))
+  {
+    equeue->codec = GAP_AVI_QUEUE_CODEC_JPEG;
+  }
+  if ((strcmp(epp->codec_name, GAP_AVI_CODEC_RAW) == 0)
+  ||  (strcmp(epp->codec_name, GAP_AVI_CODEC_RGB) == 0))
+  {
+    equeue->codec = GAP_AVI_QUEUE_CODEC_RAW;
+  }
+
+  if (epp->APP0_marker)
+  {
+    equeue->app0_length = 14;
+    equeue->app0_buffer[0] = 'A';
+    equeue->app0_buffer[1] = 'V';
+    equeue->app0_buffer[2] = 'I';
+    equeue->app0_buffer[3] = '1';
+    if (epp->jpeg_interlaced)
+    {
+      equeue->app0_buffer[4] = (epp->jpeg_odd_even) ? 2 : 1;
+    }
+  }
+
+  numThreads = gap_base_get_gimprc_int_value(GAP_GIMPRC_VIDEO_ENCODER_AVI_ENCODER_THREADS
+                                            , gap_base_get_numProcessors()  /* default */
+                                            , 1   /* min */
+                                            , 16  /* max */
+                                            );
+  if ((numThreads > 1)
+  &&  (gap_base_thread_init()))
+  {
+    GError *error = NULL;
+
+    equeue->mutex = g_mutex_new();
+    equeue->jobCond = g_cond_new();
+    equeue->maxQueuedJobs = 2 * numThreads;
+
+    if (equeue->codec != GAP_AVI_QUEUE_CODEC_NONE)
+    {
+      equeue->encoderPool = g_thread_pool_new((GFunc) p_encoder_thread_function
+                                         , equeue      /* user data */
+                                         , numThreads  /* max_threads */
+                                         , TRUE        /* exclusive */
+                                         , &error      /* GError **error */
+                                         );
+    }
+    if ((equeue->encoderPool != NULL)
+    ||  (equeue->codec == GAP_AVI_QUEUE_CODEC_NONE))
+    {
+      equeue->writerThread = g_thread_create((GThreadFunc) p_writer_thread_function
+                                         , equeue
+                                         , TRUE       /* joinable */
+                                         , &error     /* GError **error */
+                                         );
+    }
+
+    if (equeue->writerThread == NULL)
+    {
+      printf("gap_enc_avi_queue_new: threads not available, using synchronous encoding %s\n"
+        , (error != NULL) ? error->message : ""
+        );
+      if (error != NULL)
+      {
+        g_error_free(error);
+      }
+      if (equeue->encoderPool != NULL)
+      {
+        g_thread_pool_free(equeue->encoderPool, FALSE, TRUE);
+        equeue->encoderPool = NULL;
+      }
+      g_cond_free(equeue->jobCond);
+      g_mutex_free(equeue->mutex);
+      equeue->jobCond = NULL;
+      equeue->mutex = NULL;
+      equeue->maxQueuedJobs = 0;
+    }
+    else if (equeue->encoderPool != NULL)
+    {
+      equeue->numEncoderThreads = numThreads;
+    }
+  }
+
+  if (gap_debug)
+  {
+    printf("gap_enc_avi_queue_new: codec:%s queue codec:%d threads:%d encoderPool:%d writerThread:%d maxQueuedJobs:%d\n"
+      , epp->codec_name
+      , (int)equeue->codec
+      , (int)numThreads
+      , (int)(equeue->encoderPool != NULL)
+      , (int)(equeue->writerThread != NULL)
+      , (int)equeue->maxQueuedJobs
+      );
+  }
+  return (equeue);
+
+}  /* end gap_enc_avi_queue_new */
+
+
+/* --------------------------------
+ * p_push_job
+ * --------------------------------
+ * the queue takes the ownership of qjob.
+ * returns FALSE if this job (synchronous mode) or any previous job failed.
+ */
+static gboolean
+p_push_job(GapAviEncodeQueue *equeue, GapAviQueueJob *qjob)
+{
+  if (equeue->writerThread == NULL)
+  {
+    GTimer  *timer;
+    gboolean writeOk;
+
+    if (equeue->failed)
+    {
+      p_free_job(qjob);
+      return (FALSE);
+    }
+    timer = g_timer_new();
+    if (qjob->jobType == QJOB_TYPE_VIDEO_ENCODE)
+    {
+      p_encode_job(equeue, qjob);
+      equeue->encodeSeconds += g_timer_elapsed(timer, NULL);
+      equeue->framesEncoded++;
+      g_timer_start(timer);
+    }
+    writeOk = p_write_job(equeue, qjob);
+    p_register_write(equeue, qjob, writeOk, g_timer_elapsed(timer, NULL));
+    g_timer_destroy(timer);
+    p_free_job(qjob);
+    return (!equeue->failed);
+  }
+
+  g_mutex_lock(equeue->mutex);
+  while ((equeue->queuedJobs >= equeue->maxQueuedJobs)
+  &&     (!equeue->failed))
+  {
+    g_cond_wait(equeue->jobCond, equeue->mutex);
+  }
+  if (equeue->failed)
+  {
+    g_mutex_unlock(equeue->mutex);
+    p_free_job(qjob);
+    return (FALSE);
+  }
+
+  if (equeue->last != NULL)
+  {
+    ((GapAviQueueJob *)equeue->last)->next = qjob;
+  }
+  else
+  {
+    equeue->first = qjob;
+  }
+  equeue->last = qjob;
+  equeue->queuedJobs++;
+  g_cond_broadcast(equeue->jobCond);
+  g_mutex_unlock(equeue->mutex);
+
+  if (qjob->jobType == QJOB_TYPE_VIDEO_ENCODE)
+  {
+    g_thread_pool_push(equeue->encoderPool, qjob, NULL);
+  }
+  return (TRUE);
+
+}  /* end p_push_job */
+
+
+/* --------------------------------
+ * gap_enc_avi_queue_push_rgb_buffer
+ * --------------------------------
+ * queue the frame rgbBuffer (bpp 3) for encoding with the JPEG or RAW codec.
+ * the queue takes the ownership of rgbBuffer
+ * (allocated by gap_gve_new_GapRgbPixelBuffer).
+ * must not be used for GAP_AVI_QUEUE_CODEC_NONE.
+ */
+gboolean
+gap_enc_avi_queue_push_rgb_buffer(GapAviEncodeQueue *equeue
+  , gint32 frame_nr
+  , GapRgbPixelBuffer *rgbBuffer
+  )
+{
+  GapAviQueueJob *qjob;
+
+  qjob = g_new0(GapAviQueueJob, 1);
+  qjob->jobType = QJOB_TYPE_VIDEO_ENCODE;
+  qjob->frame_nr = frame_nr;
+  qjob->rgbBuffer = rgbBuffer;
+  qjob->isReady = FALSE;
+
+  if (equeue->codec == GAP_AVI_QUEUE_CODEC_NONE)
+  {
+    printf("gap_enc_avi_queue_push_rgb_buffer: codec %s can not be encoded from RGB buffers\n"
+      , equeue->epp->codec_name
+      );
+    p_free_job(qjob);
+    return (FALSE);
+  }
+  return (p_push_job(equeue, qjob));
+
+}  /* end gap_enc_avi_queue_push_rgb_buffer */
+
+
+/* --------------------------------
+ * gap_enc_avi_queue_push_video_chunk
+ * --------------------------------
+ * queue an already encoded video chunk.
+ * the queue takes the ownership of data (allocated with g_malloc).
+ */
+gboolean
+gap_enc_avi_queue_push_video_chunk(GapAviEncodeQueue *equeue
+  , gint32 frame_nr
+  , guchar *data
+  , gint32 data_size
+  , gboolean keyframe
+  )
+{
+  GapAviQueueJob *qjob;
+
+  qjob = g_new0(GapAviQueueJob, 1);
+  qjob->jobType = QJOB_TYPE_VIDEO_CHUNK;
+  qjob->frame_nr = frame_nr;
+  qjob->data = data;
+  qjob->data_size = data_size;
+  qjob->keyframe = keyframe;
+  qjob->isReady = TRUE;
+
+  return (p_push_job(equeue, qjob));
+
+}  /* end gap_enc_avi_queue_push_video_chunk */
+
+
+/* --------------------------------
+ * gap_enc_avi_queue_push_audio_chunk
+ * --------------------------------
+ * queue an audio chunk (it is written behind all previously pushed video chunks)
+ * the queue takes the ownership of data (allocated with g_malloc).
+ */
+gboolean
+gap_enc_avi_queue_push_audio_chunk(GapAviEncodeQueue *equeue
+  , guchar *data
+  , gint32 data_size
+  )
+{
+  GapAviQueueJob *qjob;
+
+  qjob = g_new0(GapAviQueueJob, 1);
+  qjob->jobType = QJOB_TYPE_AUDIO_CHUNK;
+  qjob->frame_nr = -1;
+  qjob->data = data;
+  qjob->data_size = data_size;
+  qjob->isReady = TRUE;
+
+  return (p_push_job(equeue, qjob));
+
+}  /* end gap_enc_avi_queue_push_audio_chunk */
+
+
+/* --------------------------------
+ * gap_enc_avi_queue_finish
+ * --------------------------------
+ * wait until all queued jobs are encoded and written
+ * and terminate the encoder and writer threads.
+ * returns TRUE if all chunks were written successfully.
+ */
+gboolean
+gap_enc_avi_queue_finish(GapAviEncodeQueue *equeue)
+{
+  if (equeue->writerThread != NULL)
+  {
+    g_mutex_lock(equeue->mutex);
+    equeue->finishRequest = TRUE;
+    g_cond_broadcast(equeue->jobCond);
+    g_mutex_unlock(equeue->mutex);
+
+    g_thread_join(equeue->writerThread);
+    equeue->writerThread = NULL;
+  }
+  if (equeue->encoderPool != NULL)
+  {
+    /* all jobs are done at this point (immediate == FALSE, wait_ == TRUE) */
+    g_thread_pool_free(equeue->encoderPool, FALSE, TRUE);
+    equeue->encoderPool = NULL;
+  }
+
+  if (equeue->failed)
+  {
+    printf("gap_enc_avi_queue_finish: write failed at frame:%d\n"
+      , (int)equeue->failedFrameNr
+      );
+  }
+  return (!equeue->failed);
+
+}  /* end gap_enc_avi_queue_finish */
+
+
+/* --------------------------------
+ * gap_enc_avi_queue_print_statistics
+ * --------------------------------
+ * print the throughput of the stages fetch, encode and write.
+ * (the encode time is the sum of all encoder threads,
+ * fetch and write overlap with the encoding in threaded mode)
+ */
+void
+gap_enc_avi_queue_print_statistics(GapAviEncodeQueue *equeue)
+{
+  gdouble totalSeconds;
+
+  if (equeue == NULL)
+  {
+    return;
+  }
+  totalSeconds = g_timer_elapsed(equeue->timer, NULL);
+
+  printf("AVI encoder queue: codec:%s encoder threads:%d total: %.2f sec, %d frames (%.2f frames/sec)\n"
+    , equeue->epp->codec_name
+    , (int)equeue->numEncoderThreads
+    , (float)totalSeconds
+    , (int)equeue->framesWritten
+    , (float)(equeue->framesWritten / MAX(totalSeconds, 0.001))
+    );
+  printf("AVI encoder queue: fetch:  %.2f sec for %d frames (%.2f frames/sec)\n"
+    , (float)equeue->fetchSeconds
+    , (int)equeue->framesFetched
+    , (float)(equeue->framesFetched / MAX(equeue->fetchSeconds, 0.001))
+    );
+  printf("AVI encoder queue: encode: %.2f sec for %d frames in threads (%.2f frames/sec per thread)"
+         " %.2f sec in main thread\n"
+    , (float)equeue->encodeSeconds
+    , (int)equeue->framesEncoded
+    , (float)(equeue->framesEncoded / MAX(equeue->encodeSeconds, 0.001))
+    , (float)equeue->callerEncodeSeconds
+    );
+  printf("AVI encoder queue: write:  %.2f sec for %d frames (%.0f bytes) and %d audio chunks (%.0f bytes)"
+         " (%.2f MB/sec)\n"
+    , (float)equeue->writeSeconds
+    , (int)equeue->framesWritten
+    , (gdouble)equeue->videoBytesWritten
+    , (int)equeue->audioChunksWritten
+    , (gdouble)equeue->audioBytesWritten
+    , (float)(((equeue->videoBytesWritten + equeue->audioBytesWritten) / (1024.0 * 1024.0))
+              / MAX(equeue->writeSeconds, 0.001))
+    );
+
+}  /* end gap_enc_avi_queue_print_statistics */
+
+
+/* --------------------------------
+ * gap_enc_avi_queue_free
+ * --------------------------------
+ * finishes pending jobs and frees all resources.
+ */
+void
+gap_enc_avi_queue_free(GapAviEncodeQueue *equeue)
+{
+  if (equeue == NULL)
+  {
+    return;
+  }
+  gap_enc_avi_queue_finish(equeue);
+  if (equeue->mutex != NULL)
+  {
+    g_cond_free(equeue->jobCond);
+    g_mutex_free(equeue->mutex);
+  }
+  g_slist_foreach(equeue->jpegEncoders, (GFunc) gap_gve_jpeg_encoder_free, NULL);
+  g_slist_free(equeue->jpegEncoders);
+  g_timer_destroy(equeue->timer);
+  g_free(equeue);
+
+}  /* end gap_enc_avi_queue_free */
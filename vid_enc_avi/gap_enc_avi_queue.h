@@ -0,0 +1,102 @@
+/* gap_enc_avi_queue.h
+ *    encode queue of the GIMP/GAP AVI Video Encoder
+ *    (parallel encoding of intra-only codecs and ordered writing via avilib)
+ */
+/*
+ * Changelog:
+ * version 2.8.xx;  2026.10.19   JPEG encoder contexts are reused across frames
+ * version 2.8.xx;  2026.10.18   created
+ */
+
+/*
+ * Copyright
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAP_ENC_AVI_QUEUE_H
+#define GAP_ENC_AVI_QUEUE_H
+
+#include <config.h>
+#include "libgimp/gimp.h"
+#include "gap_gve_raw.h"
+#include "gap_enc_avi_main.h"
+#include "avilib.h"
+
+#define GAP_GIMPRC_VIDEO_ENCODER_AVI_ENCODER_THREADS  "video-encoder-avi-encoder-threads"
+
+/* codecs that can be encoded from RGB buffers in the encoder threads */
+#define GAP_AVI_QUEUE_CODEC_NONE   0     /* chunks are encoded by the caller (PNG, XVID) */
+#define GAP_AVI_QUEUE_CODEC_JPEG   1     /* JPEG and MJPG */
+#define GAP_AVI_QUEUE_CODEC_RAW    2     /* RAW and RGB */
+
+typedef struct GapAviEncodeQueue   /* nick: equeue */
+{
+  avi_t            *avifile;
+  GapGveAviValues  *epp;
+  gint32            codec;           /* one of GAP_AVI_QUEUE_CODEC_* */
+  guchar            app0_buffer[14];
+  gint32            app0_length;     /* 0 if no APP0 marker is written */
+
+  gint32            numEncoderThreads; /* 1 in synchronous mode */
+  GThreadPool      *encoderPool;     /* NULL in synchronous mode or for GAP_AVI_QUEUE_CODEC_NONE */
+  GThread          *writerThread;    /* NULL in synchronous mode (the caller writes) */
+  GMutex           *mutex;
+  GCond            *jobCond;
+  gpointer          first;           /* queued jobs in output order (GapAviQueueJob) */
+  gpointer          last;
+  gint32            maxQueuedJobs;
+  gint32            queuedJobs;
+  gboolean          finishRequest;
+  gboolean          failed;
+  gint32            failedFrameNr;
+  GSList           *jpegEncoders;    /* idle JPEG encoder contexts (GapGveJpegEncoder), one per busy encoder thread at most */
+  gboolean          jpegOptimizeCoding;
+
+  /* statistics per stage */
+  GTimer           *timer;           /* wall clock time since creation of the queue */
+  gdouble           fetchSeconds;    /* fetch and RGB conversion in the caller (maintained by the caller) */
+  gdouble           callerEncodeSeconds; /* PNG and XVID encoding in the caller (maintained by the caller) */
+  gdouble           encodeSeconds;   /* sum of all encoder threads */
+  gdouble           writeSeconds;
+  gint32            framesFetched;   /* maintained by the caller */
+  gint32            framesEncoded;
+  gint32            framesWritten;
+  gint32            audioChunksWritten;
+  gdouble           videoBytesWritten;
+  gdouble           audioBytesWritten;
+} GapAviEncodeQueue;
+
+
+GapAviEncodeQueue * gap_enc_avi_queue_new(avi_t *avifile, GapGveAviValues *epp);
+gboolean   gap_enc_avi_queue_push_rgb_buffer(GapAviEncodeQueue *equeue
+                 , gint32 frame_nr
+                 , GapRgbPixelBuffer *rgbBuffer
+                 );
+gboolean   gap_enc_avi_queue_push_video_chunk(GapAviEncodeQueue *equeue
+                 , gint32 frame_nr
+                 , guchar *data
+                 , gint32 data_size
+                 , gboolean keyframe
+                 );
+gboolean   gap_enc_avi_queue_push_audio_chunk(GapAviEncodeQueue *equeue
+                 , guchar *data
+                 , gint32 data_size
+                 );
+gboolean   gap_enc_avi_queue_finish(GapAviEncodeQueue *equeue);
+void       gap_enc_avi_queue_print_statistics(GapAviEncodeQueue *equeue);
+void       gap_enc_avi_queue_free(GapAviEncodeQueue *equeue);
+
+#endif
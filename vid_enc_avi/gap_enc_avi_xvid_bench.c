@@ -0,0 +1,229 @@
+/* gap_enc_avi_xvid_bench.c
+ *    standalone benchmark driver for the XVID (MPEG4) encoder of the AVI Video Encoder
+ *
+ *  Encodes generated frames (a moving gradient with a moving box, so that
+ *  motion estimation has some work to do) as GapRgbPixelBuffer via
+ *  gap_gve_xvid_rgb_buffer_encode and prints the encoder statistics.
+ *  The program runs without gimp (no PDB calls) and writes no output file.
+ *
+ *  This program is not installed, build it in the vid_enc_avi directory with:
+ *    make gap_enc_avi_xvid_bench
+ *
+ *  usage:
+ *    gap_enc_avi_xvid_bench [width height frames threads quality_preset]
+ *      defaults: 720 576 250 1 6
+ */
+
+/*
+ * Changelog:
+ * version 2.8.xx;  2026.10.19   created
+ */
+
+/*
+ * Copyright
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+/* SYTEM (UNIX) includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* GIMP includes */
+#include "gtk/gtk.h"
+#include "libgimp/gimp.h"
+
+/* GAP includes */
+#include "gap_gve_raw.h"
+#include "gap_gve_xvid.h"
+
+
+int gap_debug = 0;  /* 1 == print debug infos , 0 dont print debug infos */
+
+
+#ifdef ENABLE_LIBXVIDCORE
+
+static void  p_generate_frame(GapRgbPixelBuffer *rgbBuffer, gint32 frame_nr);
+
+
+/* --------------------------------
+ * p_generate_frame
+ * --------------------------------
+ * render a horizontal moving gradient and a diagonal moving box
+ * for the specified frame number into rgbBuffer.
+ */
+static void
+p_generate_frame(GapRgbPixelBuffer *rgbBuffer, gint32 frame_nr)
+{
+  guint  row;
+  guint  col;
+  guint  boxSize;
+  guint  boxX;
+  guint  boxY;
+
+  boxSize = MAX(1, MIN(rgbBuffer->width, rgbBuffer->height) / 4);
+  boxX = (frame_nr * 4) % MAX(1, rgbBuffer->width - boxSize);
+  boxY = (frame_nr * 2) % MAX(1, rgbBuffer->height - boxSize);
+
+  for(row = 0; row < rgbBuffer->height; row++)
+  {
+    guchar *dst;
+
+    dst = &rgbBuffer->data[row * rgbBuffer->rowstride];
+    for(col = 0; col < rgbBuffer->width; col++)
+    {
+      if((col >= boxX) && (col < boxX + boxSize)
+      && (row >= boxY) && (row < boxY + boxSize))
+      {
+        dst[0] = 240;
+        dst[1] = 200;
+        dst[2] = 40;
+      }
+      else
+      {
+        dst[0] = (guchar)((col + (frame_nr * 3)) & 0xff);
+        dst[1] = (guchar)((row * 255) / MAX(1, rgbBuffer->height));
+        dst[2] = (guchar)(((col + row) / 2) & 0xff);
+      }
+      dst += rgbBuffer->bpp;
+    }
+  }
+
+}  /* end p_generate_frame */
+
+
+/* --------------------------------
+ * main
+ * --------------------------------
+ */
+int
+main(int argc, char *argv[])
+{
+  GapGveXvidValues   xvid_val;
+  GapGveXvidControl *xvid_control;
+  GapRgbPixelBuffer *rgbBuffer;
+  GTimer            *timer;
+  gint32             width;
+  gint32             height;
+  gint32             frames;
+  gint32             threads;
+  gint32             frame_nr;
+  gint32             keyframes;
+  gdouble            totalBytes;
+  gdouble            generateSeconds;
+  gdouble            elapsedSeconds;
+
+  width   = (argc > 1) ? atoi(argv[1]) : 720;
+  height  = (argc > 2) ? atoi(argv[2]) : 576;
+  frames  = (argc > 3) ? atoi(argv[3]) : 250;
+  threads = (argc > 4) ? atoi(argv[4]) : 1;
+
+  if((width < 16) || (height < 16) || (frames < 1) || (threads < 1))
+  {
+    printf("usage: %s [width height frames threads quality_preset]\n", argv[0]);
+    return (1);
+  }
+
+  /* same defaults as the AVI encoder (see gap_enc_avi_main_init_default_params) */
+  memset(&xvid_val, 0, sizeof(xvid_val));
+  xvid_val.rc_bitrate               = 900 * 1000;
+  xvid_val.rc_reaction_delay_factor = 16;
+  xvid_val.rc_averaging_period      = 100;
+  xvid_val.rc_buffer                = 10;
+  xvid_val.max_quantizer            = 31;
+  xvid_val.min_quantizer            = 1;
+  xvid_val.max_key_interval         = 120;
+  xvid_val.quality_preset           = (argc > 5) ? atoi(argv[5]) : 6;
+  gap_gve_xvid_algorithm_preset(&xvid_val);
+
+  xvid_control = gap_gve_xvid_init_with_threads(width, height, 25.0, &xvid_val, threads);
+  if(xvid_control == NULL)
+  {
+    printf("XVID encoder init failed\n");
+    return (1);
+  }
+
+  rgbBuffer = gap_gve_new_GapRgbPixelBuffer(width, height);
+  keyframes = 0;
+  totalBytes = 0.0;
+  generateSeconds = 0.0;
+  elapsedSeconds = 0.0;
+  timer = g_timer_new();
+
+  for(frame_nr = 0; frame_nr < frames; frame_nr++)
+  {
+    guchar *chunk;
+    gint32  chunkSize;
+    int     keyframe;
+
+    g_timer_start(timer);
+    p_generate_frame(rgbBuffer, frame_nr);
+    generateSeconds += g_timer_elapsed(timer, NULL);
+
+    g_timer_start(timer);
+    chunk = gap_gve_xvid_rgb_buffer_encode(rgbBuffer, &chunkSize, xvid_control
+                                          , &keyframe
+                                          , NULL   /* app0_buffer */
+                                          , 0      /* app0_length */
+                                          );
+    elapsedSeconds += g_timer_elapsed(timer, NULL);
+    if(chunk == NULL)
+    {
+      printf("XVID encoding of frame %d failed\n", (int)frame_nr);
+      break;
+    }
+    if(keyframe == XVID_TYPE_IVOP)  /* keyframe delivers the xvid frame type */
+    {
+      keyframes++;
+    }
+    totalBytes += chunkSize;
+    g_free(chunk);
+  }
+  g_timer_destroy(timer);
+
+  printf("XVID benchmark: %dx%d frames:%d keyframes:%d avg size:%.0f bytes"
+         " generate:%.3f sec encode (wall):%.3f sec (%.2f fps)\n"
+    , (int)width
+    , (int)height
+    , (int)frame_nr
+    , (int)keyframes
+    , (frame_nr > 0) ? totalBytes / (gdouble)frame_nr : 0.0
+    , (float)generateSeconds
+    , (float)elapsedSeconds
+    , (elapsedSeconds > 0.0) ? (float)((gdouble)frame_nr / elapsedSeconds) : 0.0
+    );
+  gap_gve_xvid_print_statistics(xvid_control);
+
+  gap_gve_free_GapRgbPixelBuffer(rgbBuffer);
+  gap_gve_xvid_cleanup(xvid_control);
+  g_free(xvid_control);
+
+  return ((frame_nr == frames) ? 0 : 1);
+
+}  /* end main */
+
+#else
+
+int
+main(int argc, char *argv[])
+{
+  printf("%s: GAP was configured without libxvidcore\n", argv[0]);
+  return (1);
+}  /* end main */
+
+#endif  /* ENABLE_LIBXVIDCORE */
@@ -44,6 +44,16 @@
  */
 
 /* revision history:
+ * version 2.8.xx;  2026.10.19   agent: optional incremental encoding (unchanged segments
+ *                                      of the previous encode are copied via the segment cache)
+ * version 2.8.xx;  2026.10.19   agent: optional forced keyframes at storyboard clip boundaries
+ *                                      and at scene changes (luma histogram difference)
+ * version 2.8.xx;  2026.10.19   agent: frames are handed over to the encoder as rgb888 buffers
+ *                                      (free-list of reusable frame buffers in the EncoderQueue,
+ *                                      each queue element has its own colormodel convert buffer)
+ * version 2.8.xx;  2026.10.19   agent: audio worker thread (audio is read and encoded in parallel
+ *                                      to the video, encoded packets are queued ordered by time)
+ * version 2.8.xx;  2026.10.18   agent: optional pass 1 spool file for 2-pass encoding
  * version 2.1.0a;  2009.02.07   hof: update to ffmpeg snapshot 2009.01.31 (removed support for older ffmpeg versions)
  * version 2.1.0a;  2005.07.16   hof: base support for encoding of multiple tracks
  *                                    video is still limited to 1 track
@@ -89,6 +99,7 @@
 
 #include "gap_audio_wav.h"
 #include "gap_base.h"
+#include "gap_story_render_segcache.h"
 
 
 /* FFMPEG defaults */
@@ -125,6 +136,9 @@
 #define MAX_AUDIO_STREAMS 16
 
 #define ENCODER_QUEUE_RINGBUFFER_SIZE 4
+
+#define PASS1_SPOOL_RECORD_RGB888   1
+#define PASS1_SPOOL_RECORD_CHUNK    2
  
 
 
@@ -156,6 +170,78 @@ typedef struct t_awk_array
 } t_awk_array;
 
 
+/* one encoded audio packet (copy of the audio codec output) */
+typedef struct AudioPacketElem    /* apkt */
+{
+  gint                    aud_track;
+  int64_t                 pts;            /* in the time_base of the audio stream or AV_NOPTS_VALUE */
+  gdouble                 startSeconds;   /* time of the 1st input sample of the packet */
+  gdouble                 endSeconds;
+  guchar                 *data;
+  gint32                  size;
+  struct AudioPacketElem *next;
+} AudioPacketElem;
+
+
+/* the audio worker thread reads the input wavefiles and encodes all audio tracks
+ * in parallel to the video. The encoded packets are queued in the order of their
+ * time, the thread that writes the video frames takes the packets
+ * that are due (according to the number of written video frames)
+ * and writes them via av_interleaved_write_frame.
+ * (all writes to the output context are done in the same thread)
+ */
+typedef struct AudioEncoderQueue  /* aque */
+{
+  struct t_ffmpeg_handle *ffh;
+  t_awk_array            *awp;
+  gdouble                 framerate;
+  gdouble                 aheadSeconds;       /* limit for audio encoded ahead of the written video */
+
+  GThread                *workerThread;
+  GMutex                 *mutex;
+  GCond                  *cond;
+  AudioPacketElem        *first;              /* queued packets ordered by startSeconds */
+  AudioPacketElem        *last;
+  gdouble                 videoSeconds;       /* playbacktime of the video frames written so far */
+  gdouble                 nextStartSeconds;   /* time range of the packet that the worker encodes next */
+  gdouble                 nextEndSeconds;
+  gboolean                workerDone;         /* all audio tracks are encoded */
+  gboolean                stopRequest;
+
+  gint64                  samplesDone[MAX_AUDIO_STREAMS];   /* reserved for the worker thread */
+  gboolean                trackDone[MAX_AUDIO_STREAMS];
+
+  /* buffer level telemetry */
+  gint32                  queuedPackets;
+  gint32                  maxQueuedPackets;
+  gdouble                 sumQueuedPackets;   /* sum of queuedPackets at the write calls */
+  gdouble                 minBufferedSeconds; /* audio encoded ahead of the video at the write calls */
+  gdouble                 maxBufferedSeconds;
+  gint32                  writeCalls;
+  gint32                  writeWaits;         /* write calls that had to wait for the worker */
+  gdouble                 writeWaitSeconds;
+  gint32                  workerWaits;        /* worker had to wait because it was aheadSeconds ahead */
+  gint32                  packetsEncoded;
+  gint32                  packetsWritten;
+  gdouble                 bytesWritten;
+  gdouble                 readSeconds;
+  gdouble                 encodeSeconds;
+} AudioEncoderQueue;
+
+
+#define SCENE_CHANGE_HISTOGRAM_BINS   64
+#define SCENE_CHANGE_SAMPLE_STEP      4   /* check every 4th pixel of every 4th row */
+
+/* detects scene changes by comparing the luma histograms of subsequent frames */
+typedef struct SceneChangeDetect  /* nick: scd */
+{
+  gint32                  thresholdPercent;   /* histogram difference that is handled as scene change */
+  gint32                  prevHist[SCENE_CHANGE_HISTOGRAM_BINS];
+  gint32                  prevCount;          /* number of samples in prevHist (0 no previous frame) */
+  gint32                  lastDiffPercent;
+} SceneChangeDetect;
+
+
 typedef struct t_ffmpeg_video
 {
  int              video_stream_index;
@@ -215,6 +301,7 @@ typedef struct t_ffmpeg_handle         /* ffh */
  gint32    validEncodeFrameNr;
  
  gboolean      isMultithreadEnabled;
+ AudioEncoderQueue *aque;      /* NULL: audio is encoded inline with the video frames */
 
 } t_ffmpeg_handle;
 
@@ -233,6 +320,8 @@ typedef struct EncoderQueueElem  /* eq_elem */
   gint32                        encode_frame_nr;
   gint                          vid_track;
   gboolean                      force_keyframe;
+  guchar                       *rgbBuffer;      /* rgb888 frame referred by the AVFrame (PIX_FMT_RGB24 codecs) or NULL */
+  guchar                       *convertBuffer;  /* colormodel convert target of this element (other pix_fmts) */
   
   EncoderQueueElemStatusEnum    status;
   GMutex                       *elemMutex;
@@ -255,6 +344,14 @@ typedef struct EncoderQueue    /* eque */
   GCond               *frameEncodedCond;  /* sent each time the encoder finished one frame */
   GMutex              *poolMutex;
 
+  /* free-list of reusable rgb888 frame buffers (reserved for the main thread).
+   * the fetched frame buffer is handed over to the queue element
+   * and the next frame is fetched into a buffer from the free-list.
+   */
+  GSList              *freeRgbBuffers;
+  gint32               rgbBuffersAllocated;
+  gint32               rgbBufferHandoffs;
+
 
   /* debug attributes reserved for runtime measuring in the main thread */
   GapTimmRecord       mainElemMutexWaits;
@@ -274,6 +371,34 @@ typedef struct EncoderQueue    /* eque */
 } EncoderQueue;
 
 
+/* optional spool file for 2-pass encoding.
+ * pass 1 writes the frames delivered by the storyboard render processor
+ * (raw RGB888 frames or 1:1 copied chunks) and pass 2 reads them
+ * instead of rendering the storyboard once more.
+ */
+typedef struct Pass1Spool    /* spool */
+{
+  gchar              *filename;
+  FILE               *fp;
+  gint64              byteLimit;
+  gint64              bytesWritten;
+  gint32              framesWritten;
+  gint32              framesRead;
+  gboolean            isComplete;   /* pass 1 has written all frames (pass 2 may read) */
+  gboolean            isDisabled;   /* size limit exceeded or IO error (pass 2 renders the frames) */
+
+} Pass1Spool;
+
+typedef struct Pass1SpoolRecordHeader
+{
+  gint32              recordType;   /* PASS1_SPOOL_RECORD_RGB888 or PASS1_SPOOL_RECORD_CHUNK */
+  gint32              dataSize;
+  gint32              chunkHdrSize;
+  gint32              forceKeyframe;
+
+} Pass1SpoolRecordHeader;
+
+
 /* ------------------------
  * global gap DEBUG switch
  * ------------------------
@@ -322,6 +447,13 @@ static void              p_sound_precalculations(t_ffmpeg_handle *ffh
                                       );
 static void              p_process_audio_frame(t_ffmpeg_handle *ffh, t_awk_array *awp);
 static void              p_close_audio_input_files(t_awk_array *awp);
+static AudioEncoderQueue * p_audio_queue_new(t_ffmpeg_handle *ffh, t_awk_array *awp, gdouble framerate);
+static gboolean          p_audio_queue_calculate_next(AudioEncoderQueue *aque, gint *aud_track);
+static AudioPacketElem * p_audio_queue_encode_packet(AudioEncoderQueue *aque, gint aud_track);
+static gpointer          p_audio_worker_thread_function(AudioEncoderQueue *aque);
+static void              p_audio_queue_write_packets(AudioEncoderQueue *aque);
+static void              p_audio_queue_print_statistics(AudioEncoderQueue *aque);
+static void              p_audio_queue_free(AudioEncoderQueue *aque);
 static void              p_open_audio_input_files(t_awk_array *awp, GapGveFFMpegGlobalParams *gpp);
 
 //static gint64            p_calculate_current_timecode(t_ffmpeg_handle *ffh);
@@ -346,8 +478,15 @@ static t_ffmpeg_handle * p_ffmpeg_open(GapGveFFMpegGlobalParams *gpp
                                       , t_awk_array *awp
                                       , gint video_tracks
                                       );
-static int    p_ffmpeg_write_frame_chunk(t_ffmpeg_handle *ffh, gint32 encoded_size, gint vid_track);
-static void   p_convert_colormodel(t_ffmpeg_handle *ffh, AVPicture *picture_codec, guchar *rgb_buffer, gint vid_track);
+static int    p_ffmpeg_write_frame_chunk(t_ffmpeg_handle *ffh, gint32 encoded_size, gboolean is_keyframe
+                     , gint vid_track);
+static void   p_ffmpeg_enable_segment_cache(GapGveFFMpegGlobalParams *gpp, GapGveStoryVidHandle *vidhand);
+static void   p_convert_colormodel(t_ffmpeg_handle *ffh, AVPicture *picture_codec, guchar *rgb_buffer
+                     , guchar *convert_buffer, gint vid_track);
+static gboolean p_ffmpeg_fetch_result_image_to_rgb888(GapStoryFetchResult *gapStoryFetchResult
+                     , gint32 vid_width
+                     , gint32 vid_height
+                     );
 
 static int    p_ffmpeg_encodeAndWriteVideoFrame(t_ffmpeg_handle *ffh, AVFrame *picture_codec
                      , gboolean force_keyframe, gint vid_track, gint32 encode_frame_nr);
@@ -355,6 +494,7 @@ static int    p_ffmpeg_encodeAndWriteVideoFrame(t_ffmpeg_handle *ffh, AVFrame *p
 static void   p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame(t_ffmpeg_handle *ffh
                      , AVFrame *picture_codec
                      , GapStoryFetchResult *gapStoryFetchResult
+                     , guchar *convert_buffer
                      , gint vid_track
                      );
 
@@ -363,7 +503,11 @@ static EncoderQueue * p_init_EncoderQueueResources(t_ffmpeg_handle *ffh, t_awk_a
 static void           p_debug_print_RingbufferStatus(EncoderQueue *eque);
 static void           p_waitUntilEncoderQueIsProcessed(EncoderQueue *eque);
 static void           p_free_EncoderQueueResources(EncoderQueue     *eque);
+static guchar *       p_get_EncoderQueueRgbBuffer(EncoderQueue *eque);
+static void           p_release_EncoderQueueRgbBuffer(EncoderQueue *eque, EncoderQueueElem *eq_elem);
 
+static gboolean p_scene_change_detect(SceneChangeDetect *scd, const guchar *rgb888
+                     , gint32 width, gint32 height);
 static void   p_fillQueueElem(EncoderQueue *eque, GapStoryFetchResult *gapStoryFetchResult, gboolean force_keyframe, gint vid_track);
 static void   p_encodeCurrentQueueElem(EncoderQueue *eque);
 static void   p_encoderWorkerThreadFunction (EncoderQueue *eque);
@@ -377,6 +521,22 @@ static int    p_ffmpeg_write_audioframe(t_ffmpeg_handle *ffh, guchar *audio_buf,
 static void   p_ffmpeg_close(t_ffmpeg_handle *ffh);
 static gint   p_ffmpeg_encode(GapGveFFMpegGlobalParams *gpp);
 
+static Pass1Spool * p_pass1_spool_new(GapGveFFMpegGlobalParams *gpp);
+static void         p_pass1_spool_disable(Pass1Spool *spool, const char *reason);
+static void         p_pass1_spool_write_frame(Pass1Spool *spool
+                       , GapStoryFetchResult *gapStoryFetchResult
+                       , gint32 vid_width
+                       , gint32 vid_height
+                       );
+static void         p_pass1_spool_finish_pass(Pass1Spool *spool, gint32 current_pass, gint rc);
+static gboolean     p_pass1_spool_read_frame(Pass1Spool *spool
+                       , GapStoryFetchResult *gapStoryFetchResult
+                       , gint32 vid_width
+                       , gint32 vid_height
+                       , gint32 video_frame_chunk_maxsize
+                       );
+static void         p_pass1_spool_free(Pass1Spool *spool);
+
 
 
 GimpPlugInInfo PLUG_IN_INFO =
@@ -1748,6 +1908,15 @@ p_process_audio_frame(t_ffmpeg_handle *ffh, t_awk_array *awp)
   gint ii;
   gint32 datasize;
 
+  if(ffh->aque != NULL)
+  {
+    /* audio is read and encoded by the audio worker thread,
+     * just write the queued packets that are due.
+     */
+    p_audio_queue_write_packets(ffh->aque);
+    return;
+  }
+
   /* foreach audio_track
    * (number of audioinput tracks should always match
    *  the max audio streams)
@@ -1844,6 +2013,497 @@ p_close_audio_input_files(t_awk_array *awp)
 }  /* end p_close_audio_input_files */
 
 
+/* -------------------------
+ * p_audio_queue_new
+ * -------------------------
+ * create the AudioEncoderQueue and start the audio worker thread.
+ * returns NULL when the audio worker is disabled (gimprc parameter
+ * video-encoder-ffmpeg-audio-worker), for videos without audio tracks
+ * or when no thread support is available.
+ * (in those cases audio is encoded inline with the video frames
+ * by p_process_audio_frame)
+ */
+static AudioEncoderQueue *
+p_audio_queue_new(t_ffmpeg_handle *ffh, t_awk_array *awp, gdouble framerate)
+{
+  AudioEncoderQueue *aque;
+  GError            *error = NULL;
+  gint32             aheadMs;
+  gint               ii;
+
+  if(MIN(ffh->max_ast, awp->audio_tracks) <= 0)
+  {
+    return (NULL);
+  }
+  if(gap_base_get_gimprc_gboolean_value(GAP_GIMPRC_VIDEO_ENCODER_FFMPEG_AUDIO_WORKER
+                                       , TRUE  /* default */
+                                       ) != TRUE)
+  {
+    return (NULL);
+  }
+  if(gap_base_thread_init() != TRUE)
+  {
+    return (NULL);
+  }
+
+  aheadMs = gap_base_get_gimprc_int_value(GAP_GIMPRC_VIDEO_ENCODER_FFMPEG_AUDIO_AHEAD_MS
+                                         , GAP_FFMPEG_DEFAULT_AUDIO_AHEAD_MS  /* default */
+                                         , 100     /* min */
+                                         , 60000   /* max */
+                                         );
+
+  aque = g_new0(AudioEncoderQueue, 1);
+  aque->ffh = ffh;
+  aque->awp = awp;
+  aque->framerate = framerate;
+  aque->aheadSeconds = (gdouble)aheadMs / 1000.0;
+  aque->minBufferedSeconds = -1.0;
+  for (ii=0; ii < MAX_AUDIO_STREAMS; ii++)
+  {
+    aque->samplesDone[ii] = 0;
+    aque->trackDone[ii] = (ii >= MIN(ffh->max_ast, awp->audio_tracks))
+                       || (awp->awk[ii].fp_inwav == NULL)
+                       || (ffh->ast[ii].aud_codec_context == NULL);
+  }
+
+  aque->mutex = g_mutex_new();
+  aque->cond = g_cond_new();
+  aque->workerThread = g_thread_create((GThreadFunc) p_audio_worker_thread_function
+                                      , aque
+                                      , TRUE       /* joinable */
+                                      , &error     /* GError **error */
+                                      );
+  if(aque->workerThread == NULL)
+  {
+    printf("p_audio_queue_new: audio worker thread not available, encoding audio inline %s\n"
+      , (error != NULL) ? error->message : ""
+      );
+    if(error != NULL)
+    {
+      g_error_free(error);
+    }
+    g_cond_free(aque->cond);
+    g_mutex_free(aque->mutex);
+    g_free(aque);
+    return (NULL);
+  }
+
+  if(gap_debug)
+  {
+    printf("p_audio_queue_new: audio worker started, tracks:%d aheadSeconds:%.3f\n"
+      , (int)MIN(ffh->max_ast, awp->audio_tracks)
+      , (float)aque->aheadSeconds
+      );
+  }
+  return (aque);
+
+}  /* end p_audio_queue_new */
+
+
+/* ----------------------------
+ * p_audio_queue_calculate_next
+ * ----------------------------
+ * select the audio track with the lowest time of unencoded audio data
+ * and set nextStartSeconds and nextEndSeconds for its next packet.
+ * returns FALSE when all tracks are completely encoded.
+ * Note: must be called by the worker thread with locked mutex.
+ */
+static gboolean
+p_audio_queue_calculate_next(AudioEncoderQueue *aque, gint *aud_track)
+{
+  gint    ii;
+  gdouble startSeconds;
+  gdouble endSeconds;
+
+  *aud_track = -1;
+  for (ii=0; ii < MAX_AUDIO_STREAMS; ii++)
+  {
+    t_audio_work *awk;
+
+    if(aque->trackDone[ii])
+    {
+      continue;
+    }
+    awk = &aque->awp->awk[ii];
+    if(awk->wavsize <= 0)
+    {
+      aque->trackDone[ii] = TRUE;
+      continue;
+    }
+
+    startSeconds = (gdouble)aque->samplesDone[ii] / (gdouble)MAX(1, awk->sample_rate);
+    endSeconds = startSeconds
+               + ((gdouble)(MIN(MAX(1, awk->audio_margin), awk->wavsize) / MAX(1, awk->bytes_per_sample))
+                 / (gdouble)MAX(1, awk->sample_rate));
+
+    if((*aud_track < 0)
+    || (startSeconds < aque->nextStartSeconds))
+    {
+      *aud_track = ii;
+      aque->nextStartSeconds = startSeconds;
+      aque->nextEndSeconds = endSeconds;
+    }
+  }
+
+  return (*aud_track >= 0);
+
+}  /* end p_audio_queue_calculate_next */
+
+
+/* ---------------------------
+ * p_audio_queue_encode_packet
+ * ---------------------------
+ * read the audio data for the next packet of the specified track
+ * from the input wavefile and encode it.
+ * returns the encoded packet or NULL when the codec has buffered the data.
+ * Note: runs in the audio worker thread without lock. The audio work data,
+ * the audio codec context and its audio_buffer of the track are reserved
+ * for the worker thread while the AudioEncoderQueue exists.
+ */
+static AudioPacketElem *
+p_audio_queue_encode_packet(AudioEncoderQueue *aque, gint aud_track)
+{
+  t_audio_work    *awk;
+  t_ffmpeg_audio  *ast;
+  AudioPacketElem *apkt;
+  GTimer          *timer;
+  gint64           startSample;
+  gint32           bytes;
+  gint32           datasize;
+  int              encoded_size;
+
+  awk = &aque->awp->awk[aud_track];
+  ast = &aque->ffh->ast[aud_track];
+
+  /* the audio codec reads audio_margin bytes (one codec frame) per call */
+  bytes = MIN(MAX(1, awk->audio_margin), awk->wavsize);
+
+  timer = g_timer_new();
+  datasize = fread(awk->databuffer, 1, bytes, awk->fp_inwav);
+  aque->readSeconds += g_timer_elapsed(timer, NULL);
+  if (datasize != bytes)
+  {
+    printf("Warning: Read from wav file failed. (non-critical)\n");
+    datasize = MAX(0, datasize);
+  }
+  if (datasize < awk->audio_margin)
+  {
+    /* fill up the last (incomplete) codec frame with silence */
+    memset(&awk->databuffer[datasize], 0, awk->audio_margin - datasize);
+  }
+  awk->wavsize -= bytes;
+
+  startSample = aque->samplesDone[aud_track];
+  aque->samplesDone[aud_track] += bytes / MAX(1, awk->bytes_per_sample);
+
+  g_timer_start(timer);
+  encoded_size = avcodec_encode_audio(ast->aud_codec_context
+                           ,ast->audio_buffer, ast->audio_buffer_size
+                           ,(short *)awk->databuffer);
+  aque->encodeSeconds += g_timer_elapsed(timer, NULL);
+  g_timer_destroy(timer);
+
+  if (encoded_size <= 0)
+  {
+    /* zero size means the samples were buffered by the codec */
+    return (NULL);
+  }
+
+  apkt = g_new(AudioPacketElem, 1);
+  apkt->aud_track = aud_track;
+  apkt->pts = AV_NOPTS_VALUE;
+  if(ast->aud_codec_context->coded_frame
+  && ast->aud_codec_context->coded_frame->pts != AV_NOPTS_VALUE)
+  {
+    apkt->pts = av_rescale_q(ast->aud_codec_context->coded_frame->pts
+                            , ast->aud_codec_context->time_base
+                            , ast->aud_stream->time_base
+                            );
+  }
+  apkt->startSeconds = (gdouble)startSample / (gdouble)MAX(1, awk->sample_rate);
+  apkt->endSeconds = (gdouble)aque->samplesDone[aud_track] / (gdouble)MAX(1, awk->sample_rate);
+  apkt->data = g_memdup(ast->audio_buffer, encoded_size);
+  apkt->size = encoded_size;
+  apkt->next = NULL;
+
+  return (apkt);
+
+}  /* end p_audio_queue_encode_packet */
+
+
+/* ------------------------------
+ * p_audio_worker_thread_function
+ * ------------------------------
+ * encodes the audio tracks packet by packet (always the track with the lowest time first)
+ * and inserts the packets into the queue ordered by time.
+ * The worker waits while it is more than aheadSeconds ahead of the written video.
+ * Note: the worker thread does not call the gimp PDB and does not write to the output context.
+ */
+static gpointer
+p_audio_worker_thread_function(AudioEncoderQueue *aque)
+{
+  gint aud_track;
+
+  g_mutex_lock(aque->mutex);
+  while(p_audio_queue_calculate_next(aque, &aud_track))
+  {
+    AudioPacketElem *apkt;
+
+    if((aque->nextStartSeconds >= aque->videoSeconds + aque->aheadSeconds)
+    && (!aque->stopRequest))
+    {
+      aque->workerWaits++;
+      while((aque->nextStartSeconds >= aque->videoSeconds + aque->aheadSeconds)
+      &&    (!aque->stopRequest))
+      {
+        g_cond_wait(aque->cond, aque->mutex);
+      }
+    }
+    if(aque->stopRequest)
+    {
+      break;
+    }
+    g_mutex_unlock(aque->mutex);
+
+    apkt = p_audio_queue_encode_packet(aque, aud_track);
+
+    g_mutex_lock(aque->mutex);
+    if(apkt != NULL)
+    {
+      /* insert ordered by startSeconds (typically appended at the end) */
+      if(aque->last == NULL)
+      {
+        aque->first = apkt;
+        aque->last = apkt;
+      }
+      else if(aque->last->startSeconds <= apkt->startSeconds)
+      {
+        aque->last->next = apkt;
+        aque->last = apkt;
+      }
+      else
+      {
+        AudioPacketElem **prevPtr;
+
+        for(prevPtr = &aque->first; *prevPtr != NULL; prevPtr = &(*prevPtr)->next)
+        {
+          if((*prevPtr)->startSeconds > apkt->startSeconds)
+          {
+            break;
+          }
+        }
+        apkt->next = *prevPtr;
+        *prevPtr = apkt;
+      }
+      aque->packetsEncoded++;
+      aque->queuedPackets++;
+      aque->maxQueuedPackets = MAX(aque->maxQueuedPackets, aque->queuedPackets);
+    }
+    g_cond_broadcast(aque->cond);
+  }
+  aque->workerDone = TRUE;
+  g_cond_broadcast(aque->cond);
+  g_mutex_unlock(aque->mutex);
+
+  if(gap_debug)
+  {
+    printf("p_audio_worker_thread_function: TID:%d DONE packetsEncoded:%d\n"
+      , p_base_get_thread_id_as_int()
+      , (int)aque->packetsEncoded
+      );
+  }
+  return (NULL);
+
+}  /* end p_audio_worker_thread_function */
+
+
+/* ---------------------------
+ * p_audio_queue_write_packets
+ * ---------------------------
+ * write all queued audio packets that end within the playbacktime
+ * of the video frames written so far. Waits for the audio worker
+ * in case it has not yet encoded the due packets.
+ * Note: must be called by the thread that writes the video frames
+ * (the main thread or the video encoder thread)
+ */
+static void
+p_audio_queue_write_packets(AudioEncoderQueue *aque)
+{
+  t_ffmpeg_handle *ffh;
+  gdouble          upToSeconds;
+  gdouble          bufferedSeconds;
+
+  ffh = aque->ffh;
+  upToSeconds = (gdouble)ffh->countVideoFramesWritten / MAX(0.001, aque->framerate);
+
+  g_mutex_lock(aque->mutex);
+  aque->writeCalls++;
+  aque->sumQueuedPackets += aque->queuedPackets;
+  aque->videoSeconds = upToSeconds;
+  g_cond_broadcast(aque->cond);   /* the worker may encode further ahead now */
+
+  while(TRUE)
+  {
+    AudioPacketElem *apkt;
+
+    apkt = aque->first;
+    if(apkt != NULL)
+    {
+      AVPacket pkt;
+
+      if(apkt->endSeconds > upToSeconds)
+      {
+        break;
+      }
+      aque->first = apkt->next;
+      if(aque->first == NULL)
+      {
+        aque->last = NULL;
+      }
+      aque->queuedPackets--;
+      g_mutex_unlock(aque->mutex);
+
+      av_init_packet (&pkt);
+      pkt.pts = apkt->pts;
+      pkt.flags |= AV_PKT_FLAG_KEY;
+      pkt.stream_index = ffh->ast[apkt->aud_track].audio_stream_index;
+      pkt.data = apkt->data;
+      pkt.size = apkt->size;
+
+      if(gap_debug)
+      {
+        printf("p_audio_queue_write_packets: TID:%d track:%d size:%d pts:%lld start:%.4f end:%.4f upTo:%.4f\n"
+          , p_base_get_thread_id_as_int()
+          , (int)apkt->aud_track
+          , (int)apkt->size
+          , (long long int)pkt.pts
+          , (float)apkt->startSeconds
+          , (float)apkt->endSeconds
+          , (float)upToSeconds
+          );
+      }
+      av_interleaved_write_frame(ffh->output_context, &pkt);
+
+      aque->packetsWritten++;
+      aque->bytesWritten += apkt->size;
+      g_free(apkt->data);
+      g_free(apkt);
+
+      g_mutex_lock(aque->mutex);
+      continue;
+    }
+
+    if((aque->workerDone)
+    || (aque->nextEndSeconds > upToSeconds))
+    {
+      break;
+    }
+
+    /* the audio worker is behind the video, wait for the next packet */
+    {
+      GTimer *timer;
+
+      aque->writeWaits++;
+      timer = g_timer_new();
+      g_cond_wait(aque->cond, aque->mutex);
+      aque->writeWaitSeconds += g_timer_elapsed(timer, NULL);
+      g_timer_destroy(timer);
+    }
+  }
+
+  bufferedSeconds = 0.0;
+  if(aque->last != NULL)
+  {
+    bufferedSeconds = MAX(0.0, aque->last->endSeconds - upToSeconds);
+  }
+  if((aque->minBufferedSeconds < 0.0)
+  || (bufferedSeconds < aque->minBufferedSeconds))
+  {
+    aque->minBufferedSeconds = bufferedSeconds;
+  }
+  aque->maxBufferedSeconds = MAX(aque->maxBufferedSeconds, bufferedSeconds);
+  g_mutex_unlock(aque->mutex);
+
+}  /* end p_audio_queue_write_packets */
+
+
+/* ------------------------------
+ * p_audio_queue_print_statistics
+ * ------------------------------
+ */
+static void
+p_audio_queue_print_statistics(AudioEncoderQueue *aque)
+{
+  if(aque == NULL)
+  {
+    return;
+  }
+  g_mutex_lock(aque->mutex);
+  printf("ffmpeg audio worker: packets encoded:%d written:%d still queued:%d (%.0f bytes written)\n"
+    , (int)aque->packetsEncoded
+    , (int)aque->packetsWritten
+    , (int)aque->queuedPackets
+    , (gdouble)aque->bytesWritten
+    );
+  printf("ffmpeg audio worker: queue max:%d avg:%.1f packets, buffered ahead of video min:%.3f max:%.3f sec (limit:%.3f)\n"
+    , (int)aque->maxQueuedPackets
+    , (float)(aque->sumQueuedPackets / MAX(1, aque->writeCalls))
+    , (float)MAX(0.0, aque->minBufferedSeconds)
+    , (float)aque->maxBufferedSeconds
+    , (float)aque->aheadSeconds
+    );
+  printf("ffmpeg audio worker: read:%.3f encode:%.3f sec, writer waits:%d (%.3f sec) of %d calls, worker waits:%d\n"
+    , (float)aque->readSeconds
+    , (float)aque->encodeSeconds
+    , (int)aque->writeWaits
+    , (float)aque->writeWaitSeconds
+    , (int)aque->writeCalls
+    , (int)aque->workerWaits
+    );
+  g_mutex_unlock(aque->mutex);
+
+}  /* end p_audio_queue_print_statistics */
+
+
+/* -------------------------
+ * p_audio_queue_free
+ * -------------------------
+ * stop the audio worker thread and free the AudioEncoderQueue
+ * including the not yet written packets.
+ * (audio that exceeds the playbacktime of the video is not written,
+ * same as in the inline audio processing)
+ */
+static void
+p_audio_queue_free(AudioEncoderQueue *aque)
+{
+  AudioPacketElem *apkt;
+  AudioPacketElem *apkt_next;
+
+  if(aque == NULL)
+  {
+    return;
+  }
+
+  g_mutex_lock(aque->mutex);
+  aque->stopRequest = TRUE;
+  g_cond_broadcast(aque->cond);
+  g_mutex_unlock(aque->mutex);
+
+  g_thread_join(aque->workerThread);
+
+  for(apkt = aque->first; apkt != NULL; apkt = apkt_next)
+  {
+    apkt_next = apkt->next;
+    g_free(apkt->data);
+    g_free(apkt);
+  }
+  g_cond_free(aque->cond);
+  g_mutex_free(aque->mutex);
+  g_free(aque);
+
+}  /* end p_audio_queue_free */
+
+
 /* -------------------------
  * p_open_audio_input_files
  * -------------------------
@@ -2126,6 +2786,7 @@ p_ffmpeg_open_init(t_ffmpeg_handle *ffh, GapGveFFMpegGlobalParams *gpp)
 
   ffh->file_overwrite               = 0;
   ffh->countVideoFramesWritten      = 0;
+  ffh->aque                         = NULL;
 
 }  /* end p_ffmpeg_open_init */
 
@@ -3124,9 +3785,12 @@ p_ffmpeg_open(GapGveFFMpegGlobalParams *gpp
  * --------------------------
  * write videoframe chunk 1:1 to the mediafile as packet.
  * (typically used for lossless video cut to copy already encoded frames)
+ * is_keyframe marks the packet as keyframe for chunks without MPEG picture header
+ * (for MPEG chunks the intra frames are detected from the picture header)
  */
 static int
-p_ffmpeg_write_frame_chunk(t_ffmpeg_handle *ffh, gint32 encoded_size, gint vid_track)
+p_ffmpeg_write_frame_chunk(t_ffmpeg_handle *ffh, gint32 encoded_size, gboolean is_keyframe
+   , gint vid_track)
 {
   int ret;
   int encoded_dummy_size;
@@ -3218,7 +3882,8 @@ p_ffmpeg_write_frame_chunk(t_ffmpeg_handle *ffh, gint32 encoded_size, gint vid_t
       }
 
       chunk_frame_type = GVA_util_check_mpg_frame_type(ffh->vst[ii].video_buffer, encoded_size);
-      if(chunk_frame_type == 1)  /* check for intra frame type */
+      if((chunk_frame_type == 1)  /* check for intra frame type */
+      || ((chunk_frame_type == GVA_MPGFRAME_UNKNOWN) && (is_keyframe)))
       {
         pkt.flags |= AV_PKT_FLAG_KEY;
       }
@@ -3267,12 +3932,14 @@ p_ffmpeg_write_frame_chunk(t_ffmpeg_handle *ffh, gint32 encoded_size, gint vid_t
  * -----------------------
  * convert video frame specified in the rgb_buffer
  * from PIX_FMT_RGB24 to the colormodel that is required
- * by the video codec.
+ * by the video codec. The converted picture is written to convert_buffer
+ * (must be large enough for uncompressed RGBA32 at frame size)
  *
  * conversion is done based on ffmpegs img_convert procedure.
  */
 static void
-p_convert_colormodel(t_ffmpeg_handle *ffh, AVPicture *picture_codec, guchar *rgb_buffer, gint vid_track)
+p_convert_colormodel(t_ffmpeg_handle *ffh, AVPicture *picture_codec, guchar *rgb_buffer
+  , guchar *convert_buffer, gint vid_track)
 {
   AVFrame   *big_picture_rgb;
   AVPicture *picture_rgb;
@@ -3297,7 +3964,7 @@ p_convert_colormodel(t_ffmpeg_handle *ffh, AVPicture *picture_codec, guchar *rgb
   /* init destination picture structure (the codec context tells us what pix_fmt is needed)
    */
    avpicture_fill(picture_codec
-                  ,ffh->convert_buffer
+                  ,convert_buffer
                   ,ffh->vst[ii].vid_codec_context->pix_fmt          /* PIX_FMT_RGB24, PIX_FMT_RGBA32, PIX_FMT_BGRA32 */
                   ,ffh->frame_width
                   ,ffh->frame_height
@@ -3373,6 +4040,71 @@ p_convert_colormodel(t_ffmpeg_handle *ffh, AVPicture *picture_codec, guchar *rgb
 }  /* end p_convert_colormodel */
 
 
+/* ---------------------------------
+ * p_scene_change_detect
+ * ---------------------------------
+ * compare the luma histogram of the rgb888 frame with the histogram
+ * of the previous frame. (only a subset of the pixels is sampled)
+ * returns TRUE if the difference exceeds the threshold (scene change).
+ * The 1st frame is never reported as scene change.
+ */
+static gboolean
+p_scene_change_detect(SceneChangeDetect *scd, const guchar *rgb888
+   , gint32 width, gint32 height)
+{
+  gint32   hist[SCENE_CHANGE_HISTOGRAM_BINS];
+  gint32   count;
+  gint32   diff;
+  gint32   row;
+  gint32   col;
+  gint32   ii;
+  gboolean isSceneChange;
+
+  if ((rgb888 == NULL) || (width <= 0) || (height <= 0))
+  {
+    return (FALSE);
+  }
+
+  memset(hist, 0, sizeof(hist));
+  count = 0;
+  for(row = 0; row < height; row += SCENE_CHANGE_SAMPLE_STEP)
+  {
+    const guchar *pix;
+
+    pix = &rgb888[row * width * 3];
+    for(col = 0; col < width; col += SCENE_CHANGE_SAMPLE_STEP)
+    {
+      gint32 luma;
+
+      /* Y = 0.30R + 0.59G + 0.11B (fixed point) */
+      luma = ((77 * pix[0]) + (150 * pix[1]) + (29 * pix[2])) >> 8;
+      hist[(luma * SCENE_CHANGE_HISTOGRAM_BINS) >> 8]++;
+      pix += (3 * SCENE_CHANGE_SAMPLE_STEP);
+      count++;
+    }
+  }
+
+  isSceneChange = FALSE;
+  if (scd->prevCount == count)
+  {
+    diff = 0;
+    for(ii = 0; ii < SCENE_CHANGE_HISTOGRAM_BINS; ii++)
+    {
+      diff += abs(hist[ii] - scd->prevHist[ii]);
+    }
+    /* diff is 2 * count when the histograms do not overlap at all */
+    scd->lastDiffPercent = (gint32)(((gint64)diff * 100) / (2 * count));
+    isSceneChange = (scd->lastDiffPercent > scd->thresholdPercent);
+  }
+
+  memcpy(scd->prevHist, hist, sizeof(hist));
+  scd->prevCount = count;
+
+  return (isSceneChange);
+
+}  /* end p_scene_change_detect */
+
+
 /* ---------------------------------
  * p_ffmpeg_encodeAndWriteVideoFrame
  * ---------------------------------
@@ -3398,17 +4130,17 @@ p_ffmpeg_encodeAndWriteVideoFrame(t_ffmpeg_handle *ffh, AVFrame *picture_codec
   if((force_keyframe)
   || (encode_frame_nr == 1))
   {
-    /* TODO: howto force the encoder to write an I frame ??
-     *   ffh->vst[ii].big_picture_codec->key_frame could be ignored
-     *   because this seems to be just an information
-     *   reported by the encoder.
+    /* key_frame is just an information reported by the encoder,
+     * the codecs encode an I frame when the picture type is preset.
      */
-    /* ffh->vst[ii].vid_codec_context->key_frame = 1; */
     picture_codec->key_frame = 1;
+    picture_codec->pict_type = FF_I_TYPE;
   }
   else
   {
+    /* let the codec decide (according to gop_size and its own scene detection) */
     picture_codec->key_frame = 0;
+    picture_codec->pict_type = 0;
   }
 
 
@@ -3528,78 +4260,107 @@ p_ffmpeg_encodeAndWriteVideoFrame(t_ffmpeg_handle *ffh, AVFrame *picture_codec
   
 }  /* end p_ffmpeg_encodeAndWriteVideoFrame */
 
-/* -----------------------------------------------
- * p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame
- * -----------------------------------------------
- * convert the specified gapStoryFetchResult into the specified AVFrame (picture_codec)
- * the encoded frame to the mediafile as packet.
+/* -------------------------------------
+ * p_ffmpeg_fetch_result_image_to_rgb888
+ * -------------------------------------
+ * in case the fetched frame was delivered as gimp image
+ * (frames that required the gimp layer based render processing)
+ * read the pixels into the rgb888 buffer of the gapStoryFetchResult
+ * and delete the image. The buffer is allocated if the caller did not provide one,
+ * it is reused in further fetches and freed at end of the pass.
+ * This way the encoder handles all frames as rgb888 buffers,
+ * and the image is deleted immediately after the fetch.
  *
+ * returns FALSE if the image can not be converted (unexpected size or bpp)
  */
-static void
-p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame(t_ffmpeg_handle *ffh
- , AVFrame *picture_codec
- , GapStoryFetchResult *gapStoryFetchResult
- , gint vid_track)
+static gboolean
+p_ffmpeg_fetch_result_image_to_rgb888(GapStoryFetchResult *gapStoryFetchResult
+  , gint32 vid_width
+  , gint32 vid_height
+  )
 {
-  int ii;
+  GimpDrawable      *drawable;
   GapRgbPixelBuffer  rgbBufferLocal;
-  GapRgbPixelBuffer *rgbBuffer;
-  guchar            *frameData;
 
-  ii = ffh->vst[vid_track].video_stream_index;
+  if(gapStoryFetchResult->resultEnum != GAP_STORY_FETCH_RESULT_IS_IMAGE)
+  {
+    return (TRUE);
+  }
 
-  rgbBuffer = &rgbBufferLocal;
-  frameData = NULL;
- 
-  if(gapStoryFetchResult->resultEnum == GAP_STORY_FETCH_RESULT_IS_RAW_RGB888)
+  drawable = gimp_drawable_get (gapStoryFetchResult->layer_id);
+  if((drawable->bpp != 3)
+  || (drawable->width != vid_width)
+  || (drawable->height != vid_height))
   {
-    if(gap_debug)
-    {
-      printf("p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame: RESULT_IS_RAW_RGB888\n");
-    }
-    if(gapStoryFetchResult->raw_rgb_data == NULL)
-    {
-      printf("** ERROR p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame  RGB88 raw_rgb_data is NULL!\n");
-      return;
-    }
-    rgbBuffer->data = gapStoryFetchResult->raw_rgb_data;
+    printf("** ERROR drawable bpp:%d size:%dx%d is not supported (expected bpp 3 and size %dx%d)\n"
+      ,(int)drawable->bpp
+      ,(int)drawable->width
+      ,(int)drawable->height
+      ,(int)vid_width
+      ,(int)vid_height
+      );
+    gimp_drawable_detach (drawable);
+    return (FALSE);
   }
-  else
+  if(gapStoryFetchResult->raw_rgb_data == NULL)
   {
-    GimpDrawable      *drawable;
-    
-    drawable = gimp_drawable_get (gapStoryFetchResult->layer_id);
-    if(drawable->bpp != 3)
-    {
-      printf("** ERROR drawable bpp value %d is not supported (only bpp == 3 is supporeted!\n"
-        ,(int)drawable->bpp
-        );
-    }
-    gap_gve_init_GapRgbPixelBuffer(rgbBuffer, drawable->width, drawable->height);
- 
-    frameData = (guchar *)g_malloc0((rgbBuffer->height * rgbBuffer->rowstride));
-    rgbBuffer->data = frameData;
+    gapStoryFetchResult->raw_rgb_data = g_malloc0(vid_width * vid_height * 3);
+  }
+  gap_gve_init_GapRgbPixelBuffer(&rgbBufferLocal, vid_width, vid_height);
+  rgbBufferLocal.data = gapStoryFetchResult->raw_rgb_data;
 
-    if(gap_debug)
-    {
-      printf("p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame: before gap_gve_drawable_to_RgbBuffer rgb_buffer\n");
-    }
- 
-    /* tests with framesize 720 x 480 on my 4 CPU development machine showed that
-     *    gap_gve_drawable_to_RgbBuffer_multithread runs 1.5 times
-     *    slower than the singleprocessor implementation  (1.25 times slower on larger frames 1440 x 960)
-     * possible reasons may be
-     * a) too much overhead to init multithread stuff
-     * b) too much time spent waiting for unlocking the mutex.
-     * TODO in case a ==> remove code for gap_gve_drawable_to_RgbBuffer_multithread
-     *      in case b ==> further tuning to reduce wait cycles.
-     */
-    // gap_gve_drawable_to_RgbBuffer_multithread(drawable, rgbBuffer);
-    gap_gve_drawable_to_RgbBuffer(drawable, rgbBuffer);
-    gimp_drawable_detach (drawable);
- 
-    /* destroy the fetched (tmp) image */
-    gimp_image_delete(gapStoryFetchResult->image_id);
+  /* tests with framesize 720 x 480 on my 4 CPU development machine showed that
+   *    gap_gve_drawable_to_RgbBuffer_multithread runs 1.5 times
+   *    slower than the singleprocessor implementation  (1.25 times slower on larger frames 1440 x 960)
+   * possible reasons may be
+   * a) too much overhead to init multithread stuff
+   * b) too much time spent waiting for unlocking the mutex.
+   * TODO in case a ==> remove code for gap_gve_drawable_to_RgbBuffer_multithread
+   *      in case b ==> further tuning to reduce wait cycles.
+   */
+  // gap_gve_drawable_to_RgbBuffer_multithread(drawable, &rgbBufferLocal);
+  gap_gve_drawable_to_RgbBuffer(drawable, &rgbBufferLocal);
+  gimp_drawable_detach (drawable);
+
+  /* destroy the fetched (tmp) image */
+  gimp_image_delete(gapStoryFetchResult->image_id);
+  gapStoryFetchResult->image_id = -1;
+  gapStoryFetchResult->layer_id = -1;
+  gapStoryFetchResult->resultEnum = GAP_STORY_FETCH_RESULT_IS_RAW_RGB888;
+
+  return (TRUE);
+
+}  /* end p_ffmpeg_fetch_result_image_to_rgb888 */
+
+
+/* -----------------------------------------------
+ * p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame
+ * -----------------------------------------------
+ * fill the AVFrame (picture_codec) with the fetched rgb888 frame.
+ * codecs with PIX_FMT_RGB24 refer to the raw_rgb_data buffer directly
+ * (the buffer must not be overwritten until the frame is encoded),
+ * other pix_fmts are converted into the specified convert_buffer.
+ * Note: frames fetched as gimp image must be converted to rgb888
+ * before (see p_ffmpeg_fetch_result_image_to_rgb888)
+ */
+static void
+p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame(t_ffmpeg_handle *ffh
+ , AVFrame *picture_codec
+ , GapStoryFetchResult *gapStoryFetchResult
+ , guchar *convert_buffer
+ , gint vid_track)
+{
+  int ii;
+
+  ii = ffh->vst[vid_track].video_stream_index;
+
+  if((gapStoryFetchResult->resultEnum != GAP_STORY_FETCH_RESULT_IS_RAW_RGB888)
+  || (gapStoryFetchResult->raw_rgb_data == NULL))
+  {
+    printf("** ERROR p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame  resultEnum:%d is no RGB888 buffer!\n"
+      ,(int)gapStoryFetchResult->resultEnum
+      );
+    return;
   }
 
   if (ffh->vst[ii].vid_codec_context->pix_fmt == PIX_FMT_RGB24)
@@ -3609,7 +4370,7 @@ p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame(t_ffmpeg_handle *ffh
       printf("p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame: USE PIX_FMT_RGB24 (no pix_fmt convert needed)\n");
     }
     avpicture_fill(picture_codec
-                ,rgbBuffer->data
+                ,gapStoryFetchResult->raw_rgb_data
                 ,PIX_FMT_RGB24          /* PIX_FMT_RGB24, PIX_FMT_BGR24, PIX_FMT_RGBA32, PIX_FMT_BGRA32 */
                 ,ffh->frame_width
                 ,ffh->frame_height
@@ -3621,17 +4382,7 @@ p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame(t_ffmpeg_handle *ffh
     {
       printf("p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame: before p_convert_colormodel rgb_buffer\n");
     }
-    p_convert_colormodel(ffh, picture_codec, rgbBuffer->data, vid_track);
-  }
-
-
-  if(frameData != NULL)
-  {
-    if(gap_debug)
-    {
-      printf("p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame: before g_free frameData\n");
-    }
-    g_free(frameData);
+    p_convert_colormodel(ffh, picture_codec, gapStoryFetchResult->raw_rgb_data, convert_buffer, vid_track);
   }
 
 }  /* end p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame */
@@ -3686,6 +4437,8 @@ p_create_EncoderQueueRingbuffer(EncoderQueue *eque)
     eq_elem->encode_frame_nr = 0;
     eq_elem->vid_track = 1;
     eq_elem->force_keyframe = FALSE;
+    eq_elem->rgbBuffer = NULL;
+    eq_elem->convertBuffer = NULL;
     eq_elem->status = EQELEM_STATUS_FREE;
     eq_elem->elemMutex = g_mutex_new();
     eq_elem->next = eque->eq_root;
@@ -3742,6 +4495,9 @@ p_init_EncoderQueueResources(t_ffmpeg_handle *ffh, t_awk_array *awp)
   eque->frameEncodedCond   = NULL;
   eque->poolMutex          = NULL;
   eque->frameEncodedCond   = NULL;
+  eque->freeRgbBuffers     = NULL;
+  eque->rgbBuffersAllocated = 0;
+  eque->rgbBufferHandoffs  = 0;
 
   GAP_TIMM_INIT_RECORD(&eque->mainElemMutexWaits);
   GAP_TIMM_INIT_RECORD(&eque->mainPoolMutexWaits);
@@ -3973,6 +4729,8 @@ p_free_EncoderQueueResources(EncoderQueue     *eque)
         ,(long)eq_elem
         );
     }
+    g_free(eq_elem->rgbBuffer);
+    g_free(eq_elem->convertBuffer);
     eq_elem_next = eq_elem->next;
     if(eq_elem_next == eque->eq_root)
     {
@@ -3986,10 +4744,66 @@ p_free_EncoderQueueResources(EncoderQueue     *eque)
   eque->eq_root      = NULL;
   eque->eq_write_ptr = NULL;
   eque->eq_read_ptr  = NULL;
+
+  if(gap_debug)
+  {
+    printf("p_free_EncoderQueueResources: rgb frame buffers allocated:%d handoffs:%d\n"
+      ,(int)eque->rgbBuffersAllocated
+      ,(int)eque->rgbBufferHandoffs
+      );
+  }
+  g_slist_foreach(eque->freeRgbBuffers, (GFunc)g_free, NULL);
+  g_slist_free(eque->freeRgbBuffers);
+  eque->freeRgbBuffers = NULL;
   
 }  /* end p_free_EncoderQueueResources */
 
 
+/* -------------------------------------------
+ * p_get_EncoderQueueRgbBuffer
+ * -------------------------------------------
+ * take a rgb888 frame buffer from the free-list
+ * (or allocate a new one when the free-list is empty)
+ * Note: the free-list is reserved for the main thread (no locking required)
+ */
+static guchar *
+p_get_EncoderQueueRgbBuffer(EncoderQueue *eque)
+{
+  guchar *rgbBuffer;
+
+  if(eque->freeRgbBuffers != NULL)
+  {
+    rgbBuffer = (guchar *)eque->freeRgbBuffers->data;
+    eque->freeRgbBuffers = g_slist_delete_link(eque->freeRgbBuffers, eque->freeRgbBuffers);
+    return (rgbBuffer);
+  }
+
+  eque->rgbBuffersAllocated++;
+  return (g_malloc0(eque->ffh->frame_width * eque->ffh->frame_height * 3));
+
+}  /* end p_get_EncoderQueueRgbBuffer */
+
+
+/* -------------------------------------------
+ * p_release_EncoderQueueRgbBuffer
+ * -------------------------------------------
+ * put the rgb888 frame buffer of the specified element back to the free-list.
+ * Note: this is done when the element is filled with the next frame
+ * (and not immediate after encoding, because the flush of the codecs internal
+ * buffers after the last frame encodes the same element repeatedly)
+ */
+static void
+p_release_EncoderQueueRgbBuffer(EncoderQueue *eque, EncoderQueueElem *eq_elem)
+{
+  if(eq_elem->rgbBuffer != NULL)
+  {
+    eque->freeRgbBuffers = g_slist_prepend(eque->freeRgbBuffers, eq_elem->rgbBuffer);
+    eq_elem->rgbBuffer = NULL;
+  }
+
+}  /* end p_release_EncoderQueueRgbBuffer */
+
+
 /* -------------------------------------
  * p_fillQueueElem
  * -------------------------------------
@@ -4022,11 +4836,30 @@ p_fillQueueElem(EncoderQueue *eque, GapStoryFetchResult *gapStoryFetchResult, gb
   /* fill the AVFrame data at eq_write_ptr */
   if(gapStoryFetchResult != NULL)
   {
+    /* the previous frame of this element is already encoded */
+    p_release_EncoderQueueRgbBuffer(eque, eq_write_ptr);
+    if(eq_write_ptr->convertBuffer == NULL)
+    {
+      eq_write_ptr->convertBuffer = g_malloc(4 * eque->ffh->frame_width * eque->ffh->frame_height);
+    }
+
     p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame(eque->ffh
                  , picture_codec
                  , gapStoryFetchResult
+                 , eq_write_ptr->convertBuffer
                  , vid_track
                  );
+
+    if((gapStoryFetchResult->resultEnum == GAP_STORY_FETCH_RESULT_IS_RAW_RGB888)
+    && (eque->ffh->vst[eque->ffh->vst[vid_track].video_stream_index].vid_codec_context->pix_fmt == PIX_FMT_RGB24))
+    {
+      /* the AVFrame refers to the fetched buffer, hand it over to the element
+       * and fetch the next frame into a buffer from the free-list
+       */
+      eq_write_ptr->rgbBuffer = gapStoryFetchResult->raw_rgb_data;
+      gapStoryFetchResult->raw_rgb_data = p_get_EncoderQueueRgbBuffer(eque);
+      eque->rgbBufferHandoffs++;
+    }
     if(gap_debug)
     {
       printf("p_fillQueueElem: DONE eq_write_ptr:%ld picture_codec:%ld vid_track:%d encode_frame_nr:%d\n"
@@ -4100,7 +4933,8 @@ p_encodeCurrentQueueElem(EncoderQueue *eque)
  * frames, Encoding is based on libavformat/libavcodec.
  * videoframe input is taken from the EncoderQueue ringbuffer
  *  (that is filled parallel by the main thread)
- * audioframe input is directly fetched from an input audifile.
+ * audioframe input is directly fetched from an input audifile
+ * (or taken from the AudioEncoderQueue when the audio worker thread is active).
  *
  * After encoding the first available frame this thread tries
  * to encode following frames when available.
@@ -4579,6 +5413,7 @@ p_ffmpeg_write_frame(t_ffmpeg_handle *ffh, GapStoryFetchResult *gapStoryFetchRes
     p_ffmpeg_convert_GapStoryFetchResult_to_AVFrame(ffh
                , picture_codec
                , gapStoryFetchResult
+               , ffh->convert_buffer
                , vid_track
                );
   }
@@ -4991,6 +5826,348 @@ p_setup_check_flags(GapGveFFMpegValues *epp
 
 
 
+/* ---------------------------
+ * p_pass1_spool_new
+ * ---------------------------
+ * create the spool file for 2-pass encoding.
+ * returns NULL if spooling is not configured
+ * (gimprc parameter video-encoder-ffmpeg-pass1-spool-mb is 0)
+ * or if the spool file can not be created.
+ */
+static Pass1Spool *
+p_pass1_spool_new(GapGveFFMpegGlobalParams *gpp)
+{
+  Pass1Spool *spool;
+  gint32      spoolMB;
+  gchar      *spoolDir;
+  gchar      *spoolBasename;
+
+  spoolMB = gap_base_get_gimprc_int_value(GAP_GIMPRC_VIDEO_ENCODER_FFMPEG_PASS1_SPOOL_MB
+                                          , 0       /* default */
+                                          , 0       /* min */
+                                          , 1048576 /* max */
+                                          );
+  if(spoolMB <= 0)
+  {
+    return (NULL);
+  }
+
+  spoolDir = gimp_gimprc_query(GAP_GIMPRC_VIDEO_ENCODER_FFMPEG_PASS1_SPOOL_DIR);
+  if(spoolDir == NULL)
+  {
+    spoolDir = g_strdup(g_get_tmp_dir());
+  }
+
+  spool = g_new0(Pass1Spool, 1);
+  spool->byteLimit = (gint64)spoolMB * (gint64)(1024 * 1024);
+
+  spoolBasename = g_strdup_printf("gap_ffenc_pass1_%d.spool", (int)gap_base_getpid());
+  spool->filename = g_build_filename(spoolDir, spoolBasename, NULL);
+  g_free(spoolBasename);
+  g_free(spoolDir);
+
+  spool->fp = g_fopen(spool->filename, "wb");
+  if(spool->fp == NULL)
+  {
+    printf("WARNING: could not create pass 1 spool file %s %s\n"
+      , spool->filename
+      , g_strerror (errno)
+      );
+    g_free(spool->filename);
+    g_free(spool);
+    return (NULL);
+  }
+
+  if(gap_debug)
+  {
+    printf("p_pass1_spool_new: %s limit:%d MB\n"
+      , spool->filename
+      , (int)spoolMB
+      );
+  }
+  return (spool);
+
+}  /* end p_pass1_spool_new */
+
+
+/* ---------------------------
+ * p_pass1_spool_disable
+ * ---------------------------
+ * stop spooling, pass 2 will render all frames again.
+ */
+static void
+p_pass1_spool_disable(Pass1Spool *spool, const char *reason)
+{
+  if(spool->isDisabled)
+  {
+    return;
+  }
+  printf("pass 1 spool disabled (%s) after %d frames\n"
+    , reason
+    , (int)spool->framesWritten
+    );
+  spool->isDisabled = TRUE;
+  spool->isComplete = FALSE;
+  if(spool->fp != NULL)
+  {
+    fclose(spool->fp);
+    spool->fp = NULL;
+  }
+  g_remove(spool->filename);
+
+}  /* end p_pass1_spool_disable */
+
+
+/* ---------------------------
+ * p_pass1_spool_write_frame
+ * ---------------------------
+ * append the frame that was fetched in pass 1 to the spool file.
+ * a frame delivered as gimp image is converted to raw RGB888
+ * (gapStoryFetchResult is changed to GAP_STORY_FETCH_RESULT_IS_RAW_RGB888
+ * and the image is deleted) so the conversion is done only once
+ * for spooling and for the encoder.
+ */
+static void
+p_pass1_spool_write_frame(Pass1Spool *spool
+  , GapStoryFetchResult *gapStoryFetchResult
+  , gint32 vid_width
+  , gint32 vid_height
+  )
+{
+  Pass1SpoolRecordHeader  recordHeader;
+  guchar                 *data;
+
+  if((spool == NULL) || (spool->isDisabled))
+  {
+    return;
+  }
+
+  if(p_ffmpeg_fetch_result_image_to_rgb888(gapStoryFetchResult, vid_width, vid_height) != TRUE)
+  {
+    p_pass1_spool_disable(spool, "unexpected frame size");
+    return;
+  }
+
+  recordHeader.forceKeyframe = gapStoryFetchResult->force_keyframe;
+  recordHeader.chunkHdrSize = 0;
+  if(gapStoryFetchResult->resultEnum == GAP_STORY_FETCH_RESULT_IS_COMPRESSED_CHUNK)
+  {
+    recordHeader.recordType = PASS1_SPOOL_RECORD_CHUNK;
+    recordHeader.dataSize = gapStoryFetchResult->video_frame_chunk_size;
+    recordHeader.chunkHdrSize = gapStoryFetchResult->video_frame_chunk_hdr_size;
+    data = gapStoryFetchResult->video_frame_chunk_data;
+  }
+  else
+  {
+    recordHeader.recordType = PASS1_SPOOL_RECORD_RGB888;
+    recordHeader.dataSize = vid_width * vid_height * 3;
+    data = gapStoryFetchResult->raw_rgb_data;
+  }
+
+  if(spool->bytesWritten + sizeof(recordHeader) + recordHeader.dataSize > spool->byteLimit)
+  {
+    p_pass1_spool_disable(spool, "size limit video-encoder-ffmpeg-pass1-spool-mb exceeded");
+    return;
+  }
+
+  if((fwrite(&recordHeader, sizeof(recordHeader), 1, spool->fp) != 1)
+  || (fwrite(data, recordHeader.dataSize, 1, spool->fp) != 1))
+  {
+    p_pass1_spool_disable(spool, g_strerror (errno));
+    return;
+  }
+  spool->bytesWritten += sizeof(recordHeader) + recordHeader.dataSize;
+  spool->framesWritten++;
+
+}  /* end p_pass1_spool_write_frame */
+
+
+/* ---------------------------
+ * p_pass1_spool_finish_pass
+ * ---------------------------
+ * at end of pass 1 the spool file is closed and reopened for read access
+ * by pass 2. (only if pass 1 was successful and all frames were spooled)
+ */
+static void
+p_pass1_spool_finish_pass(Pass1Spool *spool, gint32 current_pass, gint rc)
+{
+  if((spool == NULL) || (spool->isDisabled) || (current_pass != 1))
+  {
+    return;
+  }
+
+  if(rc < 0)
+  {
+    p_pass1_spool_disable(spool, "pass 1 failed");
+    return;
+  }
+
+  fclose(spool->fp);
+  spool->fp = g_fopen(spool->filename, "rb");
+  if(spool->fp == NULL)
+  {
+    p_pass1_spool_disable(spool, g_strerror (errno));
+    return;
+  }
+  spool->isComplete = TRUE;
+
+}  /* end p_pass1_spool_finish_pass */
+
+
+/* ---------------------------
+ * p_pass1_spool_read_frame
+ * ---------------------------
+ * read the next frame from the spool file in pass 2.
+ * returns FALSE if no spooled frame is available
+ * (the caller must render the frame in that case)
+ */
+static gboolean
+p_pass1_spool_read_frame(Pass1Spool *spool
+  , GapStoryFetchResult *gapStoryFetchResult
+  , gint32 vid_width
+  , gint32 vid_height
+  , gint32 video_frame_chunk_maxsize
+  )
+{
+  Pass1SpoolRecordHeader  recordHeader;
+  guchar                 *data;
+
+  if((spool == NULL) || (spool->isComplete != TRUE))
+  {
+    return (FALSE);
+  }
+  if(spool->framesRead >= spool->framesWritten)
+  {
+    return (FALSE);
+  }
+
+  if(fread(&recordHeader, sizeof(recordHeader), 1, spool->fp) != 1)
+  {
+    p_pass1_spool_disable(spool, "read error");
+    return (FALSE);
+  }
+
+  if(recordHeader.recordType == PASS1_SPOOL_RECORD_CHUNK)
+  {
+    if(recordHeader.dataSize > video_frame_chunk_maxsize)
+    {
+      p_pass1_spool_disable(spool, "chunk too large");
+      return (FALSE);
+    }
+    data = gapStoryFetchResult->video_frame_chunk_data;
+    gapStoryFetchResult->resultEnum = GAP_STORY_FETCH_RESULT_IS_COMPRESSED_CHUNK;
+    gapStoryFetchResult->video_frame_chunk_size = recordHeader.dataSize;
+    gapStoryFetchResult->video_frame_chunk_hdr_size = recordHeader.chunkHdrSize;
+  }
+  else
+  {
+    if(recordHeader.dataSize != vid_width * vid_height * 3)
+    {
+      p_pass1_spool_disable(spool, "unexpected frame size");
+      return (FALSE);
+    }
+    if(gapStoryFetchResult->raw_rgb_data == NULL)
+    {
+      gapStoryFetchResult->raw_rgb_data = g_malloc0(recordHeader.dataSize);
+    }
+    data = gapStoryFetchResult->raw_rgb_data;
+    gapStoryFetchResult->resultEnum = GAP_STORY_FETCH_RESULT_IS_RAW_RGB888;
+  }
+
+  if(fread(data, recordHeader.dataSize, 1, spool->fp) != 1)
+  {
+    p_pass1_spool_disable(spool, "read error");
+    return (FALSE);
+  }
+  gapStoryFetchResult->force_keyframe = recordHeader.forceKeyframe;
+  spool->framesRead++;
+
+  return (TRUE);
+
+}  /* end p_pass1_spool_read_frame */
+
+
+/* ---------------------------
+ * p_pass1_spool_free
+ * ---------------------------
+ */
+static void
+p_pass1_spool_free(Pass1Spool *spool)
+{
+  if(spool == NULL)
+  {
+    return;
+  }
+  if(spool->fp != NULL)
+  {
+    fclose(spool->fp);
+  }
+  g_remove(spool->filename);
+  g_free(spool->filename);
+  g_free(spool);
+
+}  /* end p_pass1_spool_free */
+
+
+/* ---------------------------------
+ * p_ffmpeg_enable_segment_cache
+ * ---------------------------------
+ * enable incremental encoding (if configured in gimprc).
+ * Copied chunks are written in between encoded frames,
+ * therefore segments are reused only for codecs without frame delay
+ * (no B-frames, no lookahead). Other codecs are encoded completely,
+ * but with keyframes at the segment boundaries.
+ */
+static void
+p_ffmpeg_enable_segment_cache(GapGveFFMpegGlobalParams *gpp, GapGveStoryVidHandle *vidhand)
+{
+  GapGveFFMpegValues *epp;
+  AVCodec            *codec;
+  gboolean            allowReuse;
+  guint64             paramHash;
+  gchar              *settings;
+
+  epp = &gpp->evl;
+
+  av_register_all();  /* register all fileformats and codecs before we can use the lib */
+  codec = avcodec_find_encoder_by_name(epp->vcodec_name);
+  allowReuse = ((codec != NULL)
+             && (epp->b_frames == 0)
+             && ((codec->capabilities & CODEC_CAP_DELAY) == 0));
+
+  /* all encoder parameters must be equal to reuse the previous encode */
+  paramHash = gap_story_render_segcache_hash_bytes(0, epp, G_STRUCT_OFFSET(GapGveFFMpegValues, next));
+  settings = g_strdup_printf("ffmpeg %s %s %dx%d %.4f %016" G_GINT64_MODIFIER "x %s"
+                            , epp->format_name
+                            , epp->vcodec_name
+                            , (int)gpp->val.vid_width
+                            , (int)gpp->val.vid_height
+                            , (float)gpp->val.framerate
+                            , paramHash
+                            , gpp->val.filtermacro_file
+                            );
+
+  if(gap_story_render_enable_segment_cache(vidhand
+                                          , gpp->val.videoname
+                                          , gpp->val.range_from
+                                          , gpp->val.range_to
+                                          , epp->gop_size
+                                          , settings
+                                          , allowReuse
+                                          ))
+  {
+    if(!allowReuse)
+    {
+      printf("GAP_FFMPEG: incremental encoding: codec %s has frame delay, all segments are encoded\n"
+        , epp->vcodec_name
+        );
+    }
+  }
+  g_free(settings);
+
+}  /* end p_ffmpeg_enable_segment_cache */
+
+
 /* ---------------------------
  * p_ffmpeg_encode_pass
  * ---------------------------
@@ -5003,7 +6180,8 @@ p_setup_check_flags(GapGveFFMpegValues *epp
  *           (or -1 on error)
  */
 static gint
-p_ffmpeg_encode_pass(GapGveFFMpegGlobalParams *gpp, gint32 current_pass, GapGveMasterEncoderStatus *encStatusPtr)
+p_ffmpeg_encode_pass(GapGveFFMpegGlobalParams *gpp, gint32 current_pass, GapGveMasterEncoderStatus *encStatusPtr
+  , Pass1Spool *spool)
 {
 #define GAP_FFENC_USE_YUV420P "GAP_FFENC_USE_YUV420P"
   GapGveFFMpegValues   *epp = NULL;
@@ -5016,6 +6194,7 @@ p_ffmpeg_encode_pass(GapGveFFMpegGlobalParams *gpp, gint32 current_pass, GapGveM
   gint32        l_max_master_frame_nr;
   gint32        l_cnt_encoded_frames;
   gint32        l_cnt_reused_frames;
+  gint32        l_cnt_spooled_frames;
   gint          l_video_tracks = 0;
   gint32        l_check_flags;
   t_awk_array   l_awk_arr;
@@ -5023,6 +6202,10 @@ p_ffmpeg_encode_pass(GapGveFFMpegGlobalParams *gpp, gint32 current_pass, GapGveM
   GapCodecNameElem    *l_vcodec_list;
   GapStoryFetchResult  gapStoryFetchResultLocal;
   GapStoryFetchResult *gapStoryFetchResult;
+  gboolean      l_scene_keyframes;
+  SceneChangeDetect    l_scd;
+  gint32        l_cnt_clip_keyframes;
+  gint32        l_cnt_scene_keyframes;
 
 
   static gint32 funcId = -1;
@@ -5045,8 +6228,26 @@ p_ffmpeg_encode_pass(GapGveFFMpegGlobalParams *gpp, gint32 current_pass, GapGveM
 
   l_cnt_encoded_frames = 0;
   l_cnt_reused_frames = 0;
+  l_cnt_spooled_frames = 0;
+  l_cnt_clip_keyframes = 0;
+  l_cnt_scene_keyframes = 0;
   p_init_audio_workdata(awp);
 
+  /* optional keyframes at clip boundaries and scene changes
+   * (in addition to the keyframes according to the gop size)
+   */
+  l_scene_keyframes = gap_base_get_gimprc_gboolean_value(
+                                 GAP_GIMPRC_VIDEO_ENCODER_FFMPEG_SCENE_KEYFRAMES
+                               , FALSE  /* default */
+                                 );
+  memset(&l_scd, 0, sizeof(l_scd));
+  l_scd.thresholdPercent = gap_base_get_gimprc_int_value(
+                                 GAP_GIMPRC_VIDEO_ENCODER_FFMPEG_SCENE_CHANGE_THRESHOLD
+                               , GAP_FFMPEG_DEFAULT_SCENE_CHANGE_THRESHOLD  /* default */
+                               , 0    /* min (0 keyframes at clip boundaries only) */
+                               , 100  /* max */
+                                 );
+
   l_check_flags = GAP_VID_CHCHK_FLAG_SIZE;
   l_vcodec_list = p_setup_check_flags(epp, &l_check_flags);
 
@@ -5095,6 +6296,14 @@ p_ffmpeg_encode_pass(GapGveFFMpegGlobalParams *gpp, gint32 current_pass, GapGveM
     l_vidhand->do_gimp_progress = FALSE;
   }
 
+  /* incremental encoding must be set up before the output video is created
+   * (not supported for 2-pass encoding)
+   */
+  if(epp->twoPassFlag != TRUE)
+  {
+    p_ffmpeg_enable_segment_cache(gpp, l_vidhand);
+  }
+
   /* TODO check for overwrite (in case we are called non-interactive)
    * overwrite check shall be done only if (current_pass < 2)
    */
@@ -5124,6 +6333,9 @@ p_ffmpeg_encode_pass(GapGveFFMpegGlobalParams *gpp, gint32 current_pass, GapGveM
   /* Calculations for encoding the sound */
   p_sound_precalculations(ffh, awp, gpp);
 
+  /* start the audio worker thread (if enabled) */
+  ffh->aque = p_audio_queue_new(ffh, awp, gpp->val.framerate);
+
 
   ffh->isMultithreadEnabled = gap_base_get_gimprc_gboolean_value(
                                  GAP_GIMPRC_VIDEO_ENCODER_FFMPEG_MULTIPROCESSOR_ENABLE
@@ -5203,9 +6415,20 @@ p_ffmpeg_encode_pass(GapGveFFMpegGlobalParams *gpp, gint32 current_pass, GapGveM
       GAP_TIMM_START_RECORD(&eque->mainReadFrame);
     }
 
-    
-
-    gap_story_render_fetch_composite_image_or_buffer_or_chunk(l_vidhand
+    /* in pass 2 take the frames that were spooled in pass 1 (if available) */
+    if((current_pass == 2)
+    && (p_pass1_spool_read_frame(spool
+                                , gapStoryFetchResult
+                                , (gint32)gpp->val.vid_width
+                                , (gint32)gpp->val.vid_height
+                                , ffh->vst[0].video_buffer_size
+                                ) == TRUE))
+    {
+      l_cnt_spooled_frames++;
+    }
+    else
+    {
+      gap_story_render_fetch_composite_image_or_buffer_or_chunk(l_vidhand
                     , l_master_frame_nr  /* starts at 1 */
                     , (gint32)  gpp->val.vid_width       /* desired Video Width in pixels */
                     , (gint32)  gpp->val.vid_height      /* desired Video Height in pixels */
@@ -5219,9 +6442,67 @@ p_ffmpeg_encode_pass(GapGveFFMpegGlobalParams *gpp, gint32 current_pass, GapGveM
                     , l_check_flags                      /* IN: check_flags combination of GAP_VID_CHCHK_FLAG_* flag values */
                     , gapStoryFetchResult                /* OUT: struct with feth result */
                  );
-                 
+
+      /* the encoder handles all frames as rgb888 buffers
+       * (frames delivered as gimp image are read once and the image is deleted)
+       */
+      if(p_ffmpeg_fetch_result_image_to_rgb888(gapStoryFetchResult
+                                              , (gint32)gpp->val.vid_width
+                                              , (gint32)gpp->val.vid_height
+                                              ) != TRUE)
+      {
+        gimp_image_delete(gapStoryFetchResult->image_id);
+        gapStoryFetchResult->resultEnum = GAP_STORY_FETCH_RESULT_IS_ERROR;
+      }
+      if((current_pass == 1)
+      && (gapStoryFetchResult->resultEnum != GAP_STORY_FETCH_RESULT_IS_ERROR))
+      {
+        p_pass1_spool_write_frame(spool
+                                 , gapStoryFetchResult
+                                 , (gint32)gpp->val.vid_width
+                                 , (gint32)gpp->val.vid_height
+                                 );
+      }
+    }
+
     l_force_keyframe = gapStoryFetchResult->force_keyframe;
 
+    if((l_scene_keyframes)
+    && (gapStoryFetchResult->resultEnum != GAP_STORY_FETCH_RESULT_IS_ERROR)
+    && (gapStoryFetchResult->resultEnum != GAP_STORY_FETCH_RESULT_IS_COMPRESSED_CHUNK))
+    {
+      if(gap_story_render_is_clip_boundary(l_vidhand, l_master_frame_nr))
+      {
+        if(!l_force_keyframe)
+        {
+          l_cnt_clip_keyframes++;
+        }
+        l_force_keyframe = TRUE;
+      }
+      if((l_scd.thresholdPercent > 0)
+      && (gapStoryFetchResult->resultEnum == GAP_STORY_FETCH_RESULT_IS_RAW_RGB888))
+      {
+        /* the histogram is updated for every frame (also at clip boundaries) */
+        if((p_scene_change_detect(&l_scd
+                                 , gapStoryFetchResult->raw_rgb_data
+                                 , (gint32)gpp->val.vid_width
+                                 , (gint32)gpp->val.vid_height
+                                 ))
+        && (!l_force_keyframe))
+        {
+          l_cnt_scene_keyframes++;
+          l_force_keyframe = TRUE;
+          if(gap_debug)
+          {
+            printf("FFenc: scene change at frame %d (histogram difference %d%%)\n"
+              , (int)l_master_frame_nr
+              , (int)l_scd.lastDiffPercent
+              );
+          }
+        }
+      }
+    }
+
     GAP_TIMM_STOP_FUNCTION(funcIdVidFetch);
     if(eque)
     {
@@ -5254,8 +6535,14 @@ p_ffmpeg_encode_pass(GapGveFFMpegGlobalParams *gpp, gint32 current_pass, GapGveM
 
         GAP_TIMM_START_FUNCTION(funcIdVidCopy11);
 
+        /* the frames queued for the encoder thread must be written before the chunk */
+        if(eque)
+        {
+          p_waitUntilEncoderQueIsProcessed(eque);
+        }
+
         /* dont recode, just copy video chunk to output videofile */
-        p_ffmpeg_write_frame_chunk(ffh, l_video_frame_chunk_size, 0 /* vid_track */);
+        p_ffmpeg_write_frame_chunk(ffh, l_video_frame_chunk_size, l_force_keyframe, 0 /* vid_track */);
 
         GAP_TIMM_STOP_FUNCTION(funcIdVidCopy11);
 
@@ -5413,6 +6700,17 @@ p_ffmpeg_encode_pass(GapGveFFMpegGlobalParams *gpp, gint32 current_pass, GapGveM
     {
       p_waitUntilEncoderQueIsProcessed(eque);
     }
+
+    if(ffh->aque != NULL)
+    {
+      /* stop the audio worker before the audio codecs are closed */
+      if(gap_debug)
+      {
+        p_audio_queue_print_statistics(ffh->aque);
+      }
+      p_audio_queue_free(ffh->aque);
+      ffh->aque = NULL;
+    }
     
     p_ffmpeg_close(ffh);
     if(gap_debug)
@@ -5449,6 +6747,16 @@ p_ffmpeg_encode_pass(GapGveFFMpegGlobalParams *gpp, gint32 current_pass, GapGveM
     printf("encoded       frames: %d\n", (int)l_cnt_encoded_frames);
     printf("1:1 copied    frames: %d\n", (int)l_cnt_reused_frames);
     printf("total handled frames: %d\n", (int)l_cnt_encoded_frames + l_cnt_reused_frames);
+    printf("frames read from pass 1 spool: %d\n", (int)l_cnt_spooled_frames);
+  }
+  if(l_scene_keyframes)
+  {
+    printf("pass %d forced keyframes at clip boundaries: %d, at scene changes: %d (threshold:%d%%)\n"
+      , (int)current_pass
+      , (int)l_cnt_clip_keyframes
+      , (int)l_cnt_scene_keyframes
+      , (int)l_scd.thresholdPercent
+      );
   }
 
 
@@ -5485,6 +6793,15 @@ p_ffmpeg_encode_pass(GapGveFFMpegGlobalParams *gpp, gint32 current_pass, GapGveM
      */
     g_free(gapStoryFetchResult->raw_rgb_data);
   }
+
+  if(gap_gve_misc_is_master_encoder_cancel_request(encStatusPtr))
+  {
+    p_pass1_spool_finish_pass(spool, current_pass, -1);
+  }
+  else
+  {
+    p_pass1_spool_finish_pass(spool, current_pass, l_rc);
+  }
   return l_rc;
 }    /* end p_ffmpeg_encode_pass */
 
@@ -5508,6 +6825,10 @@ p_ffmpeg_encode(GapGveFFMpegGlobalParams *gpp)
   gint l_rc;
   GapGveMasterEncoderStatus encStatus;
   GapGveMasterEncoderStatus *encStatusPtr;
+  Pass1Spool   *spool;
+  GTimer       *passTimer;
+  gdouble       l_pass1_secs;
+  gdouble       l_pass2_secs;
 
   epp = &gpp->evl;
   encStatusPtr = &encStatus;
@@ -5523,18 +6844,42 @@ p_ffmpeg_encode(GapGveFFMpegGlobalParams *gpp)
 
   if (epp->twoPassFlag == TRUE)
   {
+    /* optional spool the frames rendered in pass 1 for reuse in pass 2 */
+    spool = p_pass1_spool_new(gpp);
+    passTimer = g_timer_new();
+    l_pass2_secs = 0.0;
+
     l_current_pass = 1;
-    l_rc = p_ffmpeg_encode_pass(gpp, l_current_pass, encStatusPtr);
+    l_rc = p_ffmpeg_encode_pass(gpp, l_current_pass, encStatusPtr, spool);
+    l_pass1_secs = g_timer_elapsed(passTimer, NULL);
     if (l_rc >= 0)
     {
+      g_timer_start(passTimer);
       l_current_pass = 2;
-      l_rc = p_ffmpeg_encode_pass(gpp, l_current_pass, encStatusPtr);
+      l_rc = p_ffmpeg_encode_pass(gpp, l_current_pass, encStatusPtr, spool);
+      l_pass2_secs = g_timer_elapsed(passTimer, NULL);
+    }
+
+    printf("FFMPEG 2-pass encoding: pass 1: %.2f sec, pass 2: %.2f sec, total: %.2f sec\n"
+      , (float)l_pass1_secs
+      , (float)l_pass2_secs
+      , (float)(l_pass1_secs + l_pass2_secs)
+      );
+    if(spool != NULL)
+    {
+      printf("FFMPEG 2-pass encoding: pass 1 spooled frames: %d (%.0f bytes) pass 2 frames read from spool: %d\n"
+        , (int)spool->framesWritten
+        , (gdouble)spool->bytesWritten
+        , (int)spool->framesRead
+        );
     }
+    g_timer_destroy(passTimer);
+    p_pass1_spool_free(spool);
   }
   else
   {
     l_current_pass = 0;
-    l_rc = p_ffmpeg_encode_pass(gpp, l_current_pass, encStatusPtr);
+    l_rc = p_ffmpeg_encode_pass(gpp, l_current_pass, encStatusPtr, NULL);
   }
 
   return l_rc;
@@ -64,6 +64,11 @@
 
 /// end ffmpeg 0.5 / 0.6 support
 
+#ifndef FF_I_TYPE
+/* newer ffmpeg versions removed the FF_*_TYPE picture types */
+#define FF_I_TYPE             AV_PICTURE_TYPE_I
+#endif
+
 
 #define GAP_HELP_ID_FFMPEG_PARAMS         "plug-in-gap-encpar-ffmpeg"
 #define GAP_PLUGIN_NAME_FFMPEG_PARAMS     "plug-in-gap-encpar-ffmpeg"
@@ -71,6 +76,15 @@
 
 #define GAP_FFMPEG_CURRENT_VID_EXTENSION  "plug-in-gap-enc-ffmpeg-CURRENT-VIDEO-EXTENSION"
 
+#define GAP_GIMPRC_VIDEO_ENCODER_FFMPEG_PASS1_SPOOL_MB   "video-encoder-ffmpeg-pass1-spool-mb"
+#define GAP_GIMPRC_VIDEO_ENCODER_FFMPEG_PASS1_SPOOL_DIR  "video-encoder-ffmpeg-pass1-spool-dir"
+#define GAP_GIMPRC_VIDEO_ENCODER_FFMPEG_AUDIO_WORKER     "video-encoder-ffmpeg-audio-worker"
+#define GAP_GIMPRC_VIDEO_ENCODER_FFMPEG_AUDIO_AHEAD_MS   "video-encoder-ffmpeg-audio-ahead-ms"
+#define GAP_FFMPEG_DEFAULT_AUDIO_AHEAD_MS                2000
+#define GAP_GIMPRC_VIDEO_ENCODER_FFMPEG_SCENE_KEYFRAMES  "video-encoder-ffmpeg-scene-keyframes"
+#define GAP_GIMPRC_VIDEO_ENCODER_FFMPEG_SCENE_CHANGE_THRESHOLD  "video-encoder-ffmpeg-scene-change-threshold"
+#define GAP_FFMPEG_DEFAULT_SCENE_CHANGE_THRESHOLD        40
+
 #define GAP_GVE_FFMPEG_PRESET_00_NONE           0
 // #define GAP_GVE_FFMPEG_PRESET_01_DIVX_DEFAULT   1
 // #define GAP_GVE_FFMPEG_PRESET_02_DIVX_BEST      2
@@ -32,6 +32,8 @@
  */
 
 /* revision history:
+ * version 2.8.xx;  2026.10.18   agent: write 1:1 copied frames via writer threads,
+ *                                     recoded JPEG/PNG frames are compressed by the writer threads
  * version 2.5.0;  2008.06.01   hof: created
  */
 
@@ -625,33 +627,6 @@ p_build_format_from_framename(gchar *framename)
 }   /* end p_build_format_from_framename */
 
 
-/* --------------------------------
- * p_save_chunk_as_frame
- * --------------------------------
- */
-gboolean
-p_save_chunk_as_frame(const char *filename,  unsigned char *video_chunk, gint32 video_frame_chunk_size, gint32 header_length)
-{
-  FILE   *fp;
-  unsigned char   *dataPtr;
-  gint32  dataSize;
-
-  dataSize = video_frame_chunk_size - header_length;
-  dataPtr = video_chunk + header_length;
-
-  fp = fopen(filename, "w");
-  if (fp)
-  {
-    fwrite(dataPtr, dataSize, 1, fp);
-    fclose(fp);
-    return (TRUE);
-  }
-
-  printf("ERROR cant write to file:%s\n", filename);
-  return (FALSE);
-}  /* end p_save_chunk_as_frame */
-
-
 gint32
 p_dimSizeOfRawFrame(GapGveRawGlobalParams *gpp)
 {
@@ -724,6 +699,8 @@ p_rawframe_encode(GapGveRawGlobalParams *gpp)
   gint32         l_out_frame_nr;
   GimpRunMode    l_save_runmode;
   GapGveMasterEncoderStatus encStatus;
+  GapGveFrameWriter *l_fwr;
+  GapGveFrameFormat  l_frame_format;
 
   if(gap_debug)
   {
@@ -769,6 +746,14 @@ p_rawframe_encode(GapGveRawGlobalParams *gpp)
 
   if(gap_debug) printf("rawframes will be saved with filename: %s\n", l_frame_fmt);
 
+  /* 1:1 copied frames are written by writer threads
+   * while the next frames are fetched
+   * (recoded frames too, if enabled in the gimprc and the writer can compress
+   * the format of the videoname, PNG only for frames without alpha channel)
+   */
+  l_fwr = gap_gve_frame_writer_new();
+  l_frame_format = gap_gve_frame_writer_get_format(l_fwr, gpp->val.videoname);
+
 
   /* make list of frameranges */
   {
@@ -848,6 +833,7 @@ p_rawframe_encode(GapGveRawGlobalParams *gpp)
     if(l_fetch_ok != TRUE)
     {
       printf("ERROR: fetching of frame: %d FAILED, terminating\n", (int)l_cur_frame_nr);
+      gap_gve_frame_writer_free(l_fwr);
       return -1;
     }
     else
@@ -872,10 +858,15 @@ p_rawframe_encode(GapGveRawGlobalParams *gpp)
         }
 
         /* dont recode, just write video chunk to output frame file */
-        l_saveOk = p_save_chunk_as_frame(l_sav_name, l_video_chunk_ptr, l_video_frame_chunk_size, l_video_frame_chunk_hdr_size);
+        l_saveOk = gap_gve_frame_writer_write(l_fwr
+                         , l_sav_name
+                         , l_out_frame_nr
+                         , l_video_chunk_ptr + l_video_frame_chunk_hdr_size
+                         , l_video_frame_chunk_size - l_video_frame_chunk_hdr_size
+                         );
         if (!l_saveOk)
         {
-          return -1;
+          l_rc = -1;
         }
       }
       else
@@ -895,6 +886,31 @@ p_rawframe_encode(GapGveRawGlobalParams *gpp)
           g_free(l_msg);
         }
 
+        if((l_frame_format == GAP_GVE_FRAME_FORMAT_JPEG)
+        || ((l_frame_format == GAP_GVE_FRAME_FORMAT_PNG) && (!gimp_drawable_has_alpha(l_layer_id))))
+        {
+          GimpDrawable      *l_drawable;
+          GapRgbPixelBuffer *l_rgbBuffer;
+
+          /* read the pixels here (PDB calls are restricted to the main thread),
+           * compression and write is done by the writer threads
+           */
+          l_drawable = gimp_drawable_get(l_layer_id);
+          l_rgbBuffer = gap_gve_new_GapRgbPixelBuffer(l_drawable->width, l_drawable->height);
+          gap_gve_drawable_to_RgbBuffer(l_drawable, l_rgbBuffer);
+          gimp_drawable_detach(l_drawable);
+
+          if(gap_gve_frame_writer_write_rgb_buffer(l_fwr
+                         , l_sav_name
+                         , l_out_frame_nr
+                         , l_rgbBuffer         /* owned by the writer */
+                         , l_frame_format
+                         ) != TRUE)
+          {
+            l_rc = -1;
+          }
+        }
+        else
         {
           gint32 l_sav_rc;
 
@@ -912,10 +928,11 @@ p_rawframe_encode(GapGveRawGlobalParams *gpp)
             g_message(_("** Save FAILED on file\n%s"), l_sav_name);
             l_rc = -1;
           }
+          l_save_runmode  = GIMP_RUN_WITH_LAST_VALS;
         }
-        l_save_runmode  = GIMP_RUN_WITH_LAST_VALS;
         if(l_tmp_image_id < 0)
         {
+          gap_gve_frame_writer_free(l_fwr);
           return -1;
         }
 
@@ -958,6 +975,14 @@ p_rawframe_encode(GapGveRawGlobalParams *gpp)
 
   g_free(l_frame_fmt);
 
+  /* wait for the writer threads and report frames that could not be written */
+  if(gap_gve_frame_writer_finish(l_fwr) != TRUE)
+  {
+    g_message(_("** Save FAILED on file\n%s"), l_fwr->firstFailedFilename);
+    l_rc = -1;
+  }
+  gap_gve_frame_writer_free(l_fwr);
+
   if(l_vidhand)
   {
     gap_gve_story_close_vid_handle(l_vidhand);
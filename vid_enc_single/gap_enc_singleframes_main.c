@@ -28,6 +28,7 @@
  */
 
 /* revision history:
+ * version 2.8.xx;  2026.10.18   agent: JPEG/PNG frames are compressed and written by writer threads
  * version 2.1.0b;  2004.08.08   hof: new param input_mode, 6-digits for numberpart.
  * version 1.2.2b;  2002.11.24   hof: created
  */
@@ -629,6 +630,8 @@ p_singleframe_encode(GapGveSingleGlobalParams *gpp)
   gint32          l_out_frame_nr;
   GimpRunMode     l_save_runmode;
   GapGveMasterEncoderStatus encStatus;
+  GapGveFrameWriter *l_fwr;
+  GapGveFrameFormat  l_frame_format;
 
   if(gap_debug)
   {
@@ -657,6 +660,12 @@ p_singleframe_encode(GapGveSingleGlobalParams *gpp)
 
   if(gap_debug) printf("singleframes will be saved with filename: %s\n", l_frame_fmt);
 
+  /* JPEG and PNG frames are compressed and written by writer threads
+   * (if enabled in the gimprc, PNG only for frames without alpha channel)
+   * while the next frames are fetched
+   */
+  l_fwr = gap_gve_frame_writer_new();
+  l_frame_format = gap_gve_frame_writer_get_format(l_fwr, gpp->val.videoname);
 
   /* make list of frameranges */
   {
@@ -717,7 +726,10 @@ p_singleframe_encode(GapGveSingleGlobalParams *gpp)
                     , &l_layer_id           /* output */
                     );
     if(l_tmp_image_id < 0)
+    {
+       gap_gve_frame_writer_free(l_fwr);
        return -1;
+    }
 
     /* save each handled video frame as single file */
     if(l_rc == 0)
@@ -734,6 +746,31 @@ p_singleframe_encode(GapGveSingleGlobalParams *gpp)
          g_free(l_msg);
        }
 
+       if((l_frame_format == GAP_GVE_FRAME_FORMAT_JPEG)
+       || ((l_frame_format == GAP_GVE_FRAME_FORMAT_PNG) && (!gimp_drawable_has_alpha(l_layer_id))))
+       {
+         GimpDrawable      *l_drawable;
+         GapRgbPixelBuffer *l_rgbBuffer;
+
+         /* read the pixels here (PDB calls are restricted to the main thread),
+          * compression and write is done by the writer threads
+          */
+         l_drawable = gimp_drawable_get(l_layer_id);
+         l_rgbBuffer = gap_gve_new_GapRgbPixelBuffer(l_drawable->width, l_drawable->height);
+         gap_gve_drawable_to_RgbBuffer(l_drawable, l_rgbBuffer);
+         gimp_drawable_detach(l_drawable);
+
+         if(gap_gve_frame_writer_write_rgb_buffer(l_fwr
+                         , l_sav_name
+                         , l_out_frame_nr
+                         , l_rgbBuffer         /* owned by the writer */
+                         , l_frame_format
+                         ) != TRUE)
+         {
+           l_rc = -1;
+         }
+       }
+       else
        {
          gint32 l_sav_rc;
 
@@ -789,6 +826,14 @@ p_singleframe_encode(GapGveSingleGlobalParams *gpp)
 
   g_free(l_frame_fmt);
 
+  /* wait for the writer threads and report frames that could not be written */
+  if(gap_gve_frame_writer_finish(l_fwr) != TRUE)
+  {
+    g_message(_("** Save FAILED on file\n%s"), l_fwr->firstFailedFilename);
+    l_rc = -1;
+  }
+  gap_gve_frame_writer_free(l_fwr);
+
   if(l_vidhand)
   {
     gap_gve_story_close_vid_handle(l_vidhand);